@@ -0,0 +1,39 @@
+project "Benchmarks"
+  kind "ConsoleApp"
+  language "C++"
+  cppdialect "C++23"
+
+  targetdir ("%{wks.location}/Build/Bin/" .. outputdir .. "/%{prj.name}")
+  objdir ("%{wks.location}/Build/Obj/" .. outputdir .. "/%{prj.name}")
+
+  files
+  {
+    "src/**.h",
+    "src/**.cpp"
+  }
+
+  includedirs
+  {
+    "%{wks.location}/Engine/Source",
+    "%{IncludeDir.glm}",
+    "%{IncludeDir.sdl}",
+    "%{IncludeDir.spdlog}"
+  }
+
+  links
+  {
+    "Engine"
+  }
+
+  systemversion "latest"
+
+  filter "configurations:Debug"
+    defines "DEBUG"
+    runtime "Debug"
+    symbols "on"
+
+  -- numbers are only meaningful from this configuration
+  filter "configurations:Release"
+    defines "RELEASE"
+    runtime "Release"
+    optimize "on"
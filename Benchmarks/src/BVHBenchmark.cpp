@@ -0,0 +1,156 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Engine/Scene/BVH.h"
+
+namespace
+{
+    constexpr std::array<uint32, 3> OBJECT_COUNTS = { 10'000, 100'000, 1'000'000 };
+    // objects per unit volume stay the same at every count, a view sees about as many of them in each world
+    constexpr float OBJECT_SPACING = 4.0f;
+    constexpr float MIN_OBJECT_SIZE = 0.5f;
+    constexpr float MAX_OBJECT_SIZE = 2.0f;
+
+    constexpr uint32 FRUSTUM_COUNT = 256;
+    // the linear reference tests every object, a few views are enough to time it
+    constexpr uint32 LINEAR_FRUSTUM_COUNT = 8;
+    constexpr float  VIEW_DISTANCE = 100.0f;
+    constexpr uint32 RAY_COUNT = 65'536;
+
+    struct Scene
+    {
+        std::vector<AABB>    Bounds;
+        std::vector<Frustum> Frustums;
+        std::vector<Ray>     Rays;
+    };
+
+    Scene MakeScene( uint32 object_count )
+    {
+        std::mt19937 random( object_count );
+        const float world_size = std::cbrt( static_cast< float >( object_count ) ) * OBJECT_SPACING;
+        std::uniform_real_distribution<float> position( 0.0f, world_size );
+        std::uniform_real_distribution<float> size( MIN_OBJECT_SIZE, MAX_OBJECT_SIZE );
+        std::uniform_real_distribution<float> direction( -1.0f, 1.0f );
+
+        auto random_position = [&] {
+            return glm::vec3( position( random ), position( random ), position( random ) );
+        };
+        auto random_direction = [&] {
+            glm::vec3 result;
+            do
+            {
+                result = glm::vec3( direction( random ), direction( random ), direction( random ) );
+            } while ( glm::dot( result, result ) < 1e-4f || glm::dot( result, result ) > 1.0f );
+            return glm::normalize( result );
+        };
+
+        Scene scene;
+        scene.Bounds.reserve( object_count );
+        for ( uint32 object = 0; object < object_count; ++object )
+        {
+            const glm::vec3 center = random_position();
+            const glm::vec3 extent = glm::vec3( size( random ), size( random ), size( random ) ) * 0.5f;
+            scene.Bounds.push_back( { center - extent, center + extent } );
+        }
+
+        const glm::mat4 projection = glm::perspective( glm::radians( 60.0f ), 16.0f / 9.0f, 0.1f, VIEW_DISTANCE );
+        for ( uint32 view = 0; view < FRUSTUM_COUNT; ++view )
+        {
+            const glm::vec3 eye = random_position();
+            const glm::vec3 forward = random_direction();
+            const glm::vec3 up = std::abs( forward.z ) < 0.99f ? glm::vec3( 0.0f, 0.0f, 1.0f ) :
+                glm::vec3( 1.0f, 0.0f, 0.0f );
+            scene.Frustums.push_back( Frustum::FromMatrix( projection * glm::lookAt( eye, eye + forward, up ) ) );
+        }
+
+        for ( uint32 ray = 0; ray < RAY_COUNT; ++ray )
+        {
+            scene.Rays.push_back( { random_position(), random_direction(), VIEW_DISTANCE } );
+        }
+        return scene;
+    }
+}
+
+// Build and query costs of a tree over randomly placed boxes at 10k, 100k and 1M objects. Frustum queries are
+// compared against testing every box, the ray casts return the nearest box hit within the view distance.
+void RunBVHBenchmarks()
+{
+    std::printf( "BVH\n" );
+    std::printf( "%10s %10s %10s %14s %14s %10s %12s %8s\n", "objects", "build ms", "flatten ms", "frustum us",
+        "linear us", "visible", "rays/s", "hit %" );
+
+    for ( uint32 object_count : OBJECT_COUNTS )
+    {
+        const Scene scene = MakeScene( object_count );
+        BVH tree;
+
+        const double build_ms = MeasureMs( [&] ( Stopwatch& ) {
+            tree.Build( scene.Bounds );
+        } );
+
+        const double flatten_ms = MeasureMs( [&] ( Stopwatch& stopwatch ) {
+            stopwatch.Stop();
+            tree.Build( scene.Bounds );
+            stopwatch.Start();
+            tree.Flatten();
+        } );
+
+        std::vector<uint32> visible;
+        visible.reserve( object_count );
+        size_t visible_total = 0;
+        const double frustum_ms = MeasureMs( [&] ( Stopwatch& ) {
+            visible_total = 0;
+            for ( const Frustum& frustum : scene.Frustums )
+            {
+                visible.clear();
+                tree.QueryFrustum( frustum, visible );
+                visible_total += visible.size();
+            }
+        } );
+
+        size_t linear_total = 0;
+        const double linear_ms = MeasureMs( [&] ( Stopwatch& ) {
+            linear_total = 0;
+            for ( uint32 view = 0; view < LINEAR_FRUSTUM_COUNT; ++view )
+            {
+                for ( const AABB& bounds : scene.Bounds )
+                {
+                    linear_total += scene.Frustums[view].Intersects( bounds ) ? 1 : 0;
+                }
+            }
+        } );
+
+        uint32 hits = 0;
+        const double ray_ms = MeasureMs( [&] ( Stopwatch& ) {
+            hits = 0;
+            for ( const Ray& ray : scene.Rays )
+            {
+                hits += tree.RayCast( ray ).has_value() ? 1 : 0;
+            }
+        } );
+
+        std::printf( "%10u %10.2f %10.2f %14.2f %14.2f %10zu %12.3g %8.1f\n",
+            object_count,
+            build_ms,
+            flatten_ms,
+            frustum_ms * 1000.0 / FRUSTUM_COUNT,
+            linear_ms * 1000.0 / LINEAR_FRUSTUM_COUNT,
+            visible_total / FRUSTUM_COUNT,
+            RAY_COUNT / ( ray_ms / 1000.0 ),
+            100.0 * hits / RAY_COUNT );
+
+        // keeps the reference loop from being optimized out
+        if ( linear_total == SIZE_MAX )
+        {
+            std::printf( "\n" );
+        }
+    }
+}
@@ -0,0 +1,63 @@
+// Benchmarks/src/Benchmark.h
+
+#ifndef __benchmarks_benchmark_h_included__
+#define __benchmarks_benchmark_h_included__
+
+#include <chrono>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+
+// Accumulates the time between Start() and Stop() calls.
+class Stopwatch
+{
+public:
+    void Start()
+    {
+        Begin = std::chrono::steady_clock::now();
+    }
+
+    void Stop()
+    {
+        Elapsed += std::chrono::steady_clock::now() - Begin;
+    }
+
+    double GetMs() const
+    {
+        return std::chrono::duration<double, std::milli>( Elapsed ).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point Begin;
+    std::chrono::steady_clock::duration   Elapsed{};
+};
+
+// Runs func at least MIN_RUNS times and until MIN_TOTAL_MS were measured, returns the fastest run in
+// milliseconds, the one least disturbed by the rest of the system. func gets the running Stopwatch and
+// stops it around setup that should not count.
+template<typename Func>
+double MeasureMs( Func&& func )
+{
+    constexpr uint32 MIN_RUNS = 3;
+    constexpr double MIN_TOTAL_MS = 250.0;
+
+    double best = 0.0;
+    double total = 0.0;
+    for ( uint32 run = 0; run < MIN_RUNS || total < MIN_TOTAL_MS; ++run )
+    {
+        Stopwatch stopwatch;
+        stopwatch.Start();
+        func( stopwatch );
+        stopwatch.Stop();
+
+        const double ms = stopwatch.GetMs();
+        best = run == 0 ? ms : std::min( best, ms );
+        total += ms;
+    }
+    return best;
+}
+
+void RunBVHBenchmarks();
+void RunRenderQueueBenchmarks();
+
+#endif
@@ -0,0 +1,65 @@
+#include "Benchmark.h"
+
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Engine/Renderer/RenderQueue.h"
+
+namespace
+{
+    // the backend submits at most one item per visible object, capped at 16k a frame
+    constexpr std::array<uint32, 4> ITEM_COUNTS = { 1'024, 4'096, 16'384, 65'536 };
+    constexpr uint32 SORTS_PER_RUN = 16;
+
+    // a few pipelines and materials, many meshes and spread out depths, like a frame of scene draws
+    std::vector<uint64> MakeKeys( uint32 item_count )
+    {
+        std::mt19937 random( item_count );
+        std::uniform_int_distribution<uint32> pipeline( 0, 7 );
+        std::uniform_int_distribution<uint32> material( 0, 63 );
+        std::uniform_int_distribution<uint32> mesh( 0, 1023 );
+        std::uniform_real_distribution<float> depth( 0.0f, 1.0f );
+
+        std::vector<uint64> keys;
+        keys.reserve( item_count );
+        for ( uint32 item = 0; item < item_count; ++item )
+        {
+            keys.push_back( RenderQueue::MakeKey( 0, pipeline( random ), material( random ), mesh( random ),
+                depth( random ) ) );
+        }
+        return keys;
+    }
+}
+
+// Time to fill and sort the queue the way the backend does every frame.
+void RunRenderQueueBenchmarks()
+{
+    std::printf( "RenderQueue\n" );
+    std::printf( "%10s %12s %14s\n", "items", "sort us", "ns per item" );
+
+    for ( uint32 item_count : ITEM_COUNTS )
+    {
+        const std::vector<uint64> keys = MakeKeys( item_count );
+        RenderQueue queue;
+        queue.Reserve( item_count );
+
+        const double sort_ms = MeasureMs( [&] ( Stopwatch& stopwatch ) {
+            for ( uint32 sort = 0; sort < SORTS_PER_RUN; ++sort )
+            {
+                stopwatch.Stop();
+                queue.Clear();
+                for ( uint32 item = 0; item < item_count; ++item )
+                {
+                    queue.Push( keys[item], item );
+                }
+                stopwatch.Start();
+                queue.Sort();
+            }
+        } );
+
+        const double sort_us = sort_ms * 1000.0 / SORTS_PER_RUN;
+        std::printf( "%10u %12.2f %14.2f\n", item_count, sort_us, sort_us * 1000.0 / item_count );
+    }
+}
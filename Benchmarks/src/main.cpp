@@ -0,0 +1,33 @@
+#include "Benchmark.h"
+
+#include <string_view>
+
+// Runs every benchmark, or the ones named on the command line.
+int main( int argc, char* argv[] )
+{
+    auto selected = [argc, argv] ( std::string_view name ) {
+        if ( argc < 2 )
+        {
+            return true;
+        }
+        for ( int32 arg = 1; arg < argc; ++arg )
+        {
+            if ( name == argv[arg] )
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if ( selected( "bvh" ) )
+    {
+        RunBVHBenchmarks();
+    }
+    if ( selected( "queue" ) )
+    {
+        RunRenderQueueBenchmarks();
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+# Compiles every shader in -ShaderDir to <name>.spv through a content addressed cache.
+#
+# The cache key is a SHA-256 of the glslc version, the defines and the preprocessed source (glslc -E),
+# so a shader is only compiled when something that affects its SPIR-V changed. Entries live in
+# -CacheDir as <key>.spv and are never modified. A <name>.spv that already matches is left untouched,
+# which keeps its timestamp for anything that depends on it.
+#
+# A shader that declares "//! permutations: A B" is also compiled once per combination of those
+# keywords, each defined as 1, to <name>.A.spv, <name>.B.spv and <name>.A.B.spv (keywords sorted).
+
+param(
+    [Parameter(Mandatory = $true)][string]$Glslc,
+    [Parameter(Mandatory = $true)][string]$ShaderDir,
+    [string]$CacheDir = (Join-Path $ShaderDir "Cache"),
+    [string[]]$Defines = @()
+)
+
+$ErrorActionPreference = "Stop"
+
+# bump when the key or the entry layout changes
+$CacheFormat = "spirv-cache-1"
+
+New-Item -ItemType Directory -Force -Path $CacheDir | Out-Null
+
+$CompilerVersion = (& $Glslc --version) -join "`n"
+$Sha256 = [System.Security.Cryptography.SHA256]::Create()
+
+function Get-Key([string]$Text)
+{
+    $Bytes = [System.Text.Encoding]::UTF8.GetBytes($Text)
+    return -join ($Sha256.ComputeHash($Bytes) | ForEach-Object { $_.ToString("x2") })
+}
+
+$Hits = 0
+$Misses = 0
+
+$MaxPermutationKeywords = 4
+
+$Sources = Get-ChildItem -Path $ShaderDir -File | Where-Object { $_.Extension -in ".vert", ".frag", ".comp" }
+foreach ($Source in $Sources)
+{
+    $Keywords = @()
+    $Directive = Select-String -Path $Source.FullName -Pattern "//! permutations:(.*)" | Select-Object -First 1
+    if ($Directive)
+    {
+        [string[]]$Keywords = @($Directive.Matches[0].Groups[1].Value -split "\s+" | Where-Object { $_ } |
+            Select-Object -Unique)
+        [Array]::Sort($Keywords, [StringComparer]::Ordinal)
+    }
+    if ($Keywords.Count -gt $MaxPermutationKeywords)
+    {
+        Write-Error "$($Source.Name) declares $($Keywords.Count) permutation keywords, at most $MaxPermutationKeywords are allowed"
+        exit 1
+    }
+
+    for ($Mask = 0; $Mask -lt (1 -shl $Keywords.Count); $Mask++)
+    {
+        $Permutation = @(for ($i = 0; $i -lt $Keywords.Count; $i++) { if ($Mask -band (1 -shl $i)) { $Keywords[$i] } })
+        $PermutationDefines = @($Defines) + @($Permutation | ForEach-Object { "$_=1" })
+        $DefineArguments = $PermutationDefines | ForEach-Object { "-D$_" }
+
+        $Preprocessed = (& $Glslc -E @DefineArguments $Source.FullName) -join "`n"
+        if ($LASTEXITCODE -ne 0)
+        {
+            Write-Error "Failed to preprocess $($Source.Name)"
+            exit 1
+        }
+
+        $Key = Get-Key ("$CacheFormat`0$CompilerVersion`0$($PermutationDefines -join "`0")`0$Preprocessed")
+        $Entry = Join-Path $CacheDir "$Key.spv"
+
+        if (Test-Path $Entry)
+        {
+            $Hits++
+        }
+        else
+        {
+            $Temporary = "$Entry.tmp"
+            & $Glslc @DefineArguments $Source.FullName -o $Temporary
+            if ($LASTEXITCODE -ne 0)
+            {
+                Remove-Item -Force -ErrorAction SilentlyContinue $Temporary
+                exit 1
+            }
+            Move-Item -Force $Temporary $Entry
+            $Misses++
+        }
+
+        $Output = (@($Source.FullName) + $Permutation + @("spv")) -join "."
+        if (-not (Test-Path $Output) -or (Get-FileHash $Output).Hash -ne (Get-FileHash $Entry).Hash)
+        {
+            Copy-Item -Force $Entry $Output
+        }
+    }
+}
+
+Write-Host "Shaders: $Misses compiled, $Hits from the cache."
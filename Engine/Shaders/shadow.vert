@@ -0,0 +1,15 @@
+#version 450
+
+// Depth only, draws the scene into a shadow cascade or an atlas tile. The light's view projection
+// times the scene's model matrix comes in as a push constant, one per shadow view.
+
+layout(push_constant) uniform Params {
+    mat4 Transform;
+} params;
+
+layout(location = 0) in vec3 InPosition;
+layout(location = 3) in mat4 InModel;
+
+void main() {
+    gl_Position = params.Transform * InModel * vec4(InPosition, 1.0);
+}
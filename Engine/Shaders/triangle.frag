@@ -1,10 +1,168 @@
 #version 450
 
+//! permutations: DEBUG_UV DEBUG_LIGHT_HEATMAP
+
+layout(constant_id = 0) const bool VERTEX_COLOR = false;
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 Model;
+    mat4 View;
+    mat4 Projection;
+    // cluster slice of a view depth is log(depth) * x + y, zw is the tile size in pixels
+    vec4 ClusterSlicing;
+    // xyz clusters per axis, w capacity of a cluster's list
+    uvec4 ClusterGrid;
+    // view space to the clip space of each sun shadow cascade
+    mat4 CascadeMatrices[4];
+    // view depth each cascade ends at
+    vec4 CascadeSplits;
+    // view space, towards the sun
+    vec4 SunDirection;
+    vec4 SunColor;
+} ubo;
+
+// view space, spot cones fall off with clamp(dot(-l, Direction) * SpotScale + SpotOffset, 0, 1)
+struct Light {
+    vec4 PositionRange;
+    vec4 ColorSpotScale;
+    vec4 DirectionSpotOffset;
+    // first atlas tile, a point light has six of them in cube face order, -1 without shadows
+    int ShadowTile;
+};
+
+struct ShadowTile {
+    // view space to the clip space the tile was rendered with
+    mat4 Matrix;
+    // offset and size in atlas texture coordinates, inset by half a texel
+    vec4 Rect;
+};
+
+layout(std430, binding = 2) readonly buffer Lights {
+    Light lights[];
+};
+
+layout(std430, binding = 3) readonly buffer ClusterCounts {
+    uint counts[];
+};
+
+layout(std430, binding = 4) readonly buffer ClusterIndices {
+    uint indices[];
+};
+
 layout(location = 0) out vec4 outColor;
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragViewPosition;
 layout(binding = 1) uniform sampler2D texSampler;
+layout(binding = 5) uniform sampler2DArrayShadow shadowCascades;
+layout(binding = 6) uniform sampler2DShadow shadowAtlas;
+
+layout(std430, binding = 7) readonly buffer ShadowTiles {
+    ShadowTile tiles[];
+};
+
+const vec3 AMBIENT = vec3(0.03);
+
+uint ClusterIndex() {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / ubo.ClusterSlicing.zw), ubo.ClusterGrid.xy - 1u);
+    float slice = log(-fragViewPosition.z) * ubo.ClusterSlicing.x + ubo.ClusterSlicing.y;
+    uint z = uint(clamp(slice, 0.0, float(ubo.ClusterGrid.z - 1u)));
+    return tile.x + ubo.ClusterGrid.x * (tile.y + ubo.ClusterGrid.y * z);
+}
+
+// blue for an empty cluster through green to red for a full one
+vec3 Heatmap(float t) {
+    t = clamp(t, 0.0, 1.0);
+    return clamp(vec3(2.0 * t - 1.0, 1.0 - abs(2.0 * t - 1.0), 1.0 - 2.0 * t), 0.0, 1.0);
+}
+
+vec3 ShadeLight(Light light, vec3 position, vec3 normal) {
+    vec3 to_light = light.PositionRange.xyz - position;
+    float distance_squared = max(dot(to_light, to_light), 1e-4);
+    vec3 l = to_light * inversesqrt(distance_squared);
+
+    // inverse square, windowed so that it reaches zero at the range the light was culled with
+    float range_ratio = distance_squared / (light.PositionRange.w * light.PositionRange.w);
+    float window = clamp(1.0 - range_ratio * range_ratio, 0.0, 1.0);
+    float attenuation = window * window / distance_squared;
+
+    float spot = clamp(dot(-l, light.DirectionSpotOffset.xyz) * light.ColorSpotScale.w +
+        light.DirectionSpotOffset.w, 0.0, 1.0);
+
+    return light.ColorSpotScale.rgb * max(dot(normal, l), 0.0) * attenuation * spot * spot;
+}
+
+// the comparison samplers filter bilinearly, outside of a map the white border reads as lit
+float SunShadow(vec3 position) {
+    float depth = -position.z;
+    if (depth > ubo.CascadeSplits.w) {
+        return 1.0;
+    }
+
+    uint cascade = 0u;
+    while (cascade < 3u && depth > ubo.CascadeSplits[cascade]) {
+        ++cascade;
+    }
+
+    // orthographic, w stays 1
+    vec3 coord = (ubo.CascadeMatrices[cascade] * vec4(position, 1.0)).xyz;
+    return texture(shadowCascades, vec4(coord.xy * 0.5 + 0.5, float(cascade), coord.z));
+}
+
+float LightShadow(Light light, vec3 position) {
+    if (light.ShadowTile < 0) {
+        return 1.0;
+    }
+
+    uint tile = uint(light.ShadowTile);
+    if (light.ColorSpotScale.w == 0.0) {
+        // the cube faces are +x, -x, +y, -y, +z, -z in world space, the major axis picks one
+        vec3 direction = transpose(mat3(ubo.View)) * (position - light.PositionRange.xyz);
+        vec3 size = abs(direction);
+        if (size.x >= size.y && size.x >= size.z) {
+            tile += direction.x > 0.0 ? 0u : 1u;
+        } else if (size.y >= size.z) {
+            tile += direction.y > 0.0 ? 2u : 3u;
+        } else {
+            tile += direction.z > 0.0 ? 4u : 5u;
+        }
+    }
+
+    vec4 clip = tiles[tile].Matrix * vec4(position, 1.0);
+    vec3 coord = clip.xyz / clip.w;
+    vec4 rect = tiles[tile].Rect;
+    vec2 uv = rect.xy + clamp(coord.xy * 0.5 + 0.5, 0.0, 1.0) * rect.zw;
+    return texture(shadowAtlas, vec3(uv, coord.z));
+}
 
 void main() {
-    outColor = vec4(vec3(2.0, 2.0, 2.0) * texture( texSampler, fragTexCoord ).rgb, 1.0);
+#ifdef DEBUG_UV
+    outColor = vec4(fragTexCoord, 0.0, 1.0);
+#elif defined(DEBUG_LIGHT_HEATMAP)
+    uint count = counts[ClusterIndex()];
+    outColor = vec4(Heatmap(float(count) / float(ubo.ClusterGrid.w)), 1.0);
+#else
+    vec3 albedo = texture( texSampler, fragTexCoord ).rgb;
+    if (VERTEX_COLOR) {
+        albedo *= fragColor;
+    }
+
+    // the vertices carry no normals, the quads are flat and seen from both sides
+    vec3 normal = normalize(cross(dFdx(fragViewPosition), dFdy(fragViewPosition)));
+    if (dot(normal, fragViewPosition) > 0.0) {
+        normal = -normal;
+    }
+
+    uint cluster = ClusterIndex();
+    uint count = min(counts[cluster], ubo.ClusterGrid.w);
+    uint list_base = cluster * ubo.ClusterGrid.w;
+
+    vec3 lighting = AMBIENT + ubo.SunColor.rgb * max(dot(normal, ubo.SunDirection.xyz), 0.0) *
+        SunShadow(fragViewPosition);
+    for (uint i = 0u; i < count; ++i) {
+        Light light = lights[indices[list_base + i]];
+        lighting += ShadeLight(light, fragViewPosition, normal) * LightShadow(light, fragViewPosition);
+    }
+    outColor = vec4(albedo * lighting, 1.0);
+#endif
 }
@@ -5,18 +5,27 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 Model;
     mat4 View;
     mat4 Projection;
+    vec4 ClusterSlicing;
+    uvec4 ClusterGrid;
+    mat4 CascadeMatrices[4];
+    vec4 CascadeSplits;
+    vec4 SunDirection;
+    vec4 SunColor;
 } ubo;
 
 layout(location = 0) in vec3 InPosition;
 layout(location = 1) in vec3 InColor;
 layout(location = 2) in vec2 InTexCoord;
+layout(location = 3) in mat4 InModel;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragViewPosition;
 
 void main() {
-    gl_Position = ubo.Projection * ubo.View * ubo.Model * vec4(InPosition, 1.0);
+    vec4 view_position = ubo.View * ubo.Model * InModel * vec4(InPosition, 1.0);
+    gl_Position = ubo.Projection * view_position;
     fragColor = InColor;
     fragTexCoord = InTexCoord;
+    fragViewPosition = view_position.xyz;
 }
-
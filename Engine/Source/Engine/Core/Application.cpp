@@ -8,9 +8,11 @@
 #include <Windows.h>
 
 std::filesystem::path Application::ExePath;
+std::chrono::steady_clock::time_point Application::StartTime;
 
 Application::Application( int argc, char* argv[] )
 {
+    StartTime = std::chrono::steady_clock::now();
     ExePath = argv[0];
     if ( !SDL_Init( SDL_INIT_VIDEO ) )
     {
@@ -46,6 +48,12 @@ int32 Application::Run()
             {
                 running = false;
             }
+            // a live resize sends many of these between two frames, the renderer only keeps the last size
+            if ( event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED )
+            {
+                Window->OnResize( static_cast<uint32_t>( event.window.data1 ),
+                    static_cast<uint32_t>( event.window.data2 ) );
+            }
         }
 
         Window->OnUpdate();
@@ -3,6 +3,7 @@
 #ifndef __application_h_included__
 #define __application_h_included__
 
+#include <chrono>
 #include <memory>
 #include <filesystem>
 
@@ -22,9 +23,16 @@ public:
         return ExePath;
     }
 
+    // taken first thing in the constructor, the reference for the time to first frame
+    static inline std::chrono::steady_clock::time_point LaunchTime()
+    {
+        return StartTime;
+    }
+
 private:
     Scope<WindowBase> Window;
     static std::filesystem::path ExePath;
+    static std::chrono::steady_clock::time_point StartTime;
 };
 
 
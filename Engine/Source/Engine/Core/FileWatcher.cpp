@@ -0,0 +1,215 @@
+#include "FileWatcher.h"
+
+#include <array>
+
+#include "Log.h"
+
+#if defined( PLATFORM_WINDOWS )
+#   define NOMINMAX
+#   define WIN32_LEAN_AND_MEAN
+#   include <Windows.h>
+#elif defined( __linux__ )
+#   include <cerrno>
+#   include <poll.h>
+#   include <unistd.h>
+#   include <sys/inotify.h>
+#endif
+
+namespace
+{
+    // how long a file has to stay untouched before its change is reported
+    constexpr std::chrono::milliseconds SETTLE_TIME( 100 );
+    // how often the watcher thread checks whether it should stop
+    constexpr std::chrono::milliseconds STOP_POLL_INTERVAL( 100 );
+}
+
+FileWatcher::~FileWatcher()
+{
+    Stop();
+}
+
+bool FileWatcher::Start( const std::filesystem::path& directory )
+{
+    Stop();
+
+    std::error_code error;
+    if ( !std::filesystem::is_directory( directory, error ) )
+    {
+        LOG_ERROR( "[FileWatcher] {} is not a directory.", directory.string() );
+        return false;
+    }
+
+    Directory = directory;
+    Running.store( true, std::memory_order_relaxed );
+    Watcher = std::thread( &FileWatcher::Run, this );
+    return true;
+}
+
+void FileWatcher::Stop()
+{
+    Running.store( false, std::memory_order_relaxed );
+    if ( Watcher.joinable() )
+    {
+        Watcher.join();
+    }
+}
+
+std::vector<std::filesystem::path> FileWatcher::TakeChanges()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    std::vector<std::filesystem::path> changes;
+    std::lock_guard lock( Mutex );
+    for ( auto it = Pending.begin(); it != Pending.end(); )
+    {
+        if ( now - it->second >= SETTLE_TIME )
+        {
+            changes.emplace_back( it->first );
+            it = Pending.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return changes;
+}
+
+void FileWatcher::OnChanged( const std::filesystem::path& file )
+{
+    std::lock_guard lock( Mutex );
+    Pending[( Directory / file ).string()] = std::chrono::steady_clock::now();
+}
+
+#if defined( PLATFORM_WINDOWS )
+
+void FileWatcher::Run()
+{
+    HANDLE directory = CreateFileW( Directory.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+    if ( directory == INVALID_HANDLE_VALUE )
+    {
+        LOG_ERROR( "[FileWatcher] Failed to open {}. CreateFileW error {}.", Directory.string(), GetLastError() );
+        Running.store( false, std::memory_order_relaxed );
+        return;
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW( nullptr, TRUE, FALSE, nullptr );
+
+    alignas( DWORD ) std::array<std::byte, 16 * 1024> buffer;
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    const BOOL  watch_subtree = FALSE;
+
+    bool pending_read = false;
+    while ( Running.load( std::memory_order_relaxed ) )
+    {
+        if ( !pending_read )
+        {
+            ResetEvent( overlapped.hEvent );
+            if ( !ReadDirectoryChangesW( directory, buffer.data(), static_cast< DWORD >( buffer.size() ),
+                watch_subtree, filter, nullptr, &overlapped, nullptr ) )
+            {
+                LOG_ERROR( "[FileWatcher] ReadDirectoryChangesW failed with error {}.", GetLastError() );
+                break;
+            }
+            pending_read = true;
+        }
+
+        const DWORD wait = WaitForSingleObject( overlapped.hEvent, static_cast< DWORD >( STOP_POLL_INTERVAL.count() ) );
+        if ( wait != WAIT_OBJECT_0 )
+        {
+            continue;
+        }
+        pending_read = false;
+
+        DWORD bytes = 0;
+        if ( !GetOverlappedResult( directory, &overlapped, &bytes, FALSE ) || bytes == 0 )
+        {
+            // zero bytes means the buffer overflowed, the changes are lost but watching continues
+            continue;
+        }
+
+        for ( const std::byte* entry = buffer.data();; )
+        {
+            const auto* info = reinterpret_cast< const FILE_NOTIFY_INFORMATION* >( entry );
+            if ( info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME )
+            {
+                OnChanged( std::wstring( info->FileName, info->FileNameLength / sizeof( WCHAR ) ) );
+            }
+
+            if ( info->NextEntryOffset == 0 )
+            {
+                break;
+            }
+            entry += info->NextEntryOffset;
+        }
+    }
+
+    if ( pending_read )
+    {
+        CancelIoEx( directory, &overlapped );
+        DWORD bytes = 0;
+        GetOverlappedResult( directory, &overlapped, &bytes, TRUE );
+    }
+    CloseHandle( overlapped.hEvent );
+    CloseHandle( directory );
+}
+
+#elif defined( __linux__ )
+
+void FileWatcher::Run()
+{
+    const int32 inotify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( inotify < 0 )
+    {
+        LOG_ERROR( "[FileWatcher] inotify_init1 failed with errno {}.", errno );
+        Running.store( false, std::memory_order_relaxed );
+        return;
+    }
+
+    // IN_CLOSE_WRITE instead of IN_MODIFY, a file is reported once the writer is done with it
+    const uint32 mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    if ( inotify_add_watch( inotify, Directory.c_str(), mask ) < 0 )
+    {
+        LOG_ERROR( "[FileWatcher] Failed to watch {}, errno {}.", Directory.string(), errno );
+        close( inotify );
+        Running.store( false, std::memory_order_relaxed );
+        return;
+    }
+
+    alignas( inotify_event ) std::array<std::byte, 16 * 1024> buffer;
+    while ( Running.load( std::memory_order_relaxed ) )
+    {
+        pollfd descriptor = { inotify, POLLIN, 0 };
+        if ( poll( &descriptor, 1, static_cast< int32 >( STOP_POLL_INTERVAL.count() ) ) <= 0 )
+        {
+            continue;
+        }
+
+        const ssize_t length = read( inotify, buffer.data(), buffer.size() );
+        for ( ssize_t offset = 0; offset < length; )
+        {
+            const auto* event = reinterpret_cast< const inotify_event* >( buffer.data() + offset );
+            if ( event->len > 0 && !( event->mask & IN_ISDIR ) )
+            {
+                OnChanged( event->name );
+            }
+            offset += sizeof( inotify_event ) + event->len;
+        }
+    }
+
+    close( inotify );
+}
+
+#else
+
+void FileWatcher::Run()
+{
+    LOG_WARN( "[FileWatcher] File watching is not supported on this platform." );
+    Running.store( false, std::memory_order_relaxed );
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Engine/Core/FileWatcher.h
+
+#ifndef __core_file_watcher_h_included__
+#define __core_file_watcher_h_included__
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include "Common.h"
+
+// Watches the files directly inside one directory on a background thread, using inotify on Linux and
+// ReadDirectoryChangesW on Windows. Editors often write a file several times when saving, so a change
+// is reported only once the file has been quiet for a short while.
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher( const FileWatcher& ) = delete;
+    FileWatcher& operator=( const FileWatcher& ) = delete;
+
+    bool Start( const std::filesystem::path& directory );
+    void Stop();
+
+    bool IsRunning() const
+    {
+        return Running.load( std::memory_order_relaxed );
+    }
+
+    // files that changed and settled since the last call, each reported once
+    std::vector<std::filesystem::path> TakeChanges();
+
+private:
+    void Run();
+    void OnChanged( const std::filesystem::path& file );
+
+private:
+    std::filesystem::path Directory;
+    std::thread           Watcher;
+    std::atomic<bool>     Running = false;
+
+    std::mutex Mutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> Pending;
+};
+
+#endif
@@ -0,0 +1,53 @@
+// Engine/Core/Hash.h
+
+#ifndef __core_hash_h_included__
+#define __core_hash_h_included__
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "Common.h"
+
+// 64-bit FNV-1a. Not cryptographic, meant for cache keys and lookup tables. Hashes can be chained by
+// passing the previous result as the seed.
+struct Hash
+{
+    static constexpr uint64 FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr uint64 FNV_PRIME = 0x100000001b3ull;
+
+    static constexpr uint64 Bytes( std::span<const char> data, uint64 seed = FNV_OFFSET_BASIS )
+    {
+        uint64 hash = seed;
+        for ( const char byte : data )
+        {
+            hash ^= static_cast< uint8 >( byte );
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static constexpr uint64 String( std::string_view string, uint64 seed = FNV_OFFSET_BASIS )
+    {
+        return Bytes( std::span<const char>( string.data(), string.size() ), seed );
+    }
+
+    // 16 lowercase hex digits
+    static std::string ToHex( uint64 hash )
+    {
+        constexpr std::string_view digits = "0123456789abcdef";
+
+        std::string hex( 16, '0' );
+        for ( int32 i = 15; i >= 0; --i )
+        {
+            hex[i] = digits[hash & 0xf];
+            hash >>= 4;
+        }
+        return hex;
+    }
+};
+
+static_assert( Hash::String( "" ) == Hash::FNV_OFFSET_BASIS );
+static_assert( Hash::String( "a" ) == 0xaf63dc4c8601ec8cull );
+
+#endif
@@ -0,0 +1,312 @@
+#include "Log.h"
+
+#include <array>
+#include <memory>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    constexpr uint32 RECORD_COUNT = 2048;
+    constexpr uint32 DEFAULT_RATE_LIMIT = 128;
+    constexpr std::chrono::milliseconds IDLE_SLEEP( 1 );
+    constexpr std::chrono::milliseconds RATE_LIMIT_WINDOW( 1000 );
+    constexpr std::chrono::milliseconds DROP_REPORT_INTERVAL( 1000 );
+
+    static_assert( ( RECORD_COUNT & ( RECORD_COUNT - 1 ) ) == 0, "Record count must be a power of two." );
+
+    const char* GetCategoryName( LogCategory category )
+    {
+        switch ( category )
+        {
+            case LogCategory::General: return "General";
+            case LogCategory::Vulkan: return "Vulkan";
+            case LogCategory::Renderer: return "Renderer";
+            default: return "Unknown";
+        }
+    }
+
+    spdlog::level::level_enum ToSpdlogLevel( LogLevel level )
+    {
+        switch ( level )
+        {
+            case LogLevel::Trace: return spdlog::level::trace;
+            case LogLevel::Debug: return spdlog::level::debug;
+            case LogLevel::Info: return spdlog::level::info;
+            case LogLevel::Warn: return spdlog::level::warn;
+            case LogLevel::Error: return spdlog::level::err;
+            default: return spdlog::level::critical;
+        }
+    }
+
+    // fixed windows, cheap enough to check on every call
+    struct RateLimit
+    {
+        std::atomic<int64>  WindowStart = 0;
+        std::atomic<uint32> Count = 0;
+        std::atomic<uint32> Limit = DEFAULT_RATE_LIMIT;
+        std::atomic<uint32> Dropped = 0;
+
+        bool Admit( int64 now_ms )
+        {
+            int64 window_start = WindowStart.load( std::memory_order_relaxed );
+            if ( now_ms - window_start >= RATE_LIMIT_WINDOW.count() &&
+                WindowStart.compare_exchange_strong( window_start, now_ms, std::memory_order_relaxed ) )
+            {
+                Count.store( 0, std::memory_order_relaxed );
+            }
+
+            if ( Count.fetch_add( 1, std::memory_order_relaxed ) >= Limit.load( std::memory_order_relaxed ) )
+            {
+                Dropped.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            return true;
+        }
+    };
+
+    // Bounded MPSC queue. Every record carries a sequence number: a producer may claim the record when
+    // the sequence equals its position, the writer may read it once the producer published position + 1.
+    class AsyncLogger
+    {
+    public:
+        AsyncLogger()
+            : Records( std::make_unique<Log::Detail::Record[]>( RECORD_COUNT ) )
+        {
+            for ( uint32 i = 0; i < RECORD_COUNT; ++i )
+            {
+                Records[i].Sequence.store( i, std::memory_order_relaxed );
+            }
+
+            // the writer filters nothing, levels are checked before a record is claimed
+            spdlog::default_logger()->set_level( spdlog::level::trace );
+            Writer = std::thread( &AsyncLogger::Run, this );
+        }
+
+        ~AsyncLogger()
+        {
+            Running.store( false, std::memory_order_release );
+            Writer.join();
+        }
+
+        Log::Detail::Record* Claim( LogLevel level, LogCategory category )
+        {
+            if ( static_cast< uint8 >( level ) < Level.load( std::memory_order_relaxed ) )
+            {
+                return nullptr;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const int64 now_ms = std::chrono::duration_cast< std::chrono::milliseconds >( now.time_since_epoch() ).count();
+            if ( !RateLimits[static_cast< size_t >( category )].Admit( now_ms ) )
+            {
+                return nullptr;
+            }
+
+            uint64 position = EnqueuePosition.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                Log::Detail::Record& record = Records[position & ( RECORD_COUNT - 1 )];
+                const uint64 sequence = record.Sequence.load( std::memory_order_acquire );
+                const int64 difference = static_cast< int64 >( sequence ) - static_cast< int64 >( position );
+                if ( difference == 0 )
+                {
+                    if ( EnqueuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                    {
+                        record.Time = std::chrono::system_clock::now();
+                        record.Level = level;
+                        record.Category = category;
+                        return &record;
+                    }
+                }
+                else if ( difference < 0 )
+                {
+                    // the writer is a full ring behind
+                    RingDropped.fetch_add( 1, std::memory_order_relaxed );
+                    return nullptr;
+                }
+                else
+                {
+                    position = EnqueuePosition.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+        void Publish( Log::Detail::Record* record )
+        {
+            const uint64 position = record->Sequence.load( std::memory_order_relaxed );
+            record->Sequence.store( position + 1, std::memory_order_release );
+        }
+
+        void SetLevel( LogLevel level )
+        {
+            Level.store( static_cast< uint8 >( level ), std::memory_order_relaxed );
+        }
+
+        void SetRateLimit( LogCategory category, uint32 messages_per_second )
+        {
+            RateLimits[static_cast< size_t >( category )].Limit.store( messages_per_second, std::memory_order_relaxed );
+        }
+
+        void Flush()
+        {
+            const uint64 target = EnqueuePosition.load( std::memory_order_acquire );
+            while ( DequeuePosition.load( std::memory_order_acquire ) < target )
+            {
+                std::this_thread::yield();
+            }
+            spdlog::default_logger()->flush();
+        }
+
+    private:
+        void Run()
+        {
+            auto last_report = std::chrono::steady_clock::now();
+            while ( Running.load( std::memory_order_acquire ) )
+            {
+                if ( !Drain() )
+                {
+                    std::this_thread::sleep_for( IDLE_SLEEP );
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                if ( now - last_report >= DROP_REPORT_INTERVAL )
+                {
+                    ReportDrops();
+                    last_report = now;
+                }
+            }
+
+            Drain();
+            ReportDrops();
+            spdlog::default_logger()->flush();
+        }
+
+        // true when at least one record was written
+        bool Drain()
+        {
+            spdlog::logger* logger = spdlog::default_logger_raw();
+
+            bool written = false;
+            uint64 position = DequeuePosition.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                Log::Detail::Record& record = Records[position & ( RECORD_COUNT - 1 )];
+                if ( record.Sequence.load( std::memory_order_acquire ) != position + 1 )
+                {
+                    break;
+                }
+
+                Message.clear();
+                const std::string_view format( record.FormatData, record.FormatSize );
+                try
+                {
+                    record.Format( format, record.Payload, Message );
+                }
+                catch ( const std::format_error& error )
+                {
+                    Message = std::format( "{} [format error: {}]", format, error.what() );
+                }
+
+                const spdlog::source_loc location = {};
+                logger->log( record.Time, location, ToSpdlogLevel( record.Level ), Message );
+
+                record.Sequence.store( position + RECORD_COUNT, std::memory_order_release );
+                DequeuePosition.store( ++position, std::memory_order_release );
+                written = true;
+            }
+            return written;
+        }
+
+        void ReportDrops()
+        {
+            spdlog::logger* logger = spdlog::default_logger_raw();
+            for ( size_t i = 0; i < RateLimits.size(); ++i )
+            {
+                const uint32 dropped = RateLimits[i].Dropped.exchange( 0, std::memory_order_relaxed );
+                if ( dropped > 0 )
+                {
+                    logger->warn( "[Log] {} messages of category {} were over the rate limit and dropped.", dropped,
+                        GetCategoryName( static_cast< LogCategory >( i ) ) );
+                }
+            }
+
+            const uint32 ring_dropped = RingDropped.exchange( 0, std::memory_order_relaxed );
+            if ( ring_dropped > 0 )
+            {
+                logger->warn( "[Log] {} messages were dropped, the log queue was full.", ring_dropped );
+            }
+        }
+
+    private:
+        std::unique_ptr<Log::Detail::Record[]> Records;
+
+        alignas( 64 ) std::atomic<uint64> EnqueuePosition = 0;
+        alignas( 64 ) std::atomic<uint64> DequeuePosition = 0;
+
+        std::array<RateLimit, static_cast< size_t >( LogCategory::Count )> RateLimits;
+        std::atomic<uint32> RingDropped = 0;
+        std::atomic<uint8>  Level = LOG_ACTIVE_LEVEL;
+        std::atomic<bool>   Running = true;
+
+        std::string Message;
+        std::thread Writer;
+    };
+
+    AsyncLogger& GetLogger()
+    {
+        static AsyncLogger logger;
+        return logger;
+    }
+}
+
+namespace Log
+{
+    namespace Detail
+    {
+        Record* Claim( LogLevel level, LogCategory category )
+        {
+            return GetLogger().Claim( level, category );
+        }
+
+        void Publish( Record* record )
+        {
+            GetLogger().Publish( record );
+        }
+    }
+
+    void SetLevel( LogLevel level )
+    {
+        GetLogger().SetLevel( level );
+    }
+
+    void SetRateLimit( LogCategory category, uint32 messages_per_second )
+    {
+        GetLogger().SetRateLimit( category, messages_per_second );
+    }
+
+    void Flush()
+    {
+        GetLogger().Flush();
+    }
+
+    void Write( LogLevel level, LogCategory category, std::string_view message )
+    {
+        Detail::Record* record = Detail::Claim( level, category );
+        if ( !record )
+        {
+            return;
+        }
+
+        static constexpr std::string_view format = "{}";
+        record->Format = &Detail::FormatRecord<std::string_view>;
+        record->FormatData = format.data();
+        record->FormatSize = static_cast< uint32 >( format.size() );
+
+        Detail::ArgumentWriter writer( record->Payload, Detail::FixedSize<std::string_view>() );
+        writer.Write( message );
+
+        Detail::Publish( record );
+    }
+}
@@ -2,95 +2,300 @@
 #ifndef __log_h_included__
 #define __log_h_included__
 
+#include <bit>
+#include <array>
+#include <tuple>
+#include <atomic>
+#include <chrono>
 #include <format>
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
 
 #include <SDL3/SDL_log.h>
-#include <spdlog/spdlog.h>
 
-#include <spdlog/fmt/bundled/format.h>
+#include "Common.h"
 
-#define LOG_INFO(...)       spdlog::info( __VA_ARGS__ )
-#define LOG_ERROR(...)      spdlog::error( __VA_ARGS__ )
+// Logging never blocks the caller. A call claims a record in a lock-free ring, copies its arguments
+// into the record as raw bytes and returns. A writer thread formats the records and hands them to
+// spdlog. When the ring is full or a category exceeds its rate limit the message is dropped, the
+// writer reports how many were lost.
+//
+// Levels below LOG_ACTIVE_LEVEL are removed at compile time, the macros expand to nothing.
 
-#ifdef VULKAN_SUPPORTED 
-#include <vulkan/vulkan.h>
+#define LOG_LEVEL_TRACE     0
+#define LOG_LEVEL_DEBUG     1
+#define LOG_LEVEL_INFO      2
+#define LOG_LEVEL_WARN      3
+#define LOG_LEVEL_ERROR     4
+#define LOG_LEVEL_CRITICAL  5
 
-template<>
-struct fmt::formatter<VkResult> : fmt::formatter<std::string>
+#ifndef LOG_ACTIVE_LEVEL
+#   ifdef DEBUG
+#       define LOG_ACTIVE_LEVEL LOG_LEVEL_TRACE
+#   else
+#       define LOG_ACTIVE_LEVEL LOG_LEVEL_INFO
+#   endif
+#endif
+
+enum class LogLevel : uint8
+{
+    Trace = LOG_LEVEL_TRACE,
+    Debug = LOG_LEVEL_DEBUG,
+    Info = LOG_LEVEL_INFO,
+    Warn = LOG_LEVEL_WARN,
+    Error = LOG_LEVEL_ERROR,
+    Critical = LOG_LEVEL_CRITICAL
+};
+
+// rate limits are tracked per category
+enum class LogCategory : uint8
+{
+    General,
+    Vulkan,
+    Renderer,
+    Count
+};
+
+namespace Log
 {
-    auto format( VkResult result, auto& ctx ) const
+    // Trivially copyable types that never point at transient memory may opt in to be copied into the
+    // record as they are and formatted on the writer, instead of being formatted on the calling thread.
+    template<typename Type>
+    struct ByValue : std::false_type {};
+
+    namespace Detail
     {
-        std::string str;
-        switch ( result )
+        using FormatFunction = void ( * )( std::string_view format, const std::byte* payload, std::string& out );
+
+        static constexpr size_t RECORD_SIZE = 512;
+
+        struct RecordHeader
         {
-            case VK_SUCCESS: str = "VK_SUCCESS"; break;
-            case VK_NOT_READY: str = "VK_NOT_READY"; break;
-            case VK_TIMEOUT: str = "VK_TIMEOUT"; break;
-            case VK_EVENT_SET: str = "VK_EVENT_SET"; break;
-            case VK_EVENT_RESET: str = "VK_EVENT_RESET"; break;
-            case VK_INCOMPLETE: str = "VK_INCOMPLETE"; break;
-            case VK_ERROR_OUT_OF_HOST_MEMORY: str = "VK_ERROR_OUT_OF_HOST_MEMORY"; break;
-            case VK_ERROR_OUT_OF_DEVICE_MEMORY: str = "VK_ERROR_OUT_OF_DEVICE_MEMORY"; break;
-            case VK_ERROR_INITIALIZATION_FAILED: str = "VK_ERROR_INITIALIZATION_FAILED"; break;
-            case VK_ERROR_DEVICE_LOST: str = "VK_ERROR_DEVICE_LOST"; break;
-            case VK_ERROR_MEMORY_MAP_FAILED: str = "VK_ERROR_MEMORY_MAP_FAILED"; break;
-            case VK_ERROR_LAYER_NOT_PRESENT: str = "VK_ERROR_LAYER_NOT_PRESENT"; break;
-            case VK_ERROR_EXTENSION_NOT_PRESENT: str = "VK_ERROR_EXTENSION_NOT_PRESENT"; break;
-            case VK_ERROR_FEATURE_NOT_PRESENT: str = "VK_ERROR_FEATURE_NOT_PRESENT"; break;
-            case VK_ERROR_INCOMPATIBLE_DRIVER: str = "VK_ERROR_INCOMPATIBLE_DRIVER"; break;
-            case VK_ERROR_TOO_MANY_OBJECTS: str = "VK_ERROR_TOO_MANY_OBJECTS"; break;
-            case VK_ERROR_FORMAT_NOT_SUPPORTED: str = "VK_ERROR_FORMAT_NOT_SUPPORTED"; break;
-            case VK_ERROR_SURFACE_LOST_KHR: str = "VK_ERROR_SURFACE_LOST_KHR"; break;
-            case VK_SUBOPTIMAL_KHR: str = "VK_SUBOPTIMAL_KHR"; break;
-            case VK_ERROR_OUT_OF_DATE_KHR: str = "VK_ERROR_OUT_OF_DATE_KHR"; break;
-            case VK_ERROR_INCOMPATIBLE_DISPLAY_KHR: str = "VK_ERROR_INCOMPATIBLE_DRIVER"; break;
-            case VK_ERROR_NATIVE_WINDOW_IN_USE_KHR: str = "VK_ERROR_NATIVE_WINDOW_IN_USE_KHR"; break;
-            case VK_ERROR_VALIDATION_FAILED_EXT: str = "VK_ERROR_VALIDATION_FAILED_EXT"; break;
-            default: str = "UNKNOWN_VKRESULT(" + std::to_string( static_cast< int >( result ) ) + ")";
+            std::atomic<uint64> Sequence;
+            std::chrono::system_clock::time_point Time;
+            FormatFunction Format;
+            const char*    FormatData;
+            uint32         FormatSize;
+            LogLevel       Level;
+            LogCategory    Category;
+        };
+
+        static constexpr size_t PAYLOAD_SIZE = RECORD_SIZE - ( ( sizeof( RecordHeader ) + 15 ) & ~size_t( 15 ) );
+
+        struct alignas( 64 ) Record : RecordHeader
+        {
+            alignas( 16 ) std::byte Payload[PAYLOAD_SIZE];
+        };
+
+        static_assert( sizeof( Record ) == RECORD_SIZE );
+
+        // nullptr when the message is filtered, rate limited or the ring is full
+        Record* Claim( LogLevel level, LogCategory category );
+        void    Publish( Record* record );
+
+        // Strings are copied, the pointer may not outlive the call. Arithmetic values and enums are
+        // copied as they are, anything else is formatted on the calling thread.
+        template<typename Type>
+        concept StringArgument = std::is_convertible_v<const Type&, std::string_view>;
+
+        template<typename Type>
+        concept ValueArgument = !StringArgument<Type> &&
+            ( std::is_arithmetic_v<Type> || std::is_enum_v<Type> || std::is_pointer_v<Type> ||
+                ( ByValue<Type>::value && std::is_trivially_copyable_v<Type> ) );
+
+        template<typename Type>
+        using Stored = std::conditional_t<ValueArgument<Type>, Type, std::string_view>;
+
+        template<typename Type>
+        constexpr size_t FixedSize()
+        {
+            if constexpr ( ValueArgument<Type> )
+            {
+                return sizeof( Type );
+            }
+            else
+            {
+                return sizeof( uint32 );
+            }
+        }
+
+        class ArgumentWriter
+        {
+        public:
+            ArgumentWriter( std::byte* data, size_t reserved ) : Data( data ), Reserved( reserved ) {}
+
+            template<typename Type>
+            void Write( const Type& value )
+            {
+                if constexpr ( ValueArgument<Type> )
+                {
+                    Reserved -= sizeof( Type );
+                    std::memcpy( Data + Used, &value, sizeof( Type ) );
+                    Used += sizeof( Type );
+                }
+                else if constexpr ( StringArgument<Type> )
+                {
+                    WriteString( std::string_view( value ) );
+                }
+                else
+                {
+                    WriteFormatted( value );
+                }
+            }
+
+        private:
+            // long strings are cut so that the arguments after them still fit
+            void WriteString( std::string_view string )
+            {
+                Reserved -= sizeof( uint32 );
+                const size_t available = PAYLOAD_SIZE - Used - Reserved - sizeof( uint32 );
+                const uint32 length = static_cast< uint32 >( std::min( string.size(), available ) );
+
+                std::memcpy( Data + Used, &length, sizeof( length ) );
+                std::memcpy( Data + Used + sizeof( length ), string.data(), length );
+                Used += sizeof( length ) + length;
+            }
+
+            // formatted straight into the record, no temporary string on the calling thread
+            template<typename Type>
+            void WriteFormatted( const Type& value )
+            {
+                Reserved -= sizeof( uint32 );
+                const size_t available = PAYLOAD_SIZE - Used - Reserved - sizeof( uint32 );
+                char* text = reinterpret_cast< char* >( Data + Used + sizeof( uint32 ) );
+                const auto result = std::format_to_n( text, static_cast< std::ptrdiff_t >( available ), "{}",
+                    value );
+                const uint32 length = static_cast< uint32 >( result.out - text );
+
+                std::memcpy( Data + Used, &length, sizeof( length ) );
+                Used += sizeof( length ) + length;
+            }
+
+        private:
+            std::byte* Data;
+            size_t     Used = 0;
+            size_t     Reserved;
+        };
+
+        class ArgumentReader
+        {
+        public:
+            explicit ArgumentReader( const std::byte* data ) : Data( data ) {}
+
+            template<typename Type>
+            Type Read()
+            {
+                if constexpr ( std::is_same_v<Type, std::string_view> )
+                {
+                    uint32 length = 0;
+                    std::memcpy( &length, Data, sizeof( length ) );
+                    const std::string_view string( reinterpret_cast< const char* >( Data + sizeof( length ) ), length );
+                    Data += sizeof( length ) + length;
+                    return string;
+                }
+                else
+                {
+                    // bit_cast does not need Type to be default constructible
+                    std::array<std::byte, sizeof( Type )> bytes;
+                    std::memcpy( bytes.data(), Data, sizeof( Type ) );
+                    Data += sizeof( Type );
+                    return std::bit_cast< Type >( bytes );
+                }
+            }
+
+        private:
+            const std::byte* Data;
+        };
+
+        template<typename... Types>
+        void FormatRecord( std::string_view format, const std::byte* payload, std::string& out )
+        {
+            ArgumentReader reader( payload );
+            // braced initialization reads the arguments in order
+            std::tuple<Types...> values{ reader.Read<Types>()... };
+            std::apply( [&] ( auto&... arguments ) {
+                std::vformat_to( std::back_inserter( out ), format, std::make_format_args( arguments... ) );
+            }, values );
         }
-        return fmt::formatter<std::string>::format( str, ctx );
     }
-};
 
-template<>
-struct std::formatter<VkResult> : std::formatter<std::string>
-{
-    auto format( VkResult result, auto& ctx ) const
+    void SetLevel( LogLevel level );
+
+    // messages per second a category may log before the rest of that second is dropped
+    void SetRateLimit( LogCategory category, uint32 messages_per_second );
+
+    // blocks until everything logged so far was written
+    void Flush();
+
+    template<typename... Args>
+    void Write( LogLevel level, LogCategory category, std::format_string<Args...> format, Args&&... args )
     {
-        std::string str;
-        switch ( result )
+        constexpr size_t fixed_size = ( Detail::FixedSize<std::remove_cvref_t<Args>>() + ... + 0 );
+        static_assert( fixed_size <= Detail::PAYLOAD_SIZE, "Too many log arguments." );
+
+        Detail::Record* record = Detail::Claim( level, category );
+        if ( !record )
         {
-            case VK_SUCCESS: str = "VK_SUCCESS"; break;
-            case VK_NOT_READY: str = "VK_NOT_READY"; break;
-            case VK_TIMEOUT: str = "VK_TIMEOUT"; break;
-            case VK_EVENT_SET: str = "VK_EVENT_SET"; break;
-            case VK_EVENT_RESET: str = "VK_EVENT_RESET"; break;
-            case VK_INCOMPLETE: str = "VK_INCOMPLETE"; break;
-            case VK_ERROR_OUT_OF_HOST_MEMORY: str = "VK_ERROR_OUT_OF_HOST_MEMORY"; break;
-            case VK_ERROR_OUT_OF_DEVICE_MEMORY: str = "VK_ERROR_OUT_OF_DEVICE_MEMORY"; break;
-            case VK_ERROR_INITIALIZATION_FAILED: str = "VK_ERROR_INITIALIZATION_FAILED"; break;
-            case VK_ERROR_DEVICE_LOST: str = "VK_ERROR_DEVICE_LOST"; break;
-            case VK_ERROR_MEMORY_MAP_FAILED: str = "VK_ERROR_MEMORY_MAP_FAILED"; break;
-            case VK_ERROR_LAYER_NOT_PRESENT: str = "VK_ERROR_LAYER_NOT_PRESENT"; break;
-            case VK_ERROR_EXTENSION_NOT_PRESENT: str = "VK_ERROR_EXTENSION_NOT_PRESENT"; break;
-            case VK_ERROR_FEATURE_NOT_PRESENT: str = "VK_ERROR_FEATURE_NOT_PRESENT"; break;
-            case VK_ERROR_INCOMPATIBLE_DRIVER: str = "VK_ERROR_INCOMPATIBLE_DRIVER"; break;
-            case VK_ERROR_TOO_MANY_OBJECTS: str = "VK_ERROR_TOO_MANY_OBJECTS"; break;
-            case VK_ERROR_FORMAT_NOT_SUPPORTED: str = "VK_ERROR_FORMAT_NOT_SUPPORTED"; break;
-            case VK_ERROR_SURFACE_LOST_KHR: str = "VK_ERROR_SURFACE_LOST_KHR"; break;
-            case VK_SUBOPTIMAL_KHR: str = "VK_SUBOPTIMAL_KHR"; break;
-            case VK_ERROR_OUT_OF_DATE_KHR: str = "VK_ERROR_OUT_OF_DATE_KHR"; break;
-            case VK_ERROR_INCOMPATIBLE_DISPLAY_KHR: str = "VK_ERROR_INCOMPATIBLE_DRIVER"; break;
-            case VK_ERROR_NATIVE_WINDOW_IN_USE_KHR: str = "VK_ERROR_NATIVE_WINDOW_IN_USE_KHR"; break;
-            case VK_ERROR_VALIDATION_FAILED_EXT: str = "VK_ERROR_VALIDATION_FAILED_EXT"; break;
-            default: str = "UNKNOWN_VKRESULT(" + std::to_string( static_cast< int >( result ) ) + ")";
+            return;
         }
-        return std::formatter<std::string>::format( str, ctx );
+
+        const std::string_view format_string = format.get();
+        record->Format = &Detail::FormatRecord<Detail::Stored<std::remove_cvref_t<Args>>...>;
+        record->FormatData = format_string.data();
+        record->FormatSize = static_cast< uint32 >( format_string.size() );
+
+        Detail::ArgumentWriter writer( record->Payload, fixed_size );
+        ( writer.Write( static_cast< const std::remove_cvref_t<Args>& >( args ) ), ... );
+
+        Detail::Publish( record );
     }
-};
 
-#endif // VULKAN_SUPPORTED
+    // a message that is not a format string, e.g. an error returned by a callee
+    void Write( LogLevel level, LogCategory category, std::string_view message );
+}
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_TRACE
+#   define LOG_TRACE_CAT( category, ... )    Log::Write( LogLevel::Trace, category, __VA_ARGS__ )
+#else
+#   define LOG_TRACE_CAT( category, ... )    ( void ) 0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_DEBUG
+#   define LOG_DEBUG_CAT( category, ... )    Log::Write( LogLevel::Debug, category, __VA_ARGS__ )
+#else
+#   define LOG_DEBUG_CAT( category, ... )    ( void ) 0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_INFO
+#   define LOG_INFO_CAT( category, ... )     Log::Write( LogLevel::Info, category, __VA_ARGS__ )
+#else
+#   define LOG_INFO_CAT( category, ... )     ( void ) 0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_WARN
+#   define LOG_WARN_CAT( category, ... )     Log::Write( LogLevel::Warn, category, __VA_ARGS__ )
+#else
+#   define LOG_WARN_CAT( category, ... )     ( void ) 0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_ERROR
+#   define LOG_ERROR_CAT( category, ... )    Log::Write( LogLevel::Error, category, __VA_ARGS__ )
+#else
+#   define LOG_ERROR_CAT( category, ... )    ( void ) 0
+#endif
+
+#define LOG_CRITICAL_CAT( category, ... )    Log::Write( LogLevel::Critical, category, __VA_ARGS__ )
+
+#define LOG_TRACE(...)      LOG_TRACE_CAT( LogCategory::General, __VA_ARGS__ )
+#define LOG_DEBUG(...)      LOG_DEBUG_CAT( LogCategory::General, __VA_ARGS__ )
+#define LOG_INFO(...)       LOG_INFO_CAT( LogCategory::General, __VA_ARGS__ )
+#define LOG_WARN(...)       LOG_WARN_CAT( LogCategory::General, __VA_ARGS__ )
+#define LOG_ERROR(...)      LOG_ERROR_CAT( LogCategory::General, __VA_ARGS__ )
+#define LOG_CRITICAL(...)   LOG_CRITICAL_CAT( LogCategory::General, __VA_ARGS__ )
+
 
 #endif 
 
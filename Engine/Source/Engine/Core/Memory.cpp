@@ -0,0 +1,281 @@
+#include "Memory.h"
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+
+#include "Assert.h"
+#include "Log.h"
+
+namespace
+{
+    constexpr size_t SCRATCH_BLOCK_SIZE = 256 * 1024;
+    constexpr uint32 TAG_COUNT = static_cast< uint32 >( MemoryTag::Count );
+
+    // Forwards to the global heap and counts what is held, the counters are the only shared state.
+    class TrackedResource : public std::pmr::memory_resource
+    {
+    public:
+        MemoryTagStats GetStats() const
+        {
+            MemoryTagStats stats;
+            stats.CurrentBytes = CurrentBytes.load( std::memory_order_relaxed );
+            stats.PeakBytes = PeakBytes.load( std::memory_order_relaxed );
+            stats.Allocations = Allocations.load( std::memory_order_relaxed );
+            stats.Budget = Budget.load( std::memory_order_relaxed );
+            return stats;
+        }
+
+        void Init( MemoryTag tag )
+        {
+            Tag = tag;
+        }
+
+        void SetBudget( uint64 bytes )
+        {
+            Budget.store( bytes, std::memory_order_relaxed );
+        }
+
+    protected:
+        void* do_allocate( size_t bytes, size_t alignment ) override
+        {
+            void* pointer = std::pmr::new_delete_resource()->allocate( bytes, alignment );
+
+            const uint64 current = CurrentBytes.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+            uint64 peak = PeakBytes.load( std::memory_order_relaxed );
+            while ( current > peak && !PeakBytes.compare_exchange_weak( peak, current, std::memory_order_relaxed ) )
+            {
+            }
+            Allocations.fetch_add( 1, std::memory_order_relaxed );
+
+            // only the allocation that crosses the budget warns, logging never allocates
+            const uint64 budget = Budget.load( std::memory_order_relaxed );
+            if ( budget != 0 && current > budget && current - bytes <= budget )
+            {
+                LOG_WARN( "[Memory] {} is over its budget, {} of {} bytes held.", Memory::GetTagName( Tag ),
+                    current, budget );
+            }
+            return pointer;
+        }
+
+        void do_deallocate( void* pointer, size_t bytes, size_t alignment ) override
+        {
+            CurrentBytes.fetch_sub( bytes, std::memory_order_relaxed );
+            std::pmr::new_delete_resource()->deallocate( pointer, bytes, alignment );
+        }
+
+        bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override
+        {
+            return this == &other;
+        }
+
+    private:
+        std::atomic<uint64> CurrentBytes = 0;
+        std::atomic<uint64> PeakBytes = 0;
+        std::atomic<uint64> Allocations = 0;
+        std::atomic<uint64> Budget = 0;
+        MemoryTag           Tag = MemoryTag::General;
+    };
+
+    std::array<TrackedResource, TAG_COUNT>& GetTrackedResources()
+    {
+        // never destroyed, allocators in other statics may release memory after this would be gone
+        static auto* resources = [] {
+            auto* tracked = new std::array<TrackedResource, TAG_COUNT>();
+            for ( uint32 i = 0; i < TAG_COUNT; ++i )
+            {
+                ( *tracked )[i].Init( static_cast< MemoryTag >( i ) );
+            }
+            return tracked;
+        }();
+        return *resources;
+    }
+
+    struct ScratchArena
+    {
+        LinearAllocator Allocator{ SCRATCH_BLOCK_SIZE, MemoryTag::Scratch };
+        // open scopes on the thread, the outermost one finds the arena empty
+        uint32          Depth = 0;
+    };
+
+    ScratchArena& GetScratchArena()
+    {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    uintptr_t AlignUp( uintptr_t value, size_t alignment )
+    {
+        return ( value + alignment - 1 ) & ~static_cast< uintptr_t >( alignment - 1 );
+    }
+}
+
+namespace Memory
+{
+    std::pmr::memory_resource* GetResource( MemoryTag tag )
+    {
+        return &GetTrackedResources()[static_cast< uint32 >( tag )];
+    }
+
+    MemoryTagStats GetStats( MemoryTag tag )
+    {
+        return GetTrackedResources()[static_cast< uint32 >( tag )].GetStats();
+    }
+
+    const char* GetTagName( MemoryTag tag )
+    {
+        switch ( tag )
+        {
+            case MemoryTag::General: return "General";
+            case MemoryTag::Frame: return "Frame";
+            case MemoryTag::Scratch: return "Scratch";
+            case MemoryTag::Renderer: return "Renderer";
+            case MemoryTag::Scene: return "Scene";
+            case MemoryTag::Vulkan: return "Vulkan";
+            default: return "Unknown";
+        }
+    }
+
+    void SetBudget( MemoryTag tag, uint64 bytes )
+    {
+        GetTrackedResources()[static_cast< uint32 >( tag )].SetBudget( bytes );
+    }
+
+    void Report()
+    {
+        constexpr double KIB = 1024.0;
+        for ( uint32 i = 0; i < TAG_COUNT; ++i )
+        {
+            const MemoryTag tag = static_cast< MemoryTag >( i );
+            const MemoryTagStats stats = GetStats( tag );
+            if ( stats.Allocations == 0 )
+            {
+                continue;
+            }
+            LOG_INFO( "[Memory] {:<8} {:>10.1f} KiB held, {:>10.1f} KiB peak, {} allocations.", GetTagName( tag ),
+                stats.CurrentBytes / KIB, stats.PeakBytes / KIB, stats.Allocations );
+        }
+    }
+}
+
+LinearAllocator::LinearAllocator( size_t block_size, MemoryTag tag ) :
+    Upstream( Memory::GetResource( tag ) ),
+    BlockSize( block_size )
+{
+    First = AllocateBlock( BlockSize, nullptr );
+    Current = First;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    while ( Current )
+    {
+        Block* previous = Current->Previous;
+        FreeBlock( Current );
+        Current = previous;
+    }
+}
+
+void* LinearAllocator::Allocate( size_t size, size_t alignment )
+{
+    ASSERT( ( alignment & ( alignment - 1 ) ) == 0 );
+
+    uintptr_t data = reinterpret_cast< uintptr_t >( GetData( Current ) );
+    uintptr_t address = AlignUp( data + Offset, alignment );
+    if ( address + size > data + Current->Size )
+    {
+        // the new block has room for the request at any alignment
+        ChainUsed += Current->Size;
+        Current = AllocateBlock( std::max( BlockSize, size + alignment ), Current );
+
+        data = reinterpret_cast< uintptr_t >( GetData( Current ) );
+        address = AlignUp( data, alignment );
+    }
+
+    Offset = address + size - data;
+    return reinterpret_cast< void* >( address );
+}
+
+LinearAllocator::Marker LinearAllocator::GetMarker() const
+{
+    return { Current, Offset, ChainUsed };
+}
+
+void LinearAllocator::Rewind( const Marker& marker )
+{
+    Peak = std::max( Peak, GetUsed() );
+    while ( Current != marker.Block )
+    {
+        ASSERT( Current != First );
+        Block* previous = Current->Previous;
+        FreeBlock( Current );
+        Current = previous;
+    }
+    Offset = marker.Offset;
+    ChainUsed = marker.ChainUsed;
+}
+
+void LinearAllocator::Reset()
+{
+    Rewind( { First, 0, 0 } );
+
+    // one block sized for the peak replaces the chain, only here since markers may still point at the first block
+    if ( First->Size < Peak )
+    {
+        FreeBlock( First );
+        First = AllocateBlock( Peak, nullptr );
+        Current = First;
+    }
+}
+
+void* LinearAllocator::do_allocate( size_t bytes, size_t alignment )
+{
+    return Allocate( bytes, alignment );
+}
+
+void LinearAllocator::do_deallocate( void*, size_t, size_t )
+{
+}
+
+bool LinearAllocator::do_is_equal( const std::pmr::memory_resource& other ) const noexcept
+{
+    return this == &other;
+}
+
+LinearAllocator::Block* LinearAllocator::AllocateBlock( size_t size, Block* previous )
+{
+    void* memory = Upstream->allocate( sizeof( Block ) + size, alignof( Block ) );
+    Capacity += size;
+    return new ( memory ) Block{ previous, size };
+}
+
+void LinearAllocator::FreeBlock( Block* block )
+{
+    Capacity -= block->Size;
+    Upstream->deallocate( block, sizeof( Block ) + block->Size, alignof( Block ) );
+}
+
+FrameAllocator::FrameAllocator( size_t block_size ) :
+    Allocators{ LinearAllocator( block_size, MemoryTag::Frame ), LinearAllocator( block_size, MemoryTag::Frame ) }
+{
+}
+
+ScratchScope::ScratchScope() :
+    Arena( GetScratchArena().Allocator ),
+    Marker( Arena.GetMarker() )
+{
+    ++GetScratchArena().Depth;
+}
+
+ScratchScope::~ScratchScope()
+{
+    // outer scopes hold markers into the arena, only the outermost may let Reset replace its blocks
+    if ( --GetScratchArena().Depth == 0 )
+    {
+        Arena.Reset();
+    }
+    else
+    {
+        Arena.Rewind( Marker );
+    }
+}
@@ -0,0 +1,193 @@
+// Engine/Core/Memory.h
+
+#ifndef __core_memory_h_included__
+#define __core_memory_h_included__
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <memory_resource>
+
+#include "Common.h"
+
+// Subsystems memory is charged to. Allocators take their blocks from the resource of their tag, so the
+// report shows what each subsystem holds, arenas count with their whole capacity.
+enum class MemoryTag : uint8
+{
+    General,
+    Frame,
+    Scratch,
+    Renderer,
+    Scene,
+    // driver allocations through VkAllocationCallbacks
+    Vulkan,
+    Count
+};
+
+struct MemoryTagStats
+{
+    uint64 CurrentBytes = 0;
+    uint64 PeakBytes = 0;
+    // since launch
+    uint64 Allocations = 0;
+    // zero when the tag has none
+    uint64 Budget = 0;
+};
+
+namespace Memory
+{
+    // The global heap, counted per tag. Thread safe, usable as the resource of any std::pmr container.
+    std::pmr::memory_resource* GetResource( MemoryTag tag );
+
+    MemoryTagStats GetStats( MemoryTag tag );
+    const char*    GetTagName( MemoryTag tag );
+
+    // A warning is logged whenever the tag's held bytes grow past the budget. Zero removes it.
+    void SetBudget( MemoryTag tag, uint64 bytes );
+
+    // one log line per tag that ever allocated
+    void Report();
+}
+
+// Bump allocator over a chain of blocks. An allocation moves an offset, frees do nothing and memory is
+// released all at once by Reset or Rewind. A request that does not fit the current block starts a new
+// one; Reset replaces the chain by a single block as large as the peak, so a steady workload settles on
+// one block and stops touching the heap. Not thread safe.
+class LinearAllocator : public std::pmr::memory_resource
+{
+public:
+    struct Marker
+    {
+        const void* Block = nullptr;
+        size_t      Offset = 0;
+        size_t      ChainUsed = 0;
+    };
+
+    LinearAllocator( size_t block_size, MemoryTag tag );
+    ~LinearAllocator() override;
+
+    LinearAllocator( const LinearAllocator& ) = delete;
+    LinearAllocator& operator=( const LinearAllocator& ) = delete;
+
+    void* Allocate( size_t size, size_t alignment = alignof( std::max_align_t ) );
+
+    // uninitialized, nothing allocated here is ever destroyed
+    template<typename Type>
+    Type* AllocateArray( size_t count )
+    {
+        static_assert( std::is_trivially_destructible_v<Type> );
+        return static_cast< Type* >( Allocate( count * sizeof( Type ), alignof( Type ) ) );
+    }
+
+    Marker GetMarker() const;
+    // releases everything allocated after the marker was taken, the marker's block is kept
+    void Rewind( const Marker& marker );
+    // releases everything, markers taken before are no longer valid
+    void Reset();
+
+    // bytes handed out including alignment padding
+    size_t GetUsed() const
+    {
+        return ChainUsed + Offset;
+    }
+
+    size_t GetCapacity() const
+    {
+        return Capacity;
+    }
+
+protected:
+    void* do_allocate( size_t bytes, size_t alignment ) override;
+    void  do_deallocate( void* pointer, size_t bytes, size_t alignment ) override;
+    bool  do_is_equal( const std::pmr::memory_resource& other ) const noexcept override;
+
+private:
+    struct alignas( std::max_align_t ) Block
+    {
+        Block* Previous;
+        size_t Size;
+    };
+
+    Block* AllocateBlock( size_t size, Block* previous );
+    void   FreeBlock( Block* block );
+
+    static std::byte* GetData( Block* block )
+    {
+        return reinterpret_cast< std::byte* >( block + 1 );
+    }
+
+private:
+    std::pmr::memory_resource* Upstream;
+    size_t BlockSize;
+    Block* First = nullptr;
+    Block* Current = nullptr;
+    size_t Offset = 0;
+    // used bytes of the blocks before the current one, their unused tails included
+    size_t ChainUsed = 0;
+    size_t Capacity = 0;
+    size_t Peak = 0;
+};
+
+// Two linear allocators used on alternate frames. What a frame allocates stays valid through the next
+// one, so data handed from one frame to the following needs no copy. BeginFrame resets the allocator
+// used two frames ago. Meant for the render thread, workers use scratch scopes.
+class FrameAllocator
+{
+public:
+    explicit FrameAllocator( size_t block_size );
+
+    void BeginFrame()
+    {
+        Index ^= 1;
+        Allocators[Index].Reset();
+    }
+
+    LinearAllocator& Get()
+    {
+        return Allocators[Index];
+    }
+
+    std::pmr::memory_resource* GetResource()
+    {
+        return &Allocators[Index];
+    }
+
+    // bytes the current frame allocated so far
+    size_t GetUsed() const
+    {
+        return Allocators[Index].GetUsed();
+    }
+
+private:
+    std::array<LinearAllocator, 2> Allocators;
+    uint32 Index = 0;
+};
+
+// Marks the calling thread's scratch arena and gives back everything allocated through it when the
+// scope ends. Scopes nest, memory from an inner scope must not escape to an outer one.
+class ScratchScope
+{
+public:
+    ScratchScope();
+    ~ScratchScope();
+
+    ScratchScope( const ScratchScope& ) = delete;
+    ScratchScope& operator=( const ScratchScope& ) = delete;
+
+    template<typename Type>
+    Type* AllocateArray( size_t count )
+    {
+        return Arena.AllocateArray<Type>( count );
+    }
+
+    std::pmr::memory_resource* GetResource()
+    {
+        return &Arena;
+    }
+
+private:
+    LinearAllocator&        Arena;
+    LinearAllocator::Marker Marker;
+};
+
+#endif
@@ -15,6 +15,7 @@ struct WindowCreateInfo
     Vec2<uint32_t> Position;
     Vec2<uint32_t> Size;
     std::string    Title;
+    bool           VSync = true;
 };
 
 class WindowBase
@@ -23,6 +24,7 @@ public:
     virtual ~WindowBase() = default;
 
     virtual void OnUpdate() = 0;
+    virtual void OnResize( uint32_t width, uint32_t height ) = 0;
 
     virtual void* GetNativeWindow() const = 0;
 
@@ -3,7 +3,74 @@
 #ifndef __rhi_context_h_included__
 #define __rhi_context_h_included__
 
+#include <string>
+#include <filesystem>
+
 #include "Engine/Core/Common.h"
+#include "Engine/Renderer/RenderStats.h"
+
+// How finished frames are handed to the display. A mode the surface does not support falls back to
+// the closest one that is: Mailbox and Immediate to each other and then to Fifo, FifoRelaxed to Fifo.
+enum class PresentMode : uint8
+{
+	// vsync, never tears
+	Fifo,
+	// vsync, but a late frame is shown immediately and may tear
+	FifoRelaxed,
+	// no vsync wait, the newest frame replaces a queued one, never tears
+	Mailbox,
+	// no vsync wait, tears
+	Immediate
+};
+
+struct PresentSettings
+{
+	PresentMode Mode = PresentMode::Fifo;
+	// swapchain images to ask for, clamped to the surface limits, 0 picks one more than the minimum
+	uint32      ImageCount = 0;
+	// Waits for every earlier frame before the next one samples its input, so at most one frame is
+	// queued ahead of the display, at the cost of CPU and GPU no longer overlapping across frames.
+	bool        LowLatency = false;
+};
+
+// The scene is rendered at a fraction of the output resolution and upsampled by the temporal
+// anti-aliasing. The fraction follows the GPU time of the scene to hold the target frame rate.
+struct ResolutionSettings
+{
+	// 0 renders at MaxScale
+	float TargetFrameRate = 60.0f;
+	// per axis, of the swapchain extent
+	float MinScale = 0.5f;
+	float MaxScale = 1.0f;
+};
+
+// Replaces the shading of the scene with a visualization of what the renderer does.
+enum class DebugView : uint8
+{
+	None,
+	// lights assigned to the cluster of every pixel, from blue for none to red for a full cluster
+	LightHeatmap
+};
+
+// What the selected GPU and backend support, filled by Init.
+struct RHICapabilities
+{
+	std::string DeviceName;
+	// memory local to the GPU in bytes, shared with the CPU on integrated GPUs
+	uint64      DeviceLocalMemory = 0;
+	// queues that run next to graphics, for async compute and background uploads
+	bool        DedicatedCompute = false;
+	bool        DedicatedTransfer = false;
+	// compute passes are submitted to the dedicated compute queue
+	bool        AsyncCompute = false;
+	bool        DynamicRendering = false;
+	bool        MultiDrawIndirect = false;
+	bool        OcclusionCulling = false;
+	// the driver reports per heap budgets, usage is estimated from the engine's allocations otherwise
+	bool        MemoryBudget = false;
+	// the GPU can time the scene passes, the render scale stays at ResolutionSettings::MaxScale otherwise
+	bool        DynamicResolution = false;
+};
 
 class RHIContext
 {
@@ -26,6 +93,22 @@ public:
 
 	virtual void SwapBuffers() = 0;
 
+	virtual const RenderStats& GetRenderStats() const = 0;
+	virtual const RHICapabilities& GetCapabilities() const = 0;
+
+	// host memory per subsystem and device memory per heap with their budgets, as JSON
+	virtual bool ExportMemorySnapshot( const std::filesystem::path& path ) = 0;
+
+	// may be called before Init, takes effect on the next frame
+	virtual void SetPresentSettings( const PresentSettings& settings ) = 0;
+	// may be called before Init, takes effect on the next frame
+	virtual void SetDebugView( DebugView view ) = 0;
+	// may be called before Init, takes effect on the next frame
+	virtual void SetResolutionSettings( const ResolutionSettings& settings ) = 0;
+	// Called for every resize event, cheap enough for a burst of them. The backend reads the final size
+	// once at the start of the next frame.
+	virtual void OnResize() = 0;
+
 	static Scope<RHIContext> Create( void* window, Backend backend );
 };
 
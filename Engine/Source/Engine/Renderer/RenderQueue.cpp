@@ -0,0 +1,74 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+uint64 RenderQueue::MakeKey( uint32 pass, uint32 pipeline, uint32 material, uint32 mesh, float depth )
+{
+    const float  clamped_depth = std::clamp( depth, 0.0f, 1.0f );
+    const uint64 quantized_depth = static_cast< uint64 >( clamped_depth * ( ( 1u << DEPTH_BITS ) - 1 ) );
+
+    auto field = [] ( uint64 value, uint32 bits, uint32 shift ) -> uint64 {
+        return ( value & ( ( 1ull << bits ) - 1 ) ) << shift;
+    };
+
+    return field( pass, PASS_BITS, PASS_SHIFT ) |
+        field( pipeline, PIPELINE_BITS, PIPELINE_SHIFT ) |
+        field( material, MATERIAL_BITS, MATERIAL_SHIFT ) |
+        field( mesh, MESH_BITS, MESH_SHIFT ) |
+        field( quantized_depth, DEPTH_BITS, DEPTH_SHIFT );
+}
+
+void RenderQueue::Sort()
+{
+    const size_t count = Items.size();
+    if ( count < 2 )
+    {
+        return;
+    }
+
+    Scratch.resize( count );
+
+    // one read of the keys counts the buckets of every pass
+    for ( auto& histogram : Histograms )
+    {
+        histogram.fill( 0 );
+    }
+    for ( const Item& item : Items )
+    {
+        for ( uint32 pass = 0; pass < PASS_COUNT; ++pass )
+        {
+            ++Histograms[pass][( item.Key >> ( pass * 8 ) ) & ( RADIX - 1 )];
+        }
+    }
+
+    for ( uint32 pass = 0; pass < PASS_COUNT; ++pass )
+    {
+        auto& offsets = Histograms[pass];
+
+        // all keys share this byte, the pass would be a plain copy
+        const bool trivial = std::ranges::any_of( offsets, [count] ( uint32 bucket_count ) {
+            return bucket_count == count;
+        } );
+        if ( trivial )
+        {
+            continue;
+        }
+
+        // turn the counts into write cursors, items keep their order within a bucket so the sort stays stable
+        uint32 cursor = 0;
+        for ( uint32& offset : offsets )
+        {
+            const uint32 bucket_count = offset;
+            offset = cursor;
+            cursor += bucket_count;
+        }
+
+        const uint32 shift = pass * 8;
+        for ( const Item& item : Items )
+        {
+            Scratch[offsets[( item.Key >> shift ) & ( RADIX - 1 )]++] = item;
+        }
+
+        std::swap( Items, Scratch );
+    }
+}
@@ -0,0 +1,97 @@
+// Engine/Source/Engine/Renderer/RenderQueue.h
+
+#ifndef __renderer_render_queue_h_included__
+#define __renderer_render_queue_h_included__
+
+#include <span>
+#include <array>
+#include <vector>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Memory.h"
+
+// Draw submissions sorted by a packed 64-bit key so that draws sharing state end up adjacent.
+// From the most to the least significant bits the key holds:
+//
+//   | pass : 4 | pipeline : 12 | material : 16 | mesh : 16 | depth : 16 |
+//
+// The payload is an opaque index the backend uses to find the object the draw came from.
+class RenderQueue
+{
+public:
+    struct Item
+    {
+        uint64 Key;
+        uint32 Payload;
+    };
+
+    static constexpr uint32 PASS_BITS = 4;
+    static constexpr uint32 PIPELINE_BITS = 12;
+    static constexpr uint32 MATERIAL_BITS = 16;
+    static constexpr uint32 MESH_BITS = 16;
+    static constexpr uint32 DEPTH_BITS = 16;
+
+    static constexpr uint32 DEPTH_SHIFT = 0;
+    static constexpr uint32 MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+    static constexpr uint32 MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+    static constexpr uint32 PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+    static constexpr uint32 PASS_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+
+    static_assert( PASS_SHIFT + PASS_BITS == 64 );
+
+    // depth is expected in [0, 1], front to back
+    static uint64 MakeKey( uint32 pass, uint32 pipeline, uint32 material, uint32 mesh, float depth );
+
+    static uint32 GetPass( uint64 key )     { return Extract( key, PASS_SHIFT, PASS_BITS ); }
+    static uint32 GetPipeline( uint64 key ) { return Extract( key, PIPELINE_SHIFT, PIPELINE_BITS ); }
+    static uint32 GetMaterial( uint64 key ) { return Extract( key, MATERIAL_SHIFT, MATERIAL_BITS ); }
+    static uint32 GetMesh( uint64 key )     { return Extract( key, MESH_SHIFT, MESH_BITS ); }
+
+    // true when two keys differ only in depth, i.e. they can be merged into one instanced draw
+    static bool IsSameState( uint64 lhs, uint64 rhs )
+    {
+        return ( lhs >> MESH_SHIFT ) == ( rhs >> MESH_SHIFT );
+    }
+
+    void Clear()
+    {
+        Items.clear();
+    }
+
+    void Reserve( size_t count )
+    {
+        Items.reserve( count );
+        Scratch.reserve( count );
+    }
+
+    void Push( uint64 key, uint32 payload )
+    {
+        Items.push_back( { key, payload } );
+    }
+
+    // Stable LSD radix sort, one byte per pass. The buckets of all passes are counted in a single read
+    // of the keys and passes over a byte every key shares are skipped. It runs on the calling thread, a
+    // full frame of items sorts in less time than handing the passes to other threads would take.
+    void Sort();
+
+    std::span<const Item> GetItems() const
+    {
+        return Items;
+    }
+
+private:
+    static uint32 Extract( uint64 key, uint32 shift, uint32 bits )
+    {
+        return static_cast< uint32 >( ( key >> shift ) & ( ( 1ull << bits ) - 1 ) );
+    }
+
+private:
+    static constexpr uint32 RADIX = 256;
+    static constexpr uint32 PASS_COUNT = 8;
+
+    std::pmr::vector<Item> Items{ Memory::GetResource( MemoryTag::Renderer ) };
+    std::pmr::vector<Item> Scratch{ Memory::GetResource( MemoryTag::Renderer ) };
+    std::array<std::array<uint32, RADIX>, PASS_COUNT> Histograms = {};
+};
+
+#endif
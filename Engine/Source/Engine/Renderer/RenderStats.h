@@ -0,0 +1,55 @@
+// Engine/Source/Engine/Renderer/RenderStats.h
+
+#ifndef __renderer_render_stats_h_included__
+#define __renderer_render_stats_h_included__
+
+#include "Engine/Core/Common.h"
+
+// Per-frame counters filled by the backend while it records draw commands.
+struct RenderStats
+{
+    uint32 DrawCalls = 0;
+    uint32 Instances = 0;
+    // of the scene pass at the selected levels of detail, before occlusion culling
+    uint32 Triangles = 0;
+
+    uint32 PipelineBinds = 0;
+    uint32 DescriptorBinds = 0;
+    uint32 VertexBufferBinds = 0;
+
+    // binds that were not emitted because the requested state was already bound
+    uint32 SkippedBinds = 0;
+
+    // From the moment the frame sampled its input to the CPU seeing the GPU finish it, measured for
+    // the last completed frame. Input-to-present latency minus the wait for the display.
+    float InputLatencyMs = 0.0f;
+    // frames the CPU was ahead of the GPU when the frame started
+    uint32 QueuedFrames = 0;
+    // queue submissions of the frame, every switch between graphics and async compute passes adds one and
+    // the post chain starts its own to wait for the swapchain image
+    uint32 QueueSubmits = 0;
+    // from application launch to the first present, zero before it
+    float TimeToFirstFrameMs = 0.0f;
+    // bytes the render thread took from the frame allocator
+    uint32 FrameMemoryBytes = 0;
+    // device local heaps, refreshed every few seconds
+    uint32 DeviceMemoryUsageMiB = 0;
+    uint32 DeviceMemoryBudgetMiB = 0;
+    // lights inside the view frustum, assigned to clusters on the GPU
+    uint32 Lights = 0;
+    // shadow cascades and atlas tiles rendered this frame, the others were cached
+    uint32 ShadowViews = 0;
+    // fraction of the swapchain extent per axis the scene was rendered at
+    float RenderScale = 1.0f;
+    // GPU time of the shadow and scene passes, smoothed over recent frames, zero when it is not measured
+    float SceneGpuMs = 0.0f;
+    // GPU resources retired to submissions that have not completed yet
+    uint32 PendingDeletions = 0;
+
+    void Reset()
+    {
+        *this = RenderStats{};
+    }
+};
+
+#endif
@@ -0,0 +1,787 @@
+#include "BVH.h"
+
+#include <bit>
+#include <array>
+#include <algorithm>
+
+#include "Engine/Core/Assert.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+    // traversal stacks are reused between queries, queries never nest
+    std::vector<uint32>& GetTraversalStack()
+    {
+        thread_local std::vector<uint32> stack;
+        stack.clear();
+        return stack;
+    }
+
+    struct RayEntry
+    {
+        uint32 Node;
+        float  Distance;
+    };
+
+    std::vector<RayEntry>& GetRayStack()
+    {
+        thread_local std::vector<RayEntry> stack;
+        stack.clear();
+        return stack;
+    }
+}
+
+void BVH::Clear()
+{
+    Nodes.clear();
+    ObjectLeaves.clear();
+    WideNodes.clear();
+    Root = INVALID_INDEX;
+    FreeList = INVALID_INDEX;
+    ObjectCount = 0;
+    Dirty = false;
+}
+
+void BVH::Build( std::span<const AABB> bounds )
+{
+    Clear();
+    if ( bounds.empty() )
+    {
+        return;
+    }
+
+    const uint32 count = static_cast< uint32 >( bounds.size() );
+    Nodes.reserve( 2 * static_cast< size_t >( count ) - 1 );
+    ObjectLeaves.assign( count, INVALID_INDEX );
+
+    ScratchScope scratch;
+    std::span<uint32>    leaves( scratch.AllocateArray<uint32>( count ), count );
+    std::span<glm::vec3> centroids( scratch.AllocateArray<glm::vec3>( count ), count );
+    for ( uint32 object = 0; object < count; ++object )
+    {
+        const uint32 leaf = AllocateNode();
+        Nodes[leaf].Bounds = bounds[object];
+        Nodes[leaf].Object = object;
+        ObjectLeaves[object] = leaf;
+        leaves[object] = leaf;
+        centroids[leaf] = bounds[object].Center();
+    }
+
+    Root = BuildRange( leaves, centroids, INVALID_INDEX );
+    ObjectCount = count;
+    Dirty = true;
+}
+
+uint32 BVH::BuildRange( std::span<uint32> leaves, std::span<const glm::vec3> centroids, uint32 parent )
+{
+    if ( leaves.size() == 1 )
+    {
+        Nodes[leaves[0]].Parent = parent;
+        return leaves[0];
+    }
+
+    AABB centroid_bounds;
+    for ( uint32 leaf : leaves )
+    {
+        centroid_bounds.Extend( centroids[leaf] );
+    }
+
+    struct Bin
+    {
+        AABB   Bounds;
+        uint32 Count = 0;
+    };
+
+    // binned SAH over all three axes, the cost of a split is area * count summed over both sides
+    float  best_cost = FLT_MAX;
+    int32  best_axis = -1;
+    uint32 best_bin = 0;
+
+    const glm::vec3 extent = centroid_bounds.Max - centroid_bounds.Min;
+    for ( int32 axis = 0; axis < 3; ++axis )
+    {
+        if ( extent[axis] <= 0.0f )
+        {
+            continue;
+        }
+
+        const float scale = BIN_COUNT / extent[axis];
+        auto bin_index = [&] ( uint32 leaf ) {
+            const float offset = centroids[leaf][axis] - centroid_bounds.Min[axis];
+            return std::min( static_cast< uint32 >( offset * scale ), BIN_COUNT - 1 );
+        };
+
+        std::array<Bin, BIN_COUNT> bins = {};
+        for ( uint32 leaf : leaves )
+        {
+            Bin& bin = bins[bin_index( leaf )];
+            bin.Bounds.Extend( Nodes[leaf].Bounds );
+            ++bin.Count;
+        }
+
+        std::array<float, BIN_COUNT - 1> right_costs = {};
+        AABB   right_bounds;
+        uint32 right_count = 0;
+        for ( uint32 split = BIN_COUNT - 1; split > 0; --split )
+        {
+            right_bounds.Extend( bins[split].Bounds );
+            right_count += bins[split].Count;
+            right_costs[split - 1] = right_bounds.SurfaceArea() * right_count;
+        }
+
+        AABB   left_bounds;
+        uint32 left_count = 0;
+        for ( uint32 split = 0; split < BIN_COUNT - 1; ++split )
+        {
+            left_bounds.Extend( bins[split].Bounds );
+            left_count += bins[split].Count;
+
+            if ( left_count == 0 || left_count == leaves.size() )
+            {
+                continue;
+            }
+
+            const float cost = left_bounds.SurfaceArea() * left_count + right_costs[split];
+            if ( cost < best_cost )
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = split;
+            }
+        }
+    }
+
+    size_t middle = leaves.size() / 2;
+    if ( best_axis >= 0 )
+    {
+        const float scale = BIN_COUNT / extent[best_axis];
+        auto split = std::partition( leaves.begin(), leaves.end(), [&] ( uint32 leaf ) {
+            const float offset = centroids[leaf][best_axis] - centroid_bounds.Min[best_axis];
+            return std::min( static_cast< uint32 >( offset * scale ), BIN_COUNT - 1 ) <= best_bin;
+        } );
+        middle = static_cast< size_t >( split - leaves.begin() );
+    }
+
+    // every centroid in the same place, any split is as good as another
+    if ( middle == 0 || middle == leaves.size() )
+    {
+        middle = leaves.size() / 2;
+    }
+
+    const uint32 node = AllocateNode();
+    Nodes[node].Parent = parent;
+
+    const uint32 left = BuildRange( leaves.subspan( 0, middle ), centroids, node );
+    const uint32 right = BuildRange( leaves.subspan( middle ), centroids, node );
+
+    Nodes[node].Left = left;
+    Nodes[node].Right = right;
+    Nodes[node].Bounds = AABB::Union( Nodes[left].Bounds, Nodes[right].Bounds );
+    return node;
+}
+
+void BVH::Insert( uint32 object, const AABB& bounds )
+{
+    if ( Contains( object ) )
+    {
+        Update( object, bounds );
+        return;
+    }
+
+    ASSERT( ( object & LEAF_BIT ) == 0 );
+    if ( object >= ObjectLeaves.size() )
+    {
+        ObjectLeaves.resize( static_cast< size_t >( object ) + 1, INVALID_INDEX );
+    }
+
+    const uint32 leaf = AllocateNode();
+    Nodes[leaf].Bounds = bounds;
+    Nodes[leaf].Object = object;
+    ObjectLeaves[object] = leaf;
+
+    InsertLeaf( leaf );
+    ++ObjectCount;
+    Dirty = true;
+}
+
+void BVH::Remove( uint32 object )
+{
+    if ( !Contains( object ) )
+    {
+        return;
+    }
+
+    const uint32 leaf = ObjectLeaves[object];
+    RemoveLeaf( leaf );
+    FreeNode( leaf );
+
+    ObjectLeaves[object] = INVALID_INDEX;
+    --ObjectCount;
+    Dirty = true;
+}
+
+void BVH::Update( uint32 object, const AABB& bounds )
+{
+    ASSERT( Contains( object ) );
+
+    const uint32 leaf = ObjectLeaves[object];
+    if ( Nodes[leaf].Bounds.Contains( bounds ) )
+    {
+        return;
+    }
+
+    RemoveLeaf( leaf );
+    Nodes[leaf].Bounds = bounds;
+    InsertLeaf( leaf );
+    Dirty = true;
+}
+
+void BVH::SetBounds( uint32 object, const AABB& bounds )
+{
+    ASSERT( Contains( object ) );
+
+    Nodes[ObjectLeaves[object]].Bounds = bounds;
+    Dirty = true;
+}
+
+void BVH::Refit()
+{
+    if ( Root != INVALID_INDEX )
+    {
+        RefitNode( Root );
+    }
+    Dirty = true;
+}
+
+void BVH::RefitNode( uint32 node )
+{
+    if ( Nodes[node].IsLeaf() )
+    {
+        return;
+    }
+
+    RefitNode( Nodes[node].Left );
+    RefitNode( Nodes[node].Right );
+    Nodes[node].Bounds = AABB::Union( Nodes[Nodes[node].Left].Bounds, Nodes[Nodes[node].Right].Bounds );
+}
+
+uint32 BVH::AllocateNode()
+{
+    if ( FreeList != INVALID_INDEX )
+    {
+        const uint32 node = FreeList;
+        FreeList = Nodes[node].Parent;
+        Nodes[node] = Node{};
+        return node;
+    }
+
+    Nodes.emplace_back();
+    return static_cast< uint32 >( Nodes.size() - 1 );
+}
+
+void BVH::FreeNode( uint32 node )
+{
+    Nodes[node] = Node{};
+    Nodes[node].Parent = FreeList;
+    FreeList = node;
+}
+
+void BVH::SetChild( uint32 parent, uint32 old_child, uint32 new_child )
+{
+    if ( Nodes[parent].Left == old_child )
+    {
+        Nodes[parent].Left = new_child;
+    }
+    else
+    {
+        ASSERT( Nodes[parent].Right == old_child );
+        Nodes[parent].Right = new_child;
+    }
+}
+
+void BVH::InsertLeaf( uint32 leaf )
+{
+    if ( Root == INVALID_INDEX )
+    {
+        Root = leaf;
+        Nodes[leaf].Parent = INVALID_INDEX;
+        return;
+    }
+
+    // Walk towards the cheapest sibling. Pairing with a node costs the area of the new parent, every
+    // ancestor on the way down grows by the area it has to take in.
+    const AABB leaf_bounds = Nodes[leaf].Bounds;
+    uint32 sibling = Root;
+    while ( !Nodes[sibling].IsLeaf() )
+    {
+        const Node& node = Nodes[sibling];
+
+        const float area = node.Bounds.SurfaceArea();
+        const float combined_area = AABB::Union( node.Bounds, leaf_bounds ).SurfaceArea();
+        const float pair_cost = 2.0f * combined_area;
+        const float inherited_cost = 2.0f * ( combined_area - area );
+
+        auto descend_cost = [&] ( uint32 child ) {
+            const AABB& child_bounds = Nodes[child].Bounds;
+            const float child_area = AABB::Union( child_bounds, leaf_bounds ).SurfaceArea();
+            if ( Nodes[child].IsLeaf() )
+            {
+                return child_area + inherited_cost;
+            }
+            return child_area - child_bounds.SurfaceArea() + inherited_cost;
+        };
+
+        const float left_cost = descend_cost( node.Left );
+        const float right_cost = descend_cost( node.Right );
+        if ( pair_cost < left_cost && pair_cost < right_cost )
+        {
+            break;
+        }
+
+        sibling = left_cost < right_cost ? node.Left : node.Right;
+    }
+
+    const uint32 old_parent = Nodes[sibling].Parent;
+    const uint32 new_parent = AllocateNode();
+
+    Nodes[new_parent].Parent = old_parent;
+    Nodes[new_parent].Left = sibling;
+    Nodes[new_parent].Right = leaf;
+    Nodes[new_parent].Bounds = AABB::Union( Nodes[sibling].Bounds, leaf_bounds );
+    Nodes[sibling].Parent = new_parent;
+    Nodes[leaf].Parent = new_parent;
+
+    if ( old_parent == INVALID_INDEX )
+    {
+        Root = new_parent;
+    }
+    else
+    {
+        SetChild( old_parent, sibling, new_parent );
+    }
+
+    RefitAncestors( old_parent );
+}
+
+void BVH::RemoveLeaf( uint32 leaf )
+{
+    if ( leaf == Root )
+    {
+        Root = INVALID_INDEX;
+        return;
+    }
+
+    const uint32 parent = Nodes[leaf].Parent;
+    const uint32 grandparent = Nodes[parent].Parent;
+    const uint32 sibling = Nodes[parent].Left == leaf ? Nodes[parent].Right : Nodes[parent].Left;
+
+    Nodes[sibling].Parent = grandparent;
+    Nodes[leaf].Parent = INVALID_INDEX;
+    FreeNode( parent );
+
+    if ( grandparent == INVALID_INDEX )
+    {
+        Root = sibling;
+        return;
+    }
+
+    SetChild( grandparent, parent, sibling );
+    RefitAncestors( grandparent );
+}
+
+void BVH::RefitAncestors( uint32 node )
+{
+    while ( node != INVALID_INDEX )
+    {
+        Nodes[node].Bounds = AABB::Union( Nodes[Nodes[node].Left].Bounds, Nodes[Nodes[node].Right].Bounds );
+        Rotate( node );
+        node = Nodes[node].Parent;
+    }
+}
+
+void BVH::Rotate( uint32 node )
+{
+    // Swapping a child with a grandchild on the other side keeps the bounds of the node itself but
+    // may shrink the child that receives it. Take the swap that shrinks it the most, if any.
+    const uint32 left = Nodes[node].Left;
+    const uint32 right = Nodes[node].Right;
+
+    float  best_gain = 0.0f;
+    uint32 best_child = INVALID_INDEX;
+    uint32 best_grandchild = INVALID_INDEX;
+
+    auto consider = [&] ( uint32 child, uint32 other ) {
+        if ( Nodes[other].IsLeaf() )
+        {
+            return;
+        }
+
+        const float other_area = Nodes[other].Bounds.SurfaceArea();
+        const uint32 grandchildren[2] = { Nodes[other].Left, Nodes[other].Right };
+        for ( uint32 i = 0; i < 2; ++i )
+        {
+            const uint32 kept = grandchildren[1 - i];
+            const float gain = other_area - AABB::Union( Nodes[child].Bounds, Nodes[kept].Bounds ).SurfaceArea();
+            if ( gain > best_gain )
+            {
+                best_gain = gain;
+                best_child = child;
+                best_grandchild = grandchildren[i];
+            }
+        }
+    };
+
+    consider( left, right );
+    consider( right, left );
+
+    if ( best_child == INVALID_INDEX )
+    {
+        return;
+    }
+
+    const uint32 other = Nodes[best_grandchild].Parent;
+
+    SetChild( node, best_child, best_grandchild );
+    SetChild( other, best_grandchild, best_child );
+    Nodes[best_grandchild].Parent = node;
+    Nodes[best_child].Parent = other;
+    Nodes[other].Bounds = AABB::Union( Nodes[Nodes[other].Left].Bounds, Nodes[Nodes[other].Right].Bounds );
+}
+
+void BVH::Flatten()
+{
+    WideNodes.clear();
+    Dirty = false;
+
+    if ( Root == INVALID_INDEX )
+    {
+        return;
+    }
+
+    WideNodes.reserve( Nodes.size() / 2 + 1 );
+    if ( !Nodes[Root].IsLeaf() )
+    {
+        FlattenNode( Root );
+        return;
+    }
+
+    // a lone leaf still needs a node above it
+    WideNode& wide = WideNodes.emplace_back();
+    const AABB& bounds = Nodes[Root].Bounds;
+    for ( uint32 slot = 0; slot < 4; ++slot )
+    {
+        wide.MinX[slot] = wide.MinY[slot] = wide.MinZ[slot] = FLT_MAX;
+        wide.MaxX[slot] = wide.MaxY[slot] = wide.MaxZ[slot] = -FLT_MAX;
+        wide.Children[slot] = EMPTY_CHILD;
+    }
+    wide.MinX[0] = bounds.Min.x;
+    wide.MinY[0] = bounds.Min.y;
+    wide.MinZ[0] = bounds.Min.z;
+    wide.MaxX[0] = bounds.Max.x;
+    wide.MaxY[0] = bounds.Max.y;
+    wide.MaxZ[0] = bounds.Max.z;
+    wide.Children[0] = LEAF_BIT | Nodes[Root].Object;
+}
+
+uint32 BVH::FlattenNode( uint32 node )
+{
+    // pull up grandchildren until there are four children, opening the largest internal child first
+    std::array<uint32, 4> children = { Nodes[node].Left, Nodes[node].Right, INVALID_INDEX, INVALID_INDEX };
+    uint32 child_count = 2;
+    while ( child_count < 4 )
+    {
+        uint32 largest = INVALID_INDEX;
+        float  largest_area = -1.0f;
+        for ( uint32 i = 0; i < child_count; ++i )
+        {
+            const Node& child = Nodes[children[i]];
+            if ( !child.IsLeaf() && child.Bounds.SurfaceArea() > largest_area )
+            {
+                largest = i;
+                largest_area = child.Bounds.SurfaceArea();
+            }
+        }
+
+        if ( largest == INVALID_INDEX )
+        {
+            break;
+        }
+
+        const uint32 opened = children[largest];
+        children[largest] = Nodes[opened].Left;
+        children[child_count++] = Nodes[opened].Right;
+    }
+
+    const uint32 wide = static_cast< uint32 >( WideNodes.size() );
+    WideNodes.emplace_back();
+
+    for ( uint32 slot = 0; slot < 4; ++slot )
+    {
+        AABB   bounds;
+        uint32 child = EMPTY_CHILD;
+        if ( slot < child_count )
+        {
+            const Node& source = Nodes[children[slot]];
+            bounds = source.Bounds;
+            // recursing may grow WideNodes, so the node is indexed again below
+            child = source.IsLeaf() ? ( LEAF_BIT | source.Object ) : FlattenNode( children[slot] );
+        }
+
+        WideNode& target = WideNodes[wide];
+        target.MinX[slot] = bounds.Min.x;
+        target.MinY[slot] = bounds.Min.y;
+        target.MinZ[slot] = bounds.Min.z;
+        target.MaxX[slot] = bounds.Max.x;
+        target.MaxY[slot] = bounds.Max.y;
+        target.MaxZ[slot] = bounds.Max.z;
+        target.Children[slot] = child;
+    }
+
+    return wide;
+}
+
+uint32 BVH::OverlapMask( const WideNode& node, const AABB& bounds )
+{
+#ifdef BVH_USE_SSE
+    __m128 hit = _mm_and_ps(
+        _mm_cmple_ps( _mm_load_ps( node.MinX ), _mm_set1_ps( bounds.Max.x ) ),
+        _mm_cmpge_ps( _mm_load_ps( node.MaxX ), _mm_set1_ps( bounds.Min.x ) ) );
+    hit = _mm_and_ps( hit, _mm_and_ps(
+        _mm_cmple_ps( _mm_load_ps( node.MinY ), _mm_set1_ps( bounds.Max.y ) ),
+        _mm_cmpge_ps( _mm_load_ps( node.MaxY ), _mm_set1_ps( bounds.Min.y ) ) ) );
+    hit = _mm_and_ps( hit, _mm_and_ps(
+        _mm_cmple_ps( _mm_load_ps( node.MinZ ), _mm_set1_ps( bounds.Max.z ) ),
+        _mm_cmpge_ps( _mm_load_ps( node.MaxZ ), _mm_set1_ps( bounds.Min.z ) ) ) );
+    return static_cast< uint32 >( _mm_movemask_ps( hit ) );
+#else
+    uint32 mask = 0;
+    for ( uint32 slot = 0; slot < 4; ++slot )
+    {
+        const bool hit =
+            node.MinX[slot] <= bounds.Max.x && node.MaxX[slot] >= bounds.Min.x &&
+            node.MinY[slot] <= bounds.Max.y && node.MaxY[slot] >= bounds.Min.y &&
+            node.MinZ[slot] <= bounds.Max.z && node.MaxZ[slot] >= bounds.Min.z;
+        mask |= static_cast< uint32 >( hit ) << slot;
+    }
+    return mask;
+#endif
+}
+
+uint32 BVH::FrustumMask( const WideNode& node, const Frustum& frustum )
+{
+    // a box is outside when its corner farthest along the plane normal is behind the plane
+#ifdef BVH_USE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    __m128 inside = _mm_cmpeq_ps( zero, zero );
+    for ( const glm::vec4& plane : frustum.Planes )
+    {
+        const __m128 x = _mm_load_ps( plane.x > 0.0f ? node.MaxX : node.MinX );
+        const __m128 y = _mm_load_ps( plane.y > 0.0f ? node.MaxY : node.MinY );
+        const __m128 z = _mm_load_ps( plane.z > 0.0f ? node.MaxZ : node.MinZ );
+
+        __m128 distance = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( plane.x ) ), _mm_set1_ps( plane.w ) );
+        distance = _mm_add_ps( distance, _mm_mul_ps( y, _mm_set1_ps( plane.y ) ) );
+        distance = _mm_add_ps( distance, _mm_mul_ps( z, _mm_set1_ps( plane.z ) ) );
+
+        inside = _mm_and_ps( inside, _mm_cmpge_ps( distance, zero ) );
+        if ( _mm_movemask_ps( inside ) == 0 )
+        {
+            return 0;
+        }
+    }
+    return static_cast< uint32 >( _mm_movemask_ps( inside ) );
+#else
+    uint32 mask = 0;
+    for ( uint32 slot = 0; slot < 4; ++slot )
+    {
+        AABB bounds;
+        bounds.Min = glm::vec3( node.MinX[slot], node.MinY[slot], node.MinZ[slot] );
+        bounds.Max = glm::vec3( node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot] );
+        mask |= static_cast< uint32 >( frustum.Intersects( bounds ) ) << slot;
+    }
+    return mask;
+#endif
+}
+
+uint32 BVH::RayMask( const WideNode& node, const glm::vec3& origin, const glm::vec3& inverse_direction,
+    float max_distance, float* distances )
+{
+    // slab test, distances receive the entry distance of every child
+#ifdef BVH_USE_SSE
+    auto slab = [] ( const float* min, const float* max, float origin, float inverse, __m128& near, __m128& far ) {
+        const __m128 o = _mm_set1_ps( origin );
+        const __m128 i = _mm_set1_ps( inverse );
+        const __m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( min ), o ), i );
+        const __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( max ), o ), i );
+        near = _mm_max_ps( near, _mm_min_ps( t0, t1 ) );
+        far = _mm_min_ps( far, _mm_max_ps( t0, t1 ) );
+    };
+
+    __m128 near = _mm_setzero_ps();
+    __m128 far = _mm_set1_ps( max_distance );
+    slab( node.MinX, node.MaxX, origin.x, inverse_direction.x, near, far );
+    slab( node.MinY, node.MaxY, origin.y, inverse_direction.y, near, far );
+    slab( node.MinZ, node.MaxZ, origin.z, inverse_direction.z, near, far );
+
+    _mm_storeu_ps( distances, near );
+    return static_cast< uint32 >( _mm_movemask_ps( _mm_cmple_ps( near, far ) ) );
+#else
+    uint32 mask = 0;
+    for ( uint32 slot = 0; slot < 4; ++slot )
+    {
+        const glm::vec3 min = glm::vec3( node.MinX[slot], node.MinY[slot], node.MinZ[slot] );
+        const glm::vec3 max = glm::vec3( node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot] );
+        const glm::vec3 t0 = ( min - origin ) * inverse_direction;
+        const glm::vec3 t1 = ( max - origin ) * inverse_direction;
+        const glm::vec3 near = glm::min( t0, t1 );
+        const glm::vec3 far = glm::max( t0, t1 );
+
+        const float entry = std::max( std::max( near.x, near.y ), std::max( near.z, 0.0f ) );
+        const float exit = std::min( std::min( far.x, far.y ), std::min( far.z, max_distance ) );
+        distances[slot] = entry;
+        mask |= static_cast< uint32 >( entry <= exit ) << slot;
+    }
+    return mask;
+#endif
+}
+
+template<typename Mask, typename Visit>
+void BVH::Traverse( Mask&& mask, Visit&& visit ) const
+{
+    if ( WideNodes.empty() )
+    {
+        return;
+    }
+    ASSERT( !Dirty );
+
+    std::vector<uint32>& stack = GetTraversalStack();
+    stack.push_back( 0 );
+    while ( !stack.empty() )
+    {
+        const WideNode& node = WideNodes[stack.back()];
+        stack.pop_back();
+
+        for ( uint32 hits = mask( node ); hits != 0; hits &= hits - 1 )
+        {
+            const uint32 child = node.Children[std::countr_zero( hits )];
+            if ( child == EMPTY_CHILD )
+            {
+                continue;
+            }
+
+            if ( child & LEAF_BIT )
+            {
+                visit( child & ~LEAF_BIT );
+            }
+            else
+            {
+                stack.push_back( child );
+            }
+        }
+    }
+}
+
+void BVH::QueryFrustum( const Frustum& frustum, std::vector<uint32>& objects ) const
+{
+    Traverse(
+        [&] ( const WideNode& node ) { return FrustumMask( node, frustum ); },
+        [&] ( uint32 object ) { objects.push_back( object ); } );
+}
+
+void BVH::QueryOverlaps( const AABB& bounds, std::vector<uint32>& objects ) const
+{
+    Traverse(
+        [&] ( const WideNode& node ) { return OverlapMask( node, bounds ); },
+        [&] ( uint32 object ) { objects.push_back( object ); } );
+}
+
+std::optional<BVH::RayHit> BVH::RayCast( const Ray& ray ) const
+{
+    if ( WideNodes.empty() )
+    {
+        return std::nullopt;
+    }
+    ASSERT( !Dirty );
+
+    const glm::vec3 inverse_direction = 1.0f / ray.Direction;
+
+    std::optional<RayHit> closest;
+    float closest_distance = ray.MaxDistance;
+
+    std::vector<RayEntry>& stack = GetRayStack();
+    stack.push_back( { 0, 0.0f } );
+    while ( !stack.empty() )
+    {
+        const RayEntry entry = stack.back();
+        stack.pop_back();
+        if ( entry.Distance > closest_distance )
+        {
+            continue;
+        }
+
+        const WideNode& node = WideNodes[entry.Node];
+        alignas( 16 ) float distances[4];
+        const uint32 hits = RayMask( node, ray.Origin, inverse_direction, closest_distance, distances );
+
+        std::array<RayEntry, 4> inner = {};
+        uint32 inner_count = 0;
+        for ( uint32 mask = hits; mask != 0; mask &= mask - 1 )
+        {
+            const uint32 slot = static_cast< uint32 >( std::countr_zero( mask ) );
+            const uint32 child = node.Children[slot];
+            if ( child == EMPTY_CHILD )
+            {
+                continue;
+            }
+
+            if ( child & LEAF_BIT )
+            {
+                if ( distances[slot] <= closest_distance )
+                {
+                    closest_distance = distances[slot];
+                    closest = RayHit{ child & ~LEAF_BIT, distances[slot] };
+                }
+            }
+            else
+            {
+                inner[inner_count++] = { child, distances[slot] };
+            }
+        }
+
+        // farthest first so the nearest child is popped next
+        for ( uint32 i = 1; i < inner_count; ++i )
+        {
+            for ( uint32 j = i; j > 0 && inner[j - 1].Distance < inner[j].Distance; --j )
+            {
+                std::swap( inner[j - 1], inner[j] );
+            }
+        }
+        stack.insert( stack.end(), inner.begin(), inner.begin() + inner_count );
+    }
+
+    return closest;
+}
+
+void BVH::FindOverlappingPairs( std::vector<std::pair<uint32, uint32>>& pairs ) const
+{
+    for ( uint32 object = 0; object < ObjectLeaves.size(); ++object )
+    {
+        if ( ObjectLeaves[object] == INVALID_INDEX )
+        {
+            continue;
+        }
+
+        Traverse(
+            [&] ( const WideNode& node ) { return OverlapMask( node, Nodes[ObjectLeaves[object]].Bounds ); },
+            [&] ( uint32 other ) {
+                if ( other > object )
+                {
+                    pairs.emplace_back( object, other );
+                }
+            } );
+    }
+}
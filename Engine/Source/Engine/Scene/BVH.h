@@ -0,0 +1,142 @@
+// Engine/Source/Engine/Scene/BVH.h
+
+#ifndef __scene_bvh_h_included__
+#define __scene_bvh_h_included__
+
+#include <span>
+#include <vector>
+#include <utility>
+#include <optional>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Memory.h"
+#include "Engine/Scene/Geometry.h"
+
+// Dynamic bounding volume hierarchy over objects identified by the caller's ids.
+//
+// The tree itself is binary with one object per leaf. Build() does a binned SAH build, Insert() walks
+// down by the SAH insertion cost and rotates nodes on the way up, Remove() collapses the parent of the
+// leaf. When many objects move a little, SetBounds() + Refit() keeps the topology and only recomputes
+// the bounds.
+//
+// Queries do not walk the binary tree. Flatten() collapses it into 4-wide nodes stored as structure of
+// arrays in one contiguous vector, so every visited node tests its four children with one SIMD
+// operation. Queries expect the tree to be flattened after the last modification.
+class BVH
+{
+public:
+    static constexpr uint32 INVALID_INDEX = UINT32_MAX;
+
+    struct RayHit
+    {
+        uint32 Object;
+        float  Distance;
+    };
+
+    void Clear();
+
+    // replaces the tree, object i gets bounds[i]
+    void Build( std::span<const AABB> bounds );
+
+    void Insert( uint32 object, const AABB& bounds );
+    void Remove( uint32 object );
+
+    // reinserts the object unless the new bounds are still inside the stored ones
+    void Update( uint32 object, const AABB& bounds );
+
+    // changes the leaf bounds only, call Refit() once all leaves are updated
+    void SetBounds( uint32 object, const AABB& bounds );
+    void Refit();
+
+    void Flatten();
+
+    bool Contains( uint32 object ) const
+    {
+        return object < ObjectLeaves.size() && ObjectLeaves[object] != INVALID_INDEX;
+    }
+
+    bool IsFlattened() const
+    {
+        return !Dirty;
+    }
+
+    size_t GetObjectCount() const
+    {
+        return ObjectCount;
+    }
+
+    // Queries append to the output and never clear it. Leaves are tested by their bounds, the caller
+    // refines the result against the actual geometry when it needs to.
+    void QueryFrustum( const Frustum& frustum, std::vector<uint32>& objects ) const;
+    void QueryOverlaps( const AABB& bounds, std::vector<uint32>& objects ) const;
+    std::optional<RayHit> RayCast( const Ray& ray ) const;
+
+    // every overlapping pair once, with the smaller object id first
+    void FindOverlappingPairs( std::vector<std::pair<uint32, uint32>>& pairs ) const;
+
+private:
+    struct Node
+    {
+        AABB   Bounds;
+        uint32 Parent = INVALID_INDEX;
+        uint32 Left = INVALID_INDEX;
+        uint32 Right = INVALID_INDEX;
+        uint32 Object = INVALID_INDEX;
+
+        bool IsLeaf() const
+        {
+            return Left == INVALID_INDEX;
+        }
+    };
+
+    // four children of a flattened node, a child is either another wide node or a leaf object
+    struct alignas( 16 ) WideNode
+    {
+        float  MinX[4];
+        float  MinY[4];
+        float  MinZ[4];
+        float  MaxX[4];
+        float  MaxY[4];
+        float  MaxZ[4];
+        uint32 Children[4];
+    };
+
+    static constexpr uint32 LEAF_BIT = 0x80000000u;
+    static constexpr uint32 EMPTY_CHILD = INVALID_INDEX;
+    static constexpr uint32 BIN_COUNT = 12;
+
+    uint32 AllocateNode();
+    void   FreeNode( uint32 node );
+
+    // centroids are indexed by leaf node
+    uint32 BuildRange( std::span<uint32> leaves, std::span<const glm::vec3> centroids, uint32 parent );
+
+    void InsertLeaf( uint32 leaf );
+    void RemoveLeaf( uint32 leaf );
+    void RefitAncestors( uint32 node );
+    void Rotate( uint32 node );
+    void RefitNode( uint32 node );
+
+    void   SetChild( uint32 parent, uint32 old_child, uint32 new_child );
+    uint32 FlattenNode( uint32 node );
+
+    static uint32 OverlapMask( const WideNode& node, const AABB& bounds );
+    static uint32 FrustumMask( const WideNode& node, const Frustum& frustum );
+    static uint32 RayMask( const WideNode& node, const glm::vec3& origin, const glm::vec3& inverse_direction,
+        float max_distance, float* distances );
+
+    template<typename Mask, typename Visit>
+    void Traverse( Mask&& mask, Visit&& visit ) const;
+
+private:
+    std::pmr::vector<Node>     Nodes{ Memory::GetResource( MemoryTag::Scene ) };
+    std::pmr::vector<uint32>   ObjectLeaves{ Memory::GetResource( MemoryTag::Scene ) };
+    std::pmr::vector<WideNode> WideNodes{ Memory::GetResource( MemoryTag::Scene ) };
+
+    uint32 Root = INVALID_INDEX;
+    uint32 FreeList = INVALID_INDEX;
+    size_t ObjectCount = 0;
+    bool   Dirty = false;
+};
+
+#endif
@@ -0,0 +1,137 @@
+// Engine/Source/Engine/Scene/Geometry.h
+
+#ifndef __scene_geometry_h_included__
+#define __scene_geometry_h_included__
+
+#include <array>
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Core/Common.h"
+
+// Axis aligned box. A default constructed box is empty, extending it with anything yields that thing.
+struct AABB
+{
+    glm::vec3 Min = glm::vec3( FLT_MAX );
+    glm::vec3 Max = glm::vec3( -FLT_MAX );
+
+    static AABB Union( const AABB& lhs, const AABB& rhs )
+    {
+        return { glm::min( lhs.Min, rhs.Min ), glm::max( lhs.Max, rhs.Max ) };
+    }
+
+    void Extend( const AABB& other )
+    {
+        Min = glm::min( Min, other.Min );
+        Max = glm::max( Max, other.Max );
+    }
+
+    void Extend( const glm::vec3& point )
+    {
+        Min = glm::min( Min, point );
+        Max = glm::max( Max, point );
+    }
+
+    bool IsEmpty() const
+    {
+        return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+    }
+
+    glm::vec3 Center() const
+    {
+        return ( Min + Max ) * 0.5f;
+    }
+
+    float SurfaceArea() const
+    {
+        if ( IsEmpty() )
+        {
+            return 0.0f;
+        }
+
+        const glm::vec3 size = Max - Min;
+        return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
+    }
+
+    bool Contains( const AABB& other ) const
+    {
+        return glm::all( glm::lessThanEqual( Min, other.Min ) ) && glm::all( glm::greaterThanEqual( Max, other.Max ) );
+    }
+
+    bool Overlaps( const AABB& other ) const
+    {
+        return glm::all( glm::lessThanEqual( Min, other.Max ) ) && glm::all( glm::greaterThanEqual( Max, other.Min ) );
+    }
+};
+
+struct Ray
+{
+    glm::vec3 Origin = glm::vec3( 0.0f );
+    glm::vec3 Direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+    float     MaxDistance = FLT_MAX;
+};
+
+// Six planes with normals pointing inwards, a point is inside when dot( normal, point ) + w >= 0 for all of them.
+struct Frustum
+{
+    enum Plane
+    {
+        Left, Right, Bottom, Top, Near, Far, Count
+    };
+
+    std::array<glm::vec4, Plane::Count> Planes = {};
+
+    // Extracts the planes of a projection * view matrix with a [0, 1] clip depth range. Passing
+    // projection * view * model gives planes in the model space instead.
+    static Frustum FromMatrix( const glm::mat4& matrix )
+    {
+        auto row = [&matrix] ( int32 index ) {
+            return glm::vec4( matrix[0][index], matrix[1][index], matrix[2][index], matrix[3][index] );
+        };
+
+        Frustum frustum;
+        frustum.Planes[Left] = row( 3 ) + row( 0 );
+        frustum.Planes[Right] = row( 3 ) - row( 0 );
+        frustum.Planes[Bottom] = row( 3 ) + row( 1 );
+        frustum.Planes[Top] = row( 3 ) - row( 1 );
+        frustum.Planes[Near] = row( 2 );
+        frustum.Planes[Far] = row( 3 ) - row( 2 );
+
+        for ( glm::vec4& plane : frustum.Planes )
+        {
+            plane /= glm::length( glm::vec3( plane ) );
+        }
+        return frustum;
+    }
+
+    // conservative, boxes near the frustum corners may pass while being outside
+    bool Intersects( const AABB& box ) const
+    {
+        for ( const glm::vec4& plane : Planes )
+        {
+            const glm::vec3 normal = glm::vec3( plane );
+            const glm::vec3 farthest = glm::mix( box.Min, box.Max, glm::greaterThan( normal, glm::vec3( 0.0f ) ) );
+            if ( glm::dot( normal, farthest ) + plane.w < 0.0f )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // conservative like the box test
+    bool Intersects( const glm::vec3& center, float radius ) const
+    {
+        for ( const glm::vec4& plane : Planes )
+        {
+            if ( glm::dot( glm::vec3( plane ), center ) + plane.w < -radius )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
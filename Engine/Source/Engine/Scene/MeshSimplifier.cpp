@@ -0,0 +1,299 @@
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+#include "Engine/Core/Assert.h"
+
+namespace
+{
+    // Area weighted sum of the squared distances to a set of planes, the upper triangle of a symmetric
+    // 4x4 matrix. Evaluations divide by the total weight, their square root reads as a distance.
+    struct Quadric
+    {
+        double A2 = 0.0, AB = 0.0, AC = 0.0, AD = 0.0;
+        double B2 = 0.0, BC = 0.0, BD = 0.0;
+        double C2 = 0.0, CD = 0.0;
+        double D2 = 0.0;
+        double Weight = 0.0;
+
+        static Quadric FromPlane( const glm::dvec3& normal, double distance, double weight )
+        {
+            Quadric quadric;
+            quadric.A2 = normal.x * normal.x;
+            quadric.AB = normal.x * normal.y;
+            quadric.AC = normal.x * normal.z;
+            quadric.AD = normal.x * distance;
+            quadric.B2 = normal.y * normal.y;
+            quadric.BC = normal.y * normal.z;
+            quadric.BD = normal.y * distance;
+            quadric.C2 = normal.z * normal.z;
+            quadric.CD = normal.z * distance;
+            quadric.D2 = distance * distance;
+            quadric.Weight = 1.0;
+            quadric.Scale( weight );
+            return quadric;
+        }
+
+        void Add( const Quadric& other )
+        {
+            A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+            B2 += other.B2; BC += other.BC; BD += other.BD;
+            C2 += other.C2; CD += other.CD;
+            D2 += other.D2;
+            Weight += other.Weight;
+        }
+
+        void Scale( double factor )
+        {
+            A2 *= factor; AB *= factor; AC *= factor; AD *= factor;
+            B2 *= factor; BC *= factor; BD *= factor;
+            C2 *= factor; CD *= factor;
+            D2 *= factor;
+            Weight *= factor;
+        }
+
+        double Evaluate( const glm::vec3& point ) const
+        {
+            const double x = point.x;
+            const double y = point.y;
+            const double z = point.z;
+            const double error = A2 * x * x + B2 * y * y + C2 * z * z + D2 +
+                2.0 * ( AB * x * y + AC * x * z + BC * y * z + AD * x + BD * y + CD * z );
+            // rounding can take a point on every plane slightly below zero
+            return Weight > 0.0 ? std::max( error, 0.0 ) / Weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32 From;
+        uint32 To;
+        double Cost;
+    };
+
+    uint64 EdgeKey( uint32 a, uint32 b )
+    {
+        return a < b ? ( uint64( a ) << 32 ) | b : ( uint64( b ) << 32 ) | a;
+    }
+
+    glm::vec3 TriangleNormal( const glm::vec3& a, const glm::vec3& b, const glm::vec3& c )
+    {
+        return glm::cross( b - a, c - a );
+    }
+
+    // Triangles around every vertex. The triangles of vertex v are Triangles[Offsets[v]..Offsets[v + 1]).
+    struct VertexTriangles
+    {
+        std::vector<uint32> Offsets;
+        std::vector<uint32> Triangles;
+
+        void Build( std::span<const uint32> indices, size_t vertex_count )
+        {
+            Offsets.assign( vertex_count + 1, 0 );
+            for ( uint32 index : indices )
+            {
+                ++Offsets[index + 1];
+            }
+            std::partial_sum( Offsets.begin(), Offsets.end(), Offsets.begin() );
+
+            Triangles.resize( indices.size() );
+            std::vector<uint32> cursor( Offsets.begin(), Offsets.end() - 1 );
+            for ( size_t i = 0; i < indices.size(); ++i )
+            {
+                Triangles[cursor[indices[i]]++] = static_cast< uint32 >( i / 3 );
+            }
+        }
+
+        std::span<const uint32> Get( uint32 vertex ) const
+        {
+            return std::span<const uint32>( Triangles ).subspan( Offsets[vertex],
+                Offsets[vertex + 1] - Offsets[vertex] );
+        }
+    };
+
+    // true when moving `from` onto `to` turns a remaining triangle around `from` over or collapses it to a line
+    bool FlipsTriangle( std::span<const glm::vec3> positions, std::span<const uint32> indices,
+        const VertexTriangles& adjacency, uint32 from, uint32 to )
+    {
+        for ( uint32 triangle : adjacency.Get( from ) )
+        {
+            const uint32* corners = &indices[triangle * 3];
+            if ( corners[0] == to || corners[1] == to || corners[2] == to )
+            {
+                // shares the collapsed edge and disappears
+                continue;
+            }
+
+            glm::vec3 moved[3];
+            for ( uint32 corner = 0; corner < 3; ++corner )
+            {
+                moved[corner] = positions[corners[corner] == from ? to : corners[corner]];
+            }
+
+            const glm::vec3 before = TriangleNormal( positions[corners[0]], positions[corners[1]],
+                positions[corners[2]] );
+            const glm::vec3 after = TriangleNormal( moved[0], moved[1], moved[2] );
+            if ( glm::dot( before, after ) <= 0.0f )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+SimplifiedMesh SimplifyMesh( std::span<const glm::vec3> positions, std::span<const uint32> indices,
+    size_t target_index_count, float max_error )
+{
+    ASSERT( indices.size() % 3 == 0 );
+
+    SimplifiedMesh result;
+    result.Indices.assign( indices.begin(), indices.end() );
+    const size_t vertex_count = positions.size();
+
+    // an edge used by a single triangle is a border, both of its ends stay where they are
+    std::vector<uint64> edges;
+    edges.reserve( indices.size() );
+    for ( size_t i = 0; i < indices.size(); i += 3 )
+    {
+        for ( uint32 corner = 0; corner < 3; ++corner )
+        {
+            edges.push_back( EdgeKey( indices[i + corner], indices[i + ( corner + 1 ) % 3] ) );
+        }
+    }
+    std::sort( edges.begin(), edges.end() );
+
+    std::vector<bool> locked( vertex_count, false );
+    for ( size_t first = 0; first < edges.size(); )
+    {
+        size_t last = first + 1;
+        while ( last < edges.size() && edges[last] == edges[first] )
+        {
+            ++last;
+        }
+        if ( last - first == 1 )
+        {
+            locked[static_cast< uint32 >( edges[first] >> 32 )] = true;
+            locked[static_cast< uint32 >( edges[first] )] = true;
+        }
+        first = last;
+    }
+
+    std::vector<Quadric> quadrics( vertex_count );
+    for ( size_t i = 0; i < indices.size(); i += 3 )
+    {
+        const glm::vec3 normal = TriangleNormal( positions[indices[i]], positions[indices[i + 1]],
+            positions[indices[i + 2]] );
+        const float length = glm::length( normal );
+        if ( length == 0.0f )
+        {
+            continue;
+        }
+
+        const glm::dvec3 unit = glm::dvec3( normal / length );
+        const double distance = -glm::dot( unit, glm::dvec3( positions[indices[i]] ) );
+        const Quadric plane = Quadric::FromPlane( unit, distance, 0.5 * length );
+        for ( uint32 corner = 0; corner < 3; ++corner )
+        {
+            quadrics[indices[i + corner]].Add( plane );
+        }
+    }
+
+    const double max_cost = static_cast< double >( max_error ) * max_error;
+    VertexTriangles adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32> remap( vertex_count );
+    std::vector<bool> touched( vertex_count );
+
+    // Every pass collapses the cheapest edges whose neighbourhoods do not overlap, so the flip tests done
+    // against the positions at the start of the pass stay valid.
+    while ( result.Indices.size() > target_index_count )
+    {
+        adjacency.Build( result.Indices, vertex_count );
+
+        collapses.clear();
+        for ( size_t i = 0; i < result.Indices.size(); i += 3 )
+        {
+            for ( uint32 corner = 0; corner < 3; ++corner )
+            {
+                const uint32 a = result.Indices[i + corner];
+                const uint32 b = result.Indices[i + ( corner + 1 ) % 3];
+                for ( const auto [from, to] : { std::pair( a, b ), std::pair( b, a ) } )
+                {
+                    if ( locked[from] )
+                    {
+                        continue;
+                    }
+
+                    Quadric combined = quadrics[from];
+                    combined.Add( quadrics[to] );
+                    const double cost = combined.Evaluate( positions[to] );
+                    if ( cost <= max_cost )
+                    {
+                        collapses.push_back( { from, to, cost } );
+                    }
+                }
+            }
+        }
+        std::sort( collapses.begin(), collapses.end(), [] ( const Collapse& lhs, const Collapse& rhs ) {
+            return lhs.Cost < rhs.Cost;
+        } );
+
+        std::iota( remap.begin(), remap.end(), 0u );
+        std::fill( touched.begin(), touched.end(), false );
+
+        // an interior collapse removes the two triangles on its edge
+        const size_t excess = result.Indices.size() - target_index_count;
+        size_t removed = 0;
+        for ( const Collapse& collapse : collapses )
+        {
+            if ( removed >= excess )
+            {
+                break;
+            }
+            if ( touched[collapse.From] || touched[collapse.To] ||
+                FlipsTriangle( positions, result.Indices, adjacency, collapse.From, collapse.To ) )
+            {
+                continue;
+            }
+
+            remap[collapse.From] = collapse.To;
+            for ( uint32 triangle : adjacency.Get( collapse.From ) )
+            {
+                for ( uint32 corner = 0; corner < 3; ++corner )
+                {
+                    touched[result.Indices[triangle * 3 + corner]] = true;
+                }
+            }
+            quadrics[collapse.To].Add( quadrics[collapse.From] );
+            result.Error = std::max( result.Error, static_cast< float >( std::sqrt( collapse.Cost ) ) );
+            removed += 6;
+        }
+
+        if ( removed == 0 )
+        {
+            break;
+        }
+
+        size_t write = 0;
+        for ( size_t i = 0; i < result.Indices.size(); i += 3 )
+        {
+            const uint32 a = remap[result.Indices[i]];
+            const uint32 b = remap[result.Indices[i + 1]];
+            const uint32 c = remap[result.Indices[i + 2]];
+            if ( a == b || b == c || c == a )
+            {
+                continue;
+            }
+            result.Indices[write++] = a;
+            result.Indices[write++] = b;
+            result.Indices[write++] = c;
+        }
+        result.Indices.resize( write );
+    }
+
+    return result;
+}
@@ -0,0 +1,32 @@
+// Engine/Source/Engine/Scene/MeshSimplifier.h
+
+#ifndef __scene_mesh_simplifier_h_included__
+#define __scene_mesh_simplifier_h_included__
+
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Core/Common.h"
+
+// Edge collapse simplification of an indexed triangle list, ordered by quadric error metrics (Garland and
+// Heckbert). A collapse moves a vertex onto the other end of one of its edges, so the result indexes the
+// vertices of the input and every level of detail of a mesh can share one range of the vertex buffer.
+//
+// Vertices on a border are never moved. That includes the seams where a split in the attributes
+// duplicates a vertex, so silhouettes and texture mapping stay intact at the cost of stopping early on
+// meshes that are mostly border. Collapses that would flip a triangle are rejected.
+struct SimplifiedMesh
+{
+    std::vector<uint32> Indices;
+    // largest distance the surface moved by in a collapse, in the units of the positions, an area weighted
+    // root mean square over the triangles the collapse merged
+    float Error = 0.0f;
+};
+
+// stops once the index count is at most target_index_count or no collapse stays within max_error
+SimplifiedMesh SimplifyMesh( std::span<const glm::vec3> positions, std::span<const uint32> indices,
+    size_t target_index_count, float max_error );
+
+#endif
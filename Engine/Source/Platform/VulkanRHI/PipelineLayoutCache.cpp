@@ -0,0 +1,174 @@
+#include "PipelineLayoutCache.h"
+
+#include <algorithm>
+
+#include "Engine/Core/Hash.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		template<typename T>
+		uint64 HashValue( const T& value, uint64 seed )
+		{
+			return Hash::Bytes( std::span<const char>( reinterpret_cast< const char* >( &value ), sizeof( T ) ),
+				seed );
+		}
+
+		uint64 HashBindings( std::span<const VkDescriptorSetLayoutBinding> bindings )
+		{
+			uint64 hash = Hash::FNV_OFFSET_BASIS;
+			for ( const VkDescriptorSetLayoutBinding& binding : bindings )
+			{
+				hash = HashValue( binding.binding, hash );
+				hash = HashValue( binding.descriptorType, hash );
+				hash = HashValue( binding.descriptorCount, hash );
+				hash = HashValue( binding.stageFlags, hash );
+			}
+			return hash;
+		}
+
+		bool IsSameBinding( const VkDescriptorSetLayoutBinding& lhs, const VkDescriptorSetLayoutBinding& rhs )
+		{
+			return lhs.binding == rhs.binding && lhs.descriptorType == rhs.descriptorType &&
+				lhs.descriptorCount == rhs.descriptorCount && lhs.stageFlags == rhs.stageFlags;
+		}
+
+		bool IsSameRange( const std::optional<VkPushConstantRange>& lhs,
+			const std::optional<VkPushConstantRange>& rhs )
+		{
+			if ( !lhs || !rhs )
+			{
+				return lhs.has_value() == rhs.has_value();
+			}
+			return lhs->stageFlags == rhs->stageFlags && lhs->offset == rhs->offset && lhs->size == rhs->size;
+		}
+	}
+
+	Expected<VulkanPipelineLayout> PipelineLayoutCache::Get( VkDevice device, const ShaderReflection& reflection,
+		const VkAllocationCallbacks* alloc )
+	{
+		std::scoped_lock lock( Mutex );
+
+		// bindings are sorted by set, so every set is a contiguous run
+		const uint32 set_count = reflection.Bindings.empty() ? 0 : reflection.Bindings.back().Set + 1;
+		std::vector<VkDescriptorSetLayout> set_layouts;
+		set_layouts.reserve( set_count );
+
+		auto next = reflection.Bindings.begin();
+		for ( uint32 set = 0; set < set_count; ++set )
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			for ( ; next != reflection.Bindings.end() && next->Set == set; ++next )
+			{
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = next->Binding;
+				binding.descriptorType = next->Type;
+				binding.descriptorCount = next->Count;
+				binding.stageFlags = next->Stages;
+				bindings.push_back( binding );
+			}
+
+			auto set_layout_result = GetSetLayout( device, bindings, alloc );
+			if ( !set_layout_result )
+			{
+				return std::unexpected( set_layout_result.error() );
+			}
+			set_layouts.push_back( set_layout_result.value() );
+		}
+
+		uint64 hash = Hash::FNV_OFFSET_BASIS;
+		for ( VkDescriptorSetLayout set_layout : set_layouts )
+		{
+			hash = HashValue( set_layout, hash );
+		}
+		if ( reflection.PushConstants )
+		{
+			hash = HashValue( reflection.PushConstants->stageFlags, hash );
+			hash = HashValue( reflection.PushConstants->offset, hash );
+			hash = HashValue( reflection.PushConstants->size, hash );
+		}
+
+		auto [first, last] = PipelineLayouts.equal_range( hash );
+		for ( auto it = first; it != last; ++it )
+		{
+			const PipelineLayoutEntry& entry = it->second;
+			if ( entry.Layout.SetLayouts == set_layouts &&
+				IsSameRange( entry.PushConstants, reflection.PushConstants ) )
+			{
+				return entry.Layout;
+			}
+		}
+
+		VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipeline_layout_info.setLayoutCount = static_cast< uint32 >( set_layouts.size() );
+		pipeline_layout_info.pSetLayouts = set_layouts.data();
+		if ( reflection.PushConstants )
+		{
+			pipeline_layout_info.pushConstantRangeCount = 1;
+			pipeline_layout_info.pPushConstantRanges = &reflection.PushConstants.value();
+		}
+
+		PipelineLayoutEntry entry;
+		entry.PushConstants = reflection.PushConstants;
+		entry.Layout.SetLayouts = std::move( set_layouts );
+
+		VkResult err = vkCreatePipelineLayout( device, &pipeline_layout_info, alloc, &entry.Layout.Instance );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreatePipelineLayout, err ) );
+		}
+
+		PipelineLayouts.emplace( hash, entry );
+		return entry.Layout;
+	}
+
+	Expected<VkDescriptorSetLayout> PipelineLayoutCache::GetSetLayout( VkDevice device,
+		std::span<const VkDescriptorSetLayoutBinding> bindings, const VkAllocationCallbacks* alloc )
+	{
+		const uint64 hash = HashBindings( bindings );
+		auto [first, last] = SetLayouts.equal_range( hash );
+		for ( auto it = first; it != last; ++it )
+		{
+			if ( std::ranges::equal( it->second.Bindings, bindings, IsSameBinding ) )
+			{
+				return it->second.Instance;
+			}
+		}
+
+		VkDescriptorSetLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layout_info.bindingCount = static_cast< uint32 >( bindings.size() );
+		layout_info.pBindings = bindings.data();
+
+		SetLayoutEntry entry;
+		entry.Bindings.assign( bindings.begin(), bindings.end() );
+
+		VkResult err = vkCreateDescriptorSetLayout( device, &layout_info, alloc, &entry.Instance );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorSetLayout, err ) );
+		}
+
+		SetLayouts.emplace( hash, entry );
+		return entry.Instance;
+	}
+
+	void PipelineLayoutCache::Destroy( VkDevice device, const VkAllocationCallbacks* alloc )
+	{
+		for ( auto& [hash, entry] : PipelineLayouts )
+		{
+			vkDestroyPipelineLayout( device, entry.Layout.Instance, alloc );
+		}
+		PipelineLayouts.clear();
+
+		for ( auto& [hash, entry] : SetLayouts )
+		{
+			vkDestroyDescriptorSetLayout( device, entry.Instance, alloc );
+		}
+		SetLayouts.clear();
+	}
+
+} // namespace VulkanRHI
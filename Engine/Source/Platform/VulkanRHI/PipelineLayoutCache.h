@@ -0,0 +1,62 @@
+// Engine/Source/Platform/VulkanRHI/PipelineLayoutCache.h
+
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "VulkanError.h"
+#include "SpirvReflection.h"
+
+namespace VulkanRHI
+{
+
+	struct VulkanPipelineLayout
+	{
+		VkPipelineLayout Instance = VK_NULL_HANDLE;
+		// indexed by set number, sets no stage uses get an empty layout
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+	};
+
+	// Owns every descriptor set layout and pipeline layout. Identical layouts are created once, so
+	// pipelines with the same interface share handles and their descriptor sets are compatible, and a
+	// rebuilt pipeline can tell whether its interface changed by comparing the layout handle.
+	class PipelineLayoutCache
+	{
+	public:
+		// thread safe, startup creates pipelines on several workers
+		Expected<VulkanPipelineLayout> Get( VkDevice device, const ShaderReflection& reflection,
+			const VkAllocationCallbacks* alloc = nullptr );
+
+		void Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr );
+
+	private:
+		Expected<VkDescriptorSetLayout> GetSetLayout( VkDevice device,
+			std::span<const VkDescriptorSetLayoutBinding> bindings, const VkAllocationCallbacks* alloc );
+
+	private:
+		struct SetLayoutEntry
+		{
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			VkDescriptorSetLayout                     Instance = VK_NULL_HANDLE;
+		};
+
+		struct PipelineLayoutEntry
+		{
+			std::optional<VkPushConstantRange> PushConstants;
+			VulkanPipelineLayout               Layout;
+		};
+
+		// keyed by a hash of the contents, entries are compared in full on lookup
+		std::unordered_multimap<uint64, SetLayoutEntry>      SetLayouts;
+		std::unordered_multimap<uint64, PipelineLayoutEntry> PipelineLayouts;
+		std::mutex                                           Mutex;
+	};
+
+} // namespace VulkanRHI
@@ -0,0 +1,95 @@
+#include "ShaderCache.h"
+
+#include <fstream>
+
+#include "Engine/Core/Hash.h"
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		// bump when the key or the entry layout changes
+		constexpr std::string_view CACHE_FORMAT = "spirv-cache-1";
+	}
+
+	ShaderCache::ShaderCache( std::filesystem::path directory )
+		: Directory( std::move( directory ) )
+	{
+		std::error_code error;
+		std::filesystem::create_directories( Directory, error );
+		if ( error )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Failed to create shader cache {}: {}", Directory.string(),
+				error.message() );
+		}
+	}
+
+	uint64 ShaderCache::MakeKey( std::string_view preprocessed_source, std::span<const ShaderDefine> defines,
+		std::string_view compiler )
+	{
+		// a zero byte after every field so that moving text between fields changes the key
+		const std::string_view separator( "\0", 1 );
+
+		uint64 key = Hash::String( CACHE_FORMAT );
+		key = Hash::String( separator, Hash::String( compiler, key ) );
+		for ( const ShaderDefine& define : defines )
+		{
+			key = Hash::String( separator, Hash::String( define.Name, key ) );
+			key = Hash::String( separator, Hash::String( define.Value, key ) );
+		}
+		return Hash::String( preprocessed_source, key );
+	}
+
+	std::optional<std::vector<uint32>> ShaderCache::Load( uint64 key ) const
+	{
+		std::ifstream file( GetPath( key ), std::ios::ate | std::ios::binary );
+		if ( !file.is_open() )
+		{
+			return std::nullopt;
+		}
+
+		const size_t size = file.tellg();
+		if ( size == 0 || size % sizeof( uint32 ) != 0 )
+		{
+			return std::nullopt;
+		}
+
+		std::vector<uint32> spirv( size / sizeof( uint32 ) );
+		file.seekg( 0 );
+		file.read( reinterpret_cast< char* >( spirv.data() ), size );
+		if ( !file )
+		{
+			return std::nullopt;
+		}
+		return spirv;
+	}
+
+	bool ShaderCache::Store( uint64 key, std::span<const uint32> spirv ) const
+	{
+		// written under a temporary name and renamed, a reader never sees a partial entry
+		const std::filesystem::path path = GetPath( key );
+		std::filesystem::path temporary = path;
+		temporary += ".tmp";
+
+		{
+			std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+			file.write( reinterpret_cast< const char* >( spirv.data() ), spirv.size_bytes() );
+			if ( !file )
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename( temporary, path, error );
+		return !error;
+	}
+
+	std::filesystem::path ShaderCache::GetPath( uint64 key ) const
+	{
+		return Directory / ( Hash::ToHex( key ) + ".spv" );
+	}
+
+} // namespace VulkanRHI
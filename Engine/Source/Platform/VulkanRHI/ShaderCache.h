@@ -0,0 +1,45 @@
+// Engine/Source/Platform/VulkanRHI/ShaderCache.h
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include "Engine/Core/Common.h"
+
+namespace VulkanRHI
+{
+
+	struct ShaderDefine
+	{
+		std::string Name;
+		std::string Value;
+	};
+
+	// Content addressed store of compiled SPIR-V, one <key>.spv file per entry. The key hashes the
+	// preprocessed source, so edits to comments or to an unused include still hit, together with the
+	// defines and a description of the compiler and its options. Entries are never modified, a changed
+	// input is a different key.
+	class ShaderCache
+	{
+	public:
+		explicit ShaderCache( std::filesystem::path directory );
+
+		static uint64 MakeKey( std::string_view preprocessed_source, std::span<const ShaderDefine> defines,
+			std::string_view compiler );
+
+		std::optional<std::vector<uint32>> Load( uint64 key ) const;
+		bool Store( uint64 key, std::span<const uint32> spirv ) const;
+
+	private:
+		std::filesystem::path GetPath( uint64 key ) const;
+
+	private:
+		std::filesystem::path Directory;
+	};
+
+} // namespace VulkanRHI
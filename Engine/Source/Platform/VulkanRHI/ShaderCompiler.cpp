@@ -0,0 +1,318 @@
+#include "ShaderCompiler.h"
+
+#include <array>
+#include <format>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <optional>
+#include <iterator>
+#include <algorithm>
+
+#include <shaderc/shaderc.hpp>
+#include <vulkan/vulkan.h>
+
+#if defined( PLATFORM_WINDOWS )
+#   define NOMINMAX
+#   define WIN32_LEAN_AND_MEAN
+#   include <Windows.h>
+#elif defined( __linux__ )
+#   include <dlfcn.h>
+#endif
+
+#include "Engine/Core/Hash.h"
+#include "Engine/Core/Log.h"
+#include "Shader.h"
+#include "ShaderPermutation.h"
+
+// set by premake from the SDK the engine is built against, the one whose glslc compiles the shaders at build time
+#ifndef VULKAN_SDK_VERSION
+#define VULKAN_SDK_VERSION "unknown"
+#endif
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		std::optional<shaderc_shader_kind> GetShaderKind( const std::filesystem::path& path )
+		{
+			const std::filesystem::path extension = path.extension();
+			if ( extension == ".vert" )
+			{
+				return shaderc_vertex_shader;
+			}
+			if ( extension == ".frag" )
+			{
+				return shaderc_fragment_shader;
+			}
+			if ( extension == ".comp" )
+			{
+				return shaderc_compute_shader;
+			}
+			return std::nullopt;
+		}
+
+		// the shaderc library the process loaded, which need not come from the SDK the engine was built with
+		std::optional<std::filesystem::path> GetShadercLibraryPath()
+		{
+#if defined( PLATFORM_WINDOWS )
+			const HMODULE module = GetModuleHandleW( L"shaderc_shared.dll" );
+			if ( module == nullptr )
+			{
+				return std::nullopt;
+			}
+
+			std::wstring path( 32768, L'\0' );
+			const DWORD length = GetModuleFileNameW( module, path.data(), static_cast< DWORD >( path.size() ) );
+			if ( length == 0 || length == path.size() )
+			{
+				return std::nullopt;
+			}
+			path.resize( length );
+			return std::filesystem::path( path );
+#elif defined( __linux__ )
+			Dl_info info = {};
+			if ( dladdr( reinterpret_cast< void* >( &shaderc_compiler_initialize ), &info ) == 0 ||
+				info.dli_fname == nullptr )
+			{
+				return std::nullopt;
+			}
+			return std::filesystem::path( info.dli_fname );
+#else
+			return std::nullopt;
+#endif
+		}
+
+		std::optional<uint64> HashFile( const std::filesystem::path& path )
+		{
+			std::ifstream file( path, std::ios::binary );
+			if ( !file.is_open() )
+			{
+				return std::nullopt;
+			}
+
+			uint64 hash = Hash::FNV_OFFSET_BASIS;
+			std::array<char, 64 * 1024> buffer;
+			while ( file.read( buffer.data(), buffer.size() ) || file.gcount() > 0 )
+			{
+				const size_t size = static_cast< size_t >( file.gcount() );
+				hash = Hash::Bytes( std::span<const char>( buffer.data(), size ), hash );
+			}
+			return hash;
+		}
+
+		// Identifies everything besides the source that changes the output. The SDK version names the same
+		// shaderc and glslang as the glslc --version the build time cache is keyed by. The hash of the loaded
+		// library catches a runtime picking up a different shaderc than the one it was built against.
+		std::string DescribeCompiler()
+		{
+			uint32 spirv_version = 0;
+			uint32 spirv_revision = 0;
+			shaderc_get_spv_version( &spirv_version, &spirv_revision );
+
+			const uint32 headers = VK_HEADER_VERSION_COMPLETE;
+			std::string description = std::format( "shaderc sdk {} headers {}.{}.{} spv {:x}.{} vulkan1.0",
+				VULKAN_SDK_VERSION, VK_API_VERSION_MAJOR( headers ), VK_API_VERSION_MINOR( headers ),
+				VK_API_VERSION_PATCH( headers ), spirv_version, spirv_revision );
+
+			const std::optional<std::filesystem::path> library = GetShadercLibraryPath();
+			const std::optional<uint64> library_hash = library ? HashFile( *library ) : std::nullopt;
+			if ( library_hash )
+			{
+				description += std::format( " library {}", Hash::ToHex( *library_hash ) );
+			}
+			else
+			{
+				LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] The loaded shaderc library could not be identified, "
+					"cached shaders are only keyed by the SDK version." );
+			}
+#ifdef DEBUG
+			description += " debug-info";
+#endif
+			return description;
+		}
+
+		bool HasContents( const std::filesystem::path& path, std::span<const uint32> spirv )
+		{
+			const std::vector<char> current = GetShaderSource( path );
+			return current.size() == spirv.size_bytes() &&
+				std::memcmp( current.data(), spirv.data(), current.size() ) == 0;
+		}
+
+		// compiles one permutation, keywords are defined as 1
+		ShaderCompileResult Compile( const shaderc::Compiler& compiler,
+			const shaderc::CompileOptions& base_options, const ShaderCache& cache,
+			std::string_view compiler_description, const std::filesystem::path& source, std::string_view text,
+			std::span<const std::string> keywords )
+		{
+			const std::string file_name = source.filename().string();
+
+			ShaderCompileResult result;
+			result.Source = source;
+			result.Output = source.parent_path() / GetPermutationFileName( file_name, keywords );
+
+			shaderc::CompileOptions options( base_options );
+			std::vector<ShaderDefine> defines;
+			for ( const std::string& keyword : keywords )
+			{
+				options.AddMacroDefinition( keyword, "1" );
+				defines.push_back( { keyword, "1" } );
+			}
+
+			const shaderc_shader_kind kind = GetShaderKind( source ).value();
+			const shaderc::PreprocessedSourceCompilationResult preprocessed = compiler.PreprocessGlsl( text.data(),
+				text.size(), kind, file_name.c_str(), options );
+			if ( preprocessed.GetCompilationStatus() != shaderc_compilation_status_success )
+			{
+				result.Messages = preprocessed.GetErrorMessage();
+				return result;
+			}
+
+			const std::string_view preprocessed_source( preprocessed.cbegin(), preprocessed.cend() );
+			const uint64 key = ShaderCache::MakeKey( preprocessed_source, defines, compiler_description );
+
+			std::optional<std::vector<uint32>> spirv = cache.Load( key );
+			result.CacheHit = spirv.has_value();
+			if ( !spirv )
+			{
+				const shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv( text.data(), text.size(),
+					kind, file_name.c_str(), options );
+				result.Messages = module.GetErrorMessage();
+				if ( module.GetCompilationStatus() != shaderc_compilation_status_success )
+				{
+					return result;
+				}
+
+				spirv.emplace( module.cbegin(), module.cend() );
+				if ( !cache.Store( key, *spirv ) )
+				{
+					result.Messages += "Failed to store the shader in the cache.";
+				}
+			}
+
+			result.Succeeded = true;
+			if ( HasContents( result.Output, *spirv ) )
+			{
+				return result;
+			}
+
+			std::ofstream file( result.Output, std::ios::binary | std::ios::trunc );
+			file.write( reinterpret_cast< const char* >( spirv->data() ), spirv->size() * sizeof( uint32 ) );
+			if ( !file )
+			{
+				result.Messages += "Failed to write " + result.Output.string();
+				result.Succeeded = false;
+				return result;
+			}
+			result.Changed = true;
+			return result;
+		}
+
+		std::vector<ShaderCompileResult> CompilePermutations( const shaderc::Compiler& compiler,
+			const shaderc::CompileOptions& options, const ShaderCache& cache, std::string_view compiler_description,
+			const std::filesystem::path& source )
+		{
+			const std::vector<char> text = GetShaderSource( source );
+			const std::string_view source_text( text.data(), text.size() );
+			const std::vector<std::string> keywords = ParsePermutationKeywords( source_text );
+
+			ShaderCompileResult failure;
+			failure.Source = source;
+			if ( text.empty() )
+			{
+				failure.Messages = "Failed to read " + source.string();
+				return { failure };
+			}
+			if ( keywords.size() > MAX_PERMUTATION_KEYWORDS )
+			{
+				failure.Messages = std::format( "{} declares {} permutation keywords, at most {} are allowed.",
+					source.filename().string(), keywords.size(), MAX_PERMUTATION_KEYWORDS );
+				return { failure };
+			}
+
+			std::vector<ShaderCompileResult> results;
+			for ( const std::vector<std::string>& permutation : EnumeratePermutations( keywords ) )
+			{
+				results.push_back( Compile( compiler, options, cache, compiler_description, source, source_text,
+					permutation ) );
+			}
+			return results;
+		}
+	}
+
+	ShaderCompiler::ShaderCompiler( const std::filesystem::path& cache_directory )
+		: Cache( cache_directory )
+	{
+		Worker = std::thread( &ShaderCompiler::Run, this );
+	}
+
+	ShaderCompiler::~ShaderCompiler()
+	{
+		{
+			std::lock_guard lock( Mutex );
+			Running = false;
+		}
+		Wake.notify_one();
+		Worker.join();
+	}
+
+	void ShaderCompiler::Submit( const std::filesystem::path& source )
+	{
+		{
+			std::lock_guard lock( Mutex );
+			if ( std::ranges::find( Queue, source ) != Queue.end() )
+			{
+				return;
+			}
+			Queue.push_back( source );
+		}
+		Wake.notify_one();
+	}
+
+	std::vector<ShaderCompileResult> ShaderCompiler::TakeResults()
+	{
+		std::lock_guard lock( Mutex );
+		return std::exchange( Results, {} );
+	}
+
+	bool ShaderCompiler::IsShaderSource( const std::filesystem::path& path )
+	{
+		return GetShaderKind( path ).has_value();
+	}
+
+	void ShaderCompiler::Run()
+	{
+		// the compiler and options are not thread safe, the worker owns its own
+		const shaderc::Compiler compiler;
+		shaderc::CompileOptions options;
+		options.SetSourceLanguage( shaderc_source_language_glsl );
+		options.SetTargetEnvironment( shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0 );
+#ifdef DEBUG
+		options.SetGenerateDebugInfo();
+#endif
+		const std::string compiler_description = DescribeCompiler();
+
+		for ( ;; )
+		{
+			std::filesystem::path source;
+			{
+				std::unique_lock lock( Mutex );
+				Wake.wait( lock, [this] { return !Running || !Queue.empty(); } );
+				if ( !Running )
+				{
+					return;
+				}
+				source = std::move( Queue.front() );
+				Queue.pop_front();
+			}
+
+			std::vector<ShaderCompileResult> results = CompilePermutations( compiler, options, Cache,
+				compiler_description, source );
+
+			std::lock_guard lock( Mutex );
+			std::ranges::move( results, std::back_inserter( Results ) );
+		}
+	}
+
+} // namespace VulkanRHI
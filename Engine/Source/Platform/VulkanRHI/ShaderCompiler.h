@@ -0,0 +1,68 @@
+// Engine/Source/Platform/VulkanRHI/ShaderCompiler.h
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <condition_variable>
+
+#include "Engine/Core/Common.h"
+#include "ShaderCache.h"
+
+namespace VulkanRHI
+{
+
+	struct ShaderCompileResult
+	{
+		std::filesystem::path Source;
+		// <source>[.<KEYWORD>...].spv, written next to the source like the build does
+		std::filesystem::path Output;
+		// warnings, or the errors when the compilation failed
+		std::string Messages;
+		bool        Succeeded = false;
+		// the SPIR-V came from the cache instead of the compiler
+		bool        CacheHit = false;
+		// Output was rewritten, false when the new SPIR-V is identical to what it already held
+		bool        Changed = false;
+	};
+
+	// Compiles GLSL to SPIR-V with shaderc on a worker thread. The stage is taken from the extension
+	// (.vert, .frag, .comp). Submitting a source that is already queued does nothing. Sources are
+	// preprocessed first and looked up in the ShaderCache, only misses are compiled. Every permutation of
+	// the keywords a source declares is compiled and reported as a result of its own.
+	class ShaderCompiler
+	{
+	public:
+		explicit ShaderCompiler( const std::filesystem::path& cache_directory );
+		~ShaderCompiler();
+
+		ShaderCompiler( const ShaderCompiler& ) = delete;
+		ShaderCompiler& operator=( const ShaderCompiler& ) = delete;
+
+		void Submit( const std::filesystem::path& source );
+
+		// finished compilations since the last call, in completion order
+		std::vector<ShaderCompileResult> TakeResults();
+
+		static bool IsShaderSource( const std::filesystem::path& path );
+
+	private:
+		void Run();
+
+	private:
+		std::thread             Worker;
+		std::mutex              Mutex;
+		std::condition_variable Wake;
+		bool                    Running = true;
+
+		ShaderCache Cache;
+
+		std::deque<std::filesystem::path> Queue;
+		std::vector<ShaderCompileResult>  Results;
+	};
+
+} // namespace VulkanRHI
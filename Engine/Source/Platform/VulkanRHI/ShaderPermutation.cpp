@@ -0,0 +1,85 @@
+#include "ShaderPermutation.h"
+
+#include <algorithm>
+
+#include "Shader.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		constexpr std::string_view PERMUTATIONS_DIRECTIVE = "//! permutations:";
+		constexpr std::string_view WHITESPACE = " \t\r";
+	}
+
+	std::vector<std::string> ParsePermutationKeywords( std::string_view source )
+	{
+		std::vector<std::string> keywords;
+
+		const size_t directive = source.find( PERMUTATIONS_DIRECTIVE );
+		if ( directive == std::string_view::npos )
+		{
+			return keywords;
+		}
+
+		std::string_view line = source.substr( directive + PERMUTATIONS_DIRECTIVE.size() );
+		line = line.substr( 0, line.find( '\n' ) );
+		while ( !line.empty() )
+		{
+			const size_t begin = line.find_first_not_of( WHITESPACE );
+			if ( begin == std::string_view::npos )
+			{
+				break;
+			}
+			line.remove_prefix( begin );
+
+			const size_t end = std::min( line.find_first_of( WHITESPACE ), line.size() );
+			keywords.emplace_back( line.substr( 0, end ) );
+			line.remove_prefix( end );
+		}
+
+		std::ranges::sort( keywords );
+		const auto duplicates = std::ranges::unique( keywords );
+		keywords.erase( duplicates.begin(), duplicates.end() );
+		return keywords;
+	}
+
+	std::vector<std::string> ReadPermutationKeywords( const std::filesystem::path& source )
+	{
+		const std::vector<char> text = GetShaderSource( source );
+		return ParsePermutationKeywords( std::string_view( text.data(), text.size() ) );
+	}
+
+	std::string GetPermutationFileName( std::string_view source_name, std::span<const std::string> keywords )
+	{
+		std::string file_name( source_name );
+		for ( const std::string& keyword : keywords )
+		{
+			file_name += '.';
+			file_name += keyword;
+		}
+		return file_name + ".spv";
+	}
+
+	std::vector<std::vector<std::string>> EnumeratePermutations( std::span<const std::string> keywords )
+	{
+		const uint32 count = std::min( static_cast< uint32 >( keywords.size() ), MAX_PERMUTATION_KEYWORDS );
+
+		std::vector<std::vector<std::string>> permutations;
+		permutations.reserve( size_t( 1 ) << count );
+		for ( uint32 mask = 0; mask < ( 1u << count ); ++mask )
+		{
+			std::vector<std::string>& permutation = permutations.emplace_back();
+			for ( uint32 i = 0; i < count; ++i )
+			{
+				if ( mask & ( 1u << i ) )
+				{
+					permutation.push_back( keywords[i] );
+				}
+			}
+		}
+		return permutations;
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,44 @@
+// Engine/Source/Platform/VulkanRHI/ShaderPermutation.h
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <string_view>
+
+#include "Engine/Core/Common.h"
+
+namespace VulkanRHI
+{
+
+	// A feature toggle requested for a pipeline. Shaders expose keywords in two ways:
+	//
+	//   //! permutations: DEBUG_UV SKINNING
+	//   layout(constant_id = 0) const bool VERTEX_COLOR = false;
+	//
+	// Keywords on the permutations line are rare variants, every combination is compiled ahead of time
+	// with the keyword defined and stored as <source>.<KEYWORD>...spv. Specialization constants are
+	// common variants, they share one SPIR-V file and are set by name when the pipeline is created, so
+	// branches on them fold in the driver's compiler.
+	struct ShaderKeyword
+	{
+		std::string Name;
+		uint32      Value = 1;
+	};
+
+	// 2^4 files per source is the most a rare variant is allowed to cost
+	constexpr uint32 MAX_PERMUTATION_KEYWORDS = 4;
+
+	// Keywords of the permutations line, sorted. Empty when there is none.
+	std::vector<std::string> ParsePermutationKeywords( std::string_view source );
+	std::vector<std::string> ReadPermutationKeywords( const std::filesystem::path& source );
+
+	// "triangle.frag" with { "DEBUG_UV" } is "triangle.frag.DEBUG_UV.spv", keywords must be sorted
+	std::string GetPermutationFileName( std::string_view source_name, std::span<const std::string> keywords );
+
+	// every subset of keywords, starting with the empty one
+	std::vector<std::vector<std::string>> EnumeratePermutations( std::span<const std::string> keywords );
+
+} // namespace VulkanRHI
@@ -0,0 +1,846 @@
+#include "SpirvReflection.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		constexpr uint32 SPIRV_MAGIC = 0x07230203;
+		constexpr uint32 SPIRV_HEADER_WORDS = 5;
+		// universal limits of the SPIR-V specification, the tables below are sized by them
+		constexpr uint32 MAX_ID_BOUND = 4'194'303;
+		constexpr uint32 MAX_STRUCT_MEMBERS = 16'383;
+
+		// the few parts of the SPIR-V grammar the reflection needs, values from the SPIR-V specification
+		namespace Op
+		{
+			enum : uint16
+			{
+				Name = 5,
+				EntryPoint = 15,
+				TypeInt = 21,
+				TypeFloat = 22,
+				TypeVector = 23,
+				TypeMatrix = 24,
+				TypeImage = 25,
+				TypeSampler = 26,
+				TypeSampledImage = 27,
+				TypeArray = 28,
+				TypeRuntimeArray = 29,
+				TypeStruct = 30,
+				TypePointer = 32,
+				Constant = 43,
+				SpecConstantTrue = 48,
+				SpecConstantFalse = 49,
+				SpecConstant = 50,
+				Variable = 59,
+				Decorate = 71,
+				MemberDecorate = 72,
+				TypeAccelerationStructure = 5341,
+			};
+		}
+
+		namespace Decoration
+		{
+			enum : uint32
+			{
+				SpecId = 1,
+				Block = 2,
+				BufferBlock = 3,
+				ArrayStride = 6,
+				MatrixStride = 7,
+				BuiltIn = 11,
+				Location = 30,
+				Binding = 33,
+				DescriptorSet = 34,
+				Offset = 35,
+			};
+		}
+
+		namespace StorageClass
+		{
+			enum : uint32
+			{
+				UniformConstant = 0,
+				Input = 1,
+				Uniform = 2,
+				PushConstant = 9,
+				StorageBuffer = 12,
+			};
+		}
+
+		namespace ExecutionModel
+		{
+			enum : uint32
+			{
+				Vertex = 0,
+				TessellationControl = 1,
+				TessellationEvaluation = 2,
+				Geometry = 3,
+				Fragment = 4,
+				GLCompute = 5,
+			};
+		}
+
+		constexpr uint32 IMAGE_DIM_BUFFER = 5;
+		constexpr uint32 IMAGE_DIM_SUBPASS_DATA = 6;
+		constexpr uint32 IMAGE_SAMPLED_STORAGE = 2;
+
+		struct TypeInfo
+		{
+			uint16 Op = 0;
+			// int and float
+			uint32 Width = 0;
+			bool   Signed = false;
+			// vector, matrix, array, runtime array, pointer and sampled image
+			uint32 Element = 0;
+			// vector components, matrix columns, array length
+			uint32 Count = 0;
+			uint32 Storage = 0;
+			// image
+			uint32 Dim = 0;
+			uint32 Sampled = 0;
+			std::vector<uint32> Members;
+		};
+
+		struct IdDecorations
+		{
+			std::optional<uint32> Set;
+			std::optional<uint32> Binding;
+			std::optional<uint32> Location;
+			std::optional<uint32> SpecId;
+			uint32 ArrayStride = 0;
+			bool   Block = false;
+			bool   BufferBlock = false;
+			bool   BuiltIn = false;
+		};
+
+		struct MemberDecorations
+		{
+			uint32 Offset = 0;
+			uint32 MatrixStride = 0;
+			bool   BuiltIn = false;
+		};
+
+		struct SpecConstant
+		{
+			uint32 Id = 0;
+			uint32 Default = 0;
+		};
+
+		struct Variable
+		{
+			uint32 Id = 0;
+			uint32 Type = 0;
+			uint32 Storage = 0;
+		};
+
+		// SPIR-V ids are dense below the bound in the header, so everything is indexed by id. Parsing rejects
+		// ids past the bound and types that refer to types not declared before them, reflection can then
+		// follow any id it finds without checking it again.
+		class Module
+		{
+		public:
+			Expected<void> Parse( std::span<const uint32> spirv )
+			{
+				if ( spirv.size() < SPIRV_HEADER_WORDS || spirv[0] != SPIRV_MAGIC )
+				{
+					return Fail( "not a SPIR-V module" );
+				}
+
+				const uint32 bound = spirv[3];
+				if ( bound == 0 || bound > MAX_ID_BOUND )
+				{
+					return Fail( "id bound out of range" );
+				}
+				Types.resize( bound );
+				Decorations.resize( bound );
+				Members.resize( bound );
+				Constants.resize( bound );
+				Names.resize( bound );
+
+				for ( size_t word = SPIRV_HEADER_WORDS; word < spirv.size(); )
+				{
+					const uint16 opcode = static_cast< uint16 >( spirv[word] & 0xffff );
+					const uint16 count = static_cast< uint16 >( spirv[word] >> 16 );
+					if ( count == 0 || word + count > spirv.size() )
+					{
+						return Fail( "truncated instruction" );
+					}
+
+					auto result = ParseInstruction( opcode, spirv.subspan( word + 1, count - 1 ) );
+					if ( !result )
+					{
+						return result;
+					}
+					word += count;
+				}
+				return {};
+			}
+
+			Expected<ShaderReflection> Reflect() const
+			{
+				ShaderReflection reflection;
+				reflection.Stages = Stage;
+				if ( Stage == 0 )
+				{
+					return std::unexpected( Fail( "no supported entry point" ).error() );
+				}
+
+				for ( const Variable& variable : Variables )
+				{
+					Expected<void> result;
+					switch ( variable.Storage )
+					{
+						case StorageClass::UniformConstant:
+						case StorageClass::Uniform:
+						case StorageClass::StorageBuffer:
+							result = ReflectBinding( variable, reflection );
+							break;
+						case StorageClass::PushConstant:
+							result = ReflectPushConstants( variable, reflection );
+							break;
+						case StorageClass::Input:
+							if ( Stage == VK_SHADER_STAGE_VERTEX_BIT )
+							{
+								result = ReflectInput( variable, reflection );
+							}
+							break;
+						default:
+							break;
+					}
+
+					if ( !result )
+					{
+						return std::unexpected( result.error() );
+					}
+				}
+
+				std::ranges::sort( reflection.Bindings, {}, [] ( const ReflectedBinding& binding ) {
+					return std::pair( binding.Set, binding.Binding );
+				} );
+				std::ranges::sort( reflection.Inputs, {}, &ReflectedInput::Location );
+
+				for ( const SpecConstant& constant : SpecConstants )
+				{
+					const IdDecorations& decorations = Decorations[constant.Id];
+					if ( decorations.SpecId )
+					{
+						reflection.SpecConstants.push_back( { *decorations.SpecId, Names[constant.Id],
+							constant.Default } );
+					}
+				}
+				std::ranges::sort( reflection.SpecConstants, {}, &ReflectedSpecConstant::Id );
+				return reflection;
+			}
+
+		private:
+			static Expected<void> Fail( const char* detail,
+				std::source_location location = std::source_location::current() )
+			{
+				return std::unexpected( Error( ErrorCode::ReflectShader, VK_SUCCESS, detail, location ) );
+			}
+
+			// 0 is never a valid id
+			bool IsValid( uint32 id ) const
+			{
+				return id != 0 && id < Types.size();
+			}
+
+			// types are declared before their first use, which also rules out cycles between them
+			bool IsDeclared( uint32 id ) const
+			{
+				return IsValid( id ) && Types[id].Op != 0;
+			}
+
+			static bool IsTypeDeclaration( uint16 opcode )
+			{
+				switch ( opcode )
+				{
+					case Op::TypeInt:
+					case Op::TypeFloat:
+					case Op::TypeVector:
+					case Op::TypeMatrix:
+					case Op::TypeImage:
+					case Op::TypeSampler:
+					case Op::TypeSampledImage:
+					case Op::TypeArray:
+					case Op::TypeRuntimeArray:
+					case Op::TypeStruct:
+					case Op::TypePointer:
+					case Op::TypeAccelerationStructure:
+						return true;
+					default:
+						return false;
+				}
+			}
+
+			Expected<void> ParseInstruction( uint16 opcode, std::span<const uint32> operands )
+			{
+				// every instruction handled below starts with an id, the cases check for the operands they read
+				// past it, OpTypeSampler and OpTypeAccelerationStructureKHR have nothing else
+				if ( operands.empty() )
+				{
+					return {};
+				}
+
+				const uint32 id = operands[0];
+				switch ( opcode )
+				{
+					case Op::Name:
+					{
+						if ( !IsValid( id ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						// nul terminated and padded to a whole word
+						const auto* text = reinterpret_cast< const char* >( operands.data() + 1 );
+						const size_t size = ( operands.size() - 1 ) * sizeof( uint32 );
+						Names[id].assign( text, strnlen( text, size ) );
+						return {};
+					}
+
+					case Op::EntryPoint:
+						Stage = ToStage( operands[0] );
+						return {};
+
+					case Op::Decorate:
+						if ( !IsValid( id ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						if ( operands.size() > 1 )
+						{
+							Decorate( Decorations[id], operands[1], operands.size() > 2 ? operands[2] : 0 );
+						}
+						return {};
+
+					case Op::MemberDecorate:
+						if ( !IsValid( id ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						if ( operands.size() > 2 )
+						{
+							const uint32 member = operands[1];
+							if ( member >= MAX_STRUCT_MEMBERS )
+							{
+								return Fail( "member index out of range" );
+							}
+							if ( Members[id].size() <= member )
+							{
+								Members[id].resize( member + 1 );
+							}
+							DecorateMember( Members[id][member], operands[2], operands.size() > 3 ? operands[3] : 0 );
+						}
+						return {};
+
+					case Op::Constant:
+					case Op::SpecConstant:
+						// result type, result id, low word of the value
+						if ( operands.size() < 3 )
+						{
+							return Fail( "truncated constant" );
+						}
+						if ( !IsValid( operands[0] ) || !IsValid( operands[1] ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						Constants[operands[1]] = operands[2];
+						if ( opcode == Op::SpecConstant )
+						{
+							SpecConstants.push_back( { operands[1], operands[2] } );
+						}
+						return {};
+
+					case Op::SpecConstantTrue:
+					case Op::SpecConstantFalse:
+						if ( operands.size() < 2 )
+						{
+							return Fail( "truncated constant" );
+						}
+						if ( !IsValid( operands[0] ) || !IsValid( operands[1] ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						SpecConstants.push_back( { operands[1], opcode == Op::SpecConstantTrue ? 1u : 0u } );
+						return {};
+
+					case Op::Variable:
+						// result type, result id, storage class
+						if ( operands.size() < 3 )
+						{
+							return Fail( "truncated variable" );
+						}
+						if ( !IsDeclared( operands[0] ) || !IsValid( operands[1] ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						Variables.push_back( { operands[1], operands[0], operands[2] } );
+						return {};
+
+					default:
+						break;
+				}
+
+				if ( !IsTypeDeclaration( opcode ) )
+				{
+					return {};
+				}
+				if ( !IsValid( id ) )
+				{
+					return Fail( "id out of bounds" );
+				}
+				if ( Types[id].Op != 0 )
+				{
+					return Fail( "type declared twice" );
+				}
+
+				TypeInfo& type = Types[id];
+				switch ( opcode )
+				{
+					case Op::TypeInt:
+					case Op::TypeFloat:
+						if ( operands.size() < 2 )
+						{
+							return Fail( "truncated scalar type" );
+						}
+						// floats are signed, an integer says so in its third operand
+						type.Width = operands[1];
+						type.Signed = opcode == Op::TypeFloat || ( operands.size() > 2 && operands[2] != 0 );
+						break;
+					case Op::TypeVector:
+					case Op::TypeMatrix:
+						if ( operands.size() < 3 )
+						{
+							return Fail( "truncated vector or matrix type" );
+						}
+						if ( !IsDeclared( operands[1] ) )
+						{
+							return Fail( "undeclared element type" );
+						}
+						type.Element = operands[1];
+						type.Count = operands[2];
+						break;
+					case Op::TypeImage:
+						// sampled type, dim, depth, arrayed, multisampled, sampled
+						if ( operands.size() < 7 )
+						{
+							return Fail( "truncated image type" );
+						}
+						type.Dim = operands[2];
+						type.Sampled = operands[6];
+						break;
+					case Op::TypeSampledImage:
+					case Op::TypeRuntimeArray:
+						if ( operands.size() < 2 )
+						{
+							return Fail( "truncated sampled image or runtime array type" );
+						}
+						if ( !IsDeclared( operands[1] ) )
+						{
+							return Fail( "undeclared element type" );
+						}
+						type.Element = operands[1];
+						break;
+					case Op::TypeArray:
+						if ( operands.size() < 3 )
+						{
+							return Fail( "truncated array type" );
+						}
+						if ( !IsDeclared( operands[1] ) || !IsValid( operands[2] ) )
+						{
+							return Fail( "undeclared element type" );
+						}
+						// constants are declared before the types that use them
+						type.Element = operands[1];
+						type.Count = Constants[operands[2]];
+						break;
+					case Op::TypeStruct:
+						if ( operands.size() - 1 > MAX_STRUCT_MEMBERS )
+						{
+							return Fail( "too many struct members" );
+						}
+						for ( uint32 member : operands.subspan( 1 ) )
+						{
+							if ( !IsDeclared( member ) )
+							{
+								return Fail( "undeclared member type" );
+							}
+						}
+						type.Members.assign( operands.begin() + 1, operands.end() );
+						break;
+					case Op::TypePointer:
+						if ( operands.size() < 3 )
+						{
+							return Fail( "truncated pointer type" );
+						}
+						// may point at a type declared later through OpTypeForwardPointer
+						if ( !IsValid( operands[2] ) )
+						{
+							return Fail( "id out of bounds" );
+						}
+						type.Storage = operands[1];
+						type.Element = operands[2];
+						break;
+					default:
+						// OpTypeSampler and OpTypeAccelerationStructureKHR have nothing past their id
+						break;
+				}
+				type.Op = opcode;
+				return {};
+			}
+
+			static void Decorate( IdDecorations& decorations, uint32 decoration, uint32 value )
+			{
+				switch ( decoration )
+				{
+					case Decoration::Block: decorations.Block = true; break;
+					case Decoration::BufferBlock: decorations.BufferBlock = true; break;
+					case Decoration::ArrayStride: decorations.ArrayStride = value; break;
+					case Decoration::BuiltIn: decorations.BuiltIn = true; break;
+					case Decoration::Location: decorations.Location = value; break;
+					case Decoration::SpecId: decorations.SpecId = value; break;
+					case Decoration::Binding: decorations.Binding = value; break;
+					case Decoration::DescriptorSet: decorations.Set = value; break;
+					default: break;
+				}
+			}
+
+			static void DecorateMember( MemberDecorations& decorations, uint32 decoration, uint32 value )
+			{
+				switch ( decoration )
+				{
+					case Decoration::Offset: decorations.Offset = value; break;
+					case Decoration::MatrixStride: decorations.MatrixStride = value; break;
+					case Decoration::BuiltIn: decorations.BuiltIn = true; break;
+					default: break;
+				}
+			}
+
+			static VkShaderStageFlags ToStage( uint32 execution_model )
+			{
+				switch ( execution_model )
+				{
+					case ExecutionModel::Vertex: return VK_SHADER_STAGE_VERTEX_BIT;
+					case ExecutionModel::TessellationControl: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+					case ExecutionModel::TessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+					case ExecutionModel::Geometry: return VK_SHADER_STAGE_GEOMETRY_BIT;
+					case ExecutionModel::Fragment: return VK_SHADER_STAGE_FRAGMENT_BIT;
+					case ExecutionModel::GLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
+					default: return 0;
+				}
+			}
+
+			const TypeInfo& GetPointee( const Variable& variable ) const
+			{
+				return Types[Types[variable.Type].Element];
+			}
+
+			Expected<void> ReflectBinding( const Variable& variable, ShaderReflection& reflection ) const
+			{
+				const IdDecorations& decorations = Decorations[variable.Id];
+				if ( !decorations.Binding )
+				{
+					return Fail( "resource without a binding" );
+				}
+
+				ReflectedBinding binding;
+				binding.Set = decorations.Set.value_or( 0 );
+				binding.Binding = *decorations.Binding;
+				binding.Stages = Stage;
+
+				uint32 type_id = Types[variable.Type].Element;
+				while ( Types[type_id].Op == Op::TypeArray || Types[type_id].Op == Op::TypeRuntimeArray )
+				{
+					if ( Types[type_id].Op == Op::TypeRuntimeArray )
+					{
+						return Fail( "runtime descriptor arrays are not supported" );
+					}
+					binding.Count *= Types[type_id].Count;
+					type_id = Types[type_id].Element;
+				}
+
+				const TypeInfo& type = Types[type_id];
+				switch ( type.Op )
+				{
+					case Op::TypeSampledImage:
+						binding.Type = Types[type.Element].Dim == IMAGE_DIM_BUFFER ?
+							VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+						break;
+					case Op::TypeImage:
+						if ( type.Dim == IMAGE_DIM_SUBPASS_DATA )
+						{
+							binding.Type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+						}
+						else if ( type.Dim == IMAGE_DIM_BUFFER )
+						{
+							binding.Type = type.Sampled == IMAGE_SAMPLED_STORAGE ?
+								VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+						}
+						else
+						{
+							binding.Type = type.Sampled == IMAGE_SAMPLED_STORAGE ?
+								VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+						}
+						break;
+					case Op::TypeSampler:
+						binding.Type = VK_DESCRIPTOR_TYPE_SAMPLER;
+						break;
+					case Op::TypeAccelerationStructure:
+						binding.Type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+						break;
+					case Op::TypeStruct:
+						// before SPIR-V 1.3 storage buffers are Uniform blocks decorated as BufferBlock
+						binding.Type = variable.Storage == StorageClass::StorageBuffer || Decorations[type_id].BufferBlock ?
+							VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+						break;
+					default:
+						return Fail( "unsupported resource type" );
+				}
+
+				reflection.Bindings.push_back( binding );
+				return {};
+			}
+
+			Expected<void> ReflectPushConstants( const Variable& variable, ShaderReflection& reflection ) const
+			{
+				const uint32 block = Types[variable.Type].Element;
+				const TypeInfo& type = Types[block];
+				if ( type.Op != Op::TypeStruct || type.Members.empty() )
+				{
+					return Fail( "push constants are not a block" );
+				}
+
+				uint32 begin = UINT32_MAX;
+				uint32 end = 0;
+				for ( uint32 member = 0; member < type.Members.size(); ++member )
+				{
+					const MemberDecorations decorations = GetMember( block, member );
+					begin = std::min( begin, decorations.Offset );
+					end = std::max( end, decorations.Offset + GetSize( type.Members[member], decorations.MatrixStride ) );
+				}
+
+				VkPushConstantRange range = {};
+				range.stageFlags = Stage;
+				range.offset = begin;
+				range.size = end - begin;
+				reflection.PushConstants = range;
+				return {};
+			}
+
+			Expected<void> ReflectInput( const Variable& variable, ShaderReflection& reflection ) const
+			{
+				const IdDecorations& decorations = Decorations[variable.Id];
+				if ( decorations.BuiltIn )
+				{
+					return {};
+				}
+				if ( !decorations.Location )
+				{
+					// built-in blocks such as gl_PerVertex carry the decoration on their members
+					return {};
+				}
+
+				uint32 location = *decorations.Location;
+				uint32 type_id = Types[variable.Type].Element;
+				uint32 repeat = 1;
+				if ( Types[type_id].Op == Op::TypeArray )
+				{
+					repeat = Types[type_id].Count;
+					type_id = Types[type_id].Element;
+				}
+
+				// a matrix takes one location per column
+				uint32 columns = 1;
+				if ( Types[type_id].Op == Op::TypeMatrix )
+				{
+					columns = Types[type_id].Count;
+					type_id = Types[type_id].Element;
+				}
+
+				const VkFormat format = GetFormat( type_id );
+				if ( format == VK_FORMAT_UNDEFINED )
+				{
+					return Fail( "unsupported vertex input type" );
+				}
+
+				for ( uint32 i = 0; i < repeat * columns; ++i )
+				{
+					reflection.Inputs.push_back( { location++, format } );
+				}
+				return {};
+			}
+
+			MemberDecorations GetMember( uint32 block, uint32 member ) const
+			{
+				return member < Members[block].size() ? Members[block][member] : MemberDecorations{};
+			}
+
+			uint32 GetSize( uint32 type_id, uint32 matrix_stride ) const
+			{
+				const TypeInfo& type = Types[type_id];
+				switch ( type.Op )
+				{
+					case Op::TypeInt:
+					case Op::TypeFloat:
+						return type.Width / 8;
+					case Op::TypeVector:
+						return type.Count * GetSize( type.Element, 0 );
+					case Op::TypeMatrix:
+						return type.Count * ( matrix_stride ? matrix_stride : GetSize( type.Element, 0 ) );
+					case Op::TypeArray:
+					{
+						const uint32 stride = Decorations[type_id].ArrayStride;
+						return type.Count * ( stride ? stride : GetSize( type.Element, matrix_stride ) );
+					}
+					case Op::TypeStruct:
+					{
+						uint32 size = 0;
+						for ( uint32 member = 0; member < type.Members.size(); ++member )
+						{
+							const MemberDecorations decorations = GetMember( type_id, member );
+							size = std::max( size, decorations.Offset +
+								GetSize( type.Members[member], decorations.MatrixStride ) );
+						}
+						return size;
+					}
+					default:
+						return 0;
+				}
+			}
+
+			VkFormat GetFormat( uint32 type_id ) const
+			{
+				const TypeInfo& type = Types[type_id];
+				const uint32 components = type.Op == Op::TypeVector ? type.Count : 1;
+				const TypeInfo& scalar = type.Op == Op::TypeVector ? Types[type.Element] : type;
+				if ( scalar.Width != 32 || components < 1 || components > 4 )
+				{
+					return VK_FORMAT_UNDEFINED;
+				}
+
+				static constexpr VkFormat FLOAT_FORMATS[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+					VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+				static constexpr VkFormat SINT_FORMATS[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT,
+					VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+				static constexpr VkFormat UINT_FORMATS[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT,
+					VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+				switch ( scalar.Op )
+				{
+					case Op::TypeFloat: return FLOAT_FORMATS[components - 1];
+					case Op::TypeInt: return scalar.Signed ? SINT_FORMATS[components - 1] : UINT_FORMATS[components - 1];
+					default: return VK_FORMAT_UNDEFINED;
+				}
+			}
+
+		private:
+			VkShaderStageFlags                          Stage = 0;
+			std::vector<TypeInfo>                       Types;
+			std::vector<IdDecorations>                  Decorations;
+			std::vector<std::vector<MemberDecorations>> Members;
+			std::vector<uint32>                         Constants;
+			std::vector<std::string>                    Names;
+			std::vector<SpecConstant>                   SpecConstants;
+			std::vector<Variable>                       Variables;
+		};
+	}
+
+	Expected<void> ShaderReflection::Merge( const ShaderReflection& other )
+	{
+		Stages |= other.Stages;
+
+		for ( const ReflectedBinding& binding : other.Bindings )
+		{
+			auto it = std::ranges::find_if( Bindings, [&binding] ( const ReflectedBinding& existing ) {
+				return existing.Set == binding.Set && existing.Binding == binding.Binding;
+			} );
+
+			if ( it == Bindings.end() )
+			{
+				Bindings.push_back( binding );
+			}
+			else if ( it->Type != binding.Type || it->Count != binding.Count )
+			{
+				return std::unexpected( Error( ErrorCode::ReflectShader, VK_SUCCESS,
+					"stages disagree on the type of a binding" ) );
+			}
+			else
+			{
+				it->Stages |= binding.Stages;
+			}
+		}
+		std::ranges::sort( Bindings, {}, [] ( const ReflectedBinding& binding ) {
+			return std::pair( binding.Set, binding.Binding );
+		} );
+
+		// one range covering both blocks, visible to both stages
+		if ( other.PushConstants && PushConstants )
+		{
+			const uint32 begin = std::min( PushConstants->offset, other.PushConstants->offset );
+			const uint32 end = std::max( PushConstants->offset + PushConstants->size,
+				other.PushConstants->offset + other.PushConstants->size );
+			PushConstants->stageFlags |= other.PushConstants->stageFlags;
+			PushConstants->offset = begin;
+			PushConstants->size = end - begin;
+		}
+		else if ( other.PushConstants )
+		{
+			PushConstants = other.PushConstants;
+		}
+
+		if ( Inputs.empty() )
+		{
+			Inputs = other.Inputs;
+		}
+
+		for ( const ReflectedSpecConstant& constant : other.SpecConstants )
+		{
+			auto it = std::ranges::find( SpecConstants, constant.Id, &ReflectedSpecConstant::Id );
+			if ( it == SpecConstants.end() )
+			{
+				SpecConstants.push_back( constant );
+			}
+			else if ( it->Name != constant.Name )
+			{
+				return std::unexpected( Error( ErrorCode::ReflectShader, VK_SUCCESS,
+					"stages give a constant_id different names" ) );
+			}
+		}
+		std::ranges::sort( SpecConstants, {}, &ReflectedSpecConstant::Id );
+		return {};
+	}
+
+	const ReflectedSpecConstant* ShaderReflection::FindSpecConstant( std::string_view name ) const
+	{
+		auto it = std::ranges::find( SpecConstants, name, &ReflectedSpecConstant::Name );
+		return it != SpecConstants.end() ? &*it : nullptr;
+	}
+
+	void ShaderReflection::PromoteDynamicUniformBuffers()
+	{
+		for ( ReflectedBinding& binding : Bindings )
+		{
+			if ( binding.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER )
+			{
+				binding.Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			}
+		}
+	}
+
+	Expected<ShaderReflection> ReflectSpirv( std::span<const uint32> spirv )
+	{
+		Module module;
+		auto parse_result = module.Parse( spirv );
+		if ( !parse_result )
+		{
+			return std::unexpected( parse_result.error() );
+		}
+		return module.Reflect();
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,68 @@
+// Engine/Source/Platform/VulkanRHI/SpirvReflection.h
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "VulkanError.h"
+
+namespace VulkanRHI
+{
+
+	struct ReflectedBinding
+	{
+		uint32             Set = 0;
+		uint32             Binding = 0;
+		VkDescriptorType   Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32             Count = 1;
+		VkShaderStageFlags Stages = 0;
+	};
+
+	// one per location, a matrix or an array input takes several consecutive locations
+	struct ReflectedInput
+	{
+		uint32   Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+	};
+
+	// layout(constant_id = Id), 32-bit scalars only
+	struct ReflectedSpecConstant
+	{
+		uint32      Id = 0;
+		std::string Name;
+		uint32      Default = 0;
+	};
+
+	// What a pipeline has to provide to a shader, read from the SPIR-V instead of mirrored by hand.
+	struct ShaderReflection
+	{
+		VkShaderStageFlags Stages = 0;
+
+		// sorted by set, then binding
+		std::vector<ReflectedBinding> Bindings;
+		// vertex stage inputs sorted by location, built-ins excluded
+		std::vector<ReflectedInput> Inputs;
+		std::optional<VkPushConstantRange> PushConstants;
+		// sorted by id
+		std::vector<ReflectedSpecConstant> SpecConstants;
+
+		// Adds the resources of another stage. Fails when both stages use the same binding with
+		// different descriptor types or counts, or give the same constant_id different names.
+		Expected<void> Merge( const ShaderReflection& other );
+
+		// The renderer feeds every uniform buffer from a frame ring with a dynamic offset, which the
+		// shader cannot express.
+		void PromoteDynamicUniformBuffers();
+
+		const ReflectedSpecConstant* FindSpecConstant( std::string_view name ) const;
+	};
+
+	Expected<ShaderReflection> ReflectSpirv( std::span<const uint32> spirv );
+
+} // namespace VulkanRHI
@@ -0,0 +1,97 @@
+#include "VulkanDeletionQueue.h"
+
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	Expected<void> VulkanDeletionQueue::Init( VkDevice device, bool timeline_semaphore,
+		const VkAllocationCallbacks* alloc )
+	{
+		if ( !timeline_semaphore )
+		{
+			return {};
+		}
+
+		VkSemaphoreTypeCreateInfo type_info = {};
+		type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		type_info.initialValue = SubmittedValue;
+
+		VkSemaphoreCreateInfo semaphore_info = {};
+		semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphore_info.pNext = &type_info;
+
+		VkResult err = vkCreateSemaphore( device, &semaphore_info, alloc, &Timeline );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateSyncSemaphore, err, "timeline" ) );
+		}
+		return {};
+	}
+
+	void VulkanDeletionQueue::Destroy( VkDevice device, const VkAllocationCallbacks* alloc )
+	{
+		for ( Entry& entry : Entries )
+		{
+			entry.Destroy( device, alloc );
+		}
+		Entries.clear();
+
+		vkDestroySemaphore( device, Timeline, alloc );
+		Timeline = VK_NULL_HANDLE;
+	}
+
+	uint32 VulkanDeletionQueue::Collect( VkDevice device, const VkAllocationCallbacks* alloc )
+	{
+		if ( Entries.empty() )
+		{
+			return 0;
+		}
+
+		if ( Timeline )
+		{
+			uint64 value = 0;
+			VkResult err = vkGetSemaphoreCounterValue( device, Timeline, &value );
+			if ( err != VK_SUCCESS )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::GetSemaphoreCounterValue, err ) );
+				return 0;
+			}
+			MarkCompleted( value );
+		}
+
+		uint32 destroyed = 0;
+		while ( !Entries.empty() && Entries.front().Value <= CompletedValue )
+		{
+			Entries.front().Destroy( device, alloc );
+			Entries.pop_front();
+			++destroyed;
+		}
+		return destroyed;
+	}
+
+	Expected<void> VulkanDeletionQueue::Wait( VkDevice device, uint64 value )
+	{
+		if ( !Timeline || value <= CompletedValue )
+		{
+			return {};
+		}
+
+		VkSemaphoreWaitInfo wait_info = {};
+		wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores = &Timeline;
+		wait_info.pValues = &value;
+
+		const uint64 timeout = UINT64_MAX;
+		VkResult err = vkWaitSemaphores( device, &wait_info, timeout );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::WaitSemaphores, err ) );
+		}
+		MarkCompleted( value );
+		return {};
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,99 @@
+// Engine/Source/Platform/VulkanRHI/VulkanDeletionQueue.h
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "VulkanError.h"
+
+namespace VulkanRHI
+{
+
+	// Objects still referenced by submitted work, each retired with the timeline value of the last submission
+	// that may use it and destroyed by Collect once the GPU passed that value. Every submission on the
+	// graphics queue signals the next value, uploads as well as frames, so values complete in order.
+	// Without timeline semaphores the completed value is reported from the frame fences instead and
+	// uploads wait for the queue. Render thread only.
+	class VulkanDeletionQueue
+	{
+	public:
+		using Deleter = std::function<void( VkDevice, const VkAllocationCallbacks* )>;
+
+		Expected<void> Init( VkDevice device, bool timeline_semaphore,
+			const VkAllocationCallbacks* alloc = nullptr );
+		// everything still queued is destroyed, the caller waits for the GPU first
+		void Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr );
+
+		// null without timeline semaphore support
+		VkSemaphore GetTimeline() const
+		{
+			return Timeline;
+		}
+
+		// value to signal with the next submission
+		uint64 Advance()
+		{
+			return ++SubmittedValue;
+		}
+
+		uint64 GetSubmittedValue() const
+		{
+			return SubmittedValue;
+		}
+
+		uint64 GetCompletedValue() const
+		{
+			return CompletedValue;
+		}
+
+		// for completion observed through a fence or a queue wait
+		void MarkCompleted( uint64 value )
+		{
+			CompletedValue = std::max( CompletedValue, value );
+		}
+
+		void Retire( uint64 value, Deleter deleter )
+		{
+			Entries.push_back( { value, std::move( deleter ) } );
+		}
+
+		// by value, the queue owns the resource from here on and calls its Destroy
+		template<typename Resource>
+		void RetireResource( uint64 value, Resource resource )
+		{
+			Retire( value, [resource] ( VkDevice device, const VkAllocationCallbacks* alloc ) mutable {
+				resource.Destroy( device, alloc );
+			} );
+		}
+
+		// destroys what the GPU is done with, returns the number of objects destroyed
+		uint32 Collect( VkDevice device, const VkAllocationCallbacks* alloc = nullptr );
+		// blocks until the value completed, only meant for shutdown
+		Expected<void> Wait( VkDevice device, uint64 value );
+
+		uint32 GetPendingCount() const
+		{
+			return static_cast< uint32 >( Entries.size() );
+		}
+
+	private:
+		struct Entry
+		{
+			uint64  Value = 0;
+			Deleter Destroy;
+		};
+
+		VkSemaphore       Timeline = VK_NULL_HANDLE;
+		uint64            SubmittedValue = 0;
+		uint64            CompletedValue = 0;
+		// in retirement order, an entry waiting for a later value may hold back the ones behind it for a while
+		std::deque<Entry> Entries;
+	};
+
+} // namespace VulkanRHI
@@ -0,0 +1,262 @@
+#include "VulkanDevice.h"
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		constexpr std::array<const char*, 1> REQUIRED_EXTENSIONS = {
+			VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+		};
+
+		constexpr std::array<const char*, 1> MEMORY_BUDGET_EXTENSIONS = {
+			VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+		};
+
+		constexpr std::array<const char*, 2> DYNAMIC_RENDERING_EXTENSIONS = {
+			VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+			VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+		};
+
+		bool HasExtensions( std::span<const VkExtensionProperties> available, std::span<const char* const> names )
+		{
+			return std::ranges::all_of( names, [available] ( const char* name ) {
+				return std::ranges::any_of( available, [name] ( const VkExtensionProperties& extension ) {
+					return std::strcmp( extension.extensionName, name ) == 0;
+				} );
+			} );
+		}
+
+		Expected<std::vector<VkExtensionProperties>> GetDeviceExtensions( VkPhysicalDevice gpu )
+		{
+			uint32 count_extensions = 0;
+			const char* layer_name = nullptr;
+			VkResult err = vkEnumerateDeviceExtensionProperties( gpu, layer_name, &count_extensions, nullptr );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::EnumerateDeviceExtensions, err ) );
+			}
+
+			std::vector<VkExtensionProperties> extensions( count_extensions );
+			err = vkEnumerateDeviceExtensionProperties( gpu, layer_name, &count_extensions, extensions.data() );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::EnumerateDeviceExtensions, err ) );
+			}
+			return extensions;
+		}
+
+		// Both extensions build on Vulkan 1.2 (depth stencil resolve and create render pass 2 are core
+		// there), so older devices use render pass objects even when they report the extensions.
+		bool SupportsDynamicRendering( VkPhysicalDevice gpu, const VkPhysicalDeviceProperties& props,
+			std::span<const VkExtensionProperties> extensions )
+		{
+			if ( props.apiVersion < VK_API_VERSION_1_2 || !HasExtensions( extensions, DYNAMIC_RENDERING_EXTENSIONS ) )
+			{
+				return false;
+			}
+
+			VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features = {};
+			synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+			VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {};
+			dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+			dynamic_rendering_features.pNext = &synchronization2_features;
+
+			VkPhysicalDeviceFeatures2 features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &dynamic_rendering_features;
+			vkGetPhysicalDeviceFeatures2( gpu, &features );
+
+			return dynamic_rendering_features.dynamicRendering && synchronization2_features.synchronization2;
+		}
+
+		bool SupportsTimelineSemaphore( VkPhysicalDevice gpu, const VkPhysicalDeviceProperties& props )
+		{
+			if ( props.apiVersion < VK_API_VERSION_1_2 )
+			{
+				return false;
+			}
+
+			VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+			timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+			VkPhysicalDeviceFeatures2 features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &timeline_features;
+			vkGetPhysicalDeviceFeatures2( gpu, &features );
+
+			return timeline_features.timelineSemaphore;
+		}
+
+		VkDeviceSize GetDeviceLocalMemory( VkPhysicalDevice gpu )
+		{
+			VkPhysicalDeviceMemoryProperties memory_props;
+			vkGetPhysicalDeviceMemoryProperties( gpu, &memory_props );
+
+			VkDeviceSize size = 0;
+			for ( uint32 i = 0; i < memory_props.memoryHeapCount; ++i )
+			{
+				if ( memory_props.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+				{
+					size += memory_props.memoryHeaps[i].size;
+				}
+			}
+			return size;
+		}
+
+		int64 ScoreDeviceType( VkPhysicalDeviceType type )
+		{
+			switch ( type )
+			{
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return 100000;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 10000;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return 5000;
+			case VK_PHYSICAL_DEVICE_TYPE_CPU:            return 1000;
+			default:                                     return 0;
+			}
+		}
+	}
+
+	std::vector<uint32> VulkanQueueFamilyIndices::GetUniqueFamilies() const
+	{
+		std::vector<uint32> families;
+		for ( const std::optional<uint32>& family : { Graphics, Present, Compute, Transfer } )
+		{
+			if ( family && std::ranges::find( families, *family ) == families.end() )
+			{
+				families.push_back( *family );
+			}
+		}
+		return families;
+	}
+
+	std::span<const char* const> GetDynamicRenderingExtensions()
+	{
+		return DYNAMIC_RENDERING_EXTENSIONS;
+	}
+
+	Expected<VulkanQueueFamilyIndices> FindQueueFamilies( VkPhysicalDevice gpu, VkSurfaceKHR surface )
+	{
+		uint32 count = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties( gpu, &count, nullptr );
+		std::vector<VkQueueFamilyProperties> props( count );
+		vkGetPhysicalDeviceQueueFamilyProperties( gpu, &count, props.data() );
+
+		VulkanQueueFamilyIndices indices;
+		std::optional<uint32> graphics_present;
+		for ( uint32 family_index = 0; family_index < count; ++family_index )
+		{
+			const VkQueueFlags flags = props[family_index].queueFlags;
+			if ( props[family_index].queueCount == 0 )
+			{
+				continue;
+			}
+
+			VkBool32 present_support = false;
+			VkResult err = vkGetPhysicalDeviceSurfaceSupportKHR( gpu, family_index, surface, &present_support );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::QuerySurfaceSupport, err ) );
+			}
+
+			const bool graphics = flags & VK_QUEUE_GRAPHICS_BIT;
+			const bool compute = flags & VK_QUEUE_COMPUTE_BIT;
+			if ( graphics && !indices.Graphics )
+			{
+				indices.Graphics = family_index;
+			}
+			if ( graphics && present_support && !graphics_present )
+			{
+				graphics_present = family_index;
+			}
+			if ( present_support && !indices.Present )
+			{
+				indices.Present = family_index;
+			}
+			if ( !graphics && compute && !indices.Compute )
+			{
+				indices.Compute = family_index;
+			}
+			// graphics and compute families support transfers as well, only the dedicated ones are wanted
+			if ( !graphics && !compute && ( flags & VK_QUEUE_TRANSFER_BIT ) && !indices.Transfer )
+			{
+				indices.Transfer = family_index;
+			}
+		}
+
+		if ( graphics_present )
+		{
+			indices.Graphics = graphics_present;
+			indices.Present = graphics_present;
+		}
+		return indices;
+	}
+
+	Expected<VulkanDeviceCandidate> ProbePhysicalDevice( VkPhysicalDevice gpu, VkSurfaceKHR surface )
+	{
+		VulkanDeviceCandidate candidate;
+		candidate.Gpu = gpu;
+
+		VulkanDeviceCapabilities& capabilities = candidate.Capabilities;
+		vkGetPhysicalDeviceProperties( gpu, &capabilities.Properties );
+		vkGetPhysicalDeviceFeatures( gpu, &capabilities.Features );
+		capabilities.DeviceLocalMemory = GetDeviceLocalMemory( gpu );
+
+		auto extensions_result = GetDeviceExtensions( gpu );
+		if ( !extensions_result )
+		{
+			return std::unexpected( extensions_result.error() );
+		}
+		const std::vector<VkExtensionProperties>& extensions = extensions_result.value();
+		capabilities.DynamicRendering = SupportsDynamicRendering( gpu, capabilities.Properties, extensions );
+		capabilities.MemoryBudget = HasExtensions( extensions, MEMORY_BUDGET_EXTENSIONS );
+		capabilities.TimelineSemaphore = SupportsTimelineSemaphore( gpu, capabilities.Properties );
+
+		auto queues_result = FindQueueFamilies( gpu, surface );
+		if ( !queues_result )
+		{
+			return std::unexpected( queues_result.error() );
+		}
+		candidate.Queues = queues_result.value();
+
+		if ( !HasExtensions( extensions, REQUIRED_EXTENSIONS ) )
+		{
+			candidate.Rejection = "the swapchain extension is missing";
+		}
+		else if ( !candidate.Queues.IsComplete() )
+		{
+			candidate.Rejection = "no queue family can draw or present to the window";
+		}
+		candidate.Score = ScoreDevice( candidate );
+		return candidate;
+	}
+
+	int64 ScoreDevice( const VulkanDeviceCandidate& candidate )
+	{
+		if ( candidate.Rejection )
+		{
+			return -1;
+		}
+
+		const VulkanDeviceCapabilities& capabilities = candidate.Capabilities;
+		int64 score = ScoreDeviceType( capabilities.Properties.deviceType );
+
+		// 100 points per GiB stay below the gap between two device types up to 50 GiB
+		score += static_cast< int64 >( capabilities.DeviceLocalMemory >> 30 ) * 100;
+
+		// occlusion culling needs firstInstance in indirect draws, multi draw indirect batches them
+		score += capabilities.Features.drawIndirectFirstInstance ? 400 : 0;
+		score += capabilities.Features.multiDrawIndirect ? 200 : 0;
+		score += capabilities.DynamicRendering ? 200 : 0;
+		score += capabilities.Features.samplerAnisotropy ? 100 : 0;
+		score += candidate.Queues.Compute ? 100 : 0;
+		score += candidate.Queues.Transfer ? 50 : 0;
+		return score;
+	}
+
+} // namespace VulkanRHI
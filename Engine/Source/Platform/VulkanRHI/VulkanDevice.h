@@ -0,0 +1,74 @@
+// Engine/Source/Platform/VulkanRHI/VulkanDevice.h
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <optional>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "VulkanError.h"
+
+namespace VulkanRHI
+{
+
+	struct VulkanQueueFamilyIndices
+	{
+		std::optional<uint32> Graphics;
+		std::optional<uint32> Present;
+		// a family without graphics, work submitted to it can overlap the graphics queue
+		std::optional<uint32> Compute;
+		// a family with neither graphics nor compute, usually the copy engines
+		std::optional<uint32> Transfer;
+
+		bool IsComplete() const
+		{
+			return Graphics.has_value() && Present.has_value();
+		}
+
+		// every family that was found, each once
+		std::vector<uint32> GetUniqueFamilies() const;
+	};
+
+	// What the selected GPU supports. Fast paths are enabled from these instead of querying the device again.
+	struct VulkanDeviceCapabilities
+	{
+		VkPhysicalDeviceProperties Properties = {};
+		VkPhysicalDeviceFeatures   Features = {};
+		// sum of the device local heaps, shared system memory on integrated GPUs
+		VkDeviceSize               DeviceLocalMemory = 0;
+		// VK_KHR_dynamic_rendering together with VK_KHR_synchronization2
+		bool                       DynamicRendering = false;
+		// VK_EXT_memory_budget
+		bool                       MemoryBudget = false;
+		// core in Vulkan 1.2, lets resources be retired against submissions instead of frame fences
+		bool                       TimelineSemaphore = false;
+	};
+
+	struct VulkanDeviceCandidate
+	{
+		VkPhysicalDevice         Gpu = VK_NULL_HANDLE;
+		VulkanQueueFamilyIndices Queues;
+		VulkanDeviceCapabilities Capabilities;
+		// why the device cannot be used, null when it can
+		const char*              Rejection = nullptr;
+		int64                    Score = 0;
+	};
+
+	// device extensions enabled together with dynamic rendering
+	std::span<const char* const> GetDynamicRenderingExtensions();
+
+	// Prefers a graphics family that can also present, so the swapchain images stay on one queue.
+	Expected<VulkanQueueFamilyIndices> FindQueueFamilies( VkPhysicalDevice gpu, VkSurfaceKHR surface );
+
+	// Queries everything device selection and the fast paths need. A device missing a requirement is
+	// returned with Rejection set, errors are reserved for failing queries.
+	Expected<VulkanDeviceCandidate> ProbePhysicalDevice( VkPhysicalDevice gpu, VkSurfaceKHR surface );
+
+	// Higher is better. The device type dominates, memory and optional capabilities break ties between
+	// devices of the same type.
+	int64 ScoreDevice( const VulkanDeviceCandidate& candidate );
+
+} // namespace VulkanRHI
@@ -0,0 +1,138 @@
+#include "VulkanRHI.h"
+
+#include <array>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		VkImageMemoryBarrier2KHR MakeImageBarrier( VkImage image, VkImageAspectFlags aspect,
+			VkImageLayout old_layout, VkImageLayout new_layout )
+		{
+			VkImageMemoryBarrier2KHR barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			barrier.oldLayout = old_layout;
+			barrier.newLayout = new_layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = aspect;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = 1;
+			return barrier;
+		}
+	}
+
+	bool Context::LoadDeviceFunctions()
+	{
+		DeviceFunctions.CmdBeginRendering = reinterpret_cast< PFN_vkCmdBeginRenderingKHR >(
+			vkGetDeviceProcAddr( Device, "vkCmdBeginRenderingKHR" ) );
+		DeviceFunctions.CmdEndRendering = reinterpret_cast< PFN_vkCmdEndRenderingKHR >(
+			vkGetDeviceProcAddr( Device, "vkCmdEndRenderingKHR" ) );
+		DeviceFunctions.CmdPipelineBarrier2 = reinterpret_cast< PFN_vkCmdPipelineBarrier2KHR >(
+			vkGetDeviceProcAddr( Device, "vkCmdPipelineBarrier2KHR" ) );
+
+		return DeviceFunctions.CmdBeginRendering && DeviceFunctions.CmdEndRendering &&
+			DeviceFunctions.CmdPipelineBarrier2;
+	}
+
+	// Without a render pass the layout transitions and the dependencies on the previous frame are explicit.
+	// Phase 0 clears both attachments, phase 1 loads them and leaves both to the post chain.
+	void Context::BeginDynamicRendering( VkCommandBuffer command_buffer, uint32 phase )
+	{
+		const VkImageAspectFlags depth_aspect = GetDepthAspect( DepthTexture.Format );
+		std::array<VkImageMemoryBarrier2KHR, 2> barriers = {};
+		uint32 barrier_count = 0;
+
+		if ( phase == 0 )
+		{
+			// the previous frame's post chain is the last reader of the HDR target
+			VkImageMemoryBarrier2KHR& color_barrier = barriers[barrier_count++];
+			color_barrier = MakeImageBarrier( HdrTargets.HdrTarget.Image, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL );
+			color_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			color_barrier.srcAccessMask = VK_ACCESS_2_NONE_KHR;
+			color_barrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+			color_barrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+
+			// the previous frame's temporal pass is the last reader of the depth texture
+			VkImageMemoryBarrier2KHR& depth_barrier = barriers[barrier_count++];
+			depth_barrier = MakeImageBarrier( DepthTexture.Image, depth_aspect, VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+			depth_barrier.srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR |
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			depth_barrier.srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+			depth_barrier.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+				VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+			depth_barrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR |
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+		}
+		else
+		{
+			// phase 1 loads what phase 0 stored
+			VkImageMemoryBarrier2KHR& color_barrier = barriers[barrier_count++];
+			color_barrier = MakeImageBarrier( HdrTargets.HdrTarget.Image, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL );
+			color_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+			color_barrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+			color_barrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+			color_barrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR |
+				VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+
+			// with occlusion culling the late draw pass already handed the depth back to the depth tests
+			if ( !OcclusionCulling )
+			{
+				VkImageMemoryBarrier2KHR& depth_barrier = barriers[barrier_count++];
+				const VkImageLayout depth_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				depth_barrier = MakeImageBarrier( DepthTexture.Image, depth_aspect, depth_layout, depth_layout );
+				depth_barrier.srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+				depth_barrier.srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+				depth_barrier.dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+					VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+				depth_barrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR |
+					VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+			}
+		}
+
+		VkDependencyInfoKHR dependency_info = {};
+		dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependency_info.imageMemoryBarrierCount = barrier_count;
+		dependency_info.pImageMemoryBarriers = barriers.data();
+		DeviceFunctions.CmdPipelineBarrier2( command_buffer, &dependency_info );
+
+		const VkAttachmentLoadOp load_op = phase == 0 ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+		VkRenderingAttachmentInfoKHR color_attachment = {};
+		color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		color_attachment.imageView = HdrTargets.HdrTarget.View;
+		color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		color_attachment.loadOp = load_op;
+		color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		color_attachment.clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+		// the temporal pass reprojects with the depth of the last phase
+		VkRenderingAttachmentInfoKHR depth_attachment = {};
+		depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depth_attachment.imageView = DepthTexture.View;
+		depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depth_attachment.loadOp = load_op;
+		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depth_attachment.clearValue.depthStencil = { 1.0f, 0 };
+
+		VkRenderingInfoKHR rendering_info = {};
+		rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		rendering_info.renderArea.offset = { 0, 0 };
+		rendering_info.renderArea.extent = DynamicResolution.RenderExtent;
+		rendering_info.layerCount = 1;
+		rendering_info.colorAttachmentCount = 1;
+		rendering_info.pColorAttachments = &color_attachment;
+		rendering_info.pDepthAttachment = &depth_attachment;
+
+		DeviceFunctions.CmdBeginRendering( command_buffer, &rendering_info );
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,123 @@
+#include "VulkanRHI.h"
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	void Context::SetResolutionSettings( const ResolutionSettings& settings )
+	{
+		ResolutionConfig = settings;
+	}
+
+	// Without timestamps on the graphics queue there is no query pool and the scale stays at the maximum.
+	Expected<VulkanDynamicResolution> Context::CreateDynamicResolution()
+	{
+		VulkanDynamicResolution resolution;
+		resolution.Pending.resize( MAX_FRAMES_IN_FLIGHT, false );
+
+		const VkPhysicalDeviceLimits& limits = Capabilities.Properties.limits;
+		if ( !limits.timestampComputeAndGraphics )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] The graphics queue cannot be timed, the render scale is "
+				"fixed." );
+			return resolution;
+		}
+		resolution.TimestampPeriod = limits.timestampPeriod;
+
+		VkQueryPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		pool_info.queryCount = static_cast< uint32 >( 2 * MAX_FRAMES_IN_FLIGHT );
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		VkResult err = vkCreateQueryPool( Device, &pool_info, alloc, &resolution.QueryPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateQueryPool, err ) );
+		}
+
+		return resolution;
+	}
+
+	void Context::UpdateDynamicResolution( uint32 current_frame )
+	{
+		VulkanDynamicResolution& resolution = DynamicResolution;
+		const uint32 first_query = current_frame * 2;
+
+		// the frame's fence was waited for, the timestamps of the slot's previous frame are available
+		if ( resolution.Pending[current_frame] )
+		{
+			std::array<uint64, 2> timestamps = {};
+			const uint32 query_count = 2;
+			VkResult err = vkGetQueryPoolResults( Device, resolution.QueryPool, first_query, query_count,
+				sizeof( timestamps ), timestamps.data(), sizeof( uint64 ), VK_QUERY_RESULT_64_BIT );
+			resolution.Pending[current_frame] = false;
+			if ( err == VK_SUCCESS && timestamps[1] >= timestamps[0] )
+			{
+				const float scene_ms = static_cast< float >( timestamps[1] - timestamps[0] ) *
+					resolution.TimestampPeriod * 1e-6f;
+				resolution.SceneMs = resolution.SceneMs == 0.0f ? scene_ms :
+					std::lerp( resolution.SceneMs, scene_ms, VulkanDynamicResolution::SMOOTHING );
+			}
+		}
+
+		const float max_scale = std::clamp( ResolutionConfig.MaxScale, 0.0f, 1.0f );
+		const float min_scale = std::clamp( ResolutionConfig.MinScale, 0.0f, max_scale );
+		if ( ResolutionConfig.TargetFrameRate <= 0.0f || resolution.SceneMs == 0.0f )
+		{
+			resolution.Scale = max_scale;
+		}
+		else
+		{
+			// the cost of the passes follows the pixel count, the square root of the load is the scale change
+			// that brings them back to the budget
+			const float budget_ms = VulkanDynamicResolution::SCENE_BUDGET * 1000.0f /
+				ResolutionConfig.TargetFrameRate;
+			const float load = resolution.SceneMs / budget_ms;
+			if ( load > 1.0f || load < 1.0f - VulkanDynamicResolution::TOLERANCE )
+			{
+				const float step = resolution.Scale / std::sqrt( load ) - resolution.Scale;
+				resolution.Scale += std::clamp( step, -VulkanDynamicResolution::MAX_STEP,
+					VulkanDynamicResolution::MAX_STEP );
+			}
+			resolution.Scale = std::clamp( resolution.Scale, min_scale, max_scale );
+		}
+
+		auto scale_axis = [&resolution] ( uint32 size ) {
+			const uint32 scaled = static_cast< uint32 >( std::round( static_cast< float >( size ) *
+				resolution.Scale ) );
+			return std::clamp( scaled, 1u, size );
+		};
+		resolution.RenderExtent = { scale_axis( Swapchain.Extent.width ), scale_axis( Swapchain.Extent.height ) };
+	}
+
+	void Context::RecordSceneTimestamp( VkCommandBuffer command_buffer, bool begin )
+	{
+		if ( DynamicResolution.QueryPool == VK_NULL_HANDLE )
+		{
+			return;
+		}
+
+		const uint32 first_query = CurrentFrame * 2;
+		if ( begin )
+		{
+			// the slot was read back by UpdateDynamicResolution before the frame was recorded
+			const uint32 query_count = 2;
+			vkCmdResetQueryPool( command_buffer, DynamicResolution.QueryPool, first_query, query_count );
+			vkCmdWriteTimestamp( command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, DynamicResolution.QueryPool,
+				first_query );
+			return;
+		}
+
+		vkCmdWriteTimestamp( command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, DynamicResolution.QueryPool,
+			first_query + 1 );
+		DynamicResolution.Pending[CurrentFrame] = true;
+	}
+
+} // namespace VulkanRHI
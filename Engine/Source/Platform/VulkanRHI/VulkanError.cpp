@@ -0,0 +1,116 @@
+#include "VulkanError.h"
+
+#include <atomic>
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		constexpr size_t ERROR_CODE_COUNT = static_cast< size_t >( ErrorCode::Count );
+
+		// the last slot counts results missing from VK_RESULT_NAMES
+		constexpr size_t RESULT_SLOT_COUNT = VK_RESULT_NAMES.size() + 1;
+
+		// Relaxed atomics only. The last result and location of a code may come from different errors
+		// when two threads fail at once, which is fine for a telemetry dump.
+		struct ErrorCounters
+		{
+			std::array<std::atomic<uint32>, ERROR_CODE_COUNT>      Counts = {};
+			std::array<std::atomic<int32>, ERROR_CODE_COUNT>       LastResults = {};
+			std::array<std::atomic<const char*>, ERROR_CODE_COUNT> LastFiles = {};
+			std::array<std::atomic<uint32>, ERROR_CODE_COUNT>      LastLines = {};
+			std::array<std::atomic<uint32>, RESULT_SLOT_COUNT>     ResultCounts = {};
+		};
+
+		ErrorCounters& GetCounters()
+		{
+			static ErrorCounters counters;
+			return counters;
+		}
+	}
+
+	Error::Error( ErrorCode code, VkResult result, const char* detail, std::source_location location )
+		: Code( code )
+		, Result( result )
+		, Detail( detail )
+		, Location( location )
+	{
+		ErrorTelemetry::Record( *this );
+	}
+
+	void ErrorTelemetry::Record( const Error& error )
+	{
+		ErrorCounters& counters = GetCounters();
+		const size_t index = static_cast< size_t >( error.Code );
+
+		counters.Counts[index].fetch_add( 1, std::memory_order_relaxed );
+		counters.LastResults[index].store( static_cast< int32 >( error.Result ), std::memory_order_relaxed );
+		counters.LastFiles[index].store( error.Location.file_name(), std::memory_order_relaxed );
+		counters.LastLines[index].store( error.Location.line(), std::memory_order_relaxed );
+
+		if ( error.Result != VK_SUCCESS )
+		{
+			counters.ResultCounts[GetResultIndex( error.Result )].fetch_add( 1, std::memory_order_relaxed );
+		}
+	}
+
+	std::vector<ErrorTelemetry::Entry> ErrorTelemetry::GetEntries()
+	{
+		const ErrorCounters& counters = GetCounters();
+
+		std::vector<Entry> entries;
+		for ( size_t i = 0; i < ERROR_CODE_COUNT; ++i )
+		{
+			const uint32 count = counters.Counts[i].load( std::memory_order_relaxed );
+			if ( count == 0 )
+			{
+				continue;
+			}
+
+			Entry entry;
+			entry.Code = static_cast< ErrorCode >( i );
+			entry.Count = count;
+			entry.LastResult = static_cast< VkResult >( counters.LastResults[i].load( std::memory_order_relaxed ) );
+			entry.LastFile = counters.LastFiles[i].load( std::memory_order_relaxed );
+			entry.LastLine = counters.LastLines[i].load( std::memory_order_relaxed );
+			entries.push_back( entry );
+		}
+		return entries;
+	}
+
+	uint32 ErrorTelemetry::GetResultCount( VkResult result )
+	{
+		return GetCounters().ResultCounts[GetResultIndex( result )].load( std::memory_order_relaxed );
+	}
+
+	void ErrorTelemetry::Dump()
+	{
+		const std::vector<Entry> entries = GetEntries();
+		if ( entries.empty() )
+		{
+			return;
+		}
+
+		LOG_INFO_CAT( LogCategory::Vulkan, "[Vulkan] Error telemetry, {} distinct errors:", entries.size() );
+		for ( const Entry& entry : entries )
+		{
+			LOG_INFO_CAT( LogCategory::Vulkan, "    {} x{}, last {} at {}:{}", entry.Code, entry.Count, entry.LastResult,
+				GetFileName( entry.LastFile ), entry.LastLine );
+		}
+
+		const ErrorCounters& counters = GetCounters();
+		for ( size_t i = 0; i < RESULT_SLOT_COUNT; ++i )
+		{
+			const uint32 count = counters.ResultCounts[i].load( std::memory_order_relaxed );
+			if ( count == 0 )
+			{
+				continue;
+			}
+
+			const std::string_view name = i < VK_RESULT_NAMES.size() ? VK_RESULT_NAMES[i].Name : "unknown VkResult";
+			LOG_INFO_CAT( LogCategory::Vulkan, "    {} x{}", name, count );
+		}
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,288 @@
+// Engine/Source/Platform/VulkanRHI/VulkanError.h
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <format>
+#include <expected>
+#include <algorithm>
+#include <string_view>
+#include <source_location>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+
+#define VULKAN_RESULT_LIST( X )                         \
+	X( VK_SUCCESS )                                     \
+	X( VK_NOT_READY )                                   \
+	X( VK_TIMEOUT )                                     \
+	X( VK_EVENT_SET )                                   \
+	X( VK_EVENT_RESET )                                 \
+	X( VK_INCOMPLETE )                                  \
+	X( VK_ERROR_OUT_OF_HOST_MEMORY )                    \
+	X( VK_ERROR_OUT_OF_DEVICE_MEMORY )                  \
+	X( VK_ERROR_INITIALIZATION_FAILED )                 \
+	X( VK_ERROR_DEVICE_LOST )                           \
+	X( VK_ERROR_MEMORY_MAP_FAILED )                     \
+	X( VK_ERROR_LAYER_NOT_PRESENT )                     \
+	X( VK_ERROR_EXTENSION_NOT_PRESENT )                 \
+	X( VK_ERROR_FEATURE_NOT_PRESENT )                   \
+	X( VK_ERROR_INCOMPATIBLE_DRIVER )                   \
+	X( VK_ERROR_TOO_MANY_OBJECTS )                      \
+	X( VK_ERROR_FORMAT_NOT_SUPPORTED )                  \
+	X( VK_ERROR_FRAGMENTED_POOL )                       \
+	X( VK_ERROR_UNKNOWN )                               \
+	X( VK_ERROR_OUT_OF_POOL_MEMORY )                    \
+	X( VK_ERROR_INVALID_EXTERNAL_HANDLE )               \
+	X( VK_ERROR_FRAGMENTATION )                         \
+	X( VK_ERROR_INVALID_OPAQUE_CAPTURE_ADDRESS )        \
+	X( VK_PIPELINE_COMPILE_REQUIRED )                   \
+	X( VK_ERROR_SURFACE_LOST_KHR )                      \
+	X( VK_ERROR_NATIVE_WINDOW_IN_USE_KHR )              \
+	X( VK_SUBOPTIMAL_KHR )                              \
+	X( VK_ERROR_OUT_OF_DATE_KHR )                       \
+	X( VK_ERROR_INCOMPATIBLE_DISPLAY_KHR )              \
+	X( VK_ERROR_VALIDATION_FAILED_EXT )                 \
+	X( VK_ERROR_INVALID_SHADER_NV )                     \
+	X( VK_ERROR_FULL_SCREEN_EXCLUSIVE_MODE_LOST_EXT )   \
+	X( VK_THREAD_IDLE_KHR )                             \
+	X( VK_THREAD_DONE_KHR )                             \
+	X( VK_OPERATION_DEFERRED_KHR )                      \
+	X( VK_OPERATION_NOT_DEFERRED_KHR )
+
+// code, what failed, the call that reported it
+#define VULKAN_ERROR_LIST( X )                                                                                      \
+	X( EnumerateInstanceExtensions, "Failed to enumerate Vulkan Instance extension properties",                     \
+		"vkEnumerateInstanceExtensionProperties" )                                                                  \
+	X( MissingInstanceExtension, "Required extension is not available", "" )                                        \
+	X( EnumerateInstanceLayers, "Failed to enumerate Vulkan Instance layer properties",                             \
+		"vkEnumerateInstanceLayerProperties" )                                                                      \
+	X( MissingInstanceLayer, "Required layer is not available", "" )                                                \
+	X( CreateInstance, "Failed to create Vulkan Instance", "vkCreateInstance" )                                     \
+	X( CreateSurface, "Failed to create Vulkan Surface", "SDL_Vulkan_CreateSurface" )                               \
+	X( EnumeratePhysicalDevices, "Failed to enumerate GPUs with Vulkan support", "vkEnumeratePhysicalDevices" )     \
+	X( EnumerateDeviceExtensions, "Failed to enumerate GPU supported extensions",                                   \
+		"vkEnumerateDeviceExtensionProperties" )                                                                    \
+	X( NoSuitableGpu, "No GPU supports the required extensions, features and queues", "" )                          \
+	X( QuerySurfaceSupport, "Error checking GPU surface support", "vkGetPhysicalDeviceSurfaceSupportKHR" )          \
+	X( CreateDevice, "Failed to create Vulkan Device", "vkCreateDevice" )                                           \
+	X( GetSurfaceCapabilities, "Failed to query surface capabilities",                                              \
+		"vkGetPhysicalDeviceSurfaceCapabilitiesKHR" )                                                               \
+	X( GetSurfaceFormats, "Failed to query surface formats", "vkGetPhysicalDeviceSurfaceFormatsKHR" )               \
+	X( GetSurfacePresentModes, "Failed to query surface present modes",                                             \
+		"vkGetPhysicalDeviceSurfacePresentModesKHR" )                                                               \
+	X( CreateSwapchain, "Failed to create Vulkan Swapchain", "vkCreateSwapchainKHR" )                               \
+	X( GetSwapchainImages, "Failed to receive Swapchain Images", "vkGetSwapchainImagesKHR" )                        \
+	X( CreateShaderModule, "Failed to create Vulkan Shader Module", "vkCreateShaderModule" )                        \
+	X( ReadShader, "Failed to read SPIR-V shader", "" )                                                             \
+	X( ReflectShader, "Failed to reflect SPIR-V shader", "" )                                                       \
+	X( MissingVertexInput, "No vertex stream provides a shader input", "" )                                         \
+	X( ShaderInterfaceChanged, "Shader interface changed, the pipeline layout cannot be replaced", "" )             \
+	X( UnknownShaderKeyword, "No shader stage declares the keyword", "" )                                           \
+	X( TooManyPipelineVariants, "Pipeline variant does not fit the render queue key", "" )                          \
+	X( CreateDescriptorSetLayout, "Failed to create Vulkan Descriptor set layout", "vkCreateDescriptorSetLayout" )  \
+	X( CreatePipelineLayout, "Failed to create Vulkan Pipeline Layout", "vkCreatePipelineLayout" )                  \
+	X( CreateRenderPass, "Failed to create Vulkan Render Pass", "vkCreateRenderPass" )                              \
+	X( CreateGraphicsPipeline, "Failed to create Vulkan Graphics Pipeline", "vkCreateGraphicsPipelines" )           \
+	X( CreateComputePipeline, "Failed to create Vulkan Compute Pipeline", "vkCreateComputePipelines" )              \
+	X( CreatePipelineCache, "Failed to create pipeline cache", "vkCreatePipelineCache" )                            \
+	X( GetPipelineCacheData, "Failed to read pipeline cache data", "vkGetPipelineCacheData" )                       \
+	X( CreateImageView, "Failed to create Vulkan Image View", "vkCreateImageView" )                                 \
+	X( CreateFramebuffer, "Failed to create framebuffer", "vkCreateFramebuffer" )                                   \
+	X( CreateCommandPool, "Failed to create Vulkan Command Pool", "vkCreateCommandPool" )                           \
+	X( AllocateCommandBuffers, "Failed to allocate Vulkan Command Buffers", "vkAllocateCommandBuffers" )            \
+	X( BeginCommandBuffer, "Failed to begin command buffer", "vkBeginCommandBuffer" )                               \
+	X( EndCommandBuffer, "Failed to end command buffer", "vkEndCommandBuffer" )                                     \
+	X( ResetCommandBuffer, "Failed to reset command buffer", "vkResetCommandBuffer" )                               \
+	X( ResetCommandPool, "Failed to reset command pool", "vkResetCommandPool" )                                     \
+	X( CreateSyncSemaphore, "Failed to create semaphore", "vkCreateSemaphore" )                                     \
+	X( CreateFence, "Failed to create fence", "vkCreateFence" )                                                     \
+	X( WaitForFences, "Failed to wait for fences", "vkWaitForFences" )                                              \
+	X( ResetFences, "Failed to reset fences", "vkResetFences" )                                                     \
+	X( AcquireNextImage, "Failed to acquire swapchain image", "vkAcquireNextImageKHR" )                             \
+	X( QueueSubmit, "Failed to submit queue", "vkQueueSubmit" )                                                     \
+	X( QueuePresent, "Failed to present", "vkQueuePresentKHR" )                                                     \
+	X( QueueWaitIdle, "Failed to wait for queue idle", "vkQueueWaitIdle" )                                          \
+	X( WaitSemaphores, "Failed to wait for timeline semaphore", "vkWaitSemaphores" )                                \
+	X( GetSemaphoreCounterValue, "Failed to read timeline semaphore", "vkGetSemaphoreCounterValue" )                \
+	X( CreateBuffer, "Failed to create Vulkan Buffer", "vkCreateBuffer" )                                           \
+	X( CreateImage, "Failed to create Vulkan Image", "vkCreateImage" )                                              \
+	X( AllocateMemory, "Failed to allocate memory", "vkAllocateMemory" )                                            \
+	X( BindBufferMemory, "Failed to bind buffer memory", "vkBindBufferMemory" )                                     \
+	X( BindImageMemory, "Failed to bind image memory", "vkBindImageMemory" )                                        \
+	X( MapMemory, "Failed to map memory", "vkMapMemory" )                                                           \
+	X( CreateSampler, "Failed to create Vulkan sampler", "vkCreateSampler" )                                        \
+	X( CreateDescriptorPool, "Failed to create descriptor pool", "vkCreateDescriptorPool" )                         \
+	X( AllocateDescriptorSets, "Failed to allocate Descriptor Sets", "vkAllocateDescriptorSets" )                   \
+	X( CreateQueryPool, "Failed to create query pool", "vkCreateQueryPool" )                                        \
+	X( LoadTexture, "Failed to load texture", "stbi_load" )                                                         \
+	X( UnsupportedFormat, "Failed to find supported format", "" )
+
+namespace VulkanRHI
+{
+
+	struct VkResultName
+	{
+		VkResult         Result;
+		std::string_view Name;
+	};
+
+	// sorted by value at compile time so lookups are a binary search over a static table
+	inline constexpr auto VK_RESULT_NAMES = [] {
+#define VULKAN_RESULT_NAME( result ) VkResultName{ result, #result },
+		std::array names = { VULKAN_RESULT_LIST( VULKAN_RESULT_NAME ) };
+#undef VULKAN_RESULT_NAME
+		std::ranges::sort( names, {}, &VkResultName::Result );
+		return names;
+	}();
+
+	// index into VK_RESULT_NAMES, VK_RESULT_NAMES.size() for values missing from the table
+	constexpr size_t GetResultIndex( VkResult result )
+	{
+		auto it = std::ranges::lower_bound( VK_RESULT_NAMES, result, {}, &VkResultName::Result );
+		if ( it == VK_RESULT_NAMES.end() || it->Result != result )
+		{
+			return VK_RESULT_NAMES.size();
+		}
+		return static_cast< size_t >( it - VK_RESULT_NAMES.begin() );
+	}
+
+	// empty for values missing from the table
+	constexpr std::string_view ToString( VkResult result )
+	{
+		const size_t index = GetResultIndex( result );
+		return index < VK_RESULT_NAMES.size() ? VK_RESULT_NAMES[index].Name : std::string_view();
+	}
+
+	static_assert( ToString( VK_ERROR_DEVICE_LOST ) == "VK_ERROR_DEVICE_LOST" );
+	static_assert( ToString( VK_ERROR_INCOMPATIBLE_DISPLAY_KHR ) == "VK_ERROR_INCOMPATIBLE_DISPLAY_KHR" );
+
+	enum class ErrorCode : uint16
+	{
+#define VULKAN_ERROR_CODE( code, message, function ) code,
+		VULKAN_ERROR_LIST( VULKAN_ERROR_CODE )
+#undef VULKAN_ERROR_CODE
+		Count
+	};
+
+	struct ErrorDescription
+	{
+		std::string_view Name;
+		std::string_view Message;
+		std::string_view Function;
+	};
+
+	inline constexpr std::array<ErrorDescription, static_cast< size_t >( ErrorCode::Count )> ERROR_DESCRIPTIONS = {
+#define VULKAN_ERROR_DESCRIPTION( code, message, function ) ErrorDescription{ #code, message, function },
+		VULKAN_ERROR_LIST( VULKAN_ERROR_DESCRIPTION )
+#undef VULKAN_ERROR_DESCRIPTION
+	};
+
+	constexpr const ErrorDescription& Describe( ErrorCode code )
+	{
+		return ERROR_DESCRIPTIONS[static_cast< size_t >( code )];
+	}
+
+	// Trivially copyable, so it is returned, logged and counted without touching the heap. Detail must
+	// point at memory that outlives the error, e.g. a literal or a name owned by the context.
+	struct Error
+	{
+		ErrorCode            Code;
+		VkResult             Result;
+		const char*          Detail;
+		std::source_location Location;
+
+		// counts the error in ErrorTelemetry
+		Error( ErrorCode code, VkResult result = VK_SUCCESS, const char* detail = nullptr,
+			std::source_location location = std::source_location::current() );
+	};
+
+	template<typename VkType>
+	using Expected = std::expected<VkType, Error>;
+
+	// Per code and per VkResult counters of every error constructed so far, cheap enough to keep in
+	// release builds. Dump() logs the non-zero ones.
+	class ErrorTelemetry
+	{
+	public:
+		struct Entry
+		{
+			ErrorCode   Code;
+			uint32      Count;
+			VkResult    LastResult;
+			const char* LastFile;
+			uint32      LastLine;
+		};
+
+		static void Record( const Error& error );
+
+		static std::vector<Entry> GetEntries();
+		static uint32 GetResultCount( VkResult result );
+
+		static void Dump();
+	};
+
+	constexpr std::string_view GetFileName( std::string_view path )
+	{
+		const size_t separator = path.find_last_of( "/\\" );
+		return separator == std::string_view::npos ? path : path.substr( separator + 1 );
+	}
+
+} // namespace VulkanRHI
+
+template<>
+struct Log::ByValue<VulkanRHI::Error> : std::true_type {};
+
+template<>
+struct std::formatter<VkResult> : std::formatter<std::string_view>
+{
+	auto format( VkResult result, auto& ctx ) const
+	{
+		const std::string_view name = VulkanRHI::ToString( result );
+		if ( name.empty() )
+		{
+			return std::format_to( ctx.out(), "UNKNOWN_VKRESULT({})", static_cast< int32 >( result ) );
+		}
+		return std::formatter<std::string_view>::format( name, ctx );
+	}
+};
+
+template<>
+struct std::formatter<VulkanRHI::ErrorCode> : std::formatter<std::string_view>
+{
+	auto format( VulkanRHI::ErrorCode code, auto& ctx ) const
+	{
+		return std::formatter<std::string_view>::format( VulkanRHI::Describe( code ).Name, ctx );
+	}
+};
+
+// [Vulkan] <message> (<detail>). <function> returned <result>. [<file>:<line>]
+template<>
+struct std::formatter<VulkanRHI::Error>
+{
+	constexpr auto parse( std::format_parse_context& ctx )
+	{
+		return ctx.begin();
+	}
+
+	auto format( const VulkanRHI::Error& error, auto& ctx ) const
+	{
+		const VulkanRHI::ErrorDescription& description = VulkanRHI::Describe( error.Code );
+
+		auto out = std::format_to( ctx.out(), "[Vulkan] {}", description.Message );
+		if ( error.Detail )
+		{
+			out = std::format_to( out, " ({})", error.Detail );
+		}
+		out = std::format_to( out, "." );
+		if ( error.Result != VK_SUCCESS && !description.Function.empty() )
+		{
+			out = std::format_to( out, " {} returned {}.", description.Function, error.Result );
+		}
+		return std::format_to( out, " [{}:{}]", VulkanRHI::GetFileName( error.Location.file_name() ),
+			error.Location.line() );
+	}
+};
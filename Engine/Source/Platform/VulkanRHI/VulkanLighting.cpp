@@ -0,0 +1,275 @@
+#include "VulkanRHI.h"
+
+#include <cmath>
+#include <array>
+#include <random>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Assert.h"
+
+namespace VulkanRHI
+{
+
+	// A fixed seed keeps the scene the same between runs, so frame times can be compared.
+	void Context::BuildLights()
+	{
+		std::mt19937 generator( 1337 );
+		std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+		auto range = [&generator] ( float min, float max ) {
+			return std::uniform_real_distribution<float>( min, max )( generator );
+		};
+
+		// a slab around the quads, most of it inside the view frustum
+		const glm::vec3 volume_min = glm::vec3( -3.0f, -3.0f, -1.0f );
+		const glm::vec3 volume_max = glm::vec3( 3.0f, 3.0f, 1.5f );
+		const float     intensity = 0.02f;
+
+		Lights.reserve( SCENE_LIGHT_COUNT );
+		for ( int32 i = 0; i < SCENE_LIGHT_COUNT; ++i )
+		{
+			SceneLight light;
+			light.Position = glm::mix( volume_min, volume_max, glm::vec3( unit( generator ), unit( generator ),
+				unit( generator ) ) );
+			light.Range = range( 0.15f, 0.4f );
+
+			// saturated hues, the heatmap already covers how many lights land on a pixel
+			const float hue = unit( generator ) * 6.0f;
+			const glm::vec3 color = glm::clamp( glm::vec3(
+				std::abs( hue - 3.0f ) - 1.0f,
+				2.0f - std::abs( hue - 2.0f ),
+				2.0f - std::abs( hue - 4.0f ) ), 0.0f, 1.0f );
+			light.Color = color * intensity;
+
+			// every fourth light is a spot pointing roughly down onto the quads
+			if ( i % 4 == 0 )
+			{
+				const float outer_angle = glm::radians( range( 20.0f, 45.0f ) );
+				light.Spot = true;
+				light.Direction = glm::normalize( glm::vec3( range( -0.5f, 0.5f ), range( -0.5f, 0.5f ), -1.0f ) );
+				light.OuterConeCos = std::cos( outer_angle );
+				light.InnerConeCos = std::cos( outer_angle * 0.75f );
+				light.Range *= 2.0f;
+			}
+
+			// alternates between spots and point lights, the atlas decides how many of them get tiles
+			light.CastsShadow = i % 50 == 0;
+			Lights.push_back( light );
+		}
+
+		// low and from the side, so the quads shadow each other
+		Sun.Direction = glm::normalize( glm::vec3( -0.6f, -0.3f, -1.0f ) );
+		Sun.Color = glm::vec3( 0.5f );
+	}
+
+	Expected<VulkanLightClusters> Context::CreateLightClusters( const VulkanComputePipeline& pipeline )
+	{
+		VkResult err;
+		VulkanLightClusters clusters;
+
+		clusters.Pipeline = pipeline;
+
+		auto lights_result = CreateFrameRing( sizeof( LightData ), MAX_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			Capabilities.Properties.limits.minStorageBufferOffsetAlignment );
+		if ( !lights_result )
+		{
+			return std::unexpected( lights_result.error() );
+		}
+		clusters.Lights = lights_result.value();
+
+		// regions of both buffers start on the storage offset alignment
+		const VkDeviceSize alignment = std::max<VkDeviceSize>(
+			Capabilities.Properties.limits.minStorageBufferOffsetAlignment, 16 );
+		auto align = [alignment] ( VkDeviceSize size ) {
+			return ( size + alignment - 1 ) & ~( alignment - 1 );
+		};
+		clusters.CountsFrameSize = align( VulkanLightClusters::CLUSTER_COUNT * sizeof( uint32 ) );
+		clusters.IndicesFrameSize = align( VulkanLightClusters::CLUSTER_COUNT *
+			VulkanLightClusters::MAX_LIGHTS_PER_CLUSTER * sizeof( uint32 ) );
+
+		const bool shared = true;
+		auto counts_result = CreateBuffer( clusters.CountsFrameSize * MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shared );
+		if ( !counts_result )
+		{
+			return std::unexpected( counts_result.error() );
+		}
+		clusters.Counts = counts_result.value();
+
+		auto indices_result = CreateBuffer( clusters.IndicesFrameSize * MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shared );
+		if ( !indices_result )
+		{
+			return std::unexpected( indices_result.error() );
+		}
+		clusters.Indices = indices_result.value();
+
+		std::array<VkDescriptorPoolSize, 1> pool_sizes = {};
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pool_sizes[0].descriptorCount = static_cast< uint32 >( 3 * MAX_FRAMES_IN_FLIGHT );
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.poolSizeCount = static_cast< uint32 >( pool_sizes.size() );
+		pool_info.pPoolSizes = pool_sizes.data();
+		pool_info.maxSets = static_cast< uint32 >( MAX_FRAMES_IN_FLIGHT );
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &clusters.DescriptorPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
+		}
+
+		ScratchScope scratch;
+		std::pmr::vector<VkDescriptorSetLayout> layouts( MAX_FRAMES_IN_FLIGHT,
+			clusters.Pipeline.DescriptorSetLayout, scratch.GetResource() );
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = clusters.DescriptorPool;
+		allocate_info.descriptorSetCount = static_cast< uint32 >( layouts.size() );
+		allocate_info.pSetLayouts = layouts.data();
+
+		clusters.Sets.resize( layouts.size() );
+		err = vkAllocateDescriptorSets( Device, &allocate_info, clusters.Sets.data() );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
+		}
+
+		for ( size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i )
+		{
+			std::array<VkDescriptorBufferInfo, 3> buffer_infos = {};
+			buffer_infos[0].buffer = clusters.Lights.Buffer.Instance;
+			buffer_infos[0].offset = i * clusters.Lights.FrameCapacity;
+			buffer_infos[0].range = clusters.Lights.FrameCapacity;
+			buffer_infos[1].buffer = clusters.Counts.Instance;
+			buffer_infos[1].offset = i * clusters.CountsFrameSize;
+			buffer_infos[1].range = clusters.CountsFrameSize;
+			buffer_infos[2].buffer = clusters.Indices.Instance;
+			buffer_infos[2].offset = i * clusters.IndicesFrameSize;
+			buffer_infos[2].range = clusters.IndicesFrameSize;
+
+			std::array<VkWriteDescriptorSet, 3> descriptor_writes = {};
+			for ( uint32 binding = 0; binding < descriptor_writes.size(); ++binding )
+			{
+				descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptor_writes[binding].dstSet = clusters.Sets[i];
+				descriptor_writes[binding].dstBinding = binding;
+				descriptor_writes[binding].dstArrayElement = 0;
+				descriptor_writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				descriptor_writes[binding].descriptorCount = 1;
+				descriptor_writes[binding].pBufferInfo = &buffer_infos[binding];
+			}
+
+			const uint32 descriptor_copy_count = 0;
+			const VkCopyDescriptorSet* descriptor_copies = nullptr;
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		return clusters;
+	}
+
+	// Lights are culled against the frustum on the CPU, which costs a plane test per light and keeps the
+	// cluster pass from testing the ones that cannot touch any cluster.
+	void Context::UpdateLights( uint32 current_frame, UniformBufferObject& ubo )
+	{
+		constexpr uint32 GRID_X = VulkanLightClusters::GRID_X;
+		constexpr uint32 GRID_Y = VulkanLightClusters::GRID_Y;
+		constexpr uint32 GRID_Z = VulkanLightClusters::GRID_Z;
+
+		const float depth_range = std::log( FAR_PLANE / NEAR_PLANE );
+		ubo.ClusterSlicing = glm::vec4(
+			GRID_Z / depth_range,
+			-( GRID_Z * std::log( NEAR_PLANE ) ) / depth_range,
+			static_cast< float >( DynamicResolution.RenderExtent.width ) / GRID_X,
+			static_cast< float >( DynamicResolution.RenderExtent.height ) / GRID_Y );
+		ubo.ClusterGrid = glm::uvec4( GRID_X, GRID_Y, GRID_Z, VulkanLightClusters::MAX_LIGHTS_PER_CLUSTER );
+
+		// the projection is flipped for Vulkan, the grid is built with y pointing up
+		LightClusters.TanHalfFov = glm::vec2( 1.0f / ubo.Projection[0][0], -1.0f / ubo.Projection[1][1] );
+
+		const Frustum frustum = Frustum::FromMatrix( ubo.Projection * ubo.View );
+		const glm::mat3 view_rotation = glm::mat3( ubo.View );
+
+		FrameLights.clear();
+		for ( uint32 light_index = 0; light_index < Lights.size(); ++light_index )
+		{
+			const SceneLight& light = Lights[light_index];
+			if ( !frustum.Intersects( light.Position, light.Range ) )
+			{
+				continue;
+			}
+
+			float spot_scale = 0.0f;
+			float spot_offset = 1.0f;
+			if ( light.Spot )
+			{
+				spot_scale = 1.0f / std::max( light.InnerConeCos - light.OuterConeCos, 1e-3f );
+				spot_offset = -light.OuterConeCos * spot_scale;
+			}
+
+			const glm::vec4 view_position = ubo.View * glm::vec4( light.Position, 1.0f );
+
+			LightData data = {};
+			data.PositionRange = glm::vec4( glm::vec3( view_position ), light.Range );
+			data.ColorSpotScale = glm::vec4( light.Color, spot_scale );
+			data.DirectionSpotOffset = glm::vec4( view_rotation * light.Direction, spot_offset );
+			data.ShadowTile = ShadowMaps.FirstTiles[light_index];
+			FrameLights.push_back( data );
+
+			if ( FrameLights.size() == static_cast< size_t >( MAX_LIGHTS ) )
+			{
+				break;
+			}
+		}
+
+		LightClusters.Lights.BeginFrame( current_frame );
+		auto lights_offset = LightClusters.Lights.Push( FrameLights.data(),
+			FrameLights.size() * sizeof( LightData ) );
+		ASSERT( lights_offset && lights_offset.value() == 0 );
+		LightClusters.LightCount = static_cast< uint32 >( FrameLights.size() );
+	}
+
+	void Context::RecordLightCull( VkCommandBuffer command_buffer )
+	{
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, LightClusters.Pipeline.Instance );
+
+		const uint32 first_set = 0;
+		const uint32 descriptor_set_count = 1;
+		vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, LightClusters.Pipeline.Layout,
+			first_set, descriptor_set_count, &LightClusters.Sets[CurrentFrame], 0, nullptr );
+
+		ClusterParams params = {};
+		params.TanHalfFov = LightClusters.TanHalfFov;
+		params.Near = NEAR_PLANE;
+		params.Far = FAR_PLANE;
+		params.Grid = glm::uvec4( VulkanLightClusters::GRID_X, VulkanLightClusters::GRID_Y,
+			VulkanLightClusters::GRID_Z, VulkanLightClusters::MAX_LIGHTS_PER_CLUSTER );
+		params.LightCount = LightClusters.LightCount;
+		vkCmdPushConstants( command_buffer, LightClusters.Pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+			sizeof( params ), &params );
+
+		// every cluster is written, empty ones get a count of zero
+		const uint32 group_size = 64;
+		vkCmdDispatch( command_buffer, ( VulkanLightClusters::CLUSTER_COUNT + group_size - 1 ) / group_size, 1, 1 );
+	}
+
+	// Same reasoning as RecordDepthBarrier, the fragment stage only exists on the graphics queue.
+	void Context::RecordLightBarrier( VkCommandBuffer command_buffer )
+	{
+		const VkDependencyFlags dependency_flags = 0;
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier( command_buffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			dependency_flags, 1, &barrier, 0, nullptr, 0, nullptr );
+	}
+
+} // namespace VulkanRHI
@@ -2,6 +2,7 @@
 
 #pragma once 
 
+#include <span>
 #include <array>
 
 #include <glm/glm.hpp>
@@ -49,11 +50,229 @@ namespace VulkanRHI
 		}
 	};
 
+	// Per-instance data streamed through a second vertex binding. The model matrix takes four
+	// consecutive attribute locations, one per column.
+	struct InstanceData
+	{
+		glm::mat4 Model;
+
+		static constexpr uint32 BINDING = 1;
+		static constexpr uint32 FIRST_LOCATION = 3;
+
+		static VkVertexInputBindingDescription GetBindingDescription()
+		{
+			VkVertexInputBindingDescription description = {};
+			description.binding = BINDING;
+			description.stride = sizeof( InstanceData );
+			description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return description;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescription()
+		{
+			std::array<VkVertexInputAttributeDescription, 4> description {};
+
+			for ( uint32 column = 0; column < description.size(); ++column )
+			{
+				description[column].binding = BINDING;
+				description[column].location = FIRST_LOCATION + column;
+				description[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				description[column].offset = offsetof( InstanceData, Model ) + column * sizeof( glm::vec4 );
+			}
+
+			return description;
+		}
+	};
+
+	constexpr uint32 SHADOW_CASCADE_COUNT = 4;
+
 	struct UniformBufferObject
 	{
 		alignas( 16 ) glm::mat4 Model;
 		alignas( 16 ) glm::mat4 View;
 		alignas( 16 ) glm::mat4 Projection;
+		// slice of a view depth is log( depth ) * x + y, zw is the tile size in pixels
+		alignas( 16 ) glm::vec4  ClusterSlicing;
+		// xyz clusters per axis, w capacity of a cluster's light list
+		alignas( 16 ) glm::uvec4 ClusterGrid;
+		// view space to the clip space of each sun shadow cascade
+		alignas( 16 ) glm::mat4  CascadeMatrices[SHADOW_CASCADE_COUNT];
+		// view depth each cascade ends at
+		alignas( 16 ) glm::vec4  CascadeSplits;
+		// view space direction towards the sun
+		alignas( 16 ) glm::vec4  SunDirection;
+		alignas( 16 ) glm::vec4  SunColor;
+	};
+
+	// Matches CullObject in cull.comp (std430).
+	struct CullObject
+	{
+		alignas( 16 ) glm::vec4 BoundsMin;
+		alignas( 16 ) glm::vec4 BoundsMax;
+		uint32 ObjectId;
+		uint32 IndexCount;
+		uint32 FirstIndex;
+		int32  VertexOffset;
+		uint32 FirstInstance;
+		uint32 Padding[3];
+	};
+
+	struct CullParams
+	{
+		glm::mat4 ViewProjection;
+		glm::vec2 PyramidSize;
+		uint32    ObjectCount;
+		uint32    Phase;
+		uint32    MipCount;
+	};
+
+	struct HiZParams
+	{
+		glm::ivec2 SourceSize;
+		glm::ivec2 DestinationSize;
+	};
+
+	// World space light of the scene. Spot cones are given as cosines, a point light has no cone.
+	struct SceneLight
+	{
+		glm::vec3 Position = glm::vec3( 0.0f );
+		float     Range = 1.0f;
+		glm::vec3 Color = glm::vec3( 1.0f );
+		glm::vec3 Direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+		bool      Spot = false;
+		float     InnerConeCos = 1.0f;
+		float     OuterConeCos = 0.0f;
+		// gets tiles in the shadow atlas, one for a spot and one per cube face for a point light
+		bool      CastsShadow = false;
+	};
+
+	// Infinitely far light, Direction is the one the light travels in.
+	struct DirectionalLight
+	{
+		glm::vec3 Direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+		glm::vec3 Color = glm::vec3( 1.0f );
+	};
+
+	// Matches Light in clusters.comp and triangle.frag (std430), in view space. The spot falloff is
+	// clamp( cos_angle * SpotScale + SpotOffset, 0, 1 ), a scale of 0 and an offset of 1 is a point light.
+	struct LightData
+	{
+		glm::vec4 PositionRange;
+		glm::vec4 ColorSpotScale;
+		glm::vec4 DirectionSpotOffset;
+		// first shadow atlas tile, -1 for a light without shadows
+		int32     ShadowTile;
+		int32     Padding[3];
+	};
+
+	// Matches ShadowTile in triangle.frag (std430).
+	struct ShadowTileData
+	{
+		// view space to the clip space the tile was rendered with
+		glm::mat4 Matrix;
+		// offset and size of the tile in atlas texture coordinates
+		glm::vec4 Rect;
+	};
+
+	struct ShadowParams
+	{
+		// light view projection times the scene's model matrix
+		glm::mat4 Transform;
+	};
+
+	struct ClusterParams
+	{
+		glm::vec2  TanHalfFov;
+		float      Near;
+		float      Far;
+		glm::uvec4 Grid;
+		uint32     LightCount;
+	};
+
+	struct TemporalParams
+	{
+		glm::mat4  Reprojection;
+		// of the frame's projection, in texture coordinates of the output
+		glm::vec2  Jitter;
+		// the scene covers RenderSize texels of targets the size of the output
+		glm::ivec2 OutputSize;
+		glm::ivec2 RenderSize;
+		// share of the current frame, 1 drops the history
+		float      Blend;
+	};
+
+	struct PrefilterParams
+	{
+		glm::ivec2 SourceSize;
+		glm::ivec2 DestinationSize;
+		float      MinLogLuminance;
+		float      InverseLogLuminanceRange;
+	};
+
+	struct ExposureParams
+	{
+		float  MinLogLuminance;
+		float  LogLuminanceRange;
+		// fraction of the way to the frame's luminance covered this frame
+		float  Adaptation;
+		// texels the histogram was built from
+		uint32 PixelCount;
+	};
+
+	// the source of an upsample is the smaller level
+	struct BloomParams
+	{
+		glm::ivec2 SourceSize;
+		glm::ivec2 DestinationSize;
+	};
+
+	struct TonemapParams
+	{
+		glm::ivec2 Size;
+		float      BloomStrength;
+		// animates the dither pattern
+		uint32     Frame;
+	};
+
+	// Local space bounds of a range of vertices.
+	struct Bounds
+	{
+		glm::vec3 Min = glm::vec3( 0.0f );
+		glm::vec3 Max = glm::vec3( 0.0f );
+
+		static Bounds FromVertices( std::span<const Vertex> vertices )
+		{
+			Bounds bounds = {};
+			if ( vertices.empty() )
+			{
+				return bounds;
+			}
+
+			bounds.Min = bounds.Max = vertices[0].Pos;
+			for ( const Vertex& vertex : vertices )
+			{
+				bounds.Min = glm::min( bounds.Min, vertex.Pos );
+				bounds.Max = glm::max( bounds.Max, vertex.Pos );
+			}
+			return bounds;
+		}
+
+		// axis aligned box enclosing these bounds after the transform
+		Bounds Transform( const glm::mat4& transform ) const
+		{
+			const glm::vec3 center = ( Min + Max ) * 0.5f;
+			const glm::vec3 extent = ( Max - Min ) * 0.5f;
+
+			const glm::vec3 world_center = glm::vec3( transform * glm::vec4( center, 1.0f ) );
+			const glm::mat3 absolute = glm::mat3(
+				glm::abs( glm::vec3( transform[0] ) ),
+				glm::abs( glm::vec3( transform[1] ) ),
+				glm::abs( glm::vec3( transform[2] ) ) );
+			const glm::vec3 world_extent = absolute * extent;
+
+			return { world_center - world_extent, world_center + world_extent };
+		}
 	};
 
 	const std::vector<Vertex> VERTICES = {
@@ -0,0 +1,353 @@
+#include "VulkanRHI.h"
+#include "VulkanMemory.h"
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+#include "Engine/Core/Memory.h"
+#include "Engine/Core/Application.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		constexpr double MIB = 1024.0 * 1024.0;
+
+		// In front of every block handed to the driver, pfnFree and pfnReallocation only get the pointer.
+		struct alignas( 16 ) HostAllocationHeader
+		{
+			size_t Size;
+			uint32 Alignment;
+			uint32 Scope;
+		};
+
+		std::array<std::atomic<uint64>, VulkanHostMemoryStats::SCOPE_COUNT> HostScopeBytes = {};
+		std::atomic<uint64> HostInternalBytes = 0;
+
+		size_t GetHeaderSize( size_t alignment )
+		{
+			return ( sizeof( HostAllocationHeader ) + alignment - 1 ) & ~( alignment - 1 );
+		}
+
+		HostAllocationHeader* GetHeader( void* memory )
+		{
+			return static_cast< HostAllocationHeader* >( memory ) - 1;
+		}
+
+		void* VKAPI_PTR HostAllocate( void*, size_t size, size_t alignment, VkSystemAllocationScope scope )
+		{
+			alignment = std::max( alignment, alignof( HostAllocationHeader ) );
+			const size_t header_size = GetHeaderSize( alignment );
+
+			// the driver expects null on failure, not an exception
+			void* block = nullptr;
+			try
+			{
+				block = Memory::GetResource( MemoryTag::Vulkan )->allocate( header_size + size, alignment );
+			}
+			catch ( const std::bad_alloc& )
+			{
+				return nullptr;
+			}
+
+			void* memory = static_cast< std::byte* >( block ) + header_size;
+			new ( GetHeader( memory ) ) HostAllocationHeader{ size, static_cast< uint32 >( alignment ),
+				static_cast< uint32 >( scope ) };
+			HostScopeBytes[scope].fetch_add( size, std::memory_order_relaxed );
+			return memory;
+		}
+
+		void VKAPI_PTR HostFree( void*, void* memory )
+		{
+			if ( !memory )
+			{
+				return;
+			}
+
+			const HostAllocationHeader header = *GetHeader( memory );
+			const size_t header_size = GetHeaderSize( header.Alignment );
+			HostScopeBytes[header.Scope].fetch_sub( header.Size, std::memory_order_relaxed );
+			Memory::GetResource( MemoryTag::Vulkan )->deallocate( static_cast< std::byte* >( memory ) - header_size,
+				header_size + header.Size, header.Alignment );
+		}
+
+		void* VKAPI_PTR HostReallocate( void* user_data, void* original, size_t size, size_t alignment,
+			VkSystemAllocationScope scope )
+		{
+			if ( !original )
+			{
+				return HostAllocate( user_data, size, alignment, scope );
+			}
+			if ( size == 0 )
+			{
+				HostFree( user_data, original );
+				return nullptr;
+			}
+
+			void* memory = HostAllocate( user_data, size, alignment, scope );
+			if ( memory )
+			{
+				memcpy( memory, original, std::min( size, GetHeader( original )->Size ) );
+				HostFree( user_data, original );
+			}
+			return memory;
+		}
+
+		void VKAPI_PTR HostInternalAllocate( void*, size_t size, VkInternalAllocationType, VkSystemAllocationScope )
+		{
+			HostInternalBytes.fetch_add( size, std::memory_order_relaxed );
+		}
+
+		void VKAPI_PTR HostInternalFree( void*, size_t size, VkInternalAllocationType, VkSystemAllocationScope )
+		{
+			HostInternalBytes.fetch_sub( size, std::memory_order_relaxed );
+		}
+
+		const VkAllocationCallbacks HOST_ALLOCATION_CALLBACKS = {
+			.pUserData = nullptr,
+			.pfnAllocation = &HostAllocate,
+			.pfnReallocation = &HostReallocate,
+			.pfnFree = &HostFree,
+			.pfnInternalAllocation = &HostInternalAllocate,
+			.pfnInternalFree = &HostInternalFree
+		};
+
+		// device memory of the engine, keyed by handle since vkFreeMemory does not know the size
+		struct DeviceAllocation
+		{
+			uint32       Type;
+			VkDeviceSize Size;
+		};
+
+		struct DeviceMemoryRegistry
+		{
+			std::mutex Mutex;
+			std::unordered_map<VkDeviceMemory, DeviceAllocation> Allocations;
+			std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> TypeBytes = {};
+			std::array<uint32, VK_MAX_MEMORY_TYPES>       TypeAllocations = {};
+		};
+
+		DeviceMemoryRegistry& GetDeviceMemoryRegistry()
+		{
+			static DeviceMemoryRegistry registry;
+			return registry;
+		}
+
+		const char* GetScopeName( uint32 scope )
+		{
+			switch ( scope )
+			{
+			case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:  return "command";
+			case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:   return "object";
+			case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:    return "cache";
+			case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:   return "device";
+			case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "instance";
+			default:                                  return "unknown";
+			}
+		}
+	}
+
+	const VkAllocationCallbacks* GetHostAllocationCallbacks()
+	{
+		return &HOST_ALLOCATION_CALLBACKS;
+	}
+
+	VulkanHostMemoryStats GetHostMemoryStats()
+	{
+		VulkanHostMemoryStats stats;
+		for ( uint32 scope = 0; scope < VulkanHostMemoryStats::SCOPE_COUNT; ++scope )
+		{
+			stats.ScopeBytes[scope] = HostScopeBytes[scope].load( std::memory_order_relaxed );
+		}
+		stats.InternalBytes = HostInternalBytes.load( std::memory_order_relaxed );
+		return stats;
+	}
+
+	VkResult AllocateDeviceMemory( VkDevice device, const VkMemoryAllocateInfo& allocate_info,
+		const VkAllocationCallbacks* alloc, VkDeviceMemory* memory )
+	{
+		VkResult err = vkAllocateMemory( device, &allocate_info, alloc, memory );
+		if ( err != VK_SUCCESS )
+		{
+			return err;
+		}
+
+		DeviceMemoryRegistry& registry = GetDeviceMemoryRegistry();
+		std::scoped_lock lock( registry.Mutex );
+		registry.Allocations[*memory] = { allocate_info.memoryTypeIndex, allocate_info.allocationSize };
+		registry.TypeBytes[allocate_info.memoryTypeIndex] += allocate_info.allocationSize;
+		registry.TypeAllocations[allocate_info.memoryTypeIndex]++;
+		return err;
+	}
+
+	void FreeDeviceMemory( VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* alloc )
+	{
+		if ( memory == VK_NULL_HANDLE )
+		{
+			return;
+		}
+
+		{
+			DeviceMemoryRegistry& registry = GetDeviceMemoryRegistry();
+			std::scoped_lock lock( registry.Mutex );
+			auto it = registry.Allocations.find( memory );
+			if ( it != registry.Allocations.end() )
+			{
+				registry.TypeBytes[it->second.Type] -= it->second.Size;
+				registry.TypeAllocations[it->second.Type]--;
+				registry.Allocations.erase( it );
+			}
+		}
+		vkFreeMemory( device, memory, alloc );
+	}
+
+	std::vector<VulkanHeapUsage> QueryHeapUsage( VkPhysicalDevice gpu, bool memory_budget )
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props = {};
+		budget_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 memory_props = {};
+		memory_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memory_props.pNext = memory_budget ? &budget_props : nullptr;
+		vkGetPhysicalDeviceMemoryProperties2( gpu, &memory_props );
+
+		const VkPhysicalDeviceMemoryProperties& props = memory_props.memoryProperties;
+		std::vector<VulkanHeapUsage> heaps( props.memoryHeapCount );
+		for ( uint32 i = 0; i < props.memoryHeapCount; ++i )
+		{
+			heaps[i].Size = props.memoryHeaps[i].size;
+			heaps[i].DeviceLocal = props.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+
+		{
+			DeviceMemoryRegistry& registry = GetDeviceMemoryRegistry();
+			std::scoped_lock lock( registry.Mutex );
+			for ( uint32 type = 0; type < props.memoryTypeCount; ++type )
+			{
+				VulkanHeapUsage& heap = heaps[props.memoryTypes[type].heapIndex];
+				heap.EngineBytes += registry.TypeBytes[type];
+				heap.EngineAllocations += registry.TypeAllocations[type];
+			}
+		}
+
+		for ( uint32 i = 0; i < props.memoryHeapCount; ++i )
+		{
+			VulkanHeapUsage& heap = heaps[i];
+			heap.Budget = memory_budget ? budget_props.heapBudget[i] : heap.Size / 5 * 4;
+			heap.Usage = memory_budget ? budget_props.heapUsage[i] : heap.EngineBytes;
+		}
+		return heaps;
+	}
+
+	// Warns once for every heap or host tag that goes over its budget, the first time anything does a
+	// snapshot is written next to the executable for a look after the fact.
+	void Context::UpdateMemoryUsage()
+	{
+		HeapUsage = QueryHeapUsage( Gpu, MemoryBudget );
+
+		bool over_budget = false;
+		uint32 heaps_over_budget = 0;
+		DeviceMemoryUsage = 0;
+		DeviceMemoryBudget = 0;
+		for ( uint32 i = 0; i < HeapUsage.size(); ++i )
+		{
+			const VulkanHeapUsage& heap = HeapUsage[i];
+			if ( heap.DeviceLocal )
+			{
+				DeviceMemoryUsage += heap.Usage;
+				DeviceMemoryBudget += heap.Budget;
+			}
+
+			if ( heap.Usage <= heap.Budget )
+			{
+				continue;
+			}
+			heaps_over_budget |= 1u << i;
+			over_budget = true;
+			if ( !( HeapsOverBudget & ( 1u << i ) ) )
+			{
+				LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Heap {} is over budget, {:.1f} of {:.1f} MiB in use.",
+					i, heap.Usage / MIB, heap.Budget / MIB );
+			}
+		}
+		HeapsOverBudget = heaps_over_budget;
+
+		// host tags warn on their own when they cross the budget
+		for ( uint32 i = 0; i < static_cast< uint32 >( MemoryTag::Count ); ++i )
+		{
+			const MemoryTagStats stats = Memory::GetStats( static_cast< MemoryTag >( i ) );
+			over_budget |= stats.Budget != 0 && stats.CurrentBytes > stats.Budget;
+		}
+
+		if ( over_budget && !MemorySnapshotWritten )
+		{
+			MemorySnapshotWritten = ExportMemorySnapshot( Application::ExecutablePath().parent_path() /
+				"memory_snapshot.json" );
+		}
+	}
+
+	bool Context::ExportMemorySnapshot( const std::filesystem::path& path )
+	{
+		std::ofstream file( path, std::ios::trunc );
+		if ( !file )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Failed to write {}", path.string() );
+			return false;
+		}
+
+		file << "{\n";
+		file << std::format( "\t\"device\": \"{}\",\n", Capabilities.Properties.deviceName );
+		file << std::format( "\t\"memory_budget_extension\": {},\n", MemoryBudget );
+
+		file << "\t\"host\": [\n";
+		for ( uint32 i = 0; i < static_cast< uint32 >( MemoryTag::Count ); ++i )
+		{
+			const MemoryTag tag = static_cast< MemoryTag >( i );
+			const MemoryTagStats stats = Memory::GetStats( tag );
+			file << std::format( "\t\t{{ \"tag\": \"{}\", \"bytes\": {}, \"peak_bytes\": {}, \"allocations\": {}, "
+				"\"budget\": {} }}{}\n", Memory::GetTagName( tag ), stats.CurrentBytes, stats.PeakBytes,
+				stats.Allocations, stats.Budget, i + 1 < static_cast< uint32 >( MemoryTag::Count ) ? "," : "" );
+		}
+		file << "\t],\n";
+
+		const VulkanHostMemoryStats host_stats = GetHostMemoryStats();
+		file << "\t\"vulkan_host\": {\n";
+		for ( uint32 scope = 0; scope < VulkanHostMemoryStats::SCOPE_COUNT; ++scope )
+		{
+			file << std::format( "\t\t\"{}\": {},\n", GetScopeName( scope ), host_stats.ScopeBytes[scope] );
+		}
+		file << std::format( "\t\t\"internal\": {}\n", host_stats.InternalBytes );
+		file << "\t},\n";
+
+		const std::vector<VulkanHeapUsage> heaps = QueryHeapUsage( Gpu, MemoryBudget );
+		file << "\t\"device_heaps\": [\n";
+		for ( uint32 i = 0; i < heaps.size(); ++i )
+		{
+			const VulkanHeapUsage& heap = heaps[i];
+			file << std::format( "\t\t{{ \"index\": {}, \"device_local\": {}, \"size\": {}, \"budget\": {}, "
+				"\"usage\": {}, \"engine_bytes\": {}, \"engine_allocations\": {} }}{}\n", i, heap.DeviceLocal,
+				heap.Size, heap.Budget, heap.Usage, heap.EngineBytes, heap.EngineAllocations,
+				i + 1 < heaps.size() ? "," : "" );
+		}
+		file << "\t]\n";
+		file << "}\n";
+
+		if ( !file )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Failed to write {}", path.string() );
+			return false;
+		}
+		LOG_INFO( "[Vulkan] Memory snapshot written to {}", path.string() );
+		return true;
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,54 @@
+// Engine/Source/Platform/VulkanRHI/VulkanMemory.h
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+
+namespace VulkanRHI
+{
+
+	// Host memory the driver allocates through VkAllocationCallbacks, charged to MemoryTag::Vulkan
+	// and split by the scope the driver asked for.
+	struct VulkanHostMemoryStats
+	{
+		static constexpr uint32 SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+		std::array<uint64, SCOPE_COUNT> ScopeBytes = {};
+		// allocated by the driver without the callbacks, e.g. executable memory, reported only
+		uint64 InternalBytes = 0;
+	};
+
+	struct VulkanHeapUsage
+	{
+		VkDeviceSize Size = 0;
+		// what the process may use before the system starts paging, 80% of the heap without
+		// VK_EXT_memory_budget
+		VkDeviceSize Budget = 0;
+		// the whole process as seen by the driver, what the engine allocated without the extension
+		VkDeviceSize Usage = 0;
+		// through AllocateDeviceMemory
+		VkDeviceSize EngineBytes = 0;
+		uint32       EngineAllocations = 0;
+		bool         DeviceLocal = false;
+	};
+
+	// Callbacks routing every driver host allocation through the tracked heap. One instance for the
+	// process, the driver may call it from any thread.
+	const VkAllocationCallbacks* GetHostAllocationCallbacks();
+	VulkanHostMemoryStats GetHostMemoryStats();
+
+	// vkAllocateMemory and vkFreeMemory with the allocation recorded per memory type, every device
+	// memory allocation of the engine goes through these.
+	VkResult AllocateDeviceMemory( VkDevice device, const VkMemoryAllocateInfo& allocate_info,
+		const VkAllocationCallbacks* alloc, VkDeviceMemory* memory );
+	void FreeDeviceMemory( VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* alloc );
+
+	// Budget and usage per heap, from VK_EXT_memory_budget when it was enabled on the device.
+	std::vector<VulkanHeapUsage> QueryHeapUsage( VkPhysicalDevice gpu, bool memory_budget );
+
+} // namespace VulkanRHI
@@ -0,0 +1,103 @@
+#include "VulkanRHI.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Scene/MeshSimplifier.h"
+
+namespace VulkanRHI
+{
+
+	// Runs on the startup worker. Every level is simplified from the full mesh rather than from the one before
+	// it, so the errors of the levels do not add up.
+	uint32 Context::AddMesh( std::span<const Vertex> vertices, std::span<const uint16> indices )
+	{
+		VulkanMesh mesh = {};
+		mesh.VertexOffset = static_cast< int32 >( SceneVertices.size() );
+		mesh.LocalBounds = Bounds::FromVertices( vertices );
+		SceneVertices.insert( SceneVertices.end(), vertices.begin(), vertices.end() );
+
+		std::vector<glm::vec3> positions;
+		positions.reserve( vertices.size() );
+		for ( const Vertex& vertex : vertices )
+		{
+			positions.push_back( vertex.Pos );
+		}
+		const std::vector<uint32> full_indices( indices.begin(), indices.end() );
+
+		auto add_lod = [this, &mesh] ( std::span<const uint32> lod_indices, float error ) {
+			VulkanMeshLod& lod = mesh.Lods[mesh.LodCount++];
+			lod.FirstIndex = static_cast< uint32 >( SceneIndices.size() );
+			lod.IndexCount = static_cast< uint32 >( lod_indices.size() );
+			lod.Error = error;
+			for ( uint32 index : lod_indices )
+			{
+				SceneIndices.push_back( static_cast< uint16 >( index ) );
+			}
+		};
+		add_lod( full_indices, 0.0f );
+
+		size_t previous_count = full_indices.size();
+		while ( mesh.LodCount < VulkanMesh::MAX_LODS )
+		{
+			const size_t target_count = static_cast< size_t >( previous_count * VulkanMesh::LOD_REDUCTION ) / 3 * 3;
+			const SimplifiedMesh simplified = SimplifyMesh( positions, full_indices, target_count, FLT_MAX );
+
+			// a level that saves little only costs index memory, and a coarser target runs into whatever
+			// stopped this one
+			if ( simplified.Indices.empty() ||
+				simplified.Indices.size() > previous_count * VulkanMesh::LOD_MIN_REDUCTION )
+			{
+				break;
+			}
+
+			// selection expects the error to grow with the level
+			add_lod( simplified.Indices, std::max( simplified.Error, mesh.Lods[mesh.LodCount - 1].Error ) );
+			previous_count = simplified.Indices.size();
+		}
+
+		Meshes.push_back( mesh );
+		return static_cast< uint32 >( Meshes.size() - 1 );
+	}
+
+	// The error of a level projects to Error * pixels_per_unit / distance, taken at the point of the bounds
+	// nearest to the camera. The object goes finer as soon as its level shows more than LOD_ERROR_PIXELS, and
+	// coarser only once the next level stays under the threshold by the hysteresis margin.
+	uint32 Context::SelectLod( const VulkanRenderObject& object, const glm::mat4& view_model,
+		float pixels_per_unit ) const
+	{
+		const VulkanMesh& mesh = Meshes[object.Mesh];
+		if ( mesh.LodCount <= 1 )
+		{
+			return 0;
+		}
+
+		const glm::mat4 transform = view_model * object.Transform;
+		const float scale = std::max( { glm::length( glm::vec3( transform[0] ) ),
+			glm::length( glm::vec3( transform[1] ) ), glm::length( glm::vec3( transform[2] ) ) } );
+		const glm::vec3 farthest = glm::max( glm::abs( mesh.LocalBounds.Min ), glm::abs( mesh.LocalBounds.Max ) );
+		const float radius = glm::length( farthest ) * scale;
+		const float distance = std::max( glm::length( glm::vec3( transform[3] ) ) - radius, NEAR_PLANE );
+		const float pixels_per_error = scale * pixels_per_unit / distance;
+
+		auto projected_error = [&mesh, pixels_per_error] ( uint32 level ) {
+			return mesh.Lods[level].Error * pixels_per_error;
+		};
+
+		uint32 lod = std::min( object.Lod, mesh.LodCount - 1 );
+		while ( lod > 0 && projected_error( lod ) > VulkanMesh::LOD_ERROR_PIXELS )
+		{
+			--lod;
+		}
+
+		const float coarser_threshold = VulkanMesh::LOD_ERROR_PIXELS * ( 1.0f - VulkanMesh::LOD_HYSTERESIS );
+		while ( lod + 1 < mesh.LodCount && projected_error( lod + 1 ) <= coarser_threshold )
+		{
+			++lod;
+		}
+		return lod;
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,528 @@
+#include "VulkanRHI.h"
+
+#include <bit>
+#include <array>
+#include <filesystem>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+#include "Engine/Core/Assert.h"
+#include "Shader.h"
+
+namespace VulkanRHI
+{
+
+	Expected<VulkanComputePipeline> Context::CreateComputePipeline( const VulkanShader& shader )
+	{
+		VulkanComputePipeline pipeline;
+
+		auto layout_result = LayoutCache.Get( Device, shader.Reflection, Allocator );
+		if ( !layout_result )
+		{
+			return std::unexpected( layout_result.error() );
+		}
+		pipeline.Layout = layout_result.value().Instance;
+		if ( !layout_result.value().SetLayouts.empty() )
+		{
+			pipeline.DescriptorSetLayout = layout_result.value().SetLayouts[0];
+		}
+
+		auto instance_result = CreateComputePipelineInstance( shader, pipeline.Layout );
+		if ( !instance_result )
+		{
+			return std::unexpected( instance_result.error() );
+		}
+		pipeline.Instance = instance_result.value();
+		return pipeline;
+	}
+
+	Expected<VkPipeline> Context::CreateComputePipelineInstance( const VulkanShader& shader, VkPipelineLayout layout )
+	{
+		const VkSpecializationInfo specialization = shader.GetSpecializationInfo();
+
+		VkComputePipelineCreateInfo pipeline_info = {};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipeline_info.stage.module = shader.Module;
+		pipeline_info.stage.pName = "main";
+		if ( !shader.SpecializationEntries.empty() )
+		{
+			pipeline_info.stage.pSpecializationInfo = &specialization;
+		}
+		pipeline_info.layout = layout;
+
+		VkPipeline pipeline;
+		const uint32                 create_count = 1;
+		const VkAllocationCallbacks* alloc = Allocator;
+		VkResult err = vkCreateComputePipelines( Device, PipelineCache, create_count, &pipeline_info, alloc,
+			&pipeline );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateComputePipeline, err ) );
+		}
+		return pipeline;
+	}
+
+	// The pipelines are compiled on startup workers while the device resources are created.
+	Expected<VulkanOcclusionCuller> Context::CreateOcclusionCuller( const VulkanComputePipeline& hiz_pipeline,
+		const VulkanComputePipeline& cull_pipeline )
+	{
+		VkResult err;
+		VulkanOcclusionCuller culler;
+
+		culler.HiZPipeline = hiz_pipeline;
+		culler.CullPipeline = cull_pipeline;
+
+		auto objects_result = CreateFrameRing( sizeof( CullObject ), MAX_INSTANCES_PER_FRAME,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, Capabilities.Properties.limits.minStorageBufferOffsetAlignment );
+		if ( !objects_result )
+		{
+			return std::unexpected( objects_result.error() );
+		}
+		culler.Objects = objects_result.value();
+
+		// early and late commands for every instance, per frame in flight, written by the cull passes and
+		// read by the indirect draws on the graphics queue
+		const bool shared = true;
+		culler.DrawCommandsFrameSize = 2 * MAX_INSTANCES_PER_FRAME * VulkanOcclusionCuller::COMMAND_STRIDE;
+		auto commands_result = CreateBuffer( culler.DrawCommandsFrameSize * MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shared );
+		if ( !commands_result )
+		{
+			return std::unexpected( commands_result.error() );
+		}
+		culler.DrawCommands = commands_result.value();
+
+		const VkDeviceSize visibility_size = MAX_INSTANCES_PER_FRAME * sizeof( uint32 );
+		// cleared on the graphics queue below
+		auto visibility_result = CreateBuffer( visibility_size,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shared );
+		if ( !visibility_result )
+		{
+			return std::unexpected( visibility_result.error() );
+		}
+		culler.Visibility = visibility_result.value();
+
+		// nothing was visible before the first frame, so everything goes through the late phase once
+		auto command_buffer_result = BeginSingleTimeCommands();
+		if ( !command_buffer_result )
+		{
+			return std::unexpected( command_buffer_result.error() );
+		}
+		const VkDeviceSize fill_offset = 0;
+		const uint32       fill_value = 0;
+		vkCmdFillBuffer( command_buffer_result.value(), culler.Visibility.Instance, fill_offset, VK_WHOLE_SIZE,
+			fill_value );
+		EndSingleTimeCommands( command_buffer_result.value() );
+
+		std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pool_sizes[0].descriptorCount = static_cast< uint32 >( 3 * MAX_FRAMES_IN_FLIGHT );
+		pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_sizes[1].descriptorCount = static_cast< uint32 >( MAX_FRAMES_IN_FLIGHT );
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.poolSizeCount = static_cast< uint32 >( pool_sizes.size() );
+		pool_info.pPoolSizes = pool_sizes.data();
+		pool_info.maxSets = static_cast< uint32 >( MAX_FRAMES_IN_FLIGHT );
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &culler.DescriptorPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
+		}
+
+		ScratchScope scratch;
+		std::pmr::vector<VkDescriptorSetLayout> layouts( MAX_FRAMES_IN_FLIGHT,
+			culler.CullPipeline.DescriptorSetLayout, scratch.GetResource() );
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = culler.DescriptorPool;
+		allocate_info.descriptorSetCount = static_cast< uint32 >( layouts.size() );
+		allocate_info.pSetLayouts = layouts.data();
+
+		culler.CullSets.resize( layouts.size() );
+		culler.CullSetGenerations.resize( layouts.size(), UINT32_MAX );
+		err = vkAllocateDescriptorSets( Device, &allocate_info, culler.CullSets.data() );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
+		}
+
+		// the pyramid binding is written by UpdateOcclusionDescriptors once the pyramid exists
+		for ( size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i )
+		{
+			std::array<VkDescriptorBufferInfo, 3> buffer_infos = {};
+			buffer_infos[0].buffer = culler.Objects.Buffer.Instance;
+			buffer_infos[0].offset = i * culler.Objects.FrameCapacity;
+			buffer_infos[0].range = culler.Objects.FrameCapacity;
+			buffer_infos[1].buffer = culler.Visibility.Instance;
+			buffer_infos[1].offset = 0;
+			buffer_infos[1].range = VK_WHOLE_SIZE;
+			buffer_infos[2].buffer = culler.DrawCommands.Instance;
+			buffer_infos[2].offset = i * culler.DrawCommandsFrameSize;
+			buffer_infos[2].range = culler.DrawCommandsFrameSize;
+
+			std::array<VkWriteDescriptorSet, 3> descriptor_writes = {};
+			for ( uint32 binding = 0; binding < descriptor_writes.size(); ++binding )
+			{
+				descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptor_writes[binding].dstSet = culler.CullSets[i];
+				descriptor_writes[binding].dstBinding = binding;
+				descriptor_writes[binding].dstArrayElement = 0;
+				descriptor_writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				descriptor_writes[binding].descriptorCount = 1;
+				descriptor_writes[binding].pBufferInfo = &buffer_infos[binding];
+			}
+
+			const uint32 descriptor_copy_count = 0;
+			const VkCopyDescriptorSet* descriptor_copies = nullptr;
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		return culler;
+	}
+
+	Expected<VulkanHiZPyramid> Context::CreateHiZPyramid()
+	{
+		VkResult err;
+		VulkanHiZPyramid pyramid;
+
+		// level 0 is half the depth texture, every texel covers a 2x2 depth footprint at full render scale
+		pyramid.Extent.width = std::max( ( Swapchain.Extent.width + 1 ) / 2, 1u );
+		pyramid.Extent.height = std::max( ( Swapchain.Extent.height + 1 ) / 2, 1u );
+		pyramid.MipCount = static_cast< uint32 >( std::bit_width( std::max( pyramid.Extent.width,
+			pyramid.Extent.height ) ) );
+
+		auto texture_result = CreateTextureImage(
+			static_cast< int32 >( pyramid.Extent.width ),
+			static_cast< int32 >( pyramid.Extent.height ),
+			VK_FORMAT_R32_SFLOAT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			pyramid.MipCount );
+		if ( !texture_result )
+		{
+			return std::unexpected( texture_result.error() );
+		}
+		pyramid.Texture = texture_result.value();
+
+		auto view_result = CreateImageView( pyramid.Texture.Image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT,
+			0, pyramid.MipCount );
+		if ( !view_result )
+		{
+			return std::unexpected( view_result.error() );
+		}
+		pyramid.Texture.View = view_result.value();
+
+		for ( uint32 mip = 0; mip < pyramid.MipCount; ++mip )
+		{
+			auto mip_view_result = CreateImageView( pyramid.Texture.Image, VK_FORMAT_R32_SFLOAT,
+				VK_IMAGE_ASPECT_COLOR_BIT, mip, 1 );
+			if ( !mip_view_result )
+			{
+				return std::unexpected( mip_view_result.error() );
+			}
+			pyramid.MipViews.push_back( mip_view_result.value() );
+		}
+
+		auto sampler_result = CreatePointSampler( static_cast< float >( pyramid.MipCount ) );
+		if ( !sampler_result )
+		{
+			return std::unexpected( sampler_result.error() );
+		}
+		pyramid.Texture.Sampler = sampler_result.value();
+
+		std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_sizes[0].descriptorCount = pyramid.MipCount;
+		pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		pool_sizes[1].descriptorCount = pyramid.MipCount;
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.poolSizeCount = static_cast< uint32 >( pool_sizes.size() );
+		pool_info.pPoolSizes = pool_sizes.data();
+		pool_info.maxSets = pyramid.MipCount;
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &pyramid.DescriptorPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
+		}
+
+		ScratchScope scratch;
+		std::pmr::vector<VkDescriptorSetLayout> layouts( pyramid.MipCount, Culler.HiZPipeline.DescriptorSetLayout,
+			scratch.GetResource() );
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = pyramid.DescriptorPool;
+		allocate_info.descriptorSetCount = static_cast< uint32 >( layouts.size() );
+		allocate_info.pSetLayouts = layouts.data();
+
+		pyramid.MipSets.resize( layouts.size() );
+		err = vkAllocateDescriptorSets( Device, &allocate_info, pyramid.MipSets.data() );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
+		}
+
+		for ( uint32 mip = 0; mip < pyramid.MipCount; ++mip )
+		{
+			// level 0 reduces the depth texture, every other level reduces the one above it
+			VkDescriptorImageInfo source_info = {};
+			if ( mip == 0 )
+			{
+				source_info.sampler = DepthTexture.Sampler;
+				source_info.imageView = DepthTexture.View;
+				source_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			}
+			else
+			{
+				source_info.sampler = pyramid.Texture.Sampler;
+				source_info.imageView = pyramid.MipViews[mip - 1];
+				source_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+
+			VkDescriptorImageInfo destination_info = {};
+			destination_info.imageView = pyramid.MipViews[mip];
+			destination_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			std::array<VkWriteDescriptorSet, 2> descriptor_writes = {};
+			descriptor_writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptor_writes[0].dstSet = pyramid.MipSets[mip];
+			descriptor_writes[0].dstBinding = 0;
+			descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptor_writes[0].descriptorCount = 1;
+			descriptor_writes[0].pImageInfo = &source_info;
+
+			descriptor_writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptor_writes[1].dstSet = pyramid.MipSets[mip];
+			descriptor_writes[1].dstBinding = 1;
+			descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			descriptor_writes[1].descriptorCount = 1;
+			descriptor_writes[1].pImageInfo = &destination_info;
+
+			const uint32 descriptor_copy_count = 0;
+			const VkCopyDescriptorSet* descriptor_copies = nullptr;
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		return pyramid;
+	}
+
+	void Context::UpdateOcclusionDescriptors( uint32 frame )
+	{
+		if ( Culler.CullSetGenerations[frame] == SwapchainGeneration )
+		{
+			return;
+		}
+
+		VkDescriptorImageInfo pyramid_info = {};
+		pyramid_info.sampler = HiZPyramid.Texture.Sampler;
+		pyramid_info.imageView = HiZPyramid.Texture.View;
+		pyramid_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet descriptor_write = {};
+		descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptor_write.dstSet = Culler.CullSets[frame];
+		descriptor_write.dstBinding = 3;
+		descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptor_write.descriptorCount = 1;
+		descriptor_write.pImageInfo = &pyramid_info;
+
+		const uint32 descriptor_write_count = 1;
+		const uint32 descriptor_copy_count = 0;
+		const VkCopyDescriptorSet* descriptor_copies = nullptr;
+		vkUpdateDescriptorSets( Device, descriptor_write_count, &descriptor_write, descriptor_copy_count,
+			descriptor_copies );
+		Culler.CullSetGenerations[frame] = SwapchainGeneration;
+	}
+
+	void Context::RecordOcclusionCull( VkCommandBuffer command_buffer, uint32 phase )
+	{
+		const VkDependencyFlags dependency_flags = 0;
+
+		if ( phase == 0 )
+		{
+			// visibility written by the previous frame's late phase, and this frame slot's commands were
+			// consumed by indirect draws two frames ago
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 1, &barrier, 0, nullptr, 0, nullptr );
+		}
+
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culler.CullPipeline.Instance );
+
+		const uint32 first_set = 0;
+		const uint32 descriptor_set_count = 1;
+		vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culler.CullPipeline.Layout,
+			first_set, descriptor_set_count, &Culler.CullSets[CurrentFrame], 0, nullptr );
+
+		CullParams params = {};
+		params.ViewProjection = Culler.ViewProjection;
+		params.PyramidSize = glm::vec2( HiZPyramid.Extent.width, HiZPyramid.Extent.height );
+		params.ObjectCount = Culler.ObjectCount;
+		params.Phase = phase;
+		params.MipCount = HiZPyramid.MipCount;
+		vkCmdPushConstants( command_buffer, Culler.CullPipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+			sizeof( params ), &params );
+
+		const uint32 group_size = 64;
+		const uint32 group_count = ( Culler.ObjectCount + group_size - 1 ) / group_size;
+		if ( group_count > 0 )
+		{
+			vkCmdDispatch( command_buffer, group_count, 1, 1 );
+		}
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+		vkCmdPipelineBarrier( command_buffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			dependency_flags, 1, &barrier, 0, nullptr, 0, nullptr );
+	}
+
+	// Only stages the compute queue supports are used here, the depth texture changes layout in
+	// RecordDepthBarrier on the graphics queue before and after.
+	void Context::RecordHiZBuild( VkCommandBuffer command_buffer )
+	{
+		const VkDependencyFlags dependency_flags = 0;
+
+		VkImageSubresourceRange pyramid_range = {};
+		pyramid_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		pyramid_range.levelCount = HiZPyramid.MipCount;
+		pyramid_range.layerCount = 1;
+
+		// the previous contents are discarded, the late cull of the previous frame is the last reader
+		VkImageMemoryBarrier pyramid_barrier = {};
+		pyramid_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		pyramid_barrier.srcAccessMask = 0;
+		pyramid_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		pyramid_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		pyramid_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		pyramid_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramid_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		pyramid_barrier.image = HiZPyramid.Texture.Image;
+		pyramid_barrier.subresourceRange = pyramid_range;
+
+		vkCmdPipelineBarrier( command_buffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			dependency_flags, 0, nullptr, 0, nullptr, 1, &pyramid_barrier );
+
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culler.HiZPipeline.Instance );
+
+		// the pyramid covers the screen, level 0 reduces the part of the depth texture the scene was drawn to
+		VkExtent2D source = DynamicResolution.RenderExtent;
+		for ( uint32 mip = 0; mip < HiZPyramid.MipCount; ++mip )
+		{
+			const VkExtent2D destination = {
+				std::max( HiZPyramid.Extent.width >> mip, 1u ),
+				std::max( HiZPyramid.Extent.height >> mip, 1u )
+			};
+
+			const uint32 first_set = 0;
+			const uint32 descriptor_set_count = 1;
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, Culler.HiZPipeline.Layout,
+				first_set, descriptor_set_count, &HiZPyramid.MipSets[mip], 0, nullptr );
+
+			HiZParams params = {};
+			params.SourceSize = glm::ivec2( source.width, source.height );
+			params.DestinationSize = glm::ivec2( destination.width, destination.height );
+			vkCmdPushConstants( command_buffer, Culler.HiZPipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 8;
+			vkCmdDispatch( command_buffer,
+				( destination.width + group_size - 1 ) / group_size,
+				( destination.height + group_size - 1 ) / group_size,
+				1 );
+
+			VkImageMemoryBarrier mip_barrier = {};
+			mip_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			mip_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			mip_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			mip_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			mip_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			mip_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			mip_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			mip_barrier.image = HiZPyramid.Texture.Image;
+			mip_barrier.subresourceRange = pyramid_range;
+			mip_barrier.subresourceRange.baseMipLevel = mip;
+			mip_barrier.subresourceRange.levelCount = 1;
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 0, nullptr, 0, nullptr, 1, &mip_barrier );
+
+			source = destination;
+		}
+	}
+
+	// With async compute the semaphore between the queues orders the barrier against the Hi-Z build, on a
+	// single queue the compute stage in the masks does.
+	void Context::RecordDepthBarrier( VkCommandBuffer command_buffer, bool shader_read )
+	{
+		const VkDependencyFlags    dependency_flags = 0;
+		const VkPipelineStageFlags fragment_tests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = DepthTexture.Image;
+		barrier.subresourceRange.aspectMask = GetDepthAspect( DepthTexture.Format );
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+
+		if ( shader_read )
+		{
+			barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 0, nullptr, 0, nullptr, 1, &barrier );
+		}
+		else
+		{
+			// the late phase draws into the same depth
+			barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				fragment_tests,
+				dependency_flags, 0, nullptr, 0, nullptr, 1, &barrier );
+		}
+	}
+
+} // namespace VulkanRHI
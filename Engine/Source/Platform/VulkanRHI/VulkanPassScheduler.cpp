@@ -0,0 +1,267 @@
+#include "VulkanPassScheduler.h"
+
+#include <algorithm>
+
+namespace VulkanRHI
+{
+
+	Expected<void> VulkanPassScheduler::Init( VkDevice device, VulkanSchedulerQueue graphics,
+		VulkanSchedulerQueue compute, uint32 frame_count, const VkAllocationCallbacks* alloc )
+	{
+		Allocator = alloc;
+		Queues[static_cast< uint32 >( VulkanQueueType::Graphics )] = graphics;
+		Queues[static_cast< uint32 >( VulkanQueueType::AsyncCompute )] = compute;
+		Frames.resize( frame_count );
+
+		for ( Frame& frame : Frames )
+		{
+			for ( uint32 queue = 0; queue < QUEUE_TYPE_COUNT; ++queue )
+			{
+				// transient, the whole pool is reset once per frame instead of every command buffer
+				VkCommandPoolCreateInfo pool_info = {};
+				pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+				pool_info.queueFamilyIndex = Queues[queue].Family;
+
+				VkResult err = vkCreateCommandPool( device, &pool_info, alloc, &frame.Pools[queue] );
+				if ( err != VK_SUCCESS )
+				{
+					return std::unexpected( Error( ErrorCode::CreateCommandPool, err ) );
+				}
+			}
+		}
+		return {};
+	}
+
+	void VulkanPassScheduler::Destroy( VkDevice device, const VkAllocationCallbacks* alloc )
+	{
+		for ( Frame& frame : Frames )
+		{
+			for ( VkSemaphore semaphore : frame.Semaphores )
+			{
+				vkDestroySemaphore( device, semaphore, alloc );
+			}
+			for ( VkCommandPool pool : frame.Pools )
+			{
+				vkDestroyCommandPool( device, pool, alloc );
+			}
+		}
+		Frames.clear();
+	}
+
+	Expected<void> VulkanPassScheduler::BeginFrame( VkDevice device, uint32 frame_index )
+	{
+		CurrentFrame = frame_index;
+		Passes.clear();
+
+		Frame& frame = Frames[CurrentFrame];
+		for ( uint32 queue = 0; queue < QUEUE_TYPE_COUNT; ++queue )
+		{
+			const VkCommandPoolResetFlags flags = 0;
+			VkResult err = vkResetCommandPool( device, frame.Pools[queue], flags );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::ResetCommandPool, err ) );
+			}
+			frame.UsedCommandBuffers[queue] = 0;
+		}
+		return {};
+	}
+
+	void VulkanPassScheduler::AddPass( VulkanPass pass )
+	{
+		Passes.push_back( std::move( pass ) );
+	}
+
+	Expected<void> VulkanPassScheduler::Submit( VkDevice device, const VulkanFrameSubmit& frame_submit )
+	{
+		VkResult err;
+
+		// passes are recorded in order, a pass on a different queue than the previous one starts a batch and
+		// so does the pass writing the swapchain image
+		Batches.clear();
+		for ( const VulkanPass& pass : Passes )
+		{
+			uint32 queue = static_cast< uint32 >( pass.Queue );
+			if ( !IsAsync() )
+			{
+				queue = static_cast< uint32 >( VulkanQueueType::Graphics );
+			}
+
+			if ( Batches.empty() || Batches.back().Queue != queue || pass.WritesSwapchainImage )
+			{
+				if ( !Batches.empty() )
+				{
+					err = vkEndCommandBuffer( Batches.back().CommandBuffer );
+					if ( err != VK_SUCCESS )
+					{
+						return std::unexpected( Error( ErrorCode::EndCommandBuffer, err ) );
+					}
+				}
+
+				auto command_buffer_result = AcquireCommandBuffer( device, queue );
+				if ( !command_buffer_result )
+				{
+					return std::unexpected( command_buffer_result.error() );
+				}
+
+				VkCommandBufferBeginInfo begin_info = {};
+				begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				err = vkBeginCommandBuffer( command_buffer_result.value(), &begin_info );
+				if ( err != VK_SUCCESS )
+				{
+					return std::unexpected( Error( ErrorCode::BeginCommandBuffer, err ) );
+				}
+
+				Batch batch;
+				batch.Queue = queue;
+				batch.CommandBuffer = command_buffer_result.value();
+				batch.WaitsForImage = pass.WritesSwapchainImage;
+				Batches.push_back( batch );
+			}
+
+			// any pass of the batch may consume what the other queue produced before the batch
+			Batches.back().WaitStages |= pass.WaitStages;
+			pass.Record( Batches.back().CommandBuffer );
+		}
+
+		if ( Batches.empty() )
+		{
+			return {};
+		}
+
+		err = vkEndCommandBuffer( Batches.back().CommandBuffer );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::EndCommandBuffer, err ) );
+		}
+
+		// batches alternate between the queues and each one waits for its predecessor, so the fence of the
+		// last batch signals once the whole frame finished
+		const bool image_pass = std::ranges::any_of( Batches, [] ( const Batch& batch ) {
+			return batch.WaitsForImage;
+		} );
+		bool waited_for_image = false;
+		for ( uint32 i = 0; i < Batches.size(); ++i )
+		{
+			const Batch& batch = Batches[i];
+			const bool   last = i + 1 == Batches.size();
+
+			// the values are ignored for binary semaphores
+			std::array<VkSemaphore, 3>          wait_semaphores = {};
+			std::array<VkPipelineStageFlags, 3> wait_stages = {};
+			std::array<uint64, 3>               wait_values = {};
+			uint32 wait_count = 0;
+			if ( i > 0 )
+			{
+				wait_semaphores[wait_count] = Frames[CurrentFrame].Semaphores[i - 1];
+				wait_stages[wait_count++] = batch.WaitStages;
+			}
+			const bool image_batch = image_pass ? batch.WaitsForImage :
+				batch.Queue == static_cast< uint32 >( VulkanQueueType::Graphics );
+			if ( image_batch && !waited_for_image )
+			{
+				wait_semaphores[wait_count] = frame_submit.WaitSemaphore;
+				wait_stages[wait_count++] = frame_submit.WaitStage;
+				waited_for_image = true;
+			}
+			// uploads are only waited for once, later batches wait for the first one
+			if ( i == 0 && frame_submit.Timeline && frame_submit.TimelineWait > 0 )
+			{
+				wait_semaphores[wait_count] = frame_submit.Timeline;
+				wait_values[wait_count] = frame_submit.TimelineWait;
+				wait_stages[wait_count++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			}
+
+			std::array<VkSemaphore, 2> signal_semaphores = { frame_submit.SignalSemaphore };
+			std::array<uint64, 2>      signal_values = {};
+			uint32 signal_count = 1;
+			if ( !last )
+			{
+				auto semaphore_result = AcquireSemaphore( device, i );
+				if ( !semaphore_result )
+				{
+					return std::unexpected( semaphore_result.error() );
+				}
+				signal_semaphores[0] = semaphore_result.value();
+			}
+			else if ( frame_submit.Timeline )
+			{
+				signal_semaphores[signal_count] = frame_submit.Timeline;
+				signal_values[signal_count++] = frame_submit.TimelineSignal;
+			}
+
+			VkTimelineSemaphoreSubmitInfo timeline_info = {};
+			timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timeline_info.waitSemaphoreValueCount = wait_count;
+			timeline_info.pWaitSemaphoreValues = wait_values.data();
+			timeline_info.signalSemaphoreValueCount = signal_count;
+			timeline_info.pSignalSemaphoreValues = signal_values.data();
+
+			VkSubmitInfo submit_info = {};
+			submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submit_info.pNext = frame_submit.Timeline ? &timeline_info : nullptr;
+			submit_info.waitSemaphoreCount = wait_count;
+			submit_info.pWaitSemaphores = wait_semaphores.data();
+			submit_info.pWaitDstStageMask = wait_stages.data();
+			submit_info.commandBufferCount = 1;
+			submit_info.pCommandBuffers = &batch.CommandBuffer;
+			submit_info.signalSemaphoreCount = signal_count;
+			submit_info.pSignalSemaphores = signal_semaphores.data();
+
+			const uint32  submit_count = 1;
+			const VkFence fence = last ? frame_submit.Fence : VK_NULL_HANDLE;
+			err = vkQueueSubmit( Queues[batch.Queue].Instance, submit_count, &submit_info, fence );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::QueueSubmit, err ) );
+			}
+		}
+		SubmitCount = static_cast< uint32 >( Batches.size() );
+		return {};
+	}
+
+	Expected<VkCommandBuffer> VulkanPassScheduler::AcquireCommandBuffer( VkDevice device, uint32 queue )
+	{
+		Frame& frame = Frames[CurrentFrame];
+		std::vector<VkCommandBuffer>& command_buffers = frame.CommandBuffers[queue];
+		if ( frame.UsedCommandBuffers[queue] == command_buffers.size() )
+		{
+			VkCommandBufferAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			alloc_info.commandPool = frame.Pools[queue];
+			alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			alloc_info.commandBufferCount = 1;
+
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			VkResult err = vkAllocateCommandBuffers( device, &alloc_info, &command_buffer );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::AllocateCommandBuffers, err ) );
+			}
+			command_buffers.push_back( command_buffer );
+		}
+		return command_buffers[frame.UsedCommandBuffers[queue]++];
+	}
+
+	Expected<VkSemaphore> VulkanPassScheduler::AcquireSemaphore( VkDevice device, uint32 index )
+	{
+		std::vector<VkSemaphore>& semaphores = Frames[CurrentFrame].Semaphores;
+		while ( semaphores.size() <= index )
+		{
+			VkSemaphoreCreateInfo semaphore_info = {};
+			semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			VkResult err = vkCreateSemaphore( device, &semaphore_info, Allocator, &semaphore );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::CreateSyncSemaphore, err, "queue switch" ) );
+			}
+			semaphores.push_back( semaphore );
+		}
+		return semaphores[index];
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,121 @@
+// Engine/Source/Platform/VulkanRHI/VulkanPassScheduler.h
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "VulkanError.h"
+
+namespace VulkanRHI
+{
+
+	enum class VulkanQueueType : uint8
+	{
+		Graphics,
+		// the dedicated compute family when there is one, passes tagged with it run on the graphics queue otherwise
+		AsyncCompute,
+		Count
+	};
+
+	struct VulkanPass
+	{
+		const char*          Name = "";
+		VulkanQueueType      Queue = VulkanQueueType::Graphics;
+		// stages consuming what the previous pass produced, waited on when that pass ran on the other queue
+		VkPipelineStageFlags WaitStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		// starts a submission that waits for the swapchain image, the passes before it do not
+		bool                 WritesSwapchainImage = false;
+		std::function<void( VkCommandBuffer )> Record;
+	};
+
+	struct VulkanSchedulerQueue
+	{
+		VkQueue Instance = VK_NULL_HANDLE;
+		uint32  Family = 0;
+	};
+
+	// Semaphores and fence of the frame, the submission of the pass writing the swapchain image waits for
+	// the image, the first graphics submission without such a pass, and the last submission signals
+	// presentation and the fence. With a timeline the first submission, on
+	// whichever queue, waits for TimelineWait and the last one signals TimelineSignal.
+	struct VulkanFrameSubmit
+	{
+		VkSemaphore          WaitSemaphore = VK_NULL_HANDLE;
+		VkPipelineStageFlags WaitStage = 0;
+		VkSemaphore          SignalSemaphore = VK_NULL_HANDLE;
+		VkFence              Fence = VK_NULL_HANDLE;
+		VkSemaphore          Timeline = VK_NULL_HANDLE;
+		// zero waits for nothing
+		uint64               TimelineWait = 0;
+		uint64               TimelineSignal = 0;
+	};
+
+	// Records the passes of a frame into command buffers of the queues they are tagged with and submits
+	// them in the order they were added. Consecutive passes on one queue share a command buffer, every
+	// switch to the other queue starts a submission that waits on a semaphore signaled by the previous one,
+	// so a pass never needs to know where its neighbours run. Compute work of the next frame overlaps the
+	// rasterization of the current one, the first submission of a frame only waits for pending uploads.
+	class VulkanPassScheduler
+	{
+	public:
+		static constexpr uint32 QUEUE_TYPE_COUNT = static_cast< uint32 >( VulkanQueueType::Count );
+
+		// compute may be the graphics queue, every pass then ends up in a single submission
+		Expected<void> Init( VkDevice device, VulkanSchedulerQueue graphics, VulkanSchedulerQueue compute,
+			uint32 frame_count, const VkAllocationCallbacks* alloc = nullptr );
+		void Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr );
+
+		bool IsAsync() const
+		{
+			return Queues[0].Instance != Queues[1].Instance;
+		}
+
+		// the frame's fence must have signaled, its command buffers and semaphores are reused
+		Expected<void> BeginFrame( VkDevice device, uint32 frame );
+		void AddPass( VulkanPass pass );
+		// records every pass added since BeginFrame and submits them
+		Expected<void> Submit( VkDevice device, const VulkanFrameSubmit& frame_submit );
+
+		uint32 GetSubmitCount() const
+		{
+			return SubmitCount;
+		}
+
+	private:
+		Expected<VkCommandBuffer> AcquireCommandBuffer( VkDevice device, uint32 queue );
+		Expected<VkSemaphore>     AcquireSemaphore( VkDevice device, uint32 index );
+
+	private:
+		struct Frame
+		{
+			std::array<VkCommandPool, QUEUE_TYPE_COUNT>                Pools = {};
+			std::array<std::vector<VkCommandBuffer>, QUEUE_TYPE_COUNT> CommandBuffers;
+			std::array<uint32, QUEUE_TYPE_COUNT>                       UsedCommandBuffers = {};
+			// one per queue switch, grown on demand
+			std::vector<VkSemaphore>                                   Semaphores;
+		};
+
+		struct Batch
+		{
+			uint32               Queue = 0;
+			VkCommandBuffer      CommandBuffer = VK_NULL_HANDLE;
+			VkPipelineStageFlags WaitStages = 0;
+			bool                 WaitsForImage = false;
+		};
+
+		std::array<VulkanSchedulerQueue, QUEUE_TYPE_COUNT> Queues = {};
+		// semaphores are created on demand while submitting
+		const VkAllocationCallbacks* Allocator = nullptr;
+		std::vector<Frame>      Frames;
+		std::vector<VulkanPass> Passes;
+		std::vector<Batch>      Batches;
+		uint32                  CurrentFrame = 0;
+		uint32                  SubmitCount = 0;
+	};
+
+} // namespace VulkanRHI
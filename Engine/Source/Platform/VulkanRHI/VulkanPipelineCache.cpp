@@ -0,0 +1,118 @@
+#include "VulkanRHI.h"
+
+#include <fstream>
+#include <cstring>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+#include "Engine/Core/Application.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		// VkPipelineCacheHeaderVersionOne, read field by field since the data has no alignment guarantee
+		constexpr size_t CACHE_HEADER_SIZE = 4 * sizeof( uint32 ) + VK_UUID_SIZE;
+
+		uint32 ReadUint32( std::span<const char> data, size_t offset )
+		{
+			uint32 value = 0;
+			memcpy( &value, data.data() + offset, sizeof( value ) );
+			return value;
+		}
+
+		// drivers are supposed to reject foreign data themselves, not all of them do
+		bool IsCompatibleCache( std::span<const char> data, const VkPhysicalDeviceProperties& props )
+		{
+			if ( data.size() < CACHE_HEADER_SIZE )
+			{
+				return false;
+			}
+
+			const uint32 header_size = ReadUint32( data, 0 );
+			const uint32 header_version = ReadUint32( data, 4 );
+			const uint32 vendor_id = ReadUint32( data, 8 );
+			const uint32 device_id = ReadUint32( data, 12 );
+			return header_size >= CACHE_HEADER_SIZE && header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				vendor_id == props.vendorID && device_id == props.deviceID &&
+				memcmp( data.data() + 16, props.pipelineCacheUUID, VK_UUID_SIZE ) == 0;
+		}
+	}
+
+	std::filesystem::path Context::GetPipelineCachePath() const
+	{
+		return Application::ExecutablePath().parent_path() / "pipeline_cache.bin";
+	}
+
+	Expected<VkPipelineCache> Context::CreatePipelineCache( std::span<const char> data )
+	{
+		const bool compatible = IsCompatibleCache( data, Capabilities.Properties );
+		if ( !data.empty() && !compatible )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Pipeline cache is from another GPU or driver, ignored." );
+		}
+
+		VkPipelineCacheCreateInfo cache_info = {};
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cache_info.initialDataSize = compatible ? data.size() : 0;
+		cache_info.pInitialData = compatible ? data.data() : nullptr;
+
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		VkResult err = vkCreatePipelineCache( Device, &cache_info, Allocator, &cache );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreatePipelineCache, err ) );
+		}
+		LOG_INFO( "[Vulkan] Pipeline cache {} ({} bytes).", compatible ? "loaded" : "created empty",
+			cache_info.initialDataSize );
+		return cache;
+	}
+
+	// Written through a temporary file, an interrupted shutdown leaves the previous cache intact.
+	void Context::SavePipelineCache()
+	{
+		if ( PipelineCache == VK_NULL_HANDLE )
+		{
+			return;
+		}
+
+		size_t size = 0;
+		VkResult err = vkGetPipelineCacheData( Device, PipelineCache, &size, nullptr );
+		if ( err != VK_SUCCESS )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::GetPipelineCacheData, err ) );
+			return;
+		}
+
+		std::vector<char> data( size );
+		err = vkGetPipelineCacheData( Device, PipelineCache, &size, data.data() );
+		if ( err != VK_SUCCESS )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::GetPipelineCacheData, err ) );
+			return;
+		}
+
+		const std::filesystem::path path = GetPipelineCachePath();
+		std::filesystem::path temporary_path = path;
+		temporary_path += ".tmp";
+		{
+			std::ofstream file( temporary_path, std::ios::binary | std::ios::trunc );
+			file.write( data.data(), static_cast< std::streamsize >( size ) );
+			if ( !file )
+			{
+				LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Failed to write {}", temporary_path.string() );
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename( temporary_path, path, error );
+		if ( error )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Failed to replace {}: {}", path.string(),
+				error.message() );
+		}
+	}
+
+} // namespace VulkanRHI
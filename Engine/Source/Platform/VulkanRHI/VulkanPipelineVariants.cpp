@@ -0,0 +1,139 @@
+#include "VulkanRHI.h"
+
+#include <string>
+#include <iterator>
+#include <algorithm>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+#include "Engine/Renderer/RenderQueue.h"
+
+namespace VulkanRHI
+{
+
+	Expected<uint32> Context::GetGraphicsVariant( std::vector<ShaderKeyword> keywords )
+	{
+		std::ranges::sort( keywords, {}, &ShaderKeyword::Name );
+
+		auto same_keywords = [&keywords] ( const VulkanPipelineVariant& variant ) {
+			return std::ranges::equal( variant.Keywords, keywords, [] ( const ShaderKeyword& lhs,
+				const ShaderKeyword& rhs ) {
+				return lhs.Name == rhs.Name && lhs.Value == rhs.Value;
+			} );
+		};
+
+		auto it = std::ranges::find_if( GraphicsPipeline.Variants, same_keywords );
+		if ( it != GraphicsPipeline.Variants.end() )
+		{
+			return static_cast< uint32 >( it - GraphicsPipeline.Variants.begin() );
+		}
+
+		if ( GraphicsPipeline.Variants.size() >= ( 1u << RenderQueue::PIPELINE_BITS ) )
+		{
+			return std::unexpected( Error( ErrorCode::TooManyPipelineVariants ) );
+		}
+
+		auto pipeline_result = CreateGraphicsVariant( keywords );
+		if ( !pipeline_result )
+		{
+			return std::unexpected( pipeline_result.error() );
+		}
+
+		GraphicsPipeline.Variants.push_back( { std::move( keywords ), pipeline_result.value() } );
+		return static_cast< uint32 >( GraphicsPipeline.Variants.size() - 1 );
+	}
+
+	void Context::SetDebugView( DebugView view )
+	{
+		RequestedDebugView = view;
+	}
+
+	void Context::UpdateDebugView()
+	{
+		if ( RequestedDebugView == ActiveDebugView )
+		{
+			return;
+		}
+
+		if ( RequestedDebugView == DebugView::None )
+		{
+			DebugPipeline.reset();
+			ActiveDebugView = RequestedDebugView;
+			return;
+		}
+
+		auto variant_result = GetGraphicsVariant( { ShaderKeyword{ "DEBUG_LIGHT_HEATMAP" } } );
+		if ( !variant_result )
+		{
+			// the previous view stays, the variant is not retried until another view is requested
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", variant_result.error() );
+			RequestedDebugView = ActiveDebugView;
+			return;
+		}
+		DebugPipeline = variant_result.value();
+		ActiveDebugView = RequestedDebugView;
+	}
+
+	// A permutation must keep the interface of the base shaders: resources it uses are declared outside
+	// of its #ifdef blocks, so that every variant shares GraphicsPipeline.Layout and its descriptor sets.
+	Expected<VkPipeline> Context::CreateGraphicsVariant( std::span<const ShaderKeyword> keywords )
+	{
+		auto vertex_result = LoadShader( "triangle.vert", keywords );
+		if ( !vertex_result )
+		{
+			return std::unexpected( vertex_result.error() );
+		}
+		VulkanShader vertex = std::move( vertex_result.value() );
+
+		auto fragment_result = LoadShader( "triangle.frag", keywords );
+		if ( !fragment_result )
+		{
+			vertex.Destroy( Device, Allocator );
+			return std::unexpected( fragment_result.error() );
+		}
+		VulkanShader fragment = std::move( fragment_result.value() );
+
+		// a keyword neither stage knows is most likely a typo, it would silently select the default path
+		std::vector<std::string> permutation_keywords = ReadPermutationKeywords( ShadersPath / "triangle.vert" );
+		std::ranges::copy( ReadPermutationKeywords( ShadersPath / "triangle.frag" ),
+			std::back_inserter( permutation_keywords ) );
+
+		Expected<VkPipeline> pipeline_result;
+		for ( const ShaderKeyword& keyword : keywords )
+		{
+			const bool declared = std::ranges::find( permutation_keywords, keyword.Name ) !=
+				permutation_keywords.end() || vertex.Reflection.FindSpecConstant( keyword.Name ) ||
+				fragment.Reflection.FindSpecConstant( keyword.Name );
+			if ( !declared )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "[Vulkan] Unknown shader keyword {}.", keyword.Name );
+				pipeline_result = std::unexpected( Error( ErrorCode::UnknownShaderKeyword ) );
+			}
+		}
+
+		// identical interfaces come back as the same cached layout
+		if ( pipeline_result )
+		{
+			auto layout_result = GetGraphicsLayout( vertex, fragment );
+			if ( !layout_result )
+			{
+				pipeline_result = std::unexpected( layout_result.error() );
+			}
+			else if ( layout_result.value().Instance != GraphicsPipeline.Layout )
+			{
+				pipeline_result = std::unexpected( Error( ErrorCode::ShaderInterfaceChanged, VK_SUCCESS,
+					"triangle" ) );
+			}
+			else
+			{
+				pipeline_result = CreateGraphicsPipelineInstance( vertex, fragment, GraphicsPipeline.Layout,
+					GraphicsPipeline.RenderPass );
+			}
+		}
+
+		vertex.Destroy( Device, Allocator );
+		fragment.Destroy( Device, Allocator );
+		return pipeline_result;
+	}
+
+} // namespace VulkanRHI
@@ -0,0 +1,771 @@
+#include "VulkanRHI.h"
+
+#include <bit>
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Engine/Core/Common.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		VkWriteDescriptorSet MakeImageWrite( VkDescriptorSet set, uint32 binding, VkDescriptorType type,
+			const VkDescriptorImageInfo* image_info )
+		{
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = set;
+			write.dstBinding = binding;
+			write.descriptorType = type;
+			write.descriptorCount = 1;
+			write.pImageInfo = image_info;
+			return write;
+		}
+
+		VkWriteDescriptorSet MakeBufferWrite( VkDescriptorSet set, uint32 binding,
+			const VkDescriptorBufferInfo* buffer_info )
+		{
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = set;
+			write.dstBinding = binding;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.descriptorCount = 1;
+			write.pBufferInfo = buffer_info;
+			return write;
+		}
+
+		VkExtent2D GetMipExtent( VkExtent2D extent, uint32 mip )
+		{
+			return { std::max( extent.width >> mip, 1u ), std::max( extent.height >> mip, 1u ) };
+		}
+
+		void Dispatch( VkCommandBuffer command_buffer, VkExtent2D extent, uint32 group_size )
+		{
+			vkCmdDispatch( command_buffer,
+				( extent.width + group_size - 1 ) / group_size,
+				( extent.height + group_size - 1 ) / group_size,
+				1 );
+		}
+
+		// every pass of the chain reads what the one before it wrote, the images stay in the general layout
+		void ComputeBarrier( VkCommandBuffer command_buffer )
+		{
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+			const VkDependencyFlags dependency_flags = 0;
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 1, &barrier, 0, nullptr, 0, nullptr );
+		}
+
+		VkImageMemoryBarrier MakeColorBarrier( VkImage image, VkImageLayout old_layout, VkImageLayout new_layout,
+			VkAccessFlags src_access, VkAccessFlags dst_access, uint32 mip_count = 1 )
+		{
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = src_access;
+			barrier.dstAccessMask = dst_access;
+			barrier.oldLayout = old_layout;
+			barrier.newLayout = new_layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = mip_count;
+			barrier.subresourceRange.layerCount = 1;
+			return barrier;
+		}
+
+		// element index of the radical inverse sequence in the base, in [0, 1)
+		float Halton( uint32 index, uint32 base )
+		{
+			float result = 0.0f;
+			float fraction = 1.0f;
+			while ( index > 0 )
+			{
+				fraction /= static_cast< float >( base );
+				result += fraction * static_cast< float >( index % base );
+				index /= base;
+			}
+			return result;
+		}
+	}
+
+	// The pipelines are compiled on startup workers while the device resources are created.
+	Expected<VulkanPostProcess> Context::CreatePostProcess(
+		const std::array<VulkanComputePipeline, VulkanPostProcess::StageCount>& pipelines )
+	{
+		VkResult err;
+		VulkanPostProcess post;
+		post.Pipelines = pipelines;
+
+		// cleared below and by the exposure pass after every use
+		auto histogram_result = CreateBuffer( VulkanPostProcess::HISTOGRAM_BINS * sizeof( uint32 ),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+		if ( !histogram_result )
+		{
+			return std::unexpected( histogram_result.error() );
+		}
+		post.Histogram = histogram_result.value();
+
+		auto exposure_result = CreateBuffer( sizeof( float ),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+		if ( !exposure_result )
+		{
+			return std::unexpected( exposure_result.error() );
+		}
+		post.Exposure = exposure_result.value();
+
+		auto command_buffer_result = BeginSingleTimeCommands();
+		if ( !command_buffer_result )
+		{
+			return std::unexpected( command_buffer_result.error() );
+		}
+		const VkDeviceSize fill_offset = 0;
+		const uint32       fill_value = 0;
+		vkCmdFillBuffer( command_buffer_result.value(), post.Histogram.Instance, fill_offset, VK_WHOLE_SIZE,
+			fill_value );
+		vkCmdFillBuffer( command_buffer_result.value(), post.Exposure.Instance, fill_offset, VK_WHOLE_SIZE,
+			fill_value );
+		EndSingleTimeCommands( command_buffer_result.value() );
+
+		// bilinear taps between texels do part of the filtering of the bloom chain
+		VkSamplerCreateInfo sampler_info = {};
+		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler_info.magFilter = VK_FILTER_LINEAR;
+		sampler_info.minFilter = VK_FILTER_LINEAR;
+		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.minLod = 0.0f;
+		sampler_info.maxLod = static_cast< float >( VulkanPostProcess::BLOOM_MIP_COUNT );
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateSampler( Device, &sampler_info, alloc, &post.Sampler );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateSampler, err ) );
+		}
+
+		VkDescriptorPoolSize pool_size = {};
+		pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pool_size.descriptorCount = 2;
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+		pool_info.maxSets = 1;
+
+		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &post.DescriptorPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
+		}
+
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = post.DescriptorPool;
+		allocate_info.descriptorSetCount = 1;
+		allocate_info.pSetLayouts = &post.Pipelines[VulkanPostProcess::Exposure].DescriptorSetLayout;
+
+		err = vkAllocateDescriptorSets( Device, &allocate_info, &post.ExposureSet );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
+		}
+
+		std::array<VkDescriptorBufferInfo, 2> buffer_infos = {};
+		buffer_infos[0].buffer = post.Histogram.Instance;
+		buffer_infos[0].range = VK_WHOLE_SIZE;
+		buffer_infos[1].buffer = post.Exposure.Instance;
+		buffer_infos[1].range = VK_WHOLE_SIZE;
+
+		std::array<VkWriteDescriptorSet, 2> descriptor_writes = {
+			MakeBufferWrite( post.ExposureSet, 0, &buffer_infos[0] ),
+			MakeBufferWrite( post.ExposureSet, 1, &buffer_infos[1] )
+		};
+
+		const uint32 descriptor_copy_count = 0;
+		const VkCopyDescriptorSet* descriptor_copies = nullptr;
+		vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+			descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+
+		return post;
+	}
+
+	Expected<VulkanHdrTargets> Context::CreateHdrTargets()
+	{
+		VkResult err;
+		VulkanHdrTargets targets;
+
+		auto hdr_result = CreateTextureImage(
+			static_cast< int32 >( Swapchain.Extent.width ),
+			static_cast< int32 >( Swapchain.Extent.height ),
+			VulkanPostProcess::HDR_FORMAT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+		if ( !hdr_result )
+		{
+			return std::unexpected( hdr_result.error() );
+		}
+		targets.HdrTarget = hdr_result.value();
+
+		auto hdr_view_result = CreateImageView( targets.HdrTarget.Image, VulkanPostProcess::HDR_FORMAT,
+			VK_IMAGE_ASPECT_COLOR_BIT );
+		if ( !hdr_view_result )
+		{
+			return std::unexpected( hdr_view_result.error() );
+		}
+		targets.HdrTarget.View = hdr_view_result.value();
+
+		auto framebuffer_result = CreateSceneFramebuffer( targets.HdrTarget.View );
+		if ( !framebuffer_result )
+		{
+			return std::unexpected( framebuffer_result.error() );
+		}
+		targets.SceneFramebuffer = framebuffer_result.value();
+
+		// undefined until the first resolve, the temporal pass ignores the history then
+		for ( VulkanTexture& history : targets.History )
+		{
+			auto history_result = CreateTextureImage(
+				static_cast< int32 >( Swapchain.Extent.width ),
+				static_cast< int32 >( Swapchain.Extent.height ),
+				VulkanPostProcess::HDR_FORMAT,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+			if ( !history_result )
+			{
+				return std::unexpected( history_result.error() );
+			}
+			history = history_result.value();
+
+			auto history_view_result = CreateImageView( history.Image, VulkanPostProcess::HDR_FORMAT,
+				VK_IMAGE_ASPECT_COLOR_BIT );
+			if ( !history_view_result )
+			{
+				return std::unexpected( history_view_result.error() );
+			}
+			history.View = history_view_result.value();
+		}
+
+		// level 0 is filtered from a 4x4 footprint of the history, every further level halves it again
+		targets.BloomExtent.width = std::max( ( Swapchain.Extent.width + 1 ) / 2, 1u );
+		targets.BloomExtent.height = std::max( ( Swapchain.Extent.height + 1 ) / 2, 1u );
+		targets.BloomMipCount = std::min( VulkanPostProcess::BLOOM_MIP_COUNT, static_cast< uint32 >(
+			std::bit_width( std::max( targets.BloomExtent.width, targets.BloomExtent.height ) ) ) );
+
+		auto bloom_result = CreateTextureImage(
+			static_cast< int32 >( targets.BloomExtent.width ),
+			static_cast< int32 >( targets.BloomExtent.height ),
+			VulkanPostProcess::HDR_FORMAT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			targets.BloomMipCount );
+		if ( !bloom_result )
+		{
+			return std::unexpected( bloom_result.error() );
+		}
+		targets.Bloom = bloom_result.value();
+
+		auto bloom_view_result = CreateImageView( targets.Bloom.Image, VulkanPostProcess::HDR_FORMAT,
+			VK_IMAGE_ASPECT_COLOR_BIT, 0, targets.BloomMipCount );
+		if ( !bloom_view_result )
+		{
+			return std::unexpected( bloom_view_result.error() );
+		}
+		targets.Bloom.View = bloom_view_result.value();
+
+		for ( uint32 mip = 0; mip < targets.BloomMipCount; ++mip )
+		{
+			auto mip_view_result = CreateImageView( targets.Bloom.Image, VulkanPostProcess::HDR_FORMAT,
+				VK_IMAGE_ASPECT_COLOR_BIT, mip, 1 );
+			if ( !mip_view_result )
+			{
+				return std::unexpected( mip_view_result.error() );
+			}
+			targets.BloomMipViews.push_back( mip_view_result.value() );
+		}
+
+		if ( !Swapchain.StorageImages )
+		{
+			auto output_result = CreateTextureImage(
+				static_cast< int32 >( Swapchain.Extent.width ),
+				static_cast< int32 >( Swapchain.Extent.height ),
+				VulkanPostProcess::OUTPUT_FORMAT,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+			if ( !output_result )
+			{
+				return std::unexpected( output_result.error() );
+			}
+			targets.Output = output_result.value();
+
+			auto output_view_result = CreateImageView( targets.Output.Image, VulkanPostProcess::OUTPUT_FORMAT,
+				VK_IMAGE_ASPECT_COLOR_BIT );
+			if ( !output_view_result )
+			{
+				return std::unexpected( output_view_result.error() );
+			}
+			targets.Output.View = output_view_result.value();
+		}
+
+		const uint32 down_count = targets.BloomMipCount - 1;
+		const uint32 up_count = targets.BloomMipCount > 2 ? targets.BloomMipCount - 2 : 0;
+		const uint32 history_count = static_cast< uint32 >( targets.History.size() );
+		const uint32 image_count = static_cast< uint32 >( Swapchain.Images.size() );
+		const uint32 tonemap_count = history_count * image_count;
+		const uint32 bloom_count = down_count + up_count;
+
+		// per history image a temporal set of three samplers and a prefilter set of one
+		std::array<VkDescriptorPoolSize, 3> pool_sizes = {};
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_sizes[0].descriptorCount = 4 * history_count + bloom_count + 2 * tonemap_count;
+		pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		pool_sizes[1].descriptorCount = 2 * history_count + bloom_count + tonemap_count;
+		pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pool_sizes[2].descriptorCount = history_count + tonemap_count;
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.poolSizeCount = static_cast< uint32 >( pool_sizes.size() );
+		pool_info.pPoolSizes = pool_sizes.data();
+		pool_info.maxSets = 2 * history_count + bloom_count + tonemap_count;
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &targets.DescriptorPool );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
+		}
+
+		// in the order of the sets: temporal, prefilter, downsamples, upsamples, tonemaps
+		ScratchScope scratch;
+		const auto& pipelines = PostProcess.Pipelines;
+		std::pmr::vector<VkDescriptorSetLayout> layouts( scratch.GetResource() );
+		layouts.insert( layouts.end(), history_count, pipelines[VulkanPostProcess::Temporal].DescriptorSetLayout );
+		layouts.insert( layouts.end(), history_count, pipelines[VulkanPostProcess::Prefilter].DescriptorSetLayout );
+		layouts.insert( layouts.end(), down_count, pipelines[VulkanPostProcess::Downsample].DescriptorSetLayout );
+		layouts.insert( layouts.end(), up_count, pipelines[VulkanPostProcess::Upsample].DescriptorSetLayout );
+		layouts.insert( layouts.end(), tonemap_count, pipelines[VulkanPostProcess::Tonemap].DescriptorSetLayout );
+
+		VkDescriptorSetAllocateInfo allocate_info = {};
+		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocate_info.descriptorPool = targets.DescriptorPool;
+		allocate_info.descriptorSetCount = static_cast< uint32 >( layouts.size() );
+		allocate_info.pSetLayouts = layouts.data();
+
+		std::pmr::vector<VkDescriptorSet> sets( layouts.size(), VK_NULL_HANDLE, scratch.GetResource() );
+		err = vkAllocateDescriptorSets( Device, &allocate_info, sets.data() );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
+		}
+
+		auto next_set = sets.begin();
+		std::copy_n( next_set, history_count, targets.TemporalSets.begin() );
+		next_set += history_count;
+		std::copy_n( next_set, history_count, targets.PrefilterSets.begin() );
+		next_set += history_count;
+		targets.DownSets.assign( next_set, next_set + down_count );
+		next_set += down_count;
+		targets.UpSets.assign( next_set, next_set + up_count );
+		next_set += up_count;
+		targets.TonemapSets.assign( next_set, next_set + tonemap_count );
+
+		const VkDescriptorType sampled = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		const VkDescriptorType storage = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		const uint32 descriptor_copy_count = 0;
+		const VkCopyDescriptorSet* descriptor_copies = nullptr;
+
+		VkDescriptorImageInfo scene_info = {};
+		scene_info.sampler = PostProcess.Sampler;
+		scene_info.imageView = targets.HdrTarget.View;
+		scene_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkDescriptorImageInfo depth_info = {};
+		depth_info.sampler = DepthTexture.Sampler;
+		depth_info.imageView = DepthTexture.View;
+		depth_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+		// the history images are written and sampled in the general layout
+		auto history_info = [&targets, this] ( uint32 history ) {
+			VkDescriptorImageInfo info = {};
+			info.sampler = PostProcess.Sampler;
+			info.imageView = targets.History[history].View;
+			info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			return info;
+		};
+
+		VkDescriptorBufferInfo histogram_info = {};
+		histogram_info.buffer = PostProcess.Histogram.Instance;
+		histogram_info.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo exposure_info = {};
+		exposure_info.buffer = PostProcess.Exposure.Instance;
+		exposure_info.range = VK_WHOLE_SIZE;
+
+		// the bloom levels are written and sampled in the general layout
+		auto mip_info = [&targets, this] ( uint32 mip ) {
+			VkDescriptorImageInfo info = {};
+			info.sampler = PostProcess.Sampler;
+			info.imageView = targets.BloomMipViews[mip];
+			info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			return info;
+		};
+
+		for ( uint32 i = 0; i < history_count; ++i )
+		{
+			const VkDescriptorImageInfo previous_info = history_info( ( i + 1 ) % history_count );
+			const VkDescriptorImageInfo resolved_info = history_info( i );
+			const VkDescriptorImageInfo destination_info = mip_info( 0 );
+			std::array<VkWriteDescriptorSet, 7> descriptor_writes = {
+				MakeImageWrite( targets.TemporalSets[i], 0, sampled, &scene_info ),
+				MakeImageWrite( targets.TemporalSets[i], 1, sampled, &depth_info ),
+				MakeImageWrite( targets.TemporalSets[i], 2, sampled, &previous_info ),
+				MakeImageWrite( targets.TemporalSets[i], 3, storage, &resolved_info ),
+				MakeImageWrite( targets.PrefilterSets[i], 0, sampled, &resolved_info ),
+				MakeImageWrite( targets.PrefilterSets[i], 1, storage, &destination_info ),
+				MakeBufferWrite( targets.PrefilterSets[i], 2, &histogram_info )
+			};
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		for ( uint32 i = 0; i < down_count; ++i )
+		{
+			const VkDescriptorImageInfo source_info = mip_info( i );
+			const VkDescriptorImageInfo destination_info = mip_info( i + 1 );
+			std::array<VkWriteDescriptorSet, 2> descriptor_writes = {
+				MakeImageWrite( targets.DownSets[i], 0, sampled, &source_info ),
+				MakeImageWrite( targets.DownSets[i], 1, storage, &destination_info )
+			};
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		for ( uint32 i = 0; i < up_count; ++i )
+		{
+			const VkDescriptorImageInfo source_info = mip_info( i + 2 );
+			const VkDescriptorImageInfo destination_info = mip_info( i + 1 );
+			std::array<VkWriteDescriptorSet, 2> descriptor_writes = {
+				MakeImageWrite( targets.UpSets[i], 0, sampled, &source_info ),
+				MakeImageWrite( targets.UpSets[i], 1, storage, &destination_info )
+			};
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		VkDescriptorImageInfo bloom_info = {};
+		bloom_info.sampler = PostProcess.Sampler;
+		bloom_info.imageView = targets.Bloom.View;
+		bloom_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		for ( uint32 i = 0; i < tonemap_count; ++i )
+		{
+			const uint32 image = i % image_count;
+			VkDescriptorImageInfo destination_info = {};
+			destination_info.imageView = Swapchain.StorageImages ? Swapchain.ImageViews[image] :
+				targets.Output.View;
+			destination_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			const VkDescriptorImageInfo resolved_info = history_info( i / image_count );
+			std::array<VkWriteDescriptorSet, 4> descriptor_writes = {
+				MakeImageWrite( targets.TonemapSets[i], 0, sampled, &resolved_info ),
+				MakeImageWrite( targets.TonemapSets[i], 1, sampled, &bloom_info ),
+				MakeBufferWrite( targets.TonemapSets[i], 2, &exposure_info ),
+				MakeImageWrite( targets.TonemapSets[i], 3, storage, &destination_info )
+			};
+			vkUpdateDescriptorSets( Device, static_cast< uint32 >( descriptor_writes.size() ),
+				descriptor_writes.data(), descriptor_copy_count, descriptor_copies );
+		}
+
+		return targets;
+	}
+
+	void Context::UpdatePostProcess()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const float seconds = std::chrono::duration<float>( now - PostProcess.LastUpdate ).count();
+		// the first frame has no luminance to adapt from, the shader takes the measured one as it is
+		PostProcess.Adaptation = 1.0f - std::exp( -VulkanPostProcess::ADAPTATION_RATE * seconds );
+		PostProcess.LastUpdate = now;
+		++PostProcess.Frame;
+	}
+
+	// The jitter moves the frame by up to half a texel of the render extent, so that the history gathers
+	// samples from across the area of every pixel. The history itself is resolved without the jitter.
+	void Context::UpdateTemporal( UniformBufferObject& ubo )
+	{
+		const glm::mat4 view_projection = ubo.Projection * ubo.View * ubo.Model;
+		PostProcess.Reprojection = PostProcess.PreviousViewProjection * glm::inverse( view_projection );
+		PostProcess.PreviousViewProjection = view_projection;
+
+		// the sequence starts at 1, element 0 is the origin in every base
+		const uint32     phase = PostProcess.Frame % VulkanPostProcess::JITTER_PHASES + 1;
+		const glm::vec2  offset = glm::vec2( Halton( phase, 2 ), Halton( phase, 3 ) ) - 0.5f;
+		const VkExtent2D extent = DynamicResolution.RenderExtent;
+		const glm::vec2  jitter = 2.0f * offset / glm::vec2( extent.width, extent.height );
+
+		// applied in clip space, it moves the whole frame by the same amount after the perspective divide
+		ubo.Projection = glm::translate( glm::mat4( 1.0f ), glm::vec3( jitter, 0.0f ) ) * ubo.Projection;
+		PostProcess.Jitter = 0.5f * jitter;
+	}
+
+	void Context::RecordPostProcess( VkCommandBuffer command_buffer, uint32 image_index )
+	{
+		const VkDependencyFlags dependency_flags = 0;
+		const VkExtent2D        extent = Swapchain.Extent;
+		// resolved this frame, the other history image holds the last frame
+		const uint32            history = PostProcess.Frame % static_cast< uint32 >( HdrTargets.History.size() );
+		const uint32            previous = ( history + 1 ) % static_cast< uint32 >( HdrTargets.History.size() );
+
+		{
+			// the previous frame's chain is the last user of the bloom levels, the histogram, the exposure
+			// and the history it resolved
+			VkMemoryBarrier memory_barrier = {};
+			memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+			VkImageMemoryBarrier depth_barrier = MakeColorBarrier( DepthTexture.Image,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT );
+			depth_barrier.subresourceRange.aspectMask = GetDepthAspect( DepthTexture.Format );
+
+			std::array<VkImageMemoryBarrier, 5> image_barriers = {
+				MakeColorBarrier( HdrTargets.HdrTarget.Image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_ACCESS_SHADER_READ_BIT ),
+				depth_barrier,
+				MakeColorBarrier( HdrTargets.Bloom.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0,
+					VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, HdrTargets.BloomMipCount ),
+				MakeColorBarrier( HdrTargets.History[history].Image, VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT ),
+				// only the first frame after the targets were created, it does not sample the history
+				MakeColorBarrier( HdrTargets.History[previous].Image, VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT )
+			};
+			const uint32 image_barrier_count = HdrTargets.HistoryValid ? 4 : 5;
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 1, &memory_barrier, 0, nullptr, image_barrier_count, image_barriers.data() );
+		}
+
+		const uint32 first_set = 0;
+		const uint32 descriptor_set_count = 1;
+		const auto&  pipelines = PostProcess.Pipelines;
+		const float  log_luminance_range = VulkanPostProcess::MAX_LOG_LUMINANCE -
+			VulkanPostProcess::MIN_LOG_LUMINANCE;
+
+		{
+			const VulkanComputePipeline& pipeline = pipelines[VulkanPostProcess::Temporal];
+			vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Instance );
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, first_set,
+				descriptor_set_count, &HdrTargets.TemporalSets[history], 0, nullptr );
+
+			TemporalParams params = {};
+			params.Reprojection = PostProcess.Reprojection;
+			params.Jitter = PostProcess.Jitter;
+			params.OutputSize = glm::ivec2( extent.width, extent.height );
+			params.RenderSize = glm::ivec2( DynamicResolution.RenderExtent.width,
+				DynamicResolution.RenderExtent.height );
+			params.Blend = HdrTargets.HistoryValid ? VulkanPostProcess::TEMPORAL_BLEND : 1.0f;
+			vkCmdPushConstants( command_buffer, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 8;
+			Dispatch( command_buffer, extent, group_size );
+			ComputeBarrier( command_buffer );
+			HdrTargets.HistoryValid = true;
+		}
+
+		{
+			const VulkanComputePipeline& pipeline = pipelines[VulkanPostProcess::Prefilter];
+			vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Instance );
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, first_set,
+				descriptor_set_count, &HdrTargets.PrefilterSets[history], 0, nullptr );
+
+			PrefilterParams params = {};
+			params.SourceSize = glm::ivec2( extent.width, extent.height );
+			params.DestinationSize = glm::ivec2( HdrTargets.BloomExtent.width, HdrTargets.BloomExtent.height );
+			params.MinLogLuminance = VulkanPostProcess::MIN_LOG_LUMINANCE;
+			params.InverseLogLuminanceRange = 1.0f / log_luminance_range;
+			vkCmdPushConstants( command_buffer, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 16;
+			Dispatch( command_buffer, HdrTargets.BloomExtent, group_size );
+			ComputeBarrier( command_buffer );
+		}
+
+		{
+			const VulkanComputePipeline& pipeline = pipelines[VulkanPostProcess::Exposure];
+			vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Instance );
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, first_set,
+				descriptor_set_count, &PostProcess.ExposureSet, 0, nullptr );
+
+			// every texel of bloom level 0 added one sample to the histogram
+			ExposureParams params = {};
+			params.MinLogLuminance = VulkanPostProcess::MIN_LOG_LUMINANCE;
+			params.LogLuminanceRange = log_luminance_range;
+			params.Adaptation = PostProcess.Adaptation;
+			params.PixelCount = HdrTargets.BloomExtent.width * HdrTargets.BloomExtent.height;
+			vkCmdPushConstants( command_buffer, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			// one invocation per bin
+			vkCmdDispatch( command_buffer, 1, 1, 1 );
+		}
+
+		// the exposure pass runs beside the first downsample
+		const VulkanComputePipeline& down_pipeline = pipelines[VulkanPostProcess::Downsample];
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, down_pipeline.Instance );
+		for ( uint32 i = 0; i < HdrTargets.DownSets.size(); ++i )
+		{
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, down_pipeline.Layout,
+				first_set, descriptor_set_count, &HdrTargets.DownSets[i], 0, nullptr );
+
+			const VkExtent2D source = GetMipExtent( HdrTargets.BloomExtent, i );
+			const VkExtent2D destination = GetMipExtent( HdrTargets.BloomExtent, i + 1 );
+			BloomParams params = {};
+			params.SourceSize = glm::ivec2( source.width, source.height );
+			params.DestinationSize = glm::ivec2( destination.width, destination.height );
+			vkCmdPushConstants( command_buffer, down_pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 8;
+			Dispatch( command_buffer, destination, group_size );
+			ComputeBarrier( command_buffer );
+		}
+
+		// from the smallest level up, level 0 is finished by the tonemap pass
+		const VulkanComputePipeline& up_pipeline = pipelines[VulkanPostProcess::Upsample];
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, up_pipeline.Instance );
+		for ( uint32 i = static_cast< uint32 >( HdrTargets.UpSets.size() ); i-- > 0; )
+		{
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, up_pipeline.Layout,
+				first_set, descriptor_set_count, &HdrTargets.UpSets[i], 0, nullptr );
+
+			const VkExtent2D source = GetMipExtent( HdrTargets.BloomExtent, i + 2 );
+			const VkExtent2D destination = GetMipExtent( HdrTargets.BloomExtent, i + 1 );
+			BloomParams params = {};
+			params.SourceSize = glm::ivec2( source.width, source.height );
+			params.DestinationSize = glm::ivec2( destination.width, destination.height );
+			vkCmdPushConstants( command_buffer, up_pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 8;
+			Dispatch( command_buffer, destination, group_size );
+			ComputeBarrier( command_buffer );
+		}
+
+		// the swapchain image is only available from the compute and transfer stages on, the acquire
+		// semaphore is waited for there
+		const VkImage swapchain_image = Swapchain.Images[image_index];
+		const VkImage destination_image = Swapchain.StorageImages ? swapchain_image : HdrTargets.Output.Image;
+		{
+			// the exposure is read as well, without a bloom chain nothing ordered it after the exposure pass
+			VkMemoryBarrier memory_barrier = {};
+			memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			VkImageMemoryBarrier image_barrier = MakeColorBarrier( destination_image, VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT );
+
+			// the previous frame's blit read the output
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				dependency_flags, 1, &memory_barrier, 0, nullptr, 1, &image_barrier );
+		}
+
+		{
+			const VulkanComputePipeline& pipeline = pipelines[VulkanPostProcess::Tonemap];
+			vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Instance );
+			vkCmdBindDescriptorSets( command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, first_set,
+				descriptor_set_count, &HdrTargets.TonemapSets[history * Swapchain.Images.size() + image_index], 0,
+				nullptr );
+
+			TonemapParams params = {};
+			params.Size = glm::ivec2( extent.width, extent.height );
+			params.BloomStrength = VulkanPostProcess::BLOOM_STRENGTH;
+			params.Frame = PostProcess.Frame;
+			vkCmdPushConstants( command_buffer, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+				sizeof( params ), &params );
+
+			const uint32 group_size = 8;
+			Dispatch( command_buffer, extent, group_size );
+		}
+
+		// presentation waits on the render finished semaphore, no later stage has to wait for the transition
+		if ( Swapchain.StorageImages )
+		{
+			VkImageMemoryBarrier barrier = MakeColorBarrier( swapchain_image, VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_SHADER_WRITE_BIT, 0 );
+
+			vkCmdPipelineBarrier( command_buffer,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				dependency_flags, 0, nullptr, 0, nullptr, 1, &barrier );
+			return;
+		}
+
+		std::array<VkImageMemoryBarrier, 2> blit_barriers = {
+			MakeColorBarrier( HdrTargets.Output.Image, VK_IMAGE_LAYOUT_GENERAL,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT ),
+			MakeColorBarrier( swapchain_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT )
+		};
+		vkCmdPipelineBarrier( command_buffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			dependency_flags, 0, nullptr, 0, nullptr,
+			static_cast< uint32 >( blit_barriers.size() ), blit_barriers.data() );
+
+		// the same size, the blit only converts the format
+		VkImageBlit region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.srcOffsets[1] = { static_cast< int32 >( extent.width ), static_cast< int32 >( extent.height ), 1 };
+		region.dstSubresource = region.srcSubresource;
+		region.dstOffsets[1] = region.srcOffsets[1];
+
+		const uint32 region_count = 1;
+		vkCmdBlitImage( command_buffer,
+			HdrTargets.Output.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			swapchain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			region_count, &region, VK_FILTER_NEAREST );
+
+		VkImageMemoryBarrier present_barrier = MakeColorBarrier( swapchain_image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			VK_ACCESS_TRANSFER_WRITE_BIT, 0 );
+		vkCmdPipelineBarrier( command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			dependency_flags, 0, nullptr, 0, nullptr, 1, &present_barrier );
+	}
+
+} // namespace VulkanRHI
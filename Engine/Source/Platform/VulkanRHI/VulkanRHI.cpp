@@ -1,9 +1,11 @@
 #include "VulkanRHI.h"
 
-#include <set>
+#include <cmath>
 #include <chrono>
+#include <future>
 #include <stdexcept>
 #include <expected>
+#include <iterator>
 #include <algorithm>
 
 #include <SDL3/SDL_vulkan.h>
@@ -36,6 +38,7 @@ namespace VulkanRHI
 		Device = VK_NULL_HANDLE;
 		GraphicsQueue = VK_NULL_HANDLE;
 		PresentQueue = VK_NULL_HANDLE;
+		ComputeQueue = VK_NULL_HANDLE;
 		CommandPool = VK_NULL_HANDLE;
 	}
 
@@ -44,12 +47,46 @@ namespace VulkanRHI
 		Cleanup();
 	}
 
+	// Startup is a small dependency graph. Work that does not need the device (reading and reflecting
+	// shaders, decoding the texture, reading the pipeline cache, building the scene) runs on workers while
+	// the instance, device and swapchain come up, and the pipelines compile on workers while the buffers
+	// and textures are uploaded. Results are joined where they are first needed.
 	void Context::Init()
 	{
+		const auto init_start = std::chrono::steady_clock::now();
+		Memory::SetBudget( MemoryTag::Vulkan, VULKAN_HOST_MEMORY_BUDGET );
+		Memory::SetBudget( MemoryTag::Frame, FRAME_MEMORY_BUDGET );
+		ShadersPath = std::filesystem::current_path().parent_path() / "Engine" / "Shaders";
+
+		auto read_shader = [this] ( const char* source_name ) {
+			return std::async( std::launch::async, [this, source_name] { return ReadShader( source_name ); } );
+		};
+		auto vertex_future = read_shader( "triangle.vert" );
+		auto fragment_future = read_shader( "triangle.frag" );
+		auto hiz_future = read_shader( "hiz.comp" );
+		auto cull_future = read_shader( "cull.comp" );
+		auto clusters_future = read_shader( "clusters.comp" );
+		auto shadow_future = read_shader( "shadow.vert" );
+		std::array<std::future<Expected<VulkanShader>>, VulkanPostProcess::StageCount> post_futures;
+		for ( uint32 stage = 0; stage < VulkanPostProcess::StageCount; ++stage )
+		{
+			post_futures[stage] = read_shader( VulkanPostProcess::SHADERS[stage] );
+		}
+
+		const auto texture_path = Application::ExecutablePath()
+			.parent_path().parent_path().parent_path().parent_path().parent_path() / "Assets" / "brick.jpg";
+		auto image_future = std::async( std::launch::async, [texture_path] {
+			return DecodeImage( texture_path );
+		} );
+		auto cache_data_future = std::async( std::launch::async, [this] {
+			return GetShaderSource( GetPipelineCachePath() );
+		} );
+		auto scene_future = std::async( std::launch::async, [this] { BuildScene(); } );
+
 		auto instance_result = CreateInstance();
 		if ( !instance_result )
 		{
-			LOG_ERROR( instance_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", instance_result.error() );
 			throw std::runtime_error( "Instance == VK_NULL_HANDLE" );
 		}
 		Instance = std::move( instance_result.value() );
@@ -58,7 +95,7 @@ namespace VulkanRHI
 		auto surface_result = CreateSurface();
 		if ( !surface_result )
 		{
-			LOG_ERROR( surface_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", surface_result.error() );
 			throw std::runtime_error( "Surface == VK_NULL_HANDLE" );
 		}
 		Surface = std::move( surface_result.value() );
@@ -67,31 +104,50 @@ namespace VulkanRHI
 		auto physical_device_result = SelectPhysicalDevice();
 		if ( !physical_device_result )
 		{
-			LOG_ERROR( physical_device_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", physical_device_result.error() );
 			throw std::runtime_error( "PhysicalDevice == VK_NULL_HANDLE" );
 		}
-		Gpu = std::move( physical_device_result.value() );
-		LOG_INFO( "[Vulkan] Selected GPU." );
-
-		auto indices_result = FindQueueFamilies( Gpu, Surface );
-		if ( !indices_result )
-		{
-			LOG_ERROR( indices_result.error() );
-			throw std::runtime_error( "queue families invalid" );
-		}
-		VulkanQueueFamilyIndices indices = std::move( indices_result.value() );
-		LOG_INFO( "[Vulkan] Queue family indices are: GRAPHICS = {}, PRESENT = {}.", indices.Graphics.value(),
-			indices.Present.value() );
+		Gpu = physical_device_result.value().Gpu;
+		Capabilities = physical_device_result.value().Capabilities;
+		VulkanQueueFamilyIndices indices = physical_device_result.value().Queues;
+		LOG_INFO( "[Vulkan] Selected GPU {}.", Capabilities.Properties.deviceName );
+		LOG_INFO( "[Vulkan] Queue family indices are: GRAPHICS = {}, PRESENT = {}, COMPUTE = {}, TRANSFER = {}.",
+			indices.Graphics.value(), indices.Present.value(), indices.Compute.value_or( UINT32_MAX ),
+			indices.Transfer.value_or( UINT32_MAX ) );
 
 		auto device_result = CreateDevice( indices );
 		if ( !device_result )
 		{
-			LOG_ERROR( device_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", device_result.error() );
 			throw std::runtime_error( "Device == VK_NULL_HANDLE" );
 		}
 		Device = std::move( device_result.value() );
 		LOG_INFO( "[Vulkan] Created Device." );
 
+		if ( DynamicRendering && !LoadDeviceFunctions() )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Dynamic rendering entry points are missing." );
+			DynamicRendering = false;
+		}
+		LOG_INFO( "[Vulkan] Rendering with {}.", DynamicRendering ? "dynamic rendering" : "render passes" );
+
+		auto pipeline_cache_result = CreatePipelineCache( cache_data_future.get() );
+		if ( !pipeline_cache_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", pipeline_cache_result.error() );
+			throw std::runtime_error( "PipelineCache == VK_NULL_HANDLE" );
+		}
+		PipelineCache = pipeline_cache_result.value();
+
+		PublishedCapabilities.DeviceName = Capabilities.Properties.deviceName;
+		PublishedCapabilities.DeviceLocalMemory = Capabilities.DeviceLocalMemory;
+		PublishedCapabilities.DedicatedCompute = indices.Compute.has_value();
+		PublishedCapabilities.DedicatedTransfer = indices.Transfer.has_value();
+		PublishedCapabilities.DynamicRendering = DynamicRendering;
+		PublishedCapabilities.MultiDrawIndirect = MultiDrawIndirect;
+		PublishedCapabilities.OcclusionCulling = OcclusionCulling;
+		PublishedCapabilities.MemoryBudget = MemoryBudget;
+
 		GraphicsQueue = GetQueue( indices.Graphics.value(), 0 );
 		if ( GraphicsQueue == VK_NULL_HANDLE )
 		{
@@ -104,10 +160,24 @@ namespace VulkanRHI
 			throw std::runtime_error( "PresentQueue == VK_NULL_HANDLE" );
 		}
 
+		const bool async_compute = ContextInfo.AllowAsyncCompute && indices.Compute.has_value();
+		const uint32 compute_family = async_compute ? indices.Compute.value() : indices.Graphics.value();
+		ComputeQueue = GetQueue( compute_family, 0 );
+		if ( ComputeQueue == VK_NULL_HANDLE )
+		{
+			throw std::runtime_error( "ComputeQueue == VK_NULL_HANDLE" );
+		}
+		if ( async_compute )
+		{
+			SharedQueueFamilies = { indices.Graphics.value(), compute_family };
+		}
+		PublishedCapabilities.AsyncCompute = async_compute;
+		LOG_INFO( "[Vulkan] Compute passes run on the {} queue.", async_compute ? "async compute" : "graphics" );
+
 		auto swapchain_result = CreateSwapchain();
 		if ( !swapchain_result )
 		{
-			LOG_ERROR( swapchain_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", swapchain_result.error() );
 			throw std::runtime_error( "Swapchain == VK_NULL_HANDLE || SwapchainImages.size == 0" );
 		}
 		Swapchain = std::move( swapchain_result.value() );
@@ -116,76 +186,125 @@ namespace VulkanRHI
 		auto image_views_result = CreateImageViews();
 		if ( !image_views_result )
 		{
-			LOG_ERROR( image_views_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", image_views_result.error() );
 			throw std::runtime_error( "ImageViews == null" );
 		}
 		Swapchain.ImageViews = std::move( image_views_result.value() );
 		LOG_INFO( "[Vulkan] Created Image Views" );
 
-		auto shaders_path = std::filesystem::current_path().parent_path() / "Engine" / "Shaders";
-		auto vertex_shader = GetShaderSource( shaders_path / "triangle.vert.spv" );
-		auto fragment_shader = GetShaderSource( shaders_path / "triangle.frag.spv" );
-
-		auto vertex_module_result = CreateShaderModule( vertex_shader );
-		if ( !vertex_module_result )
-		{
-			LOG_ERROR( vertex_module_result.error() );
-			throw std::runtime_error( "vertex == VK_NULL_HANDLE" );
-		}
-		VkShaderModule vertex = std::move( vertex_module_result.value() );
-		LOG_INFO( "[Vulkan] Vertex shader loaded." );
-
-		auto fragment_module_result = CreateShaderModule( fragment_shader );
-		if ( !fragment_module_result )
-		{
-			LOG_ERROR( fragment_module_result.error() );
-			throw std::runtime_error( "fragment == VK_NULL_HANDLE" );
-		}
-		VkShaderModule fragment = std::move( fragment_module_result.value() );
-		LOG_INFO( "[Vulkan] Fragment shader loaded." );
-
-		auto graphics_pipeline_result = CreateGraphicsPipeline( vertex, fragment );
-		if ( !graphics_pipeline_result )
-		{
-			LOG_ERROR( graphics_pipeline_result.error() );
-			throw std::runtime_error( "GraphicsPipeline == VK_NULL_HANDLE" );
+		auto finish_shader = [this] ( std::future<Expected<VulkanShader>>& future ) {
+			Expected<VulkanShader> shader_result = future.get();
+			if ( shader_result )
+			{
+				auto module_result = CreateShaderModule( shader_result.value() );
+				if ( !module_result )
+				{
+					shader_result = std::unexpected( module_result.error() );
+				}
+			}
+			if ( !shader_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", shader_result.error() );
+				throw std::runtime_error( "shader == VK_NULL_HANDLE" );
+			}
+			return std::move( shader_result.value() );
+		};
+		VulkanShader vertex = finish_shader( vertex_future );
+		VulkanShader fragment = finish_shader( fragment_future );
+		LOG_INFO( "[Vulkan] Shaders loaded." );
+
+		// the futures join in their destructors, so the shaders outlive the workers even when Init throws
+		auto graphics_pipeline_future = std::async( std::launch::async, [this, &vertex, &fragment] {
+			return CreateGraphicsPipeline( vertex, fragment );
+		} );
+
+		VulkanShader clusters_shader = finish_shader( clusters_future );
+		auto clusters_pipeline_future = std::async( std::launch::async, [this, &clusters_shader] {
+			return CreateComputePipeline( clusters_shader );
+		} );
+
+		VulkanShader shadow_shader = finish_shader( shadow_future );
+		auto shadow_pipeline_future = std::async( std::launch::async, [this, &shadow_shader] {
+			return CreateShadowPipeline( shadow_shader );
+		} );
+
+		std::array<VulkanShader, VulkanPostProcess::StageCount> post_shaders;
+		std::array<std::future<Expected<VulkanComputePipeline>>, VulkanPostProcess::StageCount>
+			post_pipeline_futures;
+		for ( uint32 stage = 0; stage < VulkanPostProcess::StageCount; ++stage )
+		{
+			post_shaders[stage] = finish_shader( post_futures[stage] );
+			post_pipeline_futures[stage] = std::async( std::launch::async, [this, &post_shaders, stage] {
+				return CreateComputePipeline( post_shaders[stage] );
+			} );
+		}
+
+		VulkanShader hiz_shader;
+		VulkanShader cull_shader;
+		std::future<Expected<VulkanComputePipeline>> hiz_pipeline_future;
+		std::future<Expected<VulkanComputePipeline>> cull_pipeline_future;
+		if ( OcclusionCulling )
+		{
+			hiz_shader = finish_shader( hiz_future );
+			cull_shader = finish_shader( cull_future );
+			hiz_pipeline_future = std::async( std::launch::async, [this, &hiz_shader] {
+				return CreateComputePipeline( hiz_shader );
+			} );
+			cull_pipeline_future = std::async( std::launch::async, [this, &cull_shader] {
+				return CreateComputePipeline( cull_shader );
+			} );
 		}
-		GraphicsPipeline = std::move( graphics_pipeline_result.value() );
-		LOG_INFO( "[Vulkan] Created Graphics Pipeline." );
-
-		vkDestroyShaderModule( Device, vertex, nullptr );
-		vkDestroyShaderModule( Device, fragment, nullptr );
 
 		auto command_pool_result = CreateCommandPool( indices );
 		if ( !command_pool_result )
 		{
-			LOG_ERROR( command_pool_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", command_pool_result.error() );
 			throw std::runtime_error( "CommandPool == VK_NULL_HANDLE" );
 		}
 		CommandPool = std::move( command_pool_result.value() );
 		LOG_INFO( "[Vulkan] Created Command Pool." );
 
-		auto cmd_buffers_result = CreateCommandBuffers();
-		if ( !cmd_buffers_result )
+		const VulkanSchedulerQueue graphics_queue = { GraphicsQueue, indices.Graphics.value() };
+		const VulkanSchedulerQueue compute_queue = { ComputeQueue, compute_family };
+		auto scheduler_result = Scheduler.Init( Device, graphics_queue, compute_queue, MAX_FRAMES_IN_FLIGHT,
+			Allocator );
+		if ( !scheduler_result )
 		{
-			LOG_ERROR( cmd_buffers_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", scheduler_result.error() );
 			throw std::runtime_error( "CommandBuffer == VK_NULL_HANDLE" );
 		}
-		CommandBuffers = std::move( cmd_buffers_result.value() );
 
 		auto sync_objects_result = CreateSyncObjects();
 		if ( !sync_objects_result )
 		{
-			LOG_ERROR( sync_objects_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", sync_objects_result.error() );
 			throw std::runtime_error( "synchronization objects are invalid" );
 		}
 		SyncObjects = std::move( sync_objects_result.value() );
+		InputSampleTimes.resize( SyncObjects.size() );
+		FrameSubmissions.resize( SyncObjects.size() );
 		LOG_INFO( "[Vulkan] Created Synchronization objects." );
 
-		auto texture_result = CreateTexture();
+		auto deletion_queue_result = DeletionQueue.Init( Device, TimelineSemaphore, Allocator );
+		if ( !deletion_queue_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", deletion_queue_result.error() );
+			throw std::runtime_error( "timeline semaphore == VK_NULL_HANDLE" );
+		}
+		LOG_INFO( "[Vulkan] Resources are retired against {}.",
+			TimelineSemaphore ? "a timeline semaphore" : "frame fences" );
+
+		auto image_result = image_future.get();
+		if ( !image_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", image_result.error() );
+			throw std::runtime_error( "texture image == VK_NULL_HANDLE" );
+		}
+
+		auto texture_result = CreateTexture( image_result.value() );
 		if ( !texture_result )
 		{
-			LOG_ERROR( texture_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", texture_result.error() );
 			throw std::runtime_error( "texture image == VK_NULL_HANDLE" );
 		}
 		Texture = std::move( texture_result.value() );
@@ -194,25 +313,18 @@ namespace VulkanRHI
 		auto depth_texture_result = CreateDepthTexture();
 		if ( !depth_texture_result )
 		{
-			LOG_ERROR( depth_texture_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", depth_texture_result.error() );
 			throw std::runtime_error( "depth texture == null" );
 		}
 		DepthTexture = std::move( depth_texture_result.value() );
 		LOG_INFO( "[Vulkan] Created depth texture." );
 
-		auto framebuffers_result = CreateFramebuffers();
-		if ( !framebuffers_result )
-		{
-			LOG_ERROR( framebuffers_result.error() );
-			throw std::runtime_error( "Framebuffers == VK_NULL_HANDLE" );
-		}
-		Swapchain.Framebuffers = std::move( framebuffers_result.value() );
-		LOG_INFO( "[Vulkan] Created Vulkan Framebuffers" );
-
+		// the shared buffers hold the geometry of the scene and its levels of detail
+		scene_future.get();
 		auto vertex_buffer_result = CreateVertexBuffer();
 		if ( !vertex_buffer_result )
 		{
-			LOG_ERROR( vertex_buffer_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", vertex_buffer_result.error() );
 			throw std::runtime_error( "VertexBuffer == VK_NULL_HANDLE || VertexBufferMemory == VK_NULL_HANDLE" );
 		}
 		VertexBuffer = std::move( vertex_buffer_result.value() );
@@ -221,64 +333,278 @@ namespace VulkanRHI
 		auto index_buffer_result = CreateIndexBuffer();
 		if ( !index_buffer_result )
 		{
-			LOG_ERROR( index_buffer_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", index_buffer_result.error() );
 			throw std::runtime_error( "IndexBuffer == VK_NULL_HANDLE || IndexBufferMemory == VK_NULL_HANDLE" );
 		}
 		IndexBuffer = std::move( index_buffer_result.value() );
 		LOG_INFO( "[Vulkan] Created Index Buffer." );
+		SceneVertices = {};
+		SceneIndices = {};
+
+		auto uniform_ring_result = CreateFrameRing( sizeof( UniformBufferObject ), MAX_DRAWS_PER_FRAME,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, Capabilities.Properties.limits.minUniformBufferOffsetAlignment );
+		if ( !uniform_ring_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", uniform_ring_result.error() );
+			throw std::runtime_error( "UniformRing == VK_NULL_HANDLE" );
+		}
+		UniformRing = std::move( uniform_ring_result.value() );
+		LOG_INFO( "[Vulkan] Created Uniform Ring." );
 
-		auto uniform_buffers_result = CreateUniformBuffers();
-		if ( !uniform_buffers_result )
+		auto instance_ring_result = CreateFrameRing( sizeof( InstanceData ), MAX_INSTANCES_PER_FRAME,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof( InstanceData ) );
+		if ( !instance_ring_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", instance_ring_result.error() );
+			throw std::runtime_error( "InstanceRing == VK_NULL_HANDLE" );
+		}
+		InstanceRing = std::move( instance_ring_result.value() );
+		LOG_INFO( "[Vulkan] Created Instance Ring." );
+
+		auto graphics_pipeline_result = graphics_pipeline_future.get();
+		if ( !graphics_pipeline_result )
 		{
-			LOG_ERROR( uniform_buffers_result.error() );
-			throw std::runtime_error( "UniformBuffers == VK_NULL_HANDLE" );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", graphics_pipeline_result.error() );
+			throw std::runtime_error( "GraphicsPipeline == VK_NULL_HANDLE" );
 		}
-		UniformBuffers = std::move( uniform_buffers_result.value() );
-		LOG_INFO( "[Vulkan] Created Uniform Buffers." );
+		GraphicsPipeline = std::move( graphics_pipeline_result.value() );
+		LOG_INFO( "[Vulkan] Created Graphics Pipeline." );
+
+		vertex.Destroy( Device, Allocator );
+		fragment.Destroy( Device, Allocator );
+
+		std::array<VulkanComputePipeline, VulkanPostProcess::StageCount> post_pipelines;
+		for ( uint32 stage = 0; stage < VulkanPostProcess::StageCount; ++stage )
+		{
+			auto post_pipeline_result = post_pipeline_futures[stage].get();
+			post_shaders[stage].Destroy( Device, Allocator );
+			if ( !post_pipeline_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", post_pipeline_result.error() );
+				throw std::runtime_error( "ComputePipeline == VK_NULL_HANDLE" );
+			}
+			post_pipelines[stage] = post_pipeline_result.value();
+		}
+
+		auto post_process_result = CreatePostProcess( post_pipelines );
+		if ( !post_process_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", post_process_result.error() );
+			throw std::runtime_error( "PostProcess == VK_NULL_HANDLE" );
+		}
+		PostProcess = std::move( post_process_result.value() );
+		LOG_INFO( "[Vulkan] Created Post process." );
+
+		// the scene framebuffer attaches the HDR target and the depth texture
+		auto hdr_targets_result = CreateHdrTargets();
+		if ( !hdr_targets_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", hdr_targets_result.error() );
+			throw std::runtime_error( "HdrTargets == VK_NULL_HANDLE" );
+		}
+		HdrTargets = std::move( hdr_targets_result.value() );
+		LOG_INFO( "[Vulkan] Created HDR targets." );
+
+		auto dynamic_resolution_result = CreateDynamicResolution();
+		if ( !dynamic_resolution_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", dynamic_resolution_result.error() );
+			throw std::runtime_error( "DynamicResolution == VK_NULL_HANDLE" );
+		}
+		DynamicResolution = std::move( dynamic_resolution_result.value() );
+		PublishedCapabilities.DynamicResolution = DynamicResolution.QueryPool != VK_NULL_HANDLE;
+		LOG_INFO( "[Vulkan] Created Dynamic resolution." );
+
+		// the scene's descriptor sets read the cluster buffers
+		auto clusters_pipeline_result = clusters_pipeline_future.get();
+		clusters_shader.Destroy( Device, Allocator );
+		if ( !clusters_pipeline_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", clusters_pipeline_result.error() );
+			throw std::runtime_error( "ComputePipeline == VK_NULL_HANDLE" );
+		}
+
+		auto light_clusters_result = CreateLightClusters( clusters_pipeline_result.value() );
+		if ( !light_clusters_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", light_clusters_result.error() );
+			throw std::runtime_error( "LightClusters == VK_NULL_HANDLE" );
+		}
+		LightClusters = std::move( light_clusters_result.value() );
+		LOG_INFO( "[Vulkan] Created Light clusters." );
+
+		auto shadow_pipeline_result = shadow_pipeline_future.get();
+		shadow_shader.Destroy( Device, Allocator );
+		if ( !shadow_pipeline_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", shadow_pipeline_result.error() );
+			throw std::runtime_error( "ShadowPipeline == VK_NULL_HANDLE" );
+		}
+
+		auto shadow_maps_result = CreateShadowMaps( shadow_pipeline_result.value() );
+		if ( !shadow_maps_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", shadow_maps_result.error() );
+			throw std::runtime_error( "ShadowMaps == VK_NULL_HANDLE" );
+		}
+		ShadowMaps = std::move( shadow_maps_result.value() );
+		LOG_INFO( "[Vulkan] Created Shadow maps." );
 
 		auto descriptor_group_result = CreateDescriptorGroup();
 		if ( !descriptor_group_result )
 		{
-			LOG_ERROR( descriptor_group_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", descriptor_group_result.error() );
 			throw std::runtime_error( "DescriptorPool == VK_NULL_HANDLE" );
 		}
 		DescriptorGroup = std::move( descriptor_group_result.value() );
 		LOG_INFO( "[Vulkan] Created Descriptor group." );
+
+		if ( OcclusionCulling )
+		{
+			auto hiz_pipeline_result = hiz_pipeline_future.get();
+			auto cull_pipeline_result = cull_pipeline_future.get();
+			hiz_shader.Destroy( Device, Allocator );
+			cull_shader.Destroy( Device, Allocator );
+			if ( !hiz_pipeline_result || !cull_pipeline_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}",
+					!hiz_pipeline_result ? hiz_pipeline_result.error() : cull_pipeline_result.error() );
+				throw std::runtime_error( "ComputePipeline == VK_NULL_HANDLE" );
+			}
+
+			auto culler_result = CreateOcclusionCuller( hiz_pipeline_result.value(), cull_pipeline_result.value() );
+			if ( !culler_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", culler_result.error() );
+				throw std::runtime_error( "OcclusionCuller == VK_NULL_HANDLE" );
+			}
+			Culler = std::move( culler_result.value() );
+
+			auto pyramid_result = CreateHiZPyramid();
+			if ( !pyramid_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", pyramid_result.error() );
+				throw std::runtime_error( "HiZPyramid == VK_NULL_HANDLE" );
+			}
+			HiZPyramid = std::move( pyramid_result.value() );
+			for ( uint32 frame = 0; frame < Culler.CullSets.size(); ++frame )
+			{
+				UpdateOcclusionDescriptors( frame );
+			}
+			LOG_INFO( "[Vulkan] Created Occlusion culling resources." );
+		}
+		else
+		{
+			LOG_INFO( "[Vulkan] Occlusion culling is not supported by the GPU, drawing without it." );
+		}
+
+		DrawBatches.reserve( MAX_DRAWS_PER_FRAME );
+		FrameLights.reserve( MAX_LIGHTS );
+		Queue.Reserve( MAX_INSTANCES_PER_FRAME );
+
+		InitShaderReload();
+
+		UpdateMemoryUsage();
+		for ( uint32 i = 0; i < HeapUsage.size(); ++i )
+		{
+			const VulkanHeapUsage& heap = HeapUsage[i];
+			LOG_INFO( "[Vulkan] Heap {}: {} MiB{}, budget {} MiB, {} MiB in use.", i, heap.Size >> 20,
+				heap.DeviceLocal ? " device local" : "", heap.Budget >> 20, heap.Usage >> 20 );
+		}
+
+		const std::chrono::duration<float, std::milli> init_time = std::chrono::steady_clock::now() - init_start;
+		LOG_INFO( "[Vulkan] Init finished in {:.1f} ms.", init_time.count() );
 	}
 
-	void Context::Cleanup()
+	// runs on a startup worker, nothing else touches the scene before Init joins it
+	void Context::BuildScene()
 	{
-		const VkAllocationCallbacks* alloc = nullptr;
+		VulkanRenderObject quads = {};
+		quads.Mesh = AddMesh( VERTICES, INDICES );
+		Objects.push_back( quads );
 
-		vkDeviceWaitIdle( Device );
+		std::vector<AABB> object_bounds;
+		object_bounds.reserve( Objects.size() );
+		for ( const VulkanRenderObject& object : Objects )
+		{
+			const Bounds bounds = Meshes[object.Mesh].LocalBounds.Transform( object.Transform );
+			object_bounds.push_back( { bounds.Min, bounds.Max } );
+		}
+		SceneTree.Build( object_bounds );
+		SceneTree.Flatten();
 
-		DepthTexture.Destroy( Device );
-		Swapchain.Destroy( Device );
+		BuildLights();
+	}
 
-		Texture.Destroy( Device );
+	void Context::Cleanup()
+	{
+		const VkAllocationCallbacks* alloc = Allocator;
 
-		vkDestroyDescriptorPool( Device, DescriptorGroup.Pool, alloc );
+		Memory::Report();
+		ShaderWatcher.Stop();
+		Compiler.reset();
 
-		for ( auto& uniform_buf : UniformBuffers )
+		// every submission signals the timeline or a frame fence, presentation is the only work neither covers
+		auto wait_result = DeletionQueue.Wait( Device, DeletionQueue.GetSubmittedValue() );
+		if ( !wait_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", wait_result.error() );
+		}
+		if ( !TimelineSemaphore )
 		{
-			uniform_buf.Destroy( Device );
+			std::vector<VkFence> fences;
+			for ( const VulkanSyncObjects& sync_objects : SyncObjects )
+			{
+				fences.push_back( sync_objects.InFlightFence );
+			}
+			const VkBool32 wait_all = true;
+			const uint64   timeout = UINT64_MAX;
+			vkWaitForFences( Device, static_cast< uint32 >( fences.size() ), fences.data(), wait_all, timeout );
 		}
+		vkQueueWaitIdle( PresentQueue );
+
+		SavePipelineCache();
+		vkDestroyPipelineCache( Device, PipelineCache, alloc );
 
-		IndexBuffer.Destroy( Device );
-		VertexBuffer.Destroy( Device );
+		DeletionQueue.Destroy( Device, Allocator );
 
-		GraphicsPipeline.Destroy( Device );
+		DynamicResolution.Destroy( Device, Allocator );
+		HdrTargets.Destroy( Device, Allocator );
+		PostProcess.Destroy( Device, Allocator );
+		HiZPyramid.Destroy( Device, Allocator );
+		Culler.Destroy( Device, Allocator );
+		LightClusters.Destroy( Device, Allocator );
+		ShadowMaps.Destroy( Device, Allocator );
+
+		DepthTexture.Destroy( Device, Allocator );
+		Swapchain.Destroy( Device, Allocator );
+
+		Texture.Destroy( Device, Allocator );
+
+		vkDestroyDescriptorPool( Device, DescriptorGroup.Pool, alloc );
+
+		InstanceRing.Destroy( Device, Allocator );
+		UniformRing.Destroy( Device, Allocator );
+
+		IndexBuffer.Destroy( Device, Allocator );
+		VertexBuffer.Destroy( Device, Allocator );
+
+		GraphicsPipeline.Destroy( Device, Allocator );
+		LayoutCache.Destroy( Device, Allocator );
 
 		for ( auto& obj : SyncObjects )
 		{
-			obj.Destroy( Device );
+			obj.Destroy( Device, Allocator );
 		}
 
+		Scheduler.Destroy( Device, Allocator );
 		vkDestroyCommandPool( Device, CommandPool, alloc );
 
 		vkDestroyDevice( Device, alloc );
 		vkDestroySurfaceKHR( Instance, Surface, alloc );
 		vkDestroyInstance( Instance, alloc );
+
+		ErrorTelemetry::Dump();
 	}
 
 	void Context::DrawFrame()
@@ -286,14 +612,69 @@ namespace VulkanRHI
 		VkResult err;
 
 		const auto& [image_available, render_finished, in_flight] = SyncObjects[CurrentFrame];
+		FrameMemory.BeginFrame();
 
-		const uint32   fence_count = 1;
+		std::pmr::vector<VkFence> in_flight_fences( FrameMemory.GetResource() );
+		in_flight_fences.reserve( SyncObjects.size() );
+		uint32 queued_frames = 0;
+		for ( const VulkanSyncObjects& sync_objects : SyncObjects )
+		{
+			in_flight_fences.push_back( sync_objects.InFlightFence );
+			queued_frames += vkGetFenceStatus( Device, sync_objects.InFlightFence ) == VK_NOT_READY ? 1 : 0;
+		}
+
+		// low latency waits for every earlier frame, so the frame about to sample input is the only one queued
+		const uint32   fence_count = PresentConfig.LowLatency ? static_cast< uint32 >( in_flight_fences.size() ) : 1;
+		const VkFence* fences = PresentConfig.LowLatency ? in_flight_fences.data() : &in_flight;
 		const VkBool32 wait_all = true;
 		const uint64   timeout = UINT64_MAX;
-		err = vkWaitForFences( Device, fence_count, &in_flight, wait_all, timeout );
+		err = vkWaitForFences( Device, fence_count, fences, wait_all, timeout );
 		if ( err != VK_SUCCESS )
 		{
-			LOG_ERROR( "[Vulkan] Error from vkWaitForFences: {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::WaitForFences, err ) );
+		}
+
+		// the newest frame known to be complete, measured when the CPU sees it and not when it is scanned out
+		const uint32 completed_frame = PresentConfig.LowLatency ?
+			( CurrentFrame + MAX_FRAMES_IN_FLIGHT - 1 ) % MAX_FRAMES_IN_FLIGHT : CurrentFrame;
+		const auto completed_sample = InputSampleTimes[completed_frame];
+		if ( completed_sample != std::chrono::steady_clock::time_point{} )
+		{
+			const std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() -
+				completed_sample;
+			InputLatencyMs = latency.count();
+			InputSampleTimes[completed_frame] = {};
+		}
+
+		// the fence also covers every submission made on the graphics queue before the frame
+		DeletionQueue.MarkCompleted( FrameSubmissions[CurrentFrame] );
+		DeletionQueue.Collect( Device, Allocator );
+		UpdateShaderReload();
+		UpdateDebugView();
+
+		// any number of resize events since the last frame end up as one recreation at the final size
+		if ( ResizePending )
+		{
+			const VkExtent2D window_extent = GetWindowExtent();
+			SwapchainDirty |= window_extent.width != Swapchain.Extent.width ||
+				window_extent.height != Swapchain.Extent.height;
+			ResizePending = false;
+		}
+
+		if ( SwapchainDirty )
+		{
+			// minimized, there is nothing to present to until the window is restored
+			const VkExtent2D window_extent = GetWindowExtent();
+			if ( window_extent.width == 0 || window_extent.height == 0 )
+			{
+				return;
+			}
+			RecreateSwapchain();
+		}
+
+		if ( OcclusionCulling )
+		{
+			UpdateOcclusionDescriptors( CurrentFrame );
 		}
 
 		uint32  image_index;
@@ -301,50 +682,66 @@ namespace VulkanRHI
 		err = vkAcquireNextImageKHR( Device, Swapchain.Instance, timeout, image_available, FENCE, &image_index );
 		if ( err == VK_ERROR_OUT_OF_DATE_KHR )
 		{
-			RecreateSwapchain();
+			SwapchainDirty = true;
 			return;
 		}
 		else if ( err != VK_SUCCESS && err != VK_SUBOPTIMAL_KHR )
 		{
-			LOG_ERROR( "[Vulkan] Error from vkAcquireNextImageKHR: {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::AcquireNextImage, err ) );
 		}
 
+		InputSampleTimes[CurrentFrame] = std::chrono::steady_clock::now();
+		UpdateDynamicResolution( CurrentFrame );
 		UpdateUniformBuffer( CurrentFrame );
+		UpdatePostProcess();
 
-		err = vkResetFences( Device, fence_count, &in_flight );
+		err = vkResetFences( Device, 1, &in_flight );
 		if ( err != VK_SUCCESS )
 		{
-			LOG_ERROR( "[Vulkan] Error from vkResetFences: {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::ResetFences, err ) );
 		}
 
-		err = vkResetCommandBuffer( CommandBuffers[CurrentFrame], 0 );
-		if ( err != VK_SUCCESS )
+		auto begin_result = Scheduler.BeginFrame( Device, CurrentFrame );
+		if ( !begin_result )
 		{
-			LOG_ERROR( "[Vulkan] Error from vkResetCommandBuffer: {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", begin_result.error() );
 		}
-		RecordCommandBuffer( image_index );
-
-		VkSubmitInfo submit_info = {};
-		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SchedulePasses( image_index );
 
-		std::array<VkSemaphore, 1> wait_semaphores = { image_available };
-		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submit_info.waitSemaphoreCount = static_cast<uint32>( wait_semaphores.size() );
-		submit_info.pWaitSemaphores = wait_semaphores.data();
-		submit_info.pWaitDstStageMask = wait_stages;
-		submit_info.commandBufferCount = 1;
-		submit_info.pCommandBuffers = &CommandBuffers[CurrentFrame];
-
-		std::array<VkSemaphore, 1> signal_semaphores = { render_finished };
-		submit_info.signalSemaphoreCount = static_cast<uint32>( signal_semaphores.size() );
-		submit_info.pSignalSemaphores = signal_semaphores.data();
-
-		const uint32 submit_count = 1;
-		err = vkQueueSubmit( GraphicsQueue, submit_count, &submit_info, in_flight );
-		if ( err != VK_SUCCESS )
+		VulkanFrameSubmit frame_submit = {};
+		frame_submit.WaitSemaphore = image_available;
+		// the tonemap pass writes the swapchain image, or the blit of its output does
+		frame_submit.WaitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		frame_submit.SignalSemaphore = render_finished;
+		frame_submit.Fence = in_flight;
+		frame_submit.Timeline = DeletionQueue.GetTimeline();
+		frame_submit.TimelineWait = UploadValue > DeletionQueue.GetCompletedValue() ? UploadValue : 0;
+		frame_submit.TimelineSignal = DeletionQueue.Advance();
+		auto submit_result = Scheduler.Submit( Device, frame_submit );
+		if ( !submit_result )
 		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", submit_result.error() );
 			throw std::runtime_error( "failed to submit draw command buffer!" );
 		}
+		FrameSubmissions[CurrentFrame] = frame_submit.TimelineSignal;
+		if ( ++SubmittedFrames % MEMORY_CHECK_INTERVAL == 0 )
+		{
+			UpdateMemoryUsage();
+		}
+		Stats.InputLatencyMs = InputLatencyMs;
+		Stats.QueuedFrames = queued_frames;
+		Stats.QueueSubmits = Scheduler.GetSubmitCount();
+		Stats.TimeToFirstFrameMs = TimeToFirstFrameMs;
+		Stats.FrameMemoryBytes = static_cast< uint32 >( FrameMemory.GetUsed() );
+		Stats.DeviceMemoryUsageMiB = static_cast< uint32 >( DeviceMemoryUsage >> 20 );
+		Stats.DeviceMemoryBudgetMiB = static_cast< uint32 >( DeviceMemoryBudget >> 20 );
+		Stats.Lights = LightClusters.LightCount;
+		Stats.ShadowViews = static_cast< uint32 >( ShadowMaps.Passes.size() );
+		Stats.RenderScale = DynamicResolution.Scale;
+		Stats.SceneGpuMs = DynamicResolution.SceneMs;
+		Stats.PendingDeletions = DeletionQueue.GetPendingCount();
+
+		std::array<VkSemaphore, 1> signal_semaphores = { render_finished };
 
 		VkPresentInfoKHR present_info = {};
 		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -359,11 +756,20 @@ namespace VulkanRHI
 		err = vkQueuePresentKHR( PresentQueue, &present_info );
 		if ( err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR )
 		{
-			RecreateSwapchain();
+			SwapchainDirty = true;
 		}
 		else if ( err != VK_SUCCESS )
 		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::QueuePresent, err ) );
+		}
 
+		// measured when the first present is queued, covers process startup, Init and the first frame
+		if ( TimeToFirstFrameMs == 0.0f )
+		{
+			const std::chrono::duration<float, std::milli> time_to_first_frame = std::chrono::steady_clock::now() -
+				Application::LaunchTime();
+			TimeToFirstFrameMs = time_to_first_frame.count();
+			LOG_INFO( "[Vulkan] First frame presented {:.1f} ms after launch.", TimeToFirstFrameMs );
 		}
 
 		CurrentFrame = ( CurrentFrame + 1 ) % MAX_FRAMES_IN_FLIGHT;
@@ -415,31 +821,21 @@ namespace VulkanRHI
 		err = vkEnumerateInstanceExtensionProperties( nullptr, &count_extensions, nullptr );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate Vulkan Instance extension properties. "
-				"vkEnumerateInstanceExtensionProperties returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumerateInstanceExtensions, err ) );
 		}
 
 		std::vector<VkExtensionProperties> available_extensions( count_extensions );
 		err = vkEnumerateInstanceExtensionProperties( nullptr, &count_extensions, available_extensions.data() );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate Vulkan Instance extension properties. "
-				"vkEnumerateInstanceExtensionProperties returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumerateInstanceExtensions, err ) );
 		}
 
 		for ( const auto& ext : ContextInfo.Extensions )
 		{
 			if ( !IsExtensionAvailable( available_extensions, ext ) )
 			{
-				std::string message = std::format( 
-					"[Vulkan] Required extension is not available. Extension name: {}", ext );
-				return std::unexpected( message );
+				return std::unexpected( Error( ErrorCode::MissingInstanceExtension, VK_ERROR_EXTENSION_NOT_PRESENT, ext ) );
 			}
 		}
 
@@ -450,30 +846,21 @@ namespace VulkanRHI
 		err = vkEnumerateInstanceLayerProperties( &count_layers, nullptr );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate Vulkan Instance layer properties. "
-				"vkEnumerateInstanceLayerProperties() returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumerateInstanceLayers, err ) );
 		}
 
 		std::vector<VkLayerProperties> available_layers( count_layers );
 		err = vkEnumerateInstanceLayerProperties( &count_layers, available_layers.data() );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate Vulkan Instance layer properties. "
-				"vkEnumerateInstanceLayerProperties() returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumerateInstanceLayers, err ) );
 		}
 
 		for ( const auto& layer : ContextInfo.Layers )
 		{
 			if ( !IsLayerAvailable( available_layers, layer ) )
 			{
-				std::string message = std::format( "Required layer is not available. Layer name: {}.", layer );
-				return std::unexpected( message );
+				return std::unexpected( Error( ErrorCode::MissingInstanceLayer, VK_ERROR_LAYER_NOT_PRESENT, layer ) );
 			}
 		}
 
@@ -481,12 +868,10 @@ namespace VulkanRHI
 		instance_info.ppEnabledLayerNames = ContextInfo.Layers.data();
 
 		VkInstance instance;
-		err = vkCreateInstance( &instance_info, nullptr, &instance );
+		err = vkCreateInstance( &instance_info, Allocator, &instance );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Instance. vkCreateInstance() returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateInstance, err ) );
 		}
 
 		return instance;
@@ -495,18 +880,17 @@ namespace VulkanRHI
 	Expected<VkSurfaceKHR> Context::CreateSurface()
 	{
 		VkSurfaceKHR surface;
-		if ( bool result = SDL_Vulkan_CreateSurface( WindowHandle, Instance, nullptr, &surface ); !result )
+		if ( bool result = SDL_Vulkan_CreateSurface( WindowHandle, Instance, Allocator, &surface ); !result )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Surface with SDL_Vulkan_CreateSurface. "
-				"Error message : {}",
-				SDL_GetError() );
-			return std::unexpected( message );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "[Vulkan] SDL_Vulkan_CreateSurface failed: {}", SDL_GetError() );
+			return std::unexpected( Error( ErrorCode::CreateSurface ) );
 		}
 		return surface;
 	}
 
-	Expected<VkPhysicalDevice> Context::SelectPhysicalDevice()
+	// Every GPU is probed and scored, the best one that meets the requirements wins. Rejected GPUs are
+	// logged with the reason so a missing driver feature is visible without a debugger.
+	Expected<VulkanDeviceCandidate> Context::SelectPhysicalDevice()
 	{
 		VkResult err;
 
@@ -514,11 +898,7 @@ namespace VulkanRHI
 		err = vkEnumeratePhysicalDevices( Instance, &gpu_count, nullptr );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate GPUs with Vulkan support."
-				" vkEnumeratePhysicalDevices returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumeratePhysicalDevices, err ) );
 		}
 
 		LOG_INFO( "[Vulkan] Available GPUs amount: {}", gpu_count );
@@ -527,128 +907,58 @@ namespace VulkanRHI
 		err = vkEnumeratePhysicalDevices( Instance, &gpu_count, devices.data() );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to enumerate GPUs with Vulkan support."
-				" vkEnumeratePhysicalDevices returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::EnumeratePhysicalDevices, err ) );
 		}
 
 		LOG_INFO( "[Vulkan] Enumerating GPUs:" );
-		for ( const auto& gpu : devices )
+		std::optional<VulkanDeviceCandidate> best;
+		for ( VkPhysicalDevice gpu : devices )
 		{
-			VkPhysicalDeviceProperties props;
-			vkGetPhysicalDeviceProperties( gpu, &props );
-
-			VkPhysicalDeviceFeatures features;
-			vkGetPhysicalDeviceFeatures( gpu, &features );
-
-			LOG_INFO( "[Vulkan] GPU: {}", props.deviceName );
-
-			uint32 count_extensions = 0;
-			const char* layer_name = nullptr;
-			err = vkEnumerateDeviceExtensionProperties( gpu, layer_name, &count_extensions, nullptr );
-			if ( err != VK_SUCCESS )
+			auto candidate_result = ProbePhysicalDevice( gpu, Surface );
+			if ( !candidate_result )
 			{
-				std::string message = std::format(
-					"[Vulkan] Failed to enumerate GPU supported extensions. "
-					"vkEnumerateDeviceExtensionProperties returned {}.",
-					err );
-				return std::unexpected( message );
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", candidate_result.error() );
+				continue;
 			}
 
-			std::vector<VkExtensionProperties> extensions( count_extensions );
-			err = vkEnumerateDeviceExtensionProperties( gpu, nullptr, &count_extensions, extensions.data() );
-			if ( err != VK_SUCCESS )
+			const VulkanDeviceCandidate& candidate = candidate_result.value();
+			const char* name = candidate.Capabilities.Properties.deviceName;
+			if ( candidate.Rejection )
 			{
-				std::string message = std::format(
-					"[Vulkan] Failed to enumerate GPU supported extensions. "
-					"vkEnumerateDeviceExtensionProperties returned {}.",
-					err );
-				return std::unexpected( message );
+				LOG_INFO( "[Vulkan] GPU: {} is not usable, {}.", name, candidate.Rejection );
+				continue;
 			}
 
-			auto pred = [] ( const VkExtensionProperties& ext_prop ) -> bool {
-				return std::strcmp( ext_prop.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME );
-			};
-			auto it = std::ranges::find_if( extensions, pred );
-			bool swapchain_supported = it != extensions.end();
-
-			LOG_INFO( "[Vulkan] {} swapchain supported: {}.", props.deviceName, swapchain_supported );
-
-			if ( props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU && swapchain_supported )
+			LOG_INFO( "[Vulkan] GPU: {}, {} MiB, score {}.", name, candidate.Capabilities.DeviceLocalMemory >> 20,
+				candidate.Score );
+			if ( !best || candidate.Score > best->Score )
 			{
-				return gpu;
+				best = candidate;
 			}
 		}
 
-		LOG_INFO( "[Vulkan] Discrete GPU is not available or does not supported required extensions"
-			" first available will be selected." );
-
-		return devices[0];
-	}
-
-	Expected<VulkanQueueFamilyIndices> Context::FindQueueFamilies( VkPhysicalDevice device,
-		VkSurfaceKHR surface )
-	{
-		uint32 count = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties( device, &count, nullptr );
-		std::vector<VkQueueFamilyProperties> props( count );
-		vkGetPhysicalDeviceQueueFamilyProperties( device, &count, props.data() );
-
-		VulkanQueueFamilyIndices indices;
-		int32 family_index = 0;
-		for ( const auto& queue_family : props )
+		if ( !best )
 		{
-			if ( queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT )
-			{
-				indices.Graphics = family_index;
-			}
-
-			VkBool32 present_support = false;
-			VkResult err = vkGetPhysicalDeviceSurfaceSupportKHR( device, family_index, surface,
-				&present_support );
-			if ( err != VK_SUCCESS )
-			{
-				std::string message = std::format(
-					"[Vulkan] Error checking GPU surface support. "
-					"vkGetPhysicalDeviceSurfaceSupportKHR returned: {}.",
-					err );
-				return std::unexpected( message );
-			}
-
-			if ( present_support )
-			{
-				indices.Present = family_index;
-			}
-
-			if ( indices.IsComplete() )
-			{
-				break;
-			}
-
-			++family_index;
+			return std::unexpected( Error( ErrorCode::NoSuitableGpu ) );
 		}
-		return indices;
+		return best.value();
 	}
 
 	Expected<VkDevice> Context::CreateDevice( VulkanQueueFamilyIndices indices )
 	{
-		std::set<uint32> unique_families = {
-			indices.Graphics.value(),
-			indices.Present.value()
-		};
-		std::vector<VkDeviceQueueCreateInfo> queue_infos( unique_families.size() );
+		// one queue of every family that was found, dedicated compute and transfer queues cost nothing unused
+		const std::vector<uint32> unique_families = indices.GetUniqueFamilies();
+		std::vector<VkDeviceQueueCreateInfo> queue_infos;
 
-		float priority = 1.0f;
-		for ( uint32 i = 0; i < unique_families.size(); ++i )
+		const float priority = 1.0f;
+		for ( uint32 family : unique_families )
 		{
 			VkDeviceQueueCreateInfo queue_info = {};
 			queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queue_info.queueFamilyIndex = i;
+			queue_info.queueFamilyIndex = family;
 			queue_info.queueCount = 1;
 			queue_info.pQueuePriorities = &priority;
-			queue_infos[i] = queue_info;
+			queue_infos.push_back( queue_info );
 		}
 
 		VkDeviceCreateInfo device_info = {};
@@ -656,27 +966,67 @@ namespace VulkanRHI
 		device_info.queueCreateInfoCount = static_cast< uint32 >( queue_infos.size() );
 		device_info.pQueueCreateInfos = queue_infos.data();
 
+		const VkPhysicalDeviceFeatures& supported_features = Capabilities.Features;
+
 		VkPhysicalDeviceFeatures physical_device_features = {};
-		physical_device_features.samplerAnisotropy = true;
+		physical_device_features.samplerAnisotropy = supported_features.samplerAnisotropy;
+		physical_device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+		physical_device_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+
+		// culled draws address their instances through firstInstance of indirect commands
+		MultiDrawIndirect = supported_features.multiDrawIndirect;
+		OcclusionCulling = supported_features.drawIndirectFirstInstance;
 
 		device_info.pEnabledFeatures = &physical_device_features;
+
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features = {};
+		synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		synchronization2_features.synchronization2 = VK_TRUE;
+
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features = {};
+		dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		dynamic_rendering_features.pNext = &synchronization2_features;
+		dynamic_rendering_features.dynamicRendering = VK_TRUE;
+
+		DynamicRendering = ContextInfo.AllowDynamicRendering && Capabilities.DynamicRendering;
+		if ( DynamicRendering )
+		{
+			device_info.pNext = &dynamic_rendering_features;
+		}
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timeline_features.pNext = const_cast< void* >( device_info.pNext );
+		timeline_features.timelineSemaphore = VK_TRUE;
+
+		TimelineSemaphore = Capabilities.TimelineSemaphore;
+		if ( TimelineSemaphore )
+		{
+			device_info.pNext = &timeline_features;
+		}
 		device_info.enabledLayerCount = static_cast< uint32 >( ContextInfo.Layers.size() );
 		device_info.ppEnabledLayerNames = ContextInfo.Layers.data();
 
-		// the extension requires check for availability but i don't really care since i got rtx4060
-		// FIX: statement in comment above is temporary there'll be a fix but for now like that
+		// the swapchain extension was checked by SelectPhysicalDevice
 		std::vector<const char*> device_extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		if ( DynamicRendering )
+		{
+			std::ranges::copy( GetDynamicRenderingExtensions(), std::back_inserter( device_extensions ) );
+		}
+		MemoryBudget = Capabilities.MemoryBudget;
+		if ( MemoryBudget )
+		{
+			device_extensions.push_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+		}
 
 		device_info.enabledExtensionCount = static_cast< uint32 >( device_extensions.size() );
 		device_info.ppEnabledExtensionNames = device_extensions.data();
 
 		VkDevice device;
-		VkResult err = vkCreateDevice( Gpu, &device_info, nullptr, &device );
+		VkResult err = vkCreateDevice( Gpu, &device_info, Allocator, &device );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Device. vkCreateDevice returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateDevice, err ) );
 		}
 		return device;
 	}
@@ -688,177 +1038,169 @@ namespace VulkanRHI
 		return queue;
 	}
 
-	Expected<VulkanSwapchain> Context::CreateSwapchain()
+	Expected<VkShaderModule> Context::CreateShaderModule( const std::vector<char>& code )
 	{
-		VkResult err;
-		VkSwapchainCreateInfoKHR swapchain_info = {};
-		swapchain_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		swapchain_info.surface = Surface;
-
-		int32 width, height;
-		SDL_GetWindowSize( WindowHandle, &width, &height );
-
-		swapchain_info.imageExtent = { static_cast< uint32 >( width ), static_cast< uint32 >( height ) };
-
-		swapchain_info.minImageCount = 3;
-		swapchain_info.imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
-		swapchain_info.imageColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
-		swapchain_info.imageArrayLayers = 1;
-		swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-		swapchain_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		swapchain_info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
-		swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		swapchain_info.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
-
-		VulkanSwapchain swapchain;
-		swapchain.Format = swapchain_info.imageFormat;
-		swapchain.Extent = swapchain_info.imageExtent;
-		err = vkCreateSwapchainKHR( Device, &swapchain_info, nullptr, &swapchain.Instance );
-		if ( err != VK_SUCCESS )
-		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Swapchain. vkCreateSwapchainKHR returned: {}", err );
-			return std::unexpected( message );
-		}
+		VkShaderModuleCreateInfo module_info = {};
+		module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		module_info.codeSize = code.size();
+		ASSERT( code.size() );
+		module_info.pCode = reinterpret_cast< const uint32_t* >( code.data() );
 
-		uint32 count_images = 0;
-		err = vkGetSwapchainImagesKHR( Device, swapchain.Instance, &count_images, nullptr );
+		VkShaderModule shader_module;
+		VkResult err = vkCreateShaderModule( Device, &module_info, Allocator, &shader_module );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to receive Swapchain Images. vkGetSwapchainImagesKHR() returned: {}", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateShaderModule, err ) );
 		}
-		swapchain.Images.resize( count_images );
+		return shader_module;
+	}
 
-		err = vkGetSwapchainImagesKHR( Device, swapchain.Instance, &count_images, swapchain.Images.data() );
-		if ( err != VK_SUCCESS )
+	Expected<void> Context::CreateShaderModule( VulkanShader& shader )
+	{
+		auto module_result = CreateShaderModule( shader.Code );
+		if ( !module_result )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to receive swapchain images. vkGetSwapchainImageKHR() returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( module_result.error() );
 		}
-		return swapchain;
+		shader.Module = module_result.value();
+		shader.Code = {};
+		return {};
 	}
 
-	void Context::RecreateSwapchain()
+	Expected<VulkanShader> Context::LoadShader( const char* source_name, std::span<const ShaderKeyword> keywords )
 	{
-		vkDeviceWaitIdle( Device );
+		auto shader_result = ReadShader( source_name, keywords );
+		if ( !shader_result )
+		{
+			return std::unexpected( shader_result.error() );
+		}
 
-		Swapchain.Destroy( Device );
+		auto module_result = CreateShaderModule( shader_result.value() );
+		if ( !module_result )
+		{
+			return std::unexpected( module_result.error() );
+		}
+		return std::move( shader_result.value() );
+	}
 
-		auto swapchain_result = CreateSwapchain();
-		if ( !swapchain_result )
+	Expected<VulkanShader> Context::ReadShader( const char* source_name,
+		std::span<const ShaderKeyword> keywords ) const
+	{
+		// only keywords the source compiles permutations for are part of the file name
+		std::vector<std::string> permutation;
+		if ( !keywords.empty() )
 		{
-			LOG_ERROR( swapchain_result.error() );
-			throw std::runtime_error( "swapchain == VK_NULL_HANDLE" );
+			for ( const std::string& keyword : ReadPermutationKeywords( ShadersPath / source_name ) )
+			{
+				auto it = std::ranges::find( keywords, keyword, &ShaderKeyword::Name );
+				if ( it != keywords.end() && it->Value != 0 )
+				{
+					permutation.push_back( keyword );
+				}
+			}
 		}
-		Swapchain = std::move( swapchain_result.value() );
 
-		auto image_views_result = CreateImageViews();
-		if ( !image_views_result )
+		std::vector<char> code = GetShaderSource( ShadersPath /
+			GetPermutationFileName( source_name, permutation ) );
+		if ( code.empty() || code.size() % sizeof( uint32 ) != 0 )
 		{
-			LOG_ERROR( image_views_result.error() );
+			return std::unexpected( Error( ErrorCode::ReadShader, VK_SUCCESS, source_name ) );
 		}
-		Swapchain.ImageViews = std::move( image_views_result.value() );
 
-		auto texture_result = CreateDepthTexture();
-		if ( !texture_result )
+		std::vector<uint32> words( code.size() / sizeof( uint32 ) );
+		memcpy( words.data(), code.data(), code.size() );
+
+		auto reflection_result = ReflectSpirv( words );
+		if ( !reflection_result )
 		{
-			LOG_ERROR( texture_result.error() );
+			return std::unexpected( reflection_result.error() );
 		}
-		DepthTexture = std::move( texture_result.value() );
 
-		auto framebuffers_result = CreateFramebuffers();
-		if ( !framebuffers_result )
+		VulkanShader shader;
+		shader.Code = std::move( code );
+		shader.Reflection = std::move( reflection_result.value() );
+
+		for ( const ShaderKeyword& keyword : keywords )
 		{
-			LOG_ERROR( framebuffers_result.error() );
+			const ReflectedSpecConstant* constant = shader.Reflection.FindSpecConstant( keyword.Name );
+			if ( constant )
+			{
+				VkSpecializationMapEntry entry = {};
+				entry.constantID = constant->Id;
+				entry.offset = static_cast< uint32 >( shader.SpecializationData.size() * sizeof( uint32 ) );
+				entry.size = sizeof( uint32 );
+				shader.SpecializationEntries.push_back( entry );
+				shader.SpecializationData.push_back( keyword.Value );
+			}
 		}
-		Swapchain.Framebuffers = std::move( framebuffers_result.value() );
+		return shader;
 	}
 
-	Expected<VkShaderModule> Context::CreateShaderModule( const std::vector<char>& code )
+	Expected<VulkanPipelineLayout> Context::GetGraphicsLayout( const VulkanShader& vertex,
+		const VulkanShader& fragment )
 	{
-		VkShaderModuleCreateInfo module_info = {};
-		module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		module_info.codeSize = code.size();
-		ASSERT( code.size() );
-		module_info.pCode = reinterpret_cast< const uint32_t* >( code.data() );
-
-		VkShaderModule shader_module;
-		VkResult err = vkCreateShaderModule( Device, &module_info, nullptr, &shader_module );
-		if ( err != VK_SUCCESS )
+		ShaderReflection reflection = vertex.Reflection;
+		auto merge_result = reflection.Merge( fragment.Reflection );
+		if ( !merge_result )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Shader Module. vkCreateShaderModule returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( merge_result.error() );
 		}
-		return shader_module;
+		reflection.PromoteDynamicUniformBuffers();
+		return LayoutCache.Get( Device, reflection, Allocator );
 	}
 
-	Expected<VulkanGraphicsPipeline> Context::CreateGraphicsPipeline( VkShaderModule vertex,
-		VkShaderModule fragment )
+	Expected<VulkanGraphicsPipeline> Context::CreateGraphicsPipeline( const VulkanShader& vertex,
+		const VulkanShader& fragment )
 	{
-		VkResult err;
 		VulkanGraphicsPipeline graphics_pipeline;
 
-		VkDescriptorSetLayoutBinding ubo_layout_binding = {};
-		ubo_layout_binding.binding = 0;
-		ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		ubo_layout_binding.descriptorCount = 1;
-		ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-		VkDescriptorSetLayoutBinding sampler_layout_binding = {};
-		sampler_layout_binding.binding = 1;
-		sampler_layout_binding.descriptorCount = 1;
-		sampler_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
-			ubo_layout_binding,
-			sampler_layout_binding
-		};
-
-		VkDescriptorSetLayoutCreateInfo layout_info = {};
-		layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layout_info.bindingCount = static_cast< uint32 >( bindings.size() );
-		layout_info.pBindings = bindings.data();
-
-		const VkAllocationCallbacks* alloc = nullptr;
-		err = vkCreateDescriptorSetLayout( Device, &layout_info, alloc, &graphics_pipeline.DescriptorSetLayout );
-		if ( err != VK_SUCCESS )
+		auto layout_result = GetGraphicsLayout( vertex, fragment );
+		if ( !layout_result )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Descriptor set layout. "
-				"vkCreateDescriptorSetLayout returned {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( layout_result.error() );
+		}
+		graphics_pipeline.Layout = layout_result.value().Instance;
+		if ( !layout_result.value().SetLayouts.empty() )
+		{
+			graphics_pipeline.DescriptorSetLayout = layout_result.value().SetLayouts[0];
 		}
 
-		VkPipelineLayoutCreateInfo pipeline_layout_info = {};
-		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipeline_layout_info.setLayoutCount = 1;
-		pipeline_layout_info.pSetLayouts = &graphics_pipeline.DescriptorSetLayout;
+		if ( !DynamicRendering )
+		{
+			auto render_passes_result = CreateRenderPasses( graphics_pipeline );
+			if ( !render_passes_result )
+			{
+				return std::unexpected( render_passes_result.error() );
+			}
+		}
 
-		err = vkCreatePipelineLayout( Device, &pipeline_layout_info, alloc, &graphics_pipeline.Layout );
-		if ( err != VK_SUCCESS )
+		auto instance_result = CreateGraphicsPipelineInstance( vertex, fragment, graphics_pipeline.Layout,
+			graphics_pipeline.RenderPass );
+		if ( !instance_result )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Pipeline Layout."
-				"vkCreatePipelineLayout returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( instance_result.error() );
 		}
+		graphics_pipeline.Variants.push_back( { {}, instance_result.value() } );
+		return graphics_pipeline;
+	}
+
+	Expected<void> Context::CreateRenderPasses( VulkanGraphicsPipeline& graphics_pipeline )
+	{
+		VkResult err;
+		const VkAllocationCallbacks* alloc = Allocator;
 
+		// the frame is drawn into the HDR target in two render pass instances around the culling compute work:
+		// RenderPass clears and keeps both attachments, ResumeRenderPass loads them and keeps them for the
+		// temporal pass, which reads the depth for reprojection
 		VkAttachmentDescription color_attachment = {};
-		color_attachment.format = Swapchain.Format;
+		color_attachment.format = VulkanPostProcess::HDR_FORMAT;
 		color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference color_attachment_ref = {};
 		color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -878,7 +1220,7 @@ namespace VulkanRHI
 		depth_attachment.format = depth_format;
 		depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -893,8 +1235,9 @@ namespace VulkanRHI
 		VkSubpassDependency subpass_dependency = {};
 		subpass_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		subpass_dependency.dstSubpass = 0;
+		// the previous frame's post chain reads the HDR target and the depth texture
 		subpass_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		subpass_dependency.srcAccessMask = 0;
 		subpass_dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
 			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
@@ -914,39 +1257,122 @@ namespace VulkanRHI
 		err = vkCreateRenderPass( Device, &render_pass_info, alloc, &graphics_pipeline.RenderPass );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Render Pass. vkCreateRenderPass returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateRenderPass, err ) );
+		}
+
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		err = vkCreateRenderPass( Device, &render_pass_info, alloc, &graphics_pipeline.ResumeRenderPass );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateRenderPass, err ) );
+		}
+		return {};
+	}
+
+	// the streams the renderer provides, only the attributes the vertex shader reads are bound
+	Expected<void> Context::GetVertexInputs( const VulkanShader& vertex,
+		std::pmr::vector<VkVertexInputAttributeDescription>& attribute_desc,
+		std::pmr::vector<VkVertexInputBindingDescription>& binding_desc )
+	{
+		const auto vertex_attribute_desc = Vertex::GetAttributeDescription();
+		const auto instance_attribute_desc = InstanceData::GetAttributeDescription();
+		auto find_attribute = [] ( const auto& attributes, uint32 location ) {
+			return std::ranges::find( attributes, location, &VkVertexInputAttributeDescription::location );
+		};
+
+		bool uses_vertex_stream = false;
+		bool uses_instance_stream = false;
+		for ( const ReflectedInput& input : vertex.Reflection.Inputs )
+		{
+			auto vertex_it = find_attribute( vertex_attribute_desc, input.Location );
+			auto instance_it = find_attribute( instance_attribute_desc, input.Location );
+			if ( vertex_it != vertex_attribute_desc.end() )
+			{
+				attribute_desc.push_back( *vertex_it );
+				uses_vertex_stream = true;
+			}
+			else if ( instance_it != instance_attribute_desc.end() )
+			{
+				attribute_desc.push_back( *instance_it );
+				uses_instance_stream = true;
+			}
+			else
+			{
+				return std::unexpected( Error( ErrorCode::MissingVertexInput ) );
+			}
+		}
+
+		if ( uses_vertex_stream )
+		{
+			binding_desc.push_back( Vertex::GetBindingDescription() );
+		}
+		if ( uses_instance_stream )
+		{
+			binding_desc.push_back( InstanceData::GetBindingDescription() );
 		}
+		return {};
+	}
+
+	Expected<VkPipeline> Context::CreateGraphicsPipelineInstance( const VulkanShader& vertex,
+		const VulkanShader& fragment, VkPipelineLayout layout, VkRenderPass render_pass )
+	{
+		VkResult err;
 
 		VkPipelineShaderStageCreateInfo vertex_stage_info = {};
 		vertex_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		vertex_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertex_stage_info.module = vertex;
+		vertex_stage_info.module = vertex.Module;
 		vertex_stage_info.pName = "main";
 
+		const VkSpecializationInfo vertex_specialization = vertex.GetSpecializationInfo();
+		if ( !vertex.SpecializationEntries.empty() )
+		{
+			vertex_stage_info.pSpecializationInfo = &vertex_specialization;
+		}
+
 		VkPipelineShaderStageCreateInfo fragment_stage_info = {};
 		fragment_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		fragment_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragment_stage_info.module = fragment;
+		fragment_stage_info.module = fragment.Module;
 		fragment_stage_info.pName = "main";
 
+		const VkSpecializationInfo fragment_specialization = fragment.GetSpecializationInfo();
+		if ( !fragment.SpecializationEntries.empty() )
+		{
+			fragment_stage_info.pSpecializationInfo = &fragment_specialization;
+		}
+
 		VkPipelineShaderStageCreateInfo shader_stage_infos[] = { vertex_stage_info, fragment_stage_info };
 
-		std::vector<VkDynamicState> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		// pipelines are created on startup workers, the temporaries come from their scratch arenas
+		ScratchScope scratch;
+
+		const std::array<VkDynamicState, 2> dynamic_states = {
+			VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
+		};
 
 		VkPipelineDynamicStateCreateInfo dynamic_state_info = {};
 		dynamic_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		dynamic_state_info.dynamicStateCount = static_cast<uint32>( dynamic_states.size() );
 		dynamic_state_info.pDynamicStates = dynamic_states.data();
 
-		auto binding_desc = Vertex::GetBindingDescription();
-		auto attribute_desc = Vertex::GetAttributeDescription();
+		std::pmr::vector<VkVertexInputAttributeDescription> attribute_desc( scratch.GetResource() );
+		std::pmr::vector<VkVertexInputBindingDescription> binding_desc( scratch.GetResource() );
+		auto vertex_inputs_result = GetVertexInputs( vertex, attribute_desc, binding_desc );
+		if ( !vertex_inputs_result )
+		{
+			return std::unexpected( vertex_inputs_result.error() );
+		}
+
 		VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
 		vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertex_input_info.vertexBindingDescriptionCount = 1;
+		vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32>( binding_desc.size() );
 		vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32>( attribute_desc.size() );
-		vertex_input_info.pVertexBindingDescriptions = &binding_desc;
+		vertex_input_info.pVertexBindingDescriptions = binding_desc.data();
 		vertex_input_info.pVertexAttributeDescriptions = attribute_desc.data();
 
 		VkPipelineInputAssemblyStateCreateInfo assembly_info = {};
@@ -1008,30 +1434,46 @@ namespace VulkanRHI
 		pipeline_info.pColorBlendState = &colorblend_info;
 		pipeline_info.pDynamicState = &dynamic_state_info;
 		pipeline_info.pDepthStencilState = &depth_stencil_info;
-		pipeline_info.layout = graphics_pipeline.Layout;
-		pipeline_info.renderPass = graphics_pipeline.RenderPass;
+		pipeline_info.layout = layout;
+		pipeline_info.renderPass = render_pass;
+
+		const VkFormat                   color_format = VulkanPostProcess::HDR_FORMAT;
+		VkPipelineRenderingCreateInfoKHR rendering_info = {};
+		if ( render_pass == VK_NULL_HANDLE )
+		{
+			auto depth_format_result = FindDepthFormat();
+			if ( !depth_format_result )
+			{
+				return std::unexpected( depth_format_result.error() );
+			}
+
+			rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+			rendering_info.colorAttachmentCount = 1;
+			rendering_info.pColorAttachmentFormats = &color_format;
+			rendering_info.depthAttachmentFormat = depth_format_result.value();
+			pipeline_info.pNext = &rendering_info;
+		}
 
-		const VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
-		const uint32          create_count = 1;
-		err = vkCreateGraphicsPipelines( Device, pipeline_cache, create_count, &pipeline_info, alloc,
-			&graphics_pipeline.Instance );
+		VkPipeline pipeline;
+		const uint32                 create_count = 1;
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateGraphicsPipelines( Device, PipelineCache, create_count, &pipeline_info, alloc,
+			&pipeline );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Graphics Pipeline. vkCreateGraphicsPipeline returned: {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateGraphicsPipeline, err ) );
 		}
-		return graphics_pipeline;
+		return pipeline;
 	}
 
 
-	Expected<VkImageView> Context::CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspect_flags )
+	Expected<VkImageView> Context::CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspect_flags,
+		uint32 base_mip, uint32 mip_count, VkImageViewType view_type, uint32 base_layer, uint32 layer_count )
 	{
 		VkImageViewCreateInfo image_view_info = {};
 		image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		image_view_info.image = image;
-		image_view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_info.viewType = view_type;
 		image_view_info.format = format;
 		image_view_info.components = {
 			VK_COMPONENT_SWIZZLE_IDENTITY,
@@ -1041,27 +1483,31 @@ namespace VulkanRHI
 		};
 		VkImageSubresourceRange subresource_range = {
 			.aspectMask = aspect_flags,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
+			.baseMipLevel = base_mip,
+			.levelCount = mip_count,
+			.baseArrayLayer = base_layer,
+			.layerCount = layer_count
 		};
 		image_view_info.subresourceRange = subresource_range;
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 		VkImageView view;
 		VkResult err = vkCreateImageView( Device, &image_view_info, alloc, &view );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Image View. vkCreateImageView returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateImageView, err ) );
 		}
 		return view;
 	}
 
 	Expected<std::vector<VkImageView>> Context::CreateImageViews()
 	{
+		// only the tonemap pass binds the swapchain images, blitted images are not viewed
+		if ( !Swapchain.StorageImages )
+		{
+			return std::vector<VkImageView>{};
+		}
+
 		std::vector<VkImageView> image_views( Swapchain.Images.size() );
 
 		for ( size_t i = 0; i < Swapchain.Images.size(); ++i )
@@ -1076,34 +1522,34 @@ namespace VulkanRHI
 		return image_views;
 	}
 
-	Expected<std::vector<VkFramebuffer>> Context::CreateFramebuffers()
+	Expected<VkFramebuffer> Context::CreateSceneFramebuffer( VkImageView color_view )
 	{
-		std::vector<VkFramebuffer> framebuffers( Swapchain.ImageViews.size() );
-		for ( size_t i = 0; i < framebuffers.size(); i++ )
+		if ( DynamicRendering )
 		{
-			std::array<VkImageView, 2> attachments = {
-				Swapchain.ImageViews[i],
-				DepthTexture.View
-			};
+			return VK_NULL_HANDLE;
+		}
 
-			VkFramebufferCreateInfo framebuffer_info = {};
-			framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebuffer_info.renderPass = GraphicsPipeline.RenderPass;
-			framebuffer_info.attachmentCount = static_cast< uint32 >( attachments.size() );
-			framebuffer_info.pAttachments = attachments.data();
-			framebuffer_info.width = Swapchain.Extent.width;
-			framebuffer_info.height = Swapchain.Extent.height;
-			framebuffer_info.layers = 1;
+		std::array<VkImageView, 2> attachments = {
+			color_view,
+			DepthTexture.View
+		};
 
-			VkResult err = vkCreateFramebuffer( Device, &framebuffer_info, nullptr, &framebuffers[i] );
-			if ( err != VK_SUCCESS )
-			{
-				std::string message = std::format(
-					"[Vulkan] Failed to create framebuffer. vkCreateFramebuffer returned: {}.", err );
-				return std::unexpected( message );
-			}
+		VkFramebufferCreateInfo framebuffer_info = {};
+		framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebuffer_info.renderPass = GraphicsPipeline.RenderPass;
+		framebuffer_info.attachmentCount = static_cast< uint32 >( attachments.size() );
+		framebuffer_info.pAttachments = attachments.data();
+		framebuffer_info.width = Swapchain.Extent.width;
+		framebuffer_info.height = Swapchain.Extent.height;
+		framebuffer_info.layers = 1;
+
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkResult err = vkCreateFramebuffer( Device, &framebuffer_info, Allocator, &framebuffer );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateFramebuffer, err ) );
 		}
-		return framebuffers;
+		return framebuffer;
 	}
 
 	Expected<VkCommandPool> Context::CreateCommandPool( VulkanQueueFamilyIndices indices )
@@ -1114,36 +1560,14 @@ namespace VulkanRHI
 		cmdpool_info.queueFamilyIndex = indices.Graphics.value();
 
 		VkCommandPool command_pool;
-		VkResult err = vkCreateCommandPool( Device, &cmdpool_info, nullptr, &command_pool );
+		VkResult err = vkCreateCommandPool( Device, &cmdpool_info, Allocator, &command_pool );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Command Pool. vkCreateCommandPool returned: {}", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateCommandPool, err ) );
 		}
 		return command_pool;
 	}
 
-	Expected<std::vector<VkCommandBuffer>> Context::CreateCommandBuffers()
-	{
-		std::vector<VkCommandBuffer> command_buffers( MAX_FRAMES_IN_FLIGHT );
-
-		VkCommandBufferAllocateInfo alloc_info = {};
-		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		alloc_info.commandPool = CommandPool;
-		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		alloc_info.commandBufferCount = static_cast< uint32 >( command_buffers.size() );
-
-		VkResult err = vkAllocateCommandBuffers( Device, &alloc_info, command_buffers.data() );
-		if ( err != VK_SUCCESS )
-		{
-			std::string message = std::format(
-				"[Vulkan] Error allocating Vulkan Command Buffers. vkAllocateCommandBuffers returned: {}.", err );
-			return std::unexpected( message );
-		}
-		return command_buffers;
-	}
-
 	Expected<std::vector<VulkanSyncObjects>> Context::CreateSyncObjects()
 	{
 		VkResult err;
@@ -1156,7 +1580,7 @@ namespace VulkanRHI
 		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 
 		for ( VulkanSyncObjects& obj : sync_objs )
 		{
@@ -1164,30 +1588,21 @@ namespace VulkanRHI
 			err = vkCreateSemaphore( Device, &semaphore_info, alloc, &image_available );
 			if ( err != VK_SUCCESS )
 			{
-				std::string message = std::format(
-					"[Vulkan] Failed to create Image Available semaphore object. vkCreateSemaphore returned {}.",
-					err );
-				return std::unexpected( message );
+				return std::unexpected( Error( ErrorCode::CreateSyncSemaphore, err, "image available" ) );
 			}
 
 			VkSemaphore render_finished = VK_NULL_HANDLE;
 			err = vkCreateSemaphore( Device, &semaphore_info, alloc, &render_finished );
 			if ( err != VK_SUCCESS )
 			{
-				std::string message = std::format(
-					"[Vulkan] Failed to create Render Finished semaphore object. "
-					"vkCreateSemaphore returned {}",
-					err );
-				return std::unexpected( message );
+				return std::unexpected( Error( ErrorCode::CreateSyncSemaphore, err, "render finished" ) );
 			}
 
 			VkFence in_flight = VK_NULL_HANDLE;
 			err = vkCreateFence( Device, &fence_info, alloc, &in_flight );
 			if ( err != VK_SUCCESS )
 			{
-				std::string message = std::format(
-					"[Vulkan] Failed to create Fences. vkCreateFence returned {}", err );
-				return std::unexpected( message );
+				return std::unexpected( Error( ErrorCode::CreateFence, err ) );
 			}
 
 			obj.ImageAvailableSemaphore = std::move( image_available );
@@ -1215,7 +1630,7 @@ namespace VulkanRHI
 	}
 
 	Expected<VulkanBuffer> Context::CreateBuffer( VkDeviceSize size, VkBufferUsageFlags usage,
-		VkMemoryPropertyFlags props )
+		VkMemoryPropertyFlags props, bool shared )
 	{
 		VkResult err;
 
@@ -1224,16 +1639,21 @@ namespace VulkanRHI
 		buffer_info.size = size;
 		buffer_info.usage = usage;
 		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if ( shared && !SharedQueueFamilies.empty() )
+		{
+			// concurrent instead of ownership transfers between the graphics and the compute queue
+			buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			buffer_info.queueFamilyIndexCount = static_cast< uint32 >( SharedQueueFamilies.size() );
+			buffer_info.pQueueFamilyIndices = SharedQueueFamilies.data();
+		}
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 
 		VkBuffer instance = VK_NULL_HANDLE;
 		err = vkCreateBuffer( Device, &buffer_info, alloc, &instance );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan Buffer. vkCreate buffer returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateBuffer, err ) );
 		}
 
 		VkMemoryRequirements memory_requirements = {};
@@ -1245,21 +1665,17 @@ namespace VulkanRHI
 		allocate_info.memoryTypeIndex = FindMemoryType( memory_requirements.memoryTypeBits, props );
 
 		VkDeviceMemory memory = VK_NULL_HANDLE;
-		err = vkAllocateMemory( Device, &allocate_info, alloc, &memory );
+		err = AllocateDeviceMemory( Device, allocate_info, alloc, &memory );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to allocate memory. vkAllocateMemory returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::AllocateMemory, err ) );
 		}
 
 		const VkDeviceSize memory_offset = 0;
 		err = vkBindBufferMemory( Device, instance, memory, memory_offset );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to bind buffer memory. vkBindBufferMemory returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::BindBufferMemory, err ) );
 		}
 
 		VulkanBuffer buffer = {
@@ -1271,7 +1687,7 @@ namespace VulkanRHI
 
 	Expected<VulkanBuffer> Context::CreateVertexBuffer()
 	{
-		const VkDeviceSize    buffer_size = sizeof( VERTICES[0] ) * VERTICES.size();
+		const VkDeviceSize    buffer_size = sizeof( Vertex ) * SceneVertices.size();
 		VkBufferUsageFlags    usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 		auto staging_buffer_result = CreateBuffer( buffer_size, usage, props );
@@ -1287,11 +1703,10 @@ namespace VulkanRHI
 		VkResult err = vkMapMemory( Device, staging_buffer.Memory, offset, buffer_size, flags, &data );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format( "[Vulkan] Failed to map memory. vkMapMemory returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::MapMemory, err ) );
 		}
 
-		memcpy( data, VERTICES.data(), static_cast<size_t>( buffer_size ) );
+		memcpy( data, SceneVertices.data(), static_cast<size_t>( buffer_size ) );
 		vkUnmapMemory( Device, staging_buffer.Memory );
 
 		usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
@@ -1305,14 +1720,14 @@ namespace VulkanRHI
 
 		CopyBuffer( staging_buffer.Instance, vertex_buffer.Instance, buffer_size );
 
-		staging_buffer.Destroy( Device );
+		DeletionQueue.RetireResource( UploadValue, staging_buffer );
 
 		return vertex_buffer;
 	}
 
 	Expected<VulkanBuffer> Context::CreateIndexBuffer()
 	{
-		VkDeviceSize buffer_size = sizeof( INDICES[0] ) * INDICES.size();
+		VkDeviceSize buffer_size = sizeof( uint16 ) * SceneIndices.size();
 
 		VkBufferUsageFlags    usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 		VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -1329,12 +1744,10 @@ namespace VulkanRHI
 		VkResult err = vkMapMemory( Device, staging_buffer.Memory, offset, buffer_size, flags, &data );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to map memory. vkMapMemory returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::MapMemory, err ) );
 		}
 
-		memcpy( data, INDICES.data(), static_cast< size_t >( buffer_size ) );
+		memcpy( data, SceneIndices.data(), static_cast< size_t >( buffer_size ) );
 		vkUnmapMemory( Device, staging_buffer.Memory );
 
 		usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
@@ -1348,41 +1761,42 @@ namespace VulkanRHI
 
 		CopyBuffer( staging_buffer.Instance, index_buffer.Instance, buffer_size );
 
-		staging_buffer.Destroy( Device );
+		DeletionQueue.RetireResource( UploadValue, staging_buffer );
 
 		return index_buffer;
 	}
 
-	Expected<std::vector<VulkanBuffer>> Context::CreateUniformBuffers()
+	Expected<VulkanFrameRing> Context::CreateFrameRing( VkDeviceSize element_size, uint32 element_count,
+		VkBufferUsageFlags usage, VkDeviceSize alignment )
 	{
-		std::vector<VulkanBuffer> uniform_buffers( MAX_FRAMES_IN_FLIGHT );
+		VulkanFrameRing ring;
+		ring.Alignment = std::max<VkDeviceSize>( alignment, 16 );
+
+		const VkDeviceSize aligned_element_size = ( element_size + ring.Alignment - 1 ) & ~( ring.Alignment - 1 );
+		ring.FrameCapacity = aligned_element_size * element_count;
 
-		VkDeviceSize buffer_size = sizeof( UniformBufferObject );
-		for ( VulkanBuffer& uniform_buffer : uniform_buffers )
+		const VkDeviceSize buffer_size = ring.FrameCapacity * MAX_FRAMES_IN_FLIGHT;
+		VkBufferUsageFlags buffer_usage_flags = usage;
+		VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		auto buffer_result = CreateBuffer( buffer_size, buffer_usage_flags, props );
+		if ( !buffer_result )
 		{
-			VkBufferUsageFlags buffer_usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-			VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-			auto uniform_buffer_result = CreateBuffer( buffer_size, buffer_usage_flags, props );
-			if ( !uniform_buffer_result )
-			{
-				return std::unexpected( uniform_buffer_result.error() );
-			}
-			uniform_buffer = std::move( uniform_buffer_result.value() );
+			return std::unexpected( buffer_result.error() );
+		}
+		ring.Buffer = std::move( buffer_result.value() );
 
-			VkDeviceSize	 offset = 0;
-			VkMemoryMapFlags memory_map_flags = 0;
-			VkResult err = vkMapMemory( Device, uniform_buffer.Memory, offset, buffer_size, memory_map_flags,
-				&uniform_buffer.Mapped );
-			if ( err != VK_SUCCESS )
-			{
-				std::string message = std::format(
-					"[Vulkan] Failed to map memory. vkMapMemory returned {}.", err );
-				return std::unexpected( message );
-			}
+		// mapped once for the lifetime of the ring
+		VkDeviceSize	 offset = 0;
+		VkMemoryMapFlags memory_map_flags = 0;
+		VkResult err = vkMapMemory( Device, ring.Buffer.Memory, offset, buffer_size, memory_map_flags,
+			&ring.Buffer.Mapped );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::MapMemory, err ) );
 		}
 
-		return uniform_buffers;
+		return ring;
 	}
 
 	void Context::CopyBuffer( VkBuffer source, VkBuffer destination, VkDeviceSize size )
@@ -1390,7 +1804,7 @@ namespace VulkanRHI
 		auto command_buffer_result = BeginSingleTimeCommands();
 		if ( !command_buffer_result )
 		{
-			LOG_ERROR( command_buffer_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", command_buffer_result.error() );
 			throw std::runtime_error( "BeginSingleTimeCommands failed" );
 		}
 		VkCommandBuffer command_buffer = std::move( command_buffer_result.value() );
@@ -1404,7 +1818,7 @@ namespace VulkanRHI
 		EndSingleTimeCommands( command_buffer );
 	}
 
-	void Context::UpdateUniformBuffer( uint32 current_image )
+	void Context::UpdateUniformBuffer( uint32 current_frame )
 	{
 		namespace chrono = std::chrono;
 		static auto start_time = chrono::high_resolution_clock::now();
@@ -1426,43 +1840,165 @@ namespace VulkanRHI
 		ubo.Projection = glm::perspective(
 			glm::radians( 45.0f ),
 			Swapchain.Extent.width / static_cast<float>( Swapchain.Extent.height ),
-			0.1f,
-			10.0f );
+			NEAR_PLANE,
+			FAR_PLANE );
 
 		ubo.Projection[1][1] *= -1;
+		UpdateTemporal( ubo );
+
+		UpdateLights( current_frame, ubo );
+		UpdateShadows( current_frame, ubo );
+		BuildDrawBatches( current_frame, ubo );
+		BuildShadowDraws();
+	}
+
+	void Context::BuildDrawBatches( uint32 current_frame, const UniformBufferObject& ubo )
+	{
+		UniformRing.BeginFrame( current_frame );
+		InstanceRing.BeginFrame( current_frame );
+		DrawBatches.clear();
+		Queue.Clear();
+
+		const uint32 pass = 0;
+
+		// the tree holds bounds before ubo.Model is applied, so the frustum is taken in that space too
+		VisibleObjects.clear();
+		SceneTree.QueryFrustum( Frustum::FromMatrix( ubo.Projection * ubo.View * ubo.Model ), VisibleObjects );
+
+		const glm::mat4 view_model = ubo.View * ubo.Model;
+		// the scene is drawn at the render scale, its level of detail follows the pixels actually shaded
+		const float pixels_per_unit = 0.5f * std::abs( ubo.Projection[1][1] ) *
+			static_cast< float >( DynamicResolution.RenderExtent.height );
+		for ( uint32 object_id : VisibleObjects )
+		{
+			// object ids double as indices into the culling visibility buffer
+			if ( object_id >= static_cast< uint32 >( MAX_INSTANCES_PER_FRAME ) )
+			{
+				continue;
+			}
+
+			VulkanRenderObject& object = Objects[object_id];
+			const glm::vec4 view_position = view_model * object.Transform[3];
+			const float depth = -view_position.z / FAR_PLANE;
+			const uint32 pipeline = DebugPipeline.value_or( object.Pipeline );
+			object.Lod = SelectLod( object, view_model, pixels_per_unit );
+
+			// every level of a mesh is its own mesh to the queue, only instances of one level batch
+			const uint32 mesh_lod = object.Mesh * VulkanMesh::MAX_LODS + object.Lod;
+			Queue.Push( RenderQueue::MakeKey( pass, pipeline, object.Material, mesh_lod, depth ), object_id );
+		}
+		Queue.Sort();
+
+		CullInput.clear();
+
+		auto items = Queue.GetItems();
+		std::optional<uint32> uniform_offset;
+		uint32 uniform_material = UINT32_MAX;
+		for ( size_t begin = 0; begin < items.size(); )
+		{
+			const uint64 key = items[begin].Key;
+
+			BatchInstances.clear();
+			size_t end = begin;
+			for ( ; end < items.size() && RenderQueue::IsSameState( items[end].Key, key ); ++end )
+			{
+				BatchInstances.push_back( { Objects[items[end].Payload].Transform } );
+			}
+
+			// per-draw constants only change with the material, so batches of one material share them
+			const uint32 material = RenderQueue::GetMaterial( key );
+			if ( material != uniform_material )
+			{
+				uniform_offset = UniformRing.Push( &ubo, sizeof( ubo ) );
+				uniform_material = material;
+			}
+
+			auto instance_offset = InstanceRing.Push( BatchInstances.data(),
+				BatchInstances.size() * sizeof( InstanceData ) );
+			if ( !uniform_offset || !instance_offset )
+			{
+				// frame region is exhausted, the remaining batches are dropped for this frame
+				break;
+			}
+
+			VulkanDrawBatch batch = {};
+			batch.Pipeline = RenderQueue::GetPipeline( key );
+			batch.Mesh = RenderQueue::GetMesh( key ) / VulkanMesh::MAX_LODS;
+			batch.Lod = RenderQueue::GetMesh( key ) % VulkanMesh::MAX_LODS;
+			batch.Material = material;
+			batch.UniformOffset = uniform_offset.value();
+			batch.FirstInstance = static_cast< uint32 >(
+				InstanceRing.AbsoluteOffset( instance_offset.value() ) / sizeof( InstanceData ) );
+			batch.InstanceCount = static_cast< uint32 >( end - begin );
+			batch.FirstSlot = static_cast< uint32 >( CullInput.size() );
+			DrawBatches.push_back( batch );
+
+			if ( OcclusionCulling )
+			{
+				const VulkanMesh& mesh = Meshes[batch.Mesh];
+				const VulkanMeshLod& lod = mesh.Lods[batch.Lod];
+				for ( size_t i = begin; i < end; ++i )
+				{
+					const uint32 object_id = items[i].Payload;
+					const Bounds world_bounds = mesh.LocalBounds.Transform( ubo.Model * Objects[object_id].Transform );
+
+					CullObject cull_object = {};
+					cull_object.BoundsMin = glm::vec4( world_bounds.Min, 1.0f );
+					cull_object.BoundsMax = glm::vec4( world_bounds.Max, 1.0f );
+					cull_object.ObjectId = object_id;
+					cull_object.IndexCount = lod.IndexCount;
+					cull_object.FirstIndex = lod.FirstIndex;
+					cull_object.VertexOffset = mesh.VertexOffset;
+					cull_object.FirstInstance = batch.FirstInstance + static_cast< uint32 >( i - begin );
+					CullInput.push_back( cull_object );
+				}
+			}
+
+			begin = end;
+		}
+
+		if ( OcclusionCulling )
+		{
+			// sized like the instance ring, whatever fit there fits here
+			Culler.Objects.BeginFrame( current_frame );
+			auto objects_offset = Culler.Objects.Push( CullInput.data(), CullInput.size() * sizeof( CullObject ) );
+			ASSERT( objects_offset && objects_offset.value() == 0 );
 
-		memcpy( UniformBuffers[current_image].Mapped, &ubo, sizeof( ubo ) );
+			Culler.ObjectCount = static_cast< uint32 >( CullInput.size() );
+			Culler.ViewProjection = ubo.Projection * ubo.View;
+		}
 	}
 
 	Expected<VulkanDescriptorGroup> Context::CreateDescriptorGroup()
 	{
 		VkResult err;
 
-		std::array<VkDescriptorPoolSize, 2> pool_sizes = {};
-		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		std::array<VkDescriptorPoolSize, 3> pool_sizes = {};
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		pool_sizes[0].descriptorCount = static_cast<uint32>( MAX_FRAMES_IN_FLIGHT );
 		pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		pool_sizes[1].descriptorCount = static_cast<uint32>( MAX_FRAMES_IN_FLIGHT );
+		pool_sizes[1].descriptorCount = static_cast<uint32>( 3 * MAX_FRAMES_IN_FLIGHT );
+		pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pool_sizes[2].descriptorCount = static_cast<uint32>( 4 * MAX_FRAMES_IN_FLIGHT );
 
 		VkDescriptorPoolCreateInfo pool_info = {};
 		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		pool_info.poolSizeCount = 2;
+		pool_info.poolSizeCount = static_cast<uint32>( pool_sizes.size() );
 		pool_info.pPoolSizes = pool_sizes.data();
 		pool_info.maxSets = static_cast< uint32 >( MAX_FRAMES_IN_FLIGHT );
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 
 		VkDescriptorPool pool = VK_NULL_HANDLE;
 		err = vkCreateDescriptorPool( Device, &pool_info, alloc, &pool );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create descriptor pool. vkCreateDescriptorPool returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateDescriptorPool, err ) );
 		}
 
-		std::vector<VkDescriptorSetLayout> layouts( MAX_FRAMES_IN_FLIGHT,
-			GraphicsPipeline.DescriptorSetLayout );
+		ScratchScope scratch;
+		std::pmr::vector<VkDescriptorSetLayout> layouts( MAX_FRAMES_IN_FLIGHT, GraphicsPipeline.DescriptorSetLayout,
+			scratch.GetResource() );
 		VkDescriptorSetAllocateInfo allocate_info = {};
 		allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocate_info.descriptorPool = pool;
@@ -1473,16 +2009,14 @@ namespace VulkanRHI
 		err = vkAllocateDescriptorSets( Device, &allocate_info, sets.data() );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to allocate Descriptor Sets. vkAllocateDescriptorSets returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::AllocateDescriptorSets, err ) );
 		}
 
 		for ( size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i )
 		{
 			VkDescriptorBufferInfo buffer_info = {};
-			buffer_info.buffer = UniformBuffers[i].Instance;
-			buffer_info.offset = 0;
+			buffer_info.buffer = UniformRing.Buffer.Instance;
+			buffer_info.offset = i * UniformRing.FrameCapacity;
 			buffer_info.range = sizeof( UniformBufferObject );
 
 			VkDescriptorImageInfo image_info = {};
@@ -1490,12 +2024,38 @@ namespace VulkanRHI
 			image_info.imageView = Texture.View;
 			image_info.sampler = Texture.Sampler;
 
-			std::array<VkWriteDescriptorSet, 2> descriptor_writes = {};
+			// the frame's light list and clusters, written by the light cull pass of the same frame
+			std::array<VkDescriptorBufferInfo, 3> cluster_infos = {};
+			cluster_infos[0].buffer = LightClusters.Lights.Buffer.Instance;
+			cluster_infos[0].offset = i * LightClusters.Lights.FrameCapacity;
+			cluster_infos[0].range = LightClusters.Lights.FrameCapacity;
+			cluster_infos[1].buffer = LightClusters.Counts.Instance;
+			cluster_infos[1].offset = i * LightClusters.CountsFrameSize;
+			cluster_infos[1].range = LightClusters.CountsFrameSize;
+			cluster_infos[2].buffer = LightClusters.Indices.Instance;
+			cluster_infos[2].offset = i * LightClusters.IndicesFrameSize;
+			cluster_infos[2].range = LightClusters.IndicesFrameSize;
+
+			// the maps stay in the shader read layout outside of RecordShadows
+			std::array<VkDescriptorImageInfo, 2> shadow_image_infos = {};
+			shadow_image_infos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			shadow_image_infos[0].imageView = ShadowMaps.CascadeTexture.View;
+			shadow_image_infos[0].sampler = ShadowMaps.Sampler;
+			shadow_image_infos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			shadow_image_infos[1].imageView = ShadowMaps.AtlasTexture.View;
+			shadow_image_infos[1].sampler = ShadowMaps.Sampler;
+
+			VkDescriptorBufferInfo tiles_info = {};
+			tiles_info.buffer = ShadowMaps.TileRing.Buffer.Instance;
+			tiles_info.offset = i * ShadowMaps.TileRing.FrameCapacity;
+			tiles_info.range = ShadowMaps.TileRing.FrameCapacity;
+
+			std::array<VkWriteDescriptorSet, 8> descriptor_writes = {};
 			descriptor_writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 			descriptor_writes[0].dstSet = sets[i];
 			descriptor_writes[0].dstBinding = 0;
 			descriptor_writes[0].dstArrayElement = 0;
-			descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			descriptor_writes[0].descriptorCount = 1;
 			descriptor_writes[0].pBufferInfo = &buffer_info;
 
@@ -1507,6 +2067,36 @@ namespace VulkanRHI
 			descriptor_writes[1].descriptorCount = 1;
 			descriptor_writes[1].pImageInfo = &image_info;
 
+			for ( uint32 binding = 2; binding < 5; ++binding )
+			{
+				descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptor_writes[binding].dstSet = sets[i];
+				descriptor_writes[binding].dstBinding = binding;
+				descriptor_writes[binding].dstArrayElement = 0;
+				descriptor_writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				descriptor_writes[binding].descriptorCount = 1;
+				descriptor_writes[binding].pBufferInfo = &cluster_infos[binding - 2];
+			}
+
+			for ( uint32 binding = 5; binding < 7; ++binding )
+			{
+				descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptor_writes[binding].dstSet = sets[i];
+				descriptor_writes[binding].dstBinding = binding;
+				descriptor_writes[binding].dstArrayElement = 0;
+				descriptor_writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				descriptor_writes[binding].descriptorCount = 1;
+				descriptor_writes[binding].pImageInfo = &shadow_image_infos[binding - 5];
+			}
+
+			descriptor_writes[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptor_writes[7].dstSet = sets[i];
+			descriptor_writes[7].dstBinding = 7;
+			descriptor_writes[7].dstArrayElement = 0;
+			descriptor_writes[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptor_writes[7].descriptorCount = 1;
+			descriptor_writes[7].pBufferInfo = &tiles_info;
+
 			const uint32 descriptor_write_count = static_cast<uint32>( descriptor_writes.size() );
 			const uint32 descriptor_copy_count = 0;
 			const VkCopyDescriptorSet* descriptor_copies = nullptr;
@@ -1521,25 +2111,32 @@ namespace VulkanRHI
 		return descriptor_group;
 	}
 
-	Expected<VulkanTexture> Context::CreateTexture()
+	Expected<VulkanImageData> Context::DecodeImage( const std::filesystem::path& path )
 	{
-		VkResult err;
-
-		auto assets_path = Application::ExecutablePath()
-			.parent_path().parent_path().parent_path().parent_path().parent_path() / "Assets" / "brick.jpg";
-		std::string assets_path_string = assets_path.string();
+		const std::string path_string = path.string();
 
-		int32 width = 0;
-		int32 height = 0;
 		int32 channels = 0;
-		stbi_uc* pixels = stbi_load( assets_path_string.c_str(), &width, &height, &channels, STBI_rgb_alpha );
+		VulkanImageData image;
+		stbi_uc* pixels = stbi_load( path_string.c_str(), &image.Width, &image.Height, &channels, STBI_rgb_alpha );
 		if ( !pixels )
 		{
-			std::string message = std::format( "[Vulkan] Failed to load {}", assets_path_string );
-			return std::unexpected( message );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "[Vulkan] Failed to load {}", path_string );
+			return std::unexpected( Error( ErrorCode::LoadTexture ) );
 		}
 
-		VkDeviceSize image_size = width * height * 4;
+		const size_t image_size = static_cast< size_t >( image.Width ) * image.Height * 4;
+		image.Pixels.assign( pixels, pixels + image_size );
+		stbi_image_free( pixels );
+		return image;
+	}
+
+	Expected<VulkanTexture> Context::CreateTexture( const VulkanImageData& image )
+	{
+		VkResult err;
+
+		const int32 width = image.Width;
+		const int32 height = image.Height;
+		VkDeviceSize image_size = image.Pixels.size();
 
 		auto staging_buffer_result = CreateBuffer( image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
@@ -1555,14 +2152,11 @@ namespace VulkanRHI
 		err = vkMapMemory( Device, staging_buffer.Memory, offset, image_size, memory_flags, &data );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format( "[Vulkan] Failed to map memory. vkMapMemory returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::MapMemory, err ) );
 		}
-		memcpy( data, pixels, static_cast<size_t>( image_size ) );
+		memcpy( data, image.Pixels.data(), static_cast<size_t>( image_size ) );
 		vkUnmapMemory( Device, staging_buffer.Memory );
 
-		stbi_image_free( pixels );
-
 		auto texture_image_result = CreateTextureImage( width, height, VK_FORMAT_R8G8B8A8_SRGB,
 			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -1582,7 +2176,7 @@ namespace VulkanRHI
 
 		TransitionImageLayout( texture, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
-		staging_buffer.Destroy( Device );
+		DeletionQueue.RetireResource( UploadValue, staging_buffer );
 
 		auto view_result = CreateImageView( texture.Image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT );
 		if ( !view_result )
@@ -1598,12 +2192,8 @@ namespace VulkanRHI
 		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		sampler_info.anisotropyEnable = true;
-
-		VkPhysicalDeviceProperties physical_props = {};
-		vkGetPhysicalDeviceProperties( Gpu, &physical_props );
-
-		sampler_info.maxAnisotropy = physical_props.limits.maxSamplerAnisotropy;
+		sampler_info.anisotropyEnable = Capabilities.Features.samplerAnisotropy;
+		sampler_info.maxAnisotropy = Capabilities.Properties.limits.maxSamplerAnisotropy;
 		sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		sampler_info.unnormalizedCoordinates = false;
 		sampler_info.compareEnable = false;
@@ -1613,44 +2203,48 @@ namespace VulkanRHI
 		sampler_info.minLod = 0.0f;
 		sampler_info.maxLod = 0.0f;
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 		err = vkCreateSampler( Device, &sampler_info, alloc, &texture.Sampler );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan texture sampler. vkCreateSampler returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateSampler, err ) );
 		}
 		return texture;
 	}
 
 	Expected<VulkanTexture> Context::CreateTextureImage( int32 width, int32 height,
-		VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memory_props )
+		VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memory_props,
+		uint32 mip_levels, bool shared, uint32 array_layers )
 	{
 		VkResult err;
 		VulkanTexture texture;
+		texture.Format = format;
 		VkImageCreateInfo image_info = {};
 		image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		image_info.imageType = VK_IMAGE_TYPE_2D;
 		image_info.extent.width = static_cast< uint32 >( width );
 		image_info.extent.height = static_cast< uint32 >( height );
 		image_info.extent.depth = 1;
-		image_info.mipLevels = 1;
-		image_info.arrayLayers = 1;
+		image_info.mipLevels = mip_levels;
+		image_info.arrayLayers = array_layers;
 		image_info.format = format;
 		image_info.tiling = tiling;
 		image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		image_info.usage = usage;
 		image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if ( shared && !SharedQueueFamilies.empty() )
+		{
+			image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			image_info.queueFamilyIndexCount = static_cast< uint32 >( SharedQueueFamilies.size() );
+			image_info.pQueueFamilyIndices = SharedQueueFamilies.data();
+		}
 		image_info.samples = VK_SAMPLE_COUNT_1_BIT;
 
-		const VkAllocationCallbacks* alloc = nullptr;
+		const VkAllocationCallbacks* alloc = Allocator;
 		err = vkCreateImage( Device, &image_info, alloc, &texture.Image );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to create Vulkan texture image. vkCreateImage returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::CreateImage, err ) );
 		}
 
 		VkMemoryRequirements memory_requirements = {};
@@ -1661,21 +2255,17 @@ namespace VulkanRHI
 		allocate_info.allocationSize = memory_requirements.size;
 		allocate_info.memoryTypeIndex = FindMemoryType( memory_requirements.memoryTypeBits, memory_props );
 
-		err = vkAllocateMemory( Device, &allocate_info, alloc, &texture.Memory );
+		err = AllocateDeviceMemory( Device, allocate_info, alloc, &texture.Memory );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to allocate memory for Vulkan texture. vkAllocateMemory returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::AllocateMemory, err ) );
 		}
 
 		const VkDeviceSize memory_offset = 0;
 		err = vkBindImageMemory( Device, texture.Image, texture.Memory, memory_offset );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to bind Vulkan texture memory. vkBindImageMemory returned: {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::BindImageMemory, err ) );
 		}
 		return texture;
 	}
@@ -1693,8 +2283,12 @@ namespace VulkanRHI
 
 		const int32 width = Swapchain.Extent.width;
 		const int32 height = Swapchain.Extent.height;
+		// sampled by the Hi-Z pyramid build, which may run on the compute queue
+		const uint32 mip_levels = 1;
+		const bool   shared = true;
 		auto texture_image_result = CreateTextureImage( width, height, format, VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mip_levels, shared );
 		if ( !texture_image_result )
 		{
 			return std::unexpected( texture_image_result.error() );
@@ -1708,34 +2302,198 @@ namespace VulkanRHI
 		}
 		texture.View = std::move( view_result.value() );
 
-		TransitionImageLayout( texture, format, VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+		auto sampler_result = CreatePointSampler( 0.0f );
+		if ( !sampler_result )
+		{
+			return std::unexpected( sampler_result.error() );
+		}
+		texture.Sampler = sampler_result.value();
 
+		// no layout transition, the first render pass of every frame starts from an undefined depth layout
+		// and recreating the texture on resize does not have to wait for the queue
 		return texture;
 	}
 
-	void Context::RecordCommandBuffer( uint32 image_index )
+	Expected<VkSampler> Context::CreatePointSampler( float max_lod )
 	{
-		VkResult err;
-		VkCommandBufferBeginInfo begin_info = {};
-		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		VkSamplerCreateInfo sampler_info = {};
+		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler_info.magFilter = VK_FILTER_NEAREST;
+		sampler_info.minFilter = VK_FILTER_NEAREST;
+		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		sampler_info.minLod = 0.0f;
+		sampler_info.maxLod = max_lod;
 
-		err = vkBeginCommandBuffer( CommandBuffers[CurrentFrame], &begin_info );
+		const VkAllocationCallbacks* alloc = Allocator;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkResult err = vkCreateSampler( Device, &sampler_info, alloc, &sampler );
 		if ( err != VK_SUCCESS )
 		{
-			LOG_ERROR(
-				"[Vulkan] Error beginning recording Vulkan Command Buffer. "
-				"vkBeginCommandBuffer returned: {}.",
-				err );
-			throw std::runtime_error( "failed to begin recording command buffer" );
+			return std::unexpected( Error( ErrorCode::CreateSampler, err ) );
+		}
+		return sampler;
+	}
+
+	void Context::SchedulePasses( uint32 image_index )
+	{
+		Stats.Reset();
+
+		// phase 0 draws what was visible last frame, the depth it produces feeds the Hi-Z pyramid that
+		// phase 1 tests every object against; whatever became visible is drawn on top
+		if ( OcclusionCulling )
+		{
+			VulkanPass early_cull;
+			early_cull.Name = "EarlyCull";
+			early_cull.Queue = VulkanQueueType::AsyncCompute;
+			early_cull.Record = [this] ( VkCommandBuffer command_buffer ) {
+				RecordOcclusionCull( command_buffer, 0 );
+			};
+			Scheduler.AddPass( std::move( early_cull ) );
+		}
+
+		// lights are assigned to clusters before anything is shaded, next to the early cull on the same queue
+		VulkanPass light_cull;
+		light_cull.Name = "LightCull";
+		light_cull.Queue = VulkanQueueType::AsyncCompute;
+		light_cull.Record = [this] ( VkCommandBuffer command_buffer ) {
+			RecordLightCull( command_buffer );
+		};
+		Scheduler.AddPass( std::move( light_cull ) );
+
+		// consumes nothing from compute, it shares the submission of the early draw which sets the wait stages
+		VulkanPass shadows;
+		shadows.Name = "Shadows";
+		shadows.Queue = VulkanQueueType::Graphics;
+		shadows.WaitStages = 0;
+		shadows.Record = [this] ( VkCommandBuffer command_buffer ) {
+			RecordSceneTimestamp( command_buffer, true );
+			RecordShadows( command_buffer );
+		};
+		Scheduler.AddPass( std::move( shadows ) );
+
+		VulkanPass early_draw;
+		early_draw.Name = "EarlyDraw";
+		early_draw.Queue = VulkanQueueType::Graphics;
+		early_draw.WaitStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		early_draw.Record = [this] ( VkCommandBuffer command_buffer ) {
+			RecordLightBarrier( command_buffer );
+			BeginScenePass( command_buffer, 0 );
+			RecordDrawBatches( command_buffer, 0 );
+			EndScenePass( command_buffer );
+			if ( OcclusionCulling )
+			{
+				RecordDepthBarrier( command_buffer, true );
+			}
+		};
+		Scheduler.AddPass( std::move( early_draw ) );
+
+		if ( OcclusionCulling )
+		{
+			VulkanPass hiz_build;
+			hiz_build.Name = "HiZBuild";
+			hiz_build.Queue = VulkanQueueType::AsyncCompute;
+			hiz_build.WaitStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			hiz_build.Record = [this] ( VkCommandBuffer command_buffer ) {
+				RecordHiZBuild( command_buffer );
+			};
+			Scheduler.AddPass( std::move( hiz_build ) );
+
+			VulkanPass late_cull;
+			late_cull.Name = "LateCull";
+			late_cull.Queue = VulkanQueueType::AsyncCompute;
+			late_cull.WaitStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			late_cull.Record = [this] ( VkCommandBuffer command_buffer ) {
+				RecordOcclusionCull( command_buffer, 1 );
+			};
+			Scheduler.AddPass( std::move( late_cull ) );
+		}
+
+		// the depth barrier back to the attachment layout starts at the compute stage
+		VulkanPass late_draw;
+		late_draw.Name = "LateDraw";
+		late_draw.Queue = VulkanQueueType::Graphics;
+		late_draw.WaitStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		late_draw.Record = [this] ( VkCommandBuffer command_buffer ) {
+			if ( OcclusionCulling )
+			{
+				RecordDepthBarrier( command_buffer, false );
+			}
+			BeginScenePass( command_buffer, 1 );
+			if ( OcclusionCulling )
+			{
+				RecordDrawBatches( command_buffer, 1 );
+			}
+			EndScenePass( command_buffer );
+			RecordSceneTimestamp( command_buffer, false );
+		};
+		Scheduler.AddPass( std::move( late_draw ) );
+
+		// the frame only waits for its swapchain image here, before the tonemap pass or the blit writes it
+		VulkanPass post_process;
+		post_process.Name = "PostProcess";
+		post_process.Queue = VulkanQueueType::Graphics;
+		post_process.WaitStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		post_process.WritesSwapchainImage = true;
+		post_process.Record = [this, image_index] ( VkCommandBuffer command_buffer ) {
+			RecordPostProcess( command_buffer, image_index );
+		};
+		Scheduler.AddPass( std::move( post_process ) );
+	}
+
+	void Context::BeginScenePass( VkCommandBuffer command_buffer, uint32 phase )
+	{
+		if ( DynamicRendering )
+		{
+			BeginDynamicRendering( command_buffer, phase );
+		}
+		else
+		{
+			BeginRenderPass( command_buffer, phase );
+		}
+
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast< float >( DynamicResolution.RenderExtent.width );
+		viewport.height = static_cast< float >( DynamicResolution.RenderExtent.height );
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport( command_buffer, 0, 1, &viewport );
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0,0 };
+		scissor.extent = DynamicResolution.RenderExtent;
+		vkCmdSetScissor( command_buffer, 0, 1, &scissor );
+
+		const VkDeviceSize offset = 0;
+		vkCmdBindIndexBuffer( command_buffer, IndexBuffer.Instance, offset, VK_INDEX_TYPE_UINT16 );
+	}
+
+	void Context::EndScenePass( VkCommandBuffer command_buffer )
+	{
+		if ( DynamicRendering )
+		{
+			DeviceFunctions.CmdEndRendering( command_buffer );
+		}
+		else
+		{
+			vkCmdEndRenderPass( command_buffer );
 		}
+	}
 
+	void Context::BeginRenderPass( VkCommandBuffer command_buffer, uint32 phase )
+	{
 		VkRenderPassBeginInfo render_pass_info = {};
 		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_info.renderPass = GraphicsPipeline.RenderPass;
-		render_pass_info.framebuffer = Swapchain.Framebuffers[image_index];
+		render_pass_info.renderPass = phase == 0 ? GraphicsPipeline.RenderPass : GraphicsPipeline.ResumeRenderPass;
+		render_pass_info.framebuffer = HdrTargets.SceneFramebuffer;
+		// the targets are swapchain sized, the scene covers the top left part of them at the render scale
 		render_pass_info.renderArea.offset = { 0,0 };
-		render_pass_info.renderArea.extent = Swapchain.Extent;
+		render_pass_info.renderArea.extent = DynamicResolution.RenderExtent;
 
 		std::array<VkClearValue, 2> colors = {};
 		colors[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -1744,72 +2502,114 @@ namespace VulkanRHI
 		render_pass_info.clearValueCount = static_cast< uint32 >( colors.size() );
 		render_pass_info.pClearValues = colors.data();
 
-		vkCmdBeginRenderPass( CommandBuffers[CurrentFrame], &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
-		vkCmdBindPipeline( CommandBuffers[CurrentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS,
-			GraphicsPipeline.Instance );
+		vkCmdBeginRenderPass( command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
+	}
 
-		VkBuffer vertex_buffers[] = { VertexBuffer.Instance };
-		VkDeviceSize offsets[] = { 0 };
+	void Context::RecordDrawBatches( VkCommandBuffer command_buffer, uint32 phase )
+	{
+		// batches arrive sorted by state, so only changes between neighbours are emitted
+		uint32   bound_pipeline = UINT32_MAX;
+		uint32   bound_uniform_offset = UINT32_MAX;
+		VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
 
-		const uint32 first_binding = 0;
-		const uint32 binding_count = 1;
-		vkCmdBindVertexBuffers( CommandBuffers[CurrentFrame], first_binding, binding_count, vertex_buffers,
-			offsets );
+		for ( const VulkanDrawBatch& batch : DrawBatches )
+		{
+			const VulkanMesh& mesh = Meshes[batch.Mesh];
+			const VulkanMeshLod& lod = mesh.Lods[batch.Lod];
 
-		const VkDeviceSize offset = 0;
-		vkCmdBindIndexBuffer( CommandBuffers[CurrentFrame], IndexBuffer.Instance, offset, VK_INDEX_TYPE_UINT16 );
+			bool pipeline_changed = false;
+			if ( batch.Pipeline != bound_pipeline )
+			{
+				vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+					GraphicsPipeline.Variants[batch.Pipeline].Instance );
+				bound_pipeline = batch.Pipeline;
+				pipeline_changed = true;
+				++Stats.PipelineBinds;
+			}
+			else
+			{
+				++Stats.SkippedBinds;
+			}
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast< float >( Swapchain.Extent.width );
-		viewport.height = static_cast< float >( Swapchain.Extent.height );
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport( CommandBuffers[CurrentFrame], 0, 1, &viewport );
+			if ( bound_vertex_buffer != VertexBuffer.Instance )
+			{
+				std::array<VkBuffer, 2> vertex_buffers = { VertexBuffer.Instance, InstanceRing.Buffer.Instance };
+				std::array<VkDeviceSize, 2> offsets = { 0, 0 };
+
+				const uint32 first_binding = 0;
+				vkCmdBindVertexBuffers( command_buffer, first_binding,
+					static_cast< uint32 >( vertex_buffers.size() ), vertex_buffers.data(), offsets.data() );
+				bound_vertex_buffer = VertexBuffer.Instance;
+				++Stats.VertexBufferBinds;
+			}
+			else
+			{
+				++Stats.SkippedBinds;
+			}
 
-		VkRect2D scissor = {};
-		scissor.offset = { 0,0 };
-		scissor.extent = Swapchain.Extent;
-		vkCmdSetScissor( CommandBuffers[CurrentFrame], 0, 1, &scissor );
-
-		const uint32  first_set = 0;
-		const uint32  descriptor_set_count = 1;
-		const uint32  dynamic_offset_count = 0;
-		const uint32* dynamic_offsets = nullptr;
-		vkCmdBindDescriptorSets(
-			CommandBuffers[CurrentFrame],
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			GraphicsPipeline.Layout,
-			first_set,
-			descriptor_set_count,
-			&DescriptorGroup.Sets[CurrentFrame],
-			dynamic_offset_count,
-			dynamic_offsets
-		);
-
-		const uint32 instance_count = 1;
-		const uint32 first_index = 0;
-		const int32  vertex_offset = 0;
-		const uint32 first_instance = 0;
-		vkCmdDrawIndexed(
-			CommandBuffers[CurrentFrame],
-			static_cast< uint32 >( INDICES.size() ),
-			instance_count,
-			first_index,
-			vertex_offset,
-			first_instance
-		);
-
-		vkCmdEndRenderPass( CommandBuffers[CurrentFrame] );
-
-		err = vkEndCommandBuffer( CommandBuffers[CurrentFrame] );
-		if ( err != VK_SUCCESS )
-		{
-			LOG_ERROR(
-				"[Vulkan] Error ending recording Vulkan Command Buffer. vkEndCommandBuffer returned: {}.",
-				err );
-			throw std::runtime_error( "failed to end recording command buffer" );
+			if ( pipeline_changed || batch.UniformOffset != bound_uniform_offset )
+			{
+				const uint32 first_set = 0;
+				const uint32 descriptor_set_count = 1;
+				const uint32 dynamic_offset_count = 1;
+				vkCmdBindDescriptorSets(
+					command_buffer,
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					GraphicsPipeline.Layout,
+					first_set,
+					descriptor_set_count,
+					&DescriptorGroup.Sets[CurrentFrame],
+					dynamic_offset_count,
+					&batch.UniformOffset
+				);
+				bound_uniform_offset = batch.UniformOffset;
+				++Stats.DescriptorBinds;
+			}
+			else
+			{
+				++Stats.SkippedBinds;
+			}
+
+			if ( phase == 0 )
+			{
+				Stats.Instances += batch.InstanceCount;
+				Stats.Triangles += lod.IndexCount / 3 * batch.InstanceCount;
+			}
+
+			if ( !OcclusionCulling )
+			{
+				vkCmdDrawIndexed(
+					command_buffer,
+					lod.IndexCount,
+					batch.InstanceCount,
+					lod.FirstIndex,
+					mesh.VertexOffset,
+					batch.FirstInstance
+				);
+				++Stats.DrawCalls;
+				continue;
+			}
+
+			// one command per instance written by cull.comp, culled ones have an instance count of zero
+			const VkDeviceSize stride = VulkanOcclusionCuller::COMMAND_STRIDE;
+			const VkDeviceSize first_command = phase * Culler.ObjectCount + batch.FirstSlot;
+			const VkDeviceSize commands_offset = CurrentFrame * Culler.DrawCommandsFrameSize + first_command * stride;
+			if ( MultiDrawIndirect )
+			{
+				vkCmdDrawIndexedIndirect( command_buffer, Culler.DrawCommands.Instance, commands_offset,
+					batch.InstanceCount, static_cast< uint32 >( stride ) );
+				++Stats.DrawCalls;
+			}
+			else
+			{
+				for ( uint32 i = 0; i < batch.InstanceCount; ++i )
+				{
+					const uint32 draw_count = 1;
+					vkCmdDrawIndexedIndirect( command_buffer, Culler.DrawCommands.Instance,
+						commands_offset + i * stride, draw_count, static_cast< uint32 >( stride ) );
+					++Stats.DrawCalls;
+				}
+			}
 		}
 	}
 
@@ -1826,10 +2626,7 @@ namespace VulkanRHI
 		err = vkAllocateCommandBuffers( Device, &allocate_info, &command_buffer );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to allocate command buffers. vkAllocateCommandBuffers returned {}.",
-				err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::AllocateCommandBuffers, err ) );
 		}
 
 		VkCommandBufferBeginInfo begin_info = {};
@@ -1839,46 +2636,65 @@ namespace VulkanRHI
 		err = vkBeginCommandBuffer( command_buffer, &begin_info );
 		if ( err != VK_SUCCESS )
 		{
-			std::string message = std::format(
-				"[Vulkan] Failed to begin command buffer. vkBeginCommandBuffer returned {}.", err );
-			return std::unexpected( message );
+			return std::unexpected( Error( ErrorCode::BeginCommandBuffer, err ) );
 		}
 		return command_buffer;
 	}
 
-	void Context::EndSingleTimeCommands( VkCommandBuffer command_buffer )
+	uint64 Context::EndSingleTimeCommands( VkCommandBuffer command_buffer )
 	{
 		VkResult err;
 		err = vkEndCommandBuffer( command_buffer );
 		if ( err != VK_SUCCESS )
 		{
-			LOG_ERROR( "[Vulkan] Failed to end command buffer. vkEndCommandBuffer returned {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::EndCommandBuffer, err ) );
 			throw std::runtime_error( "vkEndCommandBuffer failed" );
 		}
 
+		const uint64      value = DeletionQueue.Advance();
+		const VkSemaphore timeline = DeletionQueue.GetTimeline();
+
+		VkTimelineSemaphoreSubmitInfo timeline_info = {};
+		timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_info.signalSemaphoreValueCount = 1;
+		timeline_info.pSignalSemaphoreValues = &value;
+
 		VkSubmitInfo submit_info = {};
 		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.pNext = timeline ? &timeline_info : nullptr;
 		submit_info.commandBufferCount = 1;
 		submit_info.pCommandBuffers = &command_buffer;
+		submit_info.signalSemaphoreCount = timeline ? 1 : 0;
+		submit_info.pSignalSemaphores = &timeline;
 
 		const VkFence fence = VK_NULL_HANDLE;
 		err = vkQueueSubmit( GraphicsQueue, 1, &submit_info, fence );
 		if ( err != VK_SUCCESS )
 		{
-			LOG_ERROR( "[Vulkan] Failed to submit queue. vkQueueSubmit returned {}.", err );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::QueueSubmit, err ) );
 			throw std::runtime_error( "vkQueueSubmit failed" );
 		}
 
-		err = vkQueueWaitIdle( GraphicsQueue );
-		if ( err != VK_SUCCESS )
+		// nothing else would tell when the submission completed
+		if ( !timeline )
 		{
-			LOG_ERROR(
-				"[Vulkan] Failed to wait for queue idle. vkQueueWaitIdle returned {}.", err );
-			throw std::runtime_error( "vkQeueuWaitIdle failed" );
+			err = vkQueueWaitIdle( GraphicsQueue );
+			if ( err != VK_SUCCESS )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", Error( ErrorCode::QueueWaitIdle, err ) );
+				throw std::runtime_error( "vkQeueuWaitIdle failed" );
+			}
+			DeletionQueue.MarkCompleted( value );
 		}
+		UploadValue = value;
 
-		const uint32 command_buffer_count = 1;
-		vkFreeCommandBuffers( Device, CommandPool, command_buffer_count, &command_buffer );
+		const VkCommandPool command_pool = CommandPool;
+		DeletionQueue.Retire( value, [command_pool, command_buffer] ( VkDevice device,
+			const VkAllocationCallbacks* ) {
+			const uint32 command_buffer_count = 1;
+			vkFreeCommandBuffers( device, command_pool, command_buffer_count, &command_buffer );
+		} );
+		return value;
 	}
 
 	void Context::TransitionImageLayout( const VulkanTexture& texture, VkFormat format,
@@ -1887,7 +2703,7 @@ namespace VulkanRHI
 		auto command_buffer_result = BeginSingleTimeCommands();
 		if ( !command_buffer_result )
 		{
-			LOG_ERROR( command_buffer_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", command_buffer_result.error() );
 			throw std::runtime_error( "BeginSingleTimeCommands failed" );
 		}
 		VkCommandBuffer command_buffer = std::move( command_buffer_result.value() );
@@ -1976,7 +2792,7 @@ namespace VulkanRHI
 		auto command_buffer_result = BeginSingleTimeCommands();
 		if ( !command_buffer_result )
 		{
-			LOG_ERROR( command_buffer_result.error() );
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", command_buffer_result.error() );
 			throw std::runtime_error( "BeginSingleTimeCommands failed" );
 		}
 		VkCommandBuffer command_buffer = std::move( command_buffer_result.value() );
@@ -2026,7 +2842,7 @@ namespace VulkanRHI
 			}
 		}
 
-		return std::unexpected( "[Vulkan] Failed to find supported format." );
+		return std::unexpected( Error( ErrorCode::UnsupportedFormat, VK_ERROR_FORMAT_NOT_SUPPORTED ) );
 	}
 
 	Expected<VkFormat> Context::FindDepthFormat()
@@ -2037,7 +2853,17 @@ namespace VulkanRHI
 			VK_FORMAT_D24_UNORM_S8_UINT
 		};
 		return FindSupportedFormat( formats, VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT );
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT );
+	}
+
+	VkImageAspectFlags Context::GetDepthAspect( VkFormat format )
+	{
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		if ( format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT )
+		{
+			aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		return aspect;
 	}
 
 } // namespace VulkanRHI 
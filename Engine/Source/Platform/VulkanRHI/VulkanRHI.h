@@ -3,15 +3,34 @@
 #pragma once
 
 #include <span>
+#include <array>
 #include <vector>
+#include <chrono>
+#include <cstring>
 #include <string>
 #include <utility>
 #include <optional>
+#include <filesystem>
 #include <expected>
 
 #include <vulkan/vulkan.h>
 
 #include "Engine/RHI/RHI.h"
+#include "Engine/Renderer/RenderQueue.h"
+#include "Engine/Renderer/RenderStats.h"
+#include "Engine/Core/FileWatcher.h"
+#include "Engine/Core/Memory.h"
+#include "Engine/Scene/BVH.h"
+#include "VulkanMath.h"
+#include "VulkanError.h"
+#include "VulkanDevice.h"
+#include "VulkanMemory.h"
+#include "VulkanDeletionQueue.h"
+#include "VulkanPassScheduler.h"
+#include "ShaderCompiler.h"
+#include "SpirvReflection.h"
+#include "ShaderPermutation.h"
+#include "PipelineLayoutCache.h"
 
 struct SDL_Window;
 
@@ -23,41 +42,38 @@ struct VulkanContextCreateInfo
 	std::vector<const char*> Layers;
 	const char* ApplicationName;
 	const char* EngineName;
+	// use VK_KHR_dynamic_rendering when the GPU supports it, render pass and framebuffer objects otherwise
+	bool AllowDynamicRendering = true;
+	// run culling and the Hi-Z build on a dedicated compute queue when the GPU has one
+	bool AllowAsyncCompute = true;
 };
 
 namespace VulkanRHI 
 {
 
-	template<typename VkType>
-	using Expected = std::expected<VkType, std::string>;
-
-	struct VulkanQueueFamilyIndices
+	// Device level extension entry points, the loader library only exports core functions.
+	struct VulkanDeviceFunctions
 	{
-		std::optional<uint32> Graphics;
-		std::optional<uint32> Present;
-
-		bool IsComplete() const
-		{
-			return Graphics.has_value() && Present.has_value();
-		}
+		PFN_vkCmdBeginRenderingKHR   CmdBeginRendering = nullptr;
+		PFN_vkCmdEndRenderingKHR     CmdEndRendering = nullptr;
+		PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2 = nullptr;
 	};
 
 	struct VulkanSwapchain
 	{
-		VkSwapchainKHR Instance = VK_NULL_HANDLE;
-		VkFormat       Format = VK_FORMAT_UNDEFINED;
-		VkExtent2D     Extent = {};
+		VkSwapchainKHR   Instance = VK_NULL_HANDLE;
+		VkFormat         Format = VK_FORMAT_UNDEFINED;
+		VkColorSpaceKHR  ColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+		VkPresentModeKHR PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+		VkExtent2D       Extent = {};
 		std::vector<VkImage> Images;
+		// empty when the images are blitted to
 		std::vector<VkImageView> ImageViews;
-		std::vector<VkFramebuffer> Framebuffers;
+		// the tonemap pass writes the images, otherwise its result is blitted to them
+		bool             StorageImages = false;
 
 		void Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
 		{
-			for ( auto framebuffer : Framebuffers )
-			{
-				vkDestroyFramebuffer( device, framebuffer, alloc );
-			}
-
 			for ( auto image_view : ImageViews )
 			{
 				vkDestroyImageView( device, image_view, alloc );
@@ -67,22 +83,83 @@ namespace VulkanRHI
 		}
 	};
 
+	struct VulkanShader
+	{
+		VkShaderModule   Module = VK_NULL_HANDLE;
+		// SPIR-V read by ReadShader, released once the module exists
+		std::vector<char> Code;
+		ShaderReflection Reflection;
+		// specialization constants the pipeline is created with, one 32-bit value per entry
+		std::vector<VkSpecializationMapEntry> SpecializationEntries;
+		std::vector<uint32>                   SpecializationData;
+
+		VkSpecializationInfo GetSpecializationInfo() const
+		{
+			VkSpecializationInfo info = {};
+			info.mapEntryCount = static_cast< uint32 >( SpecializationEntries.size() );
+			info.pMapEntries = SpecializationEntries.data();
+			info.dataSize = SpecializationData.size() * sizeof( uint32 );
+			info.pData = SpecializationData.data();
+			return info;
+		}
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyShaderModule( device, Module, alloc );
+		}
+	};
+
+	// RGBA8 pixels decoded on a startup worker, uploaded once the device exists
+	struct VulkanImageData
+	{
+		int32              Width = 0;
+		int32              Height = 0;
+		std::vector<uint8> Pixels;
+	};
+
+	struct VulkanPipelineVariant
+	{
+		// sorted by name
+		std::vector<ShaderKeyword> Keywords;
+		VkPipeline                 Instance = VK_NULL_HANDLE;
+	};
+
+	// Layout and DescriptorSetLayout (set 0) belong to the PipelineLayoutCache. Every variant shares
+	// them, the one at index 0 has no keywords.
 	struct VulkanGraphicsPipeline
 	{
+		// both render passes are null with dynamic rendering
 		VkRenderPass     RenderPass = VK_NULL_HANDLE;
+		// same attachments as RenderPass but loads them, used to continue drawing after compute work
+		VkRenderPass     ResumeRenderPass = VK_NULL_HANDLE;
 		VkPipelineLayout Layout = VK_NULL_HANDLE;
-		VkPipeline       Instance = VK_NULL_HANDLE;
 		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		std::vector<VulkanPipelineVariant> Variants;
 
 		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
 		{
-			vkDestroyDescriptorSetLayout( device, DescriptorSetLayout, alloc );
-			vkDestroyPipeline( device, Instance, alloc );
-			vkDestroyPipelineLayout( device, Layout, alloc );
+			for ( const VulkanPipelineVariant& variant : Variants )
+			{
+				vkDestroyPipeline( device, variant.Instance, alloc );
+			}
+			vkDestroyRenderPass( device, ResumeRenderPass, alloc );
 			vkDestroyRenderPass( device, RenderPass, alloc );
 		}
 	};
 
+	// Layout and DescriptorSetLayout (set 0) belong to the PipelineLayoutCache.
+	struct VulkanComputePipeline
+	{
+		VkDescriptorSetLayout DescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout      Layout = VK_NULL_HANDLE;
+		VkPipeline            Instance = VK_NULL_HANDLE;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyPipeline( device, Instance, alloc );
+		}
+	};
+
 	struct VulkanSyncObjects
 	{
 		VkSemaphore ImageAvailableSemaphore = VK_NULL_HANDLE;
@@ -106,8 +183,106 @@ namespace VulkanRHI
 		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
 		{
 			vkDestroyBuffer( device, Instance, alloc );
-			vkFreeMemory( device, Memory, alloc );
+			FreeDeviceMemory( device, Memory, alloc );
+		}
+	};
+
+	// One large persistently mapped buffer split into a region per frame in flight. Per-draw data
+	// (uniforms, instance streams) is appended linearly into the current frame's region and bound
+	// through dynamic offsets, so the per-object cost is a memcpy.
+	struct VulkanFrameRing
+	{
+		VulkanBuffer Buffer;
+		VkDeviceSize Alignment = 0;
+		VkDeviceSize FrameCapacity = 0;
+		VkDeviceSize FrameBase = 0;
+		VkDeviceSize Head = 0;
+
+		void BeginFrame( uint32 frame )
+		{
+			FrameBase = frame * FrameCapacity;
+			Head = 0;
+		}
+
+		// returns the offset relative to the frame's region or nullopt if the region is full
+		std::optional<uint32> Push( const void* data, VkDeviceSize size )
+		{
+			const VkDeviceSize aligned_size = ( size + Alignment - 1 ) & ~( Alignment - 1 );
+			if ( Head + aligned_size > FrameCapacity )
+			{
+				return std::nullopt;
+			}
+
+			const VkDeviceSize offset = Head;
+			memcpy( static_cast< uint8* >( Buffer.Mapped ) + FrameBase + offset, data, size );
+			Head += aligned_size;
+			return static_cast< uint32 >( offset );
+		}
+
+		VkDeviceSize AbsoluteOffset( uint32 offset ) const
+		{
+			return FrameBase + offset;
 		}
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			Buffer.Destroy( device, alloc );
+		}
+	};
+
+	// Index range of one level of detail. Every level indexes the vertices of the full mesh.
+	struct VulkanMeshLod
+	{
+		uint32 FirstIndex = 0;
+		uint32 IndexCount = 0;
+		// local space distance the simplified surface deviates from the full one by
+		float  Error = 0.0f;
+	};
+
+	// A range inside the shared vertex and index buffers, level 0 is the full mesh.
+	struct VulkanMesh
+	{
+		static constexpr uint32 MAX_LODS = 4;
+		// every level aims for this share of the indices of the previous one
+		static constexpr float LOD_REDUCTION = 0.25f;
+		// a level is dropped, with all coarser ones, when it keeps more than this share of the previous one
+		static constexpr float LOD_MIN_REDUCTION = 0.75f;
+		// screen space error in pixels a level may show
+		static constexpr float LOD_ERROR_PIXELS = 1.0f;
+		// share of LOD_ERROR_PIXELS a coarser level has to stay below, keeps objects near a switching
+		// distance from flipping between two levels every frame
+		static constexpr float LOD_HYSTERESIS = 0.25f;
+
+		std::array<VulkanMeshLod, MAX_LODS> Lods = {};
+		uint32 LodCount = 0;
+		int32  VertexOffset = 0;
+		Bounds LocalBounds;
+	};
+
+	struct VulkanRenderObject
+	{
+		glm::mat4 Transform = glm::mat4( 1.0f );
+		uint32    Mesh = 0;
+		uint32    Material = 0;
+		// index into GraphicsPipeline.Variants
+		uint32    Pipeline = 0;
+		// level of detail picked the last time the object was visible
+		uint32    Lod = 0;
+	};
+
+	// Adjacent render queue items with the same state collapsed into a single instanced draw.
+	// Instances are addressed through FirstInstance so the instance ring stays bound for the whole frame.
+	struct VulkanDrawBatch
+	{
+		uint32 Pipeline = 0;
+		uint32 Mesh = 0;
+		uint32 Lod = 0;
+		uint32 Material = 0;
+		uint32 UniformOffset = 0;
+		uint32 FirstInstance = 0;
+		uint32 InstanceCount = 0;
+		// index of the first instance among all instances of the frame, addresses the culling commands
+		uint32 FirstSlot = 0;
 	};
 
 	struct VulkanDescriptorGroup
@@ -122,6 +297,7 @@ namespace VulkanRHI
 		VkImageView    View = VK_NULL_HANDLE;
 		VkSampler      Sampler = VK_NULL_HANDLE;
 		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkFormat       Format = VK_FORMAT_UNDEFINED;
 
 		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
 		{
@@ -131,7 +307,364 @@ namespace VulkanRHI
 			}
 			vkDestroyImageView( device, View, alloc );
 			vkDestroyImage( device, Image, alloc );
-			vkFreeMemory( device, Memory, alloc );
+			FreeDeviceMemory( device, Memory, alloc );
+		}
+	};
+
+	// Max-depth mip chain rebuilt from the depth texture every frame.
+	struct VulkanHiZPyramid
+	{
+		VulkanTexture                Texture;
+		VkExtent2D                   Extent = {};
+		uint32                       MipCount = 0;
+		std::vector<VkImageView>     MipViews;
+		VkDescriptorPool             DescriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> MipSets;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyDescriptorPool( device, DescriptorPool, alloc );
+			for ( auto view : MipViews )
+			{
+				vkDestroyImageView( device, view, alloc );
+			}
+			Texture.Destroy( device, alloc );
+		}
+	};
+
+	// Swapchain sized images of the HDR pipeline. The scene is drawn into the render extent of HdrTarget,
+	// the temporal pass resolves it into a full resolution History image, the rest of the post chain reads
+	// that and writes the swapchain image, or Output when the swapchain images cannot be storage images.
+	struct VulkanHdrTargets
+	{
+		VulkanTexture                HdrTarget;
+		// written in turns, History[Frame % 2] is resolved from the other one
+		std::array<VulkanTexture, 2> History;
+		// false until the first resolve, the temporal pass then takes the current frame as it is
+		bool                         HistoryValid = false;
+		// the HDR target and the depth texture, null with dynamic rendering
+		VkFramebuffer                SceneFramebuffer = VK_NULL_HANDLE;
+		// level 0 is half the HDR target, View covers every level for the tonemap pass
+		VulkanTexture                Bloom;
+		VkExtent2D                   BloomExtent = {};
+		uint32                       BloomMipCount = 0;
+		std::vector<VkImageView>     BloomMipViews;
+		// null when the swapchain images are written directly
+		VulkanTexture                Output;
+		VkDescriptorPool             DescriptorPool = VK_NULL_HANDLE;
+		// one per history image the frame resolves into
+		std::array<VkDescriptorSet, 2> TemporalSets = {};
+		std::array<VkDescriptorSet, 2> PrefilterSets = {};
+		// DownSets[i] writes level i + 1 from level i, UpSets[i] adds level i + 2 onto level i + 1
+		std::vector<VkDescriptorSet> DownSets;
+		std::vector<VkDescriptorSet> UpSets;
+		// one per swapchain image and history image, [history * image count + image]
+		std::vector<VkDescriptorSet> TonemapSets;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyDescriptorPool( device, DescriptorPool, alloc );
+			Output.Destroy( device, alloc );
+			for ( auto view : BloomMipViews )
+			{
+				vkDestroyImageView( device, view, alloc );
+			}
+			Bloom.Destroy( device, alloc );
+			for ( VulkanTexture& history : History )
+			{
+				history.Destroy( device, alloc );
+			}
+			vkDestroyFramebuffer( device, SceneFramebuffer, alloc );
+			HdrTarget.Destroy( device, alloc );
+		}
+	};
+
+	// Size dependent resources replaced by a swapchain recreation, retired to the first frame submitted after
+	// the recreation, every frame that could still use them was submitted before it.
+	struct VulkanRetiredSwapchain
+	{
+		VulkanSwapchain  Swapchain;
+		VulkanTexture    DepthTexture;
+		VulkanHiZPyramid HiZPyramid;
+		VulkanHdrTargets HdrTargets;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			HdrTargets.Destroy( device, alloc );
+			HiZPyramid.Destroy( device, alloc );
+			DepthTexture.Destroy( device, alloc );
+			Swapchain.Destroy( device, alloc );
+		}
+	};
+
+	// GPU side state of the two-phase occlusion culling. Objects are uploaded per frame, draw commands
+	// are written by cull.comp (early commands first, late commands after them) and the visibility of
+	// every object survives between frames.
+	struct VulkanOcclusionCuller
+	{
+		static constexpr VkDeviceSize COMMAND_STRIDE = sizeof( VkDrawIndexedIndirectCommand );
+
+		VulkanComputePipeline HiZPipeline;
+		VulkanComputePipeline CullPipeline;
+
+		VulkanFrameRing Objects;
+		VulkanBuffer    DrawCommands;
+		VkDeviceSize    DrawCommandsFrameSize = 0;
+		VulkanBuffer    Visibility;
+
+		VkDescriptorPool             DescriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> CullSets;
+		// swapchain generation whose pyramid each cull set samples
+		std::vector<uint32>          CullSetGenerations;
+
+		glm::mat4 ViewProjection = glm::mat4( 1.0f );
+		uint32    ObjectCount = 0;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyDescriptorPool( device, DescriptorPool, alloc );
+			Visibility.Destroy( device, alloc );
+			DrawCommands.Destroy( device, alloc );
+			Objects.Destroy( device, alloc );
+			CullPipeline.Destroy( device, alloc );
+			HiZPipeline.Destroy( device, alloc );
+		}
+	};
+
+	// Forward+ light assignment. The lights inside the view frustum are uploaded in view space every frame,
+	// clusters.comp splits the frustum into a froxel grid of screen tiles and exponential depth slices and
+	// writes the lights overlapping each cluster into a fixed size list that triangle.frag walks.
+	struct VulkanLightClusters
+	{
+		static constexpr uint32 GRID_X = 16;
+		static constexpr uint32 GRID_Y = 9;
+		static constexpr uint32 GRID_Z = 24;
+		static constexpr uint32 CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+		// lights past it are not shaded in that cluster, the heatmap still counts them
+		static constexpr uint32 MAX_LIGHTS_PER_CLUSTER = 256;
+
+		VulkanComputePipeline Pipeline;
+
+		VulkanFrameRing Lights;
+		// light count and light list of every cluster, per frame in flight, written by the compute queue
+		// and read by fragment shaders
+		VulkanBuffer    Counts;
+		VkDeviceSize    CountsFrameSize = 0;
+		VulkanBuffer    Indices;
+		VkDeviceSize    IndicesFrameSize = 0;
+
+		VkDescriptorPool             DescriptorPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSet> Sets;
+
+		glm::vec2 TanHalfFov = glm::vec2( 1.0f );
+		uint32    LightCount = 0;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyDescriptorPool( device, DescriptorPool, alloc );
+			Indices.Destroy( device, alloc );
+			Counts.Destroy( device, alloc );
+			Lights.Destroy( device, alloc );
+			Pipeline.Destroy( device, alloc );
+		}
+	};
+
+	// Depth only pipeline every shadow view is drawn with. Layout belongs to the PipelineLayoutCache.
+	struct VulkanShadowPipeline
+	{
+		VkFormat         Format = VK_FORMAT_UNDEFINED;
+		// null with dynamic rendering
+		VkRenderPass     RenderPass = VK_NULL_HANDLE;
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		VkPipeline       Instance = VK_NULL_HANDLE;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyPipeline( device, Instance, alloc );
+			vkDestroyRenderPass( device, RenderPass, alloc );
+		}
+	};
+
+	// A cascade or an atlas tile and what it was last rendered with, the map keeps its contents until then.
+	struct VulkanShadowView
+	{
+		glm::mat4 ViewProjection = glm::mat4( 1.0f );
+		glm::mat4 CasterTransform = glm::mat4( 1.0f );
+		// zero if it was never rendered
+		uint64    RenderedFrame = 0;
+		// atlas tiles only, the scene light and the cube face of a point light
+		uint32    Light = 0;
+		uint32    Face = 0;
+	};
+
+	// A shadow view rendered this frame, its casters are instanced draws out of the instance ring.
+	struct VulkanShadowPass
+	{
+		glm::mat4 Transform = glm::mat4( 1.0f );
+		// cascade layer, SHADOW_CASCADE_COUNT for the atlas
+		uint32    Target = 0;
+		VkRect2D  Rect = {};
+		uint32    FirstDraw = 0;
+		uint32    DrawCount = 0;
+	};
+
+	struct VulkanShadowDraw
+	{
+		uint32 Mesh = 0;
+		uint32 Lod = 0;
+		uint32 FirstInstance = 0;
+		uint32 InstanceCount = 0;
+	};
+
+	// Cascaded shadow maps of the sun and a shadow atlas for spot and point lights. Both stay in the shader
+	// read layout between frames and are only redrawn where a view went stale: the near cascades every
+	// frame, the far ones when their fit, the light or the casters changed, a bounded number of them per
+	// frame, oldest first. Atlas tiles follow the same rule with their own budget.
+	struct VulkanShadowMaps
+	{
+		static constexpr uint32 CASCADE_SIZE = 2048;
+		static constexpr uint32 ATLAS_SIZE = 2048;
+		static constexpr uint32 TILE_SIZE = 256;
+		static constexpr uint32 TILES_PER_ROW = ATLAS_SIZE / TILE_SIZE;
+		static constexpr uint32 TILE_COUNT = TILES_PER_ROW * TILES_PER_ROW;
+		// cascades from this one on are cached
+		static constexpr uint32 FIRST_CACHED_CASCADE = 2;
+		static constexpr uint32 CACHED_CASCADE_BUDGET = 1;
+		static constexpr uint32 TILE_BUDGET = 8;
+
+		VulkanShadowPipeline Pipeline;
+
+		// sampled as an array, rendered one layer at a time
+		VulkanTexture              CascadeTexture;
+		std::vector<VkImageView>   LayerViews;
+		VulkanTexture              AtlasTexture;
+		// one per cascade layer and the atlas last, empty with dynamic rendering
+		std::vector<VkFramebuffer> Framebuffers;
+		// depth comparison, shared by both maps
+		VkSampler                  Sampler = VK_NULL_HANDLE;
+		// matrices and rects of every tile, uploaded per frame
+		VulkanFrameRing            TileRing;
+
+		std::array<VulkanShadowView, SHADOW_CASCADE_COUNT> Cascades;
+		std::vector<VulkanShadowView> Tiles;
+		// first tile of every scene light, -1 for lights without shadows
+		std::vector<int32>            FirstTiles;
+
+		std::vector<VulkanShadowPass> Passes;
+		std::vector<VulkanShadowDraw> Draws;
+		std::vector<uint32>           Casters;
+		uint64                        Frame = 0;
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			TileRing.Destroy( device, alloc );
+			vkDestroySampler( device, Sampler, alloc );
+			for ( auto framebuffer : Framebuffers )
+			{
+				vkDestroyFramebuffer( device, framebuffer, alloc );
+			}
+			for ( auto view : LayerViews )
+			{
+				vkDestroyImageView( device, view, alloc );
+			}
+			AtlasTexture.Destroy( device, alloc );
+			CascadeTexture.Destroy( device, alloc );
+			Pipeline.Destroy( device, alloc );
+		}
+	};
+
+	// The compute passes between the HDR target and the swapchain and the state they keep across frames,
+	// the images they work on are in VulkanHdrTargets. The temporal pass upsamples the jittered scene into
+	// the history, the luminance histogram is built while the first bloom level is filtered and the last
+	// upsample happens in the tonemap pass, so the resolved image is read twice and written once.
+	struct VulkanPostProcess
+	{
+		// in the order they run
+		enum Stage : uint32
+		{
+			Temporal, Prefilter, Exposure, Downsample, Upsample, Tonemap, StageCount
+		};
+
+		static constexpr std::array<const char*, StageCount> SHADERS = {
+			"taa.comp", "bloom_prefilter.comp", "exposure.comp", "bloom_down.comp", "bloom_up.comp",
+			"tonemap.comp"
+		};
+
+		static constexpr VkFormat HDR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+		static constexpr VkFormat OUTPUT_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+		// matches the bin count of the shaders
+		static constexpr uint32   HISTOGRAM_BINS = 256;
+		static constexpr float    MIN_LOG_LUMINANCE = -10.0f;
+		static constexpr float    MAX_LOG_LUMINANCE = 6.0f;
+		// per second, the adapted luminance covers 1 - exp( -rate * seconds ) of the way to the frame's
+		static constexpr float    ADAPTATION_RATE = 1.5f;
+		static constexpr uint32   BLOOM_MIP_COUNT = 6;
+		static constexpr float    BLOOM_STRENGTH = 0.04f;
+		// length of the Halton (2, 3) jitter sequence
+		static constexpr uint32   JITTER_PHASES = 8;
+		// share of the current frame in the resolved one, the history keeps the rest
+		static constexpr float    TEMPORAL_BLEND = 0.1f;
+
+		std::array<VulkanComputePipeline, StageCount> Pipelines;
+		VulkanBuffer     Histogram;
+		// adapted average luminance, zero until the first frame was measured
+		VulkanBuffer     Exposure;
+		VkSampler        Sampler = VK_NULL_HANDLE;
+		VkDescriptorPool DescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet  ExposureSet = VK_NULL_HANDLE;
+
+		float  Adaptation = 1.0f;
+		uint32 Frame = 0;
+		std::chrono::steady_clock::time_point LastUpdate;
+
+		// unjittered projection, view and model of the last frame, the history was resolved with it
+		glm::mat4 PreviousViewProjection = glm::mat4( 1.0f );
+		// from the clip space of this frame, without jitter, to the clip space of the last frame
+		glm::mat4 Reprojection = glm::mat4( 1.0f );
+		// of the frame's projection, in texture coordinates of the output
+		glm::vec2 Jitter = glm::vec2( 0.0f );
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyDescriptorPool( device, DescriptorPool, alloc );
+			vkDestroySampler( device, Sampler, alloc );
+			Exposure.Destroy( device, alloc );
+			Histogram.Destroy( device, alloc );
+			for ( VulkanComputePipeline& pipeline : Pipelines )
+			{
+				pipeline.Destroy( device, alloc );
+			}
+		}
+	};
+
+	// Picks the resolution the scene is rendered at from the GPU time of the shadow and scene passes. Their
+	// timestamps are read back once the frame slot comes around again, the cost of the passes is taken to
+	// grow with the pixel count, the square of the scale.
+	struct VulkanDynamicResolution
+	{
+		// of the frame time at the target rate, the post chain and the compute passes need the rest
+		static constexpr float SCENE_BUDGET = 0.75f;
+		// below and above the budget the scale is left alone, so it does not oscillate around it
+		static constexpr float TOLERANCE = 0.05f;
+		// weight of the newest measurement in SceneMs
+		static constexpr float SMOOTHING = 0.1f;
+		// per frame, the history of the temporal pass stays usable while the scale moves
+		static constexpr float MAX_STEP = 0.02f;
+
+		// two timestamps per frame in flight, null when the queues cannot be timed
+		VkQueryPool         QueryPool = VK_NULL_HANDLE;
+		// per frame in flight, timestamps were written and not read back yet
+		std::vector<bool>   Pending;
+		// nanoseconds per timestamp tick
+		float               TimestampPeriod = 0.0f;
+		float               SceneMs = 0.0f;
+		float               Scale = 1.0f;
+		// the top left part of the scene targets the frame renders to
+		VkExtent2D          RenderExtent = {};
+
+		void inline Destroy( VkDevice device, const VkAllocationCallbacks* alloc = nullptr )
+		{
+			vkDestroyQueryPool( device, QueryPool, alloc );
 		}
 	};
 
@@ -161,60 +694,194 @@ namespace VulkanRHI
 			( void ) 0;
 		}
 
+		const RenderStats& GetRenderStats() const override
+		{
+			return Stats;
+		}
+
+		const RHICapabilities& GetCapabilities() const override
+		{
+			return PublishedCapabilities;
+		}
+
+		void SetPresentSettings( const PresentSettings& settings ) override;
+		void OnResize() override;
+		void SetDebugView( DebugView view ) override;
+		void SetResolutionSettings( const ResolutionSettings& settings ) override;
+
+		bool ExportMemorySnapshot( const std::filesystem::path& path ) override;
+
 	private:
 		static bool IsExtensionAvailable( const std::vector<VkExtensionProperties>& props,
 			const char* extension );
 		static bool IsLayerAvailable( const std::vector<VkLayerProperties>& props, const char* layer );
 
-		static Expected<VulkanQueueFamilyIndices> FindQueueFamilies( VkPhysicalDevice device, 
-			VkSurfaceKHR surface );
 
 	private:
 		Expected<VkInstance>       CreateInstance();
 		Expected<VkSurfaceKHR>     CreateSurface();
-		Expected<VkPhysicalDevice> SelectPhysicalDevice();
+		Expected<VulkanDeviceCandidate> SelectPhysicalDevice();
 		Expected<VkDevice>         CreateDevice( VulkanQueueFamilyIndices indices );
 		VkQueue          GetQueue( uint32 family_index, uint32 index );
+		bool             LoadDeviceFunctions();
 
-		Expected<VulkanSwapchain>  CreateSwapchain();
+		// queries the surface and negotiates format, present mode and image count with PresentConfig
+		Expected<VulkanSwapchain>  CreateSwapchain( VkSwapchainKHR old_swapchain = VK_NULL_HANDLE );
 		void RecreateSwapchain();
+		VkExtent2D GetWindowExtent() const;
 
 		Expected<VkShaderModule>         CreateShaderModule( const std::vector<char>& code );
-		Expected<VulkanGraphicsPipeline> CreateGraphicsPipeline( VkShaderModule vertex,
-			VkShaderModule fragment );
+		// source_name is relative to ShadersPath, keywords select the permutation and set the
+		// specialization constants, those the shader does not declare are ignored
+		Expected<VulkanShader>           LoadShader( const char* source_name,
+			std::span<const ShaderKeyword> keywords = {} );
+		// the device independent part of LoadShader, startup workers run it before the device exists
+		Expected<VulkanShader>           ReadShader( const char* source_name,
+			std::span<const ShaderKeyword> keywords = {} ) const;
+		Expected<void>                   CreateShaderModule( VulkanShader& shader );
+		Expected<VulkanPipelineLayout>   GetGraphicsLayout( const VulkanShader& vertex,
+			const VulkanShader& fragment );
+		Expected<VulkanGraphicsPipeline> CreateGraphicsPipeline( const VulkanShader& vertex,
+			const VulkanShader& fragment );
+		Expected<void>       CreateRenderPasses( VulkanGraphicsPipeline& graphics_pipeline );
+		// the attributes of the vertex and instance streams the vertex shader reads
+		static Expected<void> GetVertexInputs( const VulkanShader& vertex,
+			std::pmr::vector<VkVertexInputAttributeDescription>& attribute_desc,
+			std::pmr::vector<VkVertexInputBindingDescription>& binding_desc );
+		// a null render_pass creates the pipeline for dynamic rendering into the swapchain and depth formats
+		Expected<VkPipeline> CreateGraphicsPipelineInstance( const VulkanShader& vertex,
+			const VulkanShader& fragment, VkPipelineLayout layout, VkRenderPass render_pass );
+
+		// Index of the graphics pipeline variant for the keywords, created on first use. Fails when no
+		// stage declares one of the keywords or the variant needs a different layout.
+		Expected<uint32>     GetGraphicsVariant( std::vector<ShaderKeyword> keywords );
+		Expected<VkPipeline> CreateGraphicsVariant( std::span<const ShaderKeyword> keywords );
+
+		void InitShaderReload();
+		// runs at the frame boundary, after the frame's fence was waited for
+		void UpdateShaderReload();
+		Expected<VkPipeline> ReloadComputePipeline( const char* source_name, VkPipelineLayout layout );
+		Expected<VkPipeline> ReloadShadowPipeline();
+		void ReplacePipeline( VkPipeline& pipeline, const Expected<VkPipeline>& reloaded );
+
+		// selects the pipeline variant of a requested debug view, runs at the frame boundary
+		void UpdateDebugView();
 
-		Expected<VkImageView> CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspect_flags );
-		Expected<std::vector<VkImageView>>   CreateImageViews();
-		Expected<std::vector<VkFramebuffer>> CreateFramebuffers();
+		// the cache file is validated against the GPU, a stale or foreign one starts an empty cache
+		std::filesystem::path     GetPipelineCachePath() const;
+		Expected<VkPipelineCache> CreatePipelineCache( std::span<const char> data );
+		void                      SavePipelineCache();
+
+		// refreshes the heap budgets and warns about everything over budget
+		void UpdateMemoryUsage();
+
+		Expected<VkImageView> CreateImageView( VkImage image, VkFormat format, VkImageAspectFlags aspect_flags,
+			uint32 base_mip = 0, uint32 mip_count = 1, VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D,
+			uint32 base_layer = 0, uint32 layer_count = 1 );
+		Expected<std::vector<VkImageView>> CreateImageViews();
+		// null with dynamic rendering
+		Expected<VkFramebuffer>            CreateSceneFramebuffer( VkImageView color_view );
 
 		Expected<VkCommandPool>				   CreateCommandPool( VulkanQueueFamilyIndices indices );
-		Expected<std::vector<VkCommandBuffer>> CreateCommandBuffers();
 
 		Expected<std::vector<VulkanSyncObjects>> CreateSyncObjects();
 
 		uint32 FindMemoryType( uint32 type_filter, VkMemoryPropertyFlags prop_flags );
 
+		// shared resources are used by passes on both queues, exclusive ones by a single queue family
 		Expected<VulkanBuffer> CreateBuffer( VkDeviceSize size, VkBufferUsageFlags usage,
-			VkMemoryPropertyFlags props );
+			VkMemoryPropertyFlags props, bool shared = false );
 		Expected<VulkanBuffer> CreateVertexBuffer();
 		Expected<VulkanBuffer> CreateIndexBuffer();
-		Expected<std::vector<VulkanBuffer>> CreateUniformBuffers();
+		Expected<VulkanFrameRing> CreateFrameRing( VkDeviceSize element_size, uint32 element_count,
+			VkBufferUsageFlags usage, VkDeviceSize alignment );
 		void CopyBuffer( VkBuffer source, VkBuffer destination, VkDeviceSize size );
 
-		void UpdateUniformBuffer( uint32 current_image );
+		// meshes, objects and the scene tree, runs on a startup worker
+		void BuildScene();
+		// appends the mesh and its simplified levels of detail to the scene geometry
+		uint32 AddMesh( std::span<const Vertex> vertices, std::span<const uint16> indices );
+		// coarsest level of the object's mesh that keeps the projected error under LOD_ERROR_PIXELS,
+		// pixels_per_unit is the size in pixels of one unit at a view distance of one
+		uint32 SelectLod( const VulkanRenderObject& object, const glm::mat4& view_model,
+			float pixels_per_unit ) const;
+		void BuildLights();
+		void UpdateUniformBuffer( uint32 current_frame );
+		// uploads the lights inside the frustum and fills the cluster constants of the ubo
+		void UpdateLights( uint32 current_frame, UniformBufferObject& ubo );
+		void BuildDrawBatches( uint32 current_frame, const UniformBufferObject& ubo );
 
 		Expected<VulkanDescriptorGroup> CreateDescriptorGroup();
 
-		Expected<VulkanTexture> CreateTexture();
+		static Expected<VulkanImageData> DecodeImage( const std::filesystem::path& path );
+		Expected<VulkanTexture> CreateTexture( const VulkanImageData& image );
 		Expected<VulkanTexture> CreateTextureImage( int32 width, int32 height, VkFormat format,
-			VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memory_props );
+			VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memory_props,
+			uint32 mip_levels = 1, bool shared = false, uint32 array_layers = 1 );
+		Expected<VkSampler> CreatePointSampler( float max_lod );
 
 		Expected<VulkanTexture> CreateDepthTexture();
 
-		void RecordCommandBuffer( uint32 image_index );
+		Expected<VulkanComputePipeline> CreateComputePipeline( const VulkanShader& shader );
+		Expected<VkPipeline> CreateComputePipelineInstance( const VulkanShader& shader, VkPipelineLayout layout );
+		Expected<VulkanOcclusionCuller> CreateOcclusionCuller( const VulkanComputePipeline& hiz_pipeline,
+			const VulkanComputePipeline& cull_pipeline );
+		Expected<VulkanHiZPyramid>      CreateHiZPyramid();
+		// points the frame's cull set at the current pyramid, the set must not be in use
+		void UpdateOcclusionDescriptors( uint32 frame );
+
+		Expected<VulkanLightClusters> CreateLightClusters( const VulkanComputePipeline& pipeline );
+		void RecordLightCull( VkCommandBuffer command_buffer );
+		// recorded on the graphics queue before the first fragment shader reads the clusters
+		void RecordLightBarrier( VkCommandBuffer command_buffer );
+
+		Expected<VulkanShadowPipeline> CreateShadowPipeline( const VulkanShader& vertex );
+		// a null render_pass creates the pipeline for dynamic rendering into the format
+		Expected<VkPipeline> CreateShadowPipelineInstance( const VulkanShader& vertex, VkPipelineLayout layout,
+			VkRenderPass render_pass, VkFormat format );
+		// hands the atlas tiles out to the scene's shadow casting lights, the scene must be built
+		Expected<VulkanShadowMaps> CreateShadowMaps( const VulkanShadowPipeline& pipeline );
+		Expected<VkSampler> CreateShadowSampler();
+		// fits the cascades, picks the views to render within the budgets and fills the shadow constants
+		void UpdateShadows( uint32 current_frame, UniformBufferObject& ubo );
+		// instances of the casters of every view picked by UpdateShadows, after BuildDrawBatches
+		void BuildShadowDraws();
+		void RecordShadows( VkCommandBuffer command_buffer );
+
+		Expected<VulkanPostProcess> CreatePostProcess(
+			const std::array<VulkanComputePipeline, VulkanPostProcess::StageCount>& pipelines );
+		// sized to the swapchain, after the depth texture the scene framebuffer attaches
+		Expected<VulkanHdrTargets> CreateHdrTargets();
+		// advances the exposure adaptation by the time since the last frame
+		void UpdatePostProcess();
+		// from the finished HDR target to the swapchain image, ready for presentation
+		void RecordPostProcess( VkCommandBuffer command_buffer, uint32 image_index );
+		// jitters the projection and keeps the unjittered matrices the temporal pass reprojects with
+		void UpdateTemporal( UniformBufferObject& ubo );
+
+		Expected<VulkanDynamicResolution> CreateDynamicResolution();
+		// reads the timestamps of the frame slot and picks the render extent, after the frame's fence
+		void UpdateDynamicResolution( uint32 current_frame );
+		// begin is recorded before the shadow passes, end after the last scene pass
+		void RecordSceneTimestamp( VkCommandBuffer command_buffer, bool begin );
+
+		// adds the frame's passes to the scheduler, compute passes are tagged for the async compute queue
+		void SchedulePasses( uint32 image_index );
+		// phase 0 clears the attachments, phase 1 continues drawing into them
+		void BeginScenePass( VkCommandBuffer command_buffer, uint32 phase );
+		void EndScenePass( VkCommandBuffer command_buffer );
+		void BeginRenderPass( VkCommandBuffer command_buffer, uint32 phase );
+		void BeginDynamicRendering( VkCommandBuffer command_buffer, uint32 phase );
+		void RecordDrawBatches( VkCommandBuffer command_buffer, uint32 phase );
+		void RecordOcclusionCull( VkCommandBuffer command_buffer, uint32 phase );
+		void RecordHiZBuild( VkCommandBuffer command_buffer );
+		// recorded on the graphics queue around the Hi-Z build, which may run on the compute queue
+		void RecordDepthBarrier( VkCommandBuffer command_buffer, bool shader_read );
 
+		// Submitted without waiting, the command buffer is retired to the submission and the next frame waits
+		// for it on the GPU. Returns the timeline value resources used by the commands are retired to.
 		Expected<VkCommandBuffer> BeginSingleTimeCommands();
-		void EndSingleTimeCommands( VkCommandBuffer command_buffer );
+		uint64 EndSingleTimeCommands( VkCommandBuffer command_buffer );
 
 		void TransitionImageLayout( const VulkanTexture& texture, VkFormat format,VkImageLayout old_layout,
 			VkImageLayout new_layout );
@@ -223,39 +890,144 @@ namespace VulkanRHI
 		Expected<VkFormat> FindSupportedFormat( std::span<const VkFormat> candidates,
 			VkImageTiling tiling, VkFormatFeatureFlags features ) const;
 		Expected<VkFormat> FindDepthFormat();
+		static VkImageAspectFlags GetDepthAspect( VkFormat format );
 
 	private:
 		VulkanContextCreateInfo ContextInfo;
 		SDL_Window* WindowHandle;
 
 	private:
+		// passed to every vkCreate and vkDestroy call, driver host memory is charged to MemoryTag::Vulkan
+		const VkAllocationCallbacks* Allocator = GetHostAllocationCallbacks();
 		VkInstance       Instance;
 		VkSurfaceKHR     Surface;
 		VkPhysicalDevice Gpu;
 		VkDevice         Device;
 		VkQueue          GraphicsQueue;
 		VkQueue          PresentQueue;
+		// the graphics queue without a dedicated compute family
+		VkQueue          ComputeQueue;
+		// graphics and compute family with async compute, empty otherwise
+		std::vector<uint32> SharedQueueFamilies;
 
-		VkCommandPool   CommandPool;
-		std::vector<VkCommandBuffer> CommandBuffers;
+		VulkanDeviceCapabilities Capabilities;
+		RHICapabilities          PublishedCapabilities;
+		VulkanDeviceFunctions    DeviceFunctions;
+		// render passes and framebuffers are replaced by vkCmdBeginRenderingKHR and synchronization2 barriers
+		bool DynamicRendering = false;
+		// VK_EXT_memory_budget is enabled
+		bool MemoryBudget = false;
+		// every graphics submission signals the deletion queue timeline, frame fences are used otherwise
+		bool TimelineSemaphore = false;
 
+		// one time commands, the frame's command buffers come from the scheduler
+		VkCommandPool       CommandPool;
+		VulkanPassScheduler Scheduler;
+
+		PipelineLayoutCache    LayoutCache;
 		VulkanGraphicsPipeline GraphicsPipeline;
 
+		std::filesystem::path ShadersPath;
+		// shared by every pipeline creation, the driver synchronises it between the startup workers
+		VkPipelineCache       PipelineCache = VK_NULL_HANDLE;
+		FileWatcher           ShaderWatcher;
+		Scope<ShaderCompiler> Compiler;
+
 		VulkanSwapchain Swapchain;
+		PresentSettings PresentConfig;
+		// the present settings changed or presentation reported the swapchain out of date
+		bool            SwapchainDirty = false;
+		// the window was resized, its size is compared to the swapchain once per frame
+		bool            ResizePending = false;
+		uint32          SwapchainGeneration = 0;
 
 		std::vector<VulkanSyncObjects> SyncObjects;
+		// when each frame in flight sampled its input, for the latency stat
+		std::vector<std::chrono::steady_clock::time_point> InputSampleTimes;
+		float InputLatencyMs = 0.0f;
+		// from Application::LaunchTime to the first present, zero until then
+		float TimeToFirstFrameMs = 0.0f;
+		uint64 SubmittedFrames = 0;
+		// timeline value of the last submission of every frame in flight
+		std::vector<uint64> FrameSubmissions;
+
+		// resources the GPU may still use, destroyed once their submissions completed
+		VulkanDeletionQueue DeletionQueue;
+		// timeline value of the last single time submission, the next frame waits for it
+		uint64              UploadValue = 0;
 
 		VulkanBuffer VertexBuffer;
 		VulkanBuffer IndexBuffer;
-		std::vector<VulkanBuffer> UniformBuffers;
+		VulkanFrameRing UniformRing;
+		VulkanFrameRing InstanceRing;
 
 		VulkanDescriptorGroup DescriptorGroup;
 
 		VulkanTexture Texture;
 		VulkanTexture DepthTexture;
 
+		VulkanOcclusionCuller Culler;
+		VulkanHiZPyramid      HiZPyramid;
+		std::vector<CullObject> CullInput;
+		bool OcclusionCulling = false;
+		bool MultiDrawIndirect = false;
+
+		VulkanLightClusters     LightClusters;
+		std::vector<SceneLight> Lights;
+		// the visible lights of the frame in view space
+		std::vector<LightData>  FrameLights;
+		DirectionalLight        Sun;
+
+		VulkanShadowMaps ShadowMaps;
+
+		VulkanPostProcess PostProcess;
+		VulkanHdrTargets  HdrTargets;
+
+		ResolutionSettings      ResolutionConfig;
+		VulkanDynamicResolution DynamicResolution;
+
+		DebugView RequestedDebugView = DebugView::None;
+		DebugView ActiveDebugView = DebugView::None;
+		// replaces the pipeline of every object while a debug view is active
+		std::optional<uint32> DebugPipeline;
+
+		std::vector<VulkanMesh>         Meshes;
+		// geometry of every mesh and level of detail, uploaded into the shared buffers at startup
+		std::vector<Vertex>             SceneVertices;
+		std::vector<uint16>             SceneIndices;
+		std::vector<VulkanRenderObject> Objects;
+		std::vector<VulkanDrawBatch>    DrawBatches;
+		std::vector<InstanceData>       BatchInstances;
+
+		BVH                 SceneTree;
+		std::vector<uint32> VisibleObjects;
+
+		std::vector<VulkanHeapUsage> HeapUsage;
+		// bit per heap, a heap warns again only after it went back under budget
+		uint32       HeapsOverBudget = 0;
+		VkDeviceSize DeviceMemoryUsage = 0;
+		VkDeviceSize DeviceMemoryBudget = 0;
+		// written on the first budget overrun of the run
+		bool         MemorySnapshotWritten = false;
+
+		RenderQueue Queue;
+		RenderStats Stats;
+		// temporaries of the render thread that live for the frame
+		FrameAllocator FrameMemory{ 64 * 1024 };
+
 	private:
 		const int32 MAX_FRAMES_IN_FLIGHT = 2;
+		const int32 MAX_DRAWS_PER_FRAME = 4096;
+		const int32 MAX_INSTANCES_PER_FRAME = 16384;
+		const int32 MAX_LIGHTS = 16384;
+		const int32 SCENE_LIGHT_COUNT = 10000;
+		// frames between two budget queries
+		const uint64 MEMORY_CHECK_INTERVAL = 240;
+		// generous, meant to catch leaks and runaway growth
+		const uint64 VULKAN_HOST_MEMORY_BUDGET = 256ull << 20;
+		const uint64 FRAME_MEMORY_BUDGET = 4ull << 20;
+		const float NEAR_PLANE = 0.1f;
+		const float FAR_PLANE = 10.0f;
 		uint32 CurrentFrame = 0;
 	};
 
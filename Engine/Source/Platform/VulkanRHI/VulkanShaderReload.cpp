@@ -0,0 +1,229 @@
+#include "VulkanRHI.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		enum class ReloadTarget : uint8
+		{
+			Graphics,
+			HiZ,
+			Cull,
+			Clusters,
+			Shadow,
+			Count
+		};
+
+		struct ShaderTarget
+		{
+			std::string_view Source;
+			ReloadTarget     Target;
+		};
+
+		// which pipeline has to be rebuilt when a source changes
+		constexpr std::array SHADER_TARGETS = {
+			ShaderTarget{ "triangle.vert", ReloadTarget::Graphics },
+			ShaderTarget{ "triangle.frag", ReloadTarget::Graphics },
+			ShaderTarget{ "hiz.comp", ReloadTarget::HiZ },
+			ShaderTarget{ "cull.comp", ReloadTarget::Cull },
+			ShaderTarget{ "clusters.comp", ReloadTarget::Clusters },
+			ShaderTarget{ "shadow.vert", ReloadTarget::Shadow },
+		};
+	}
+
+	void Context::InitShaderReload()
+	{
+		if ( !ShaderWatcher.Start( ShadersPath ) )
+		{
+			LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] Shader hot reload is disabled." );
+			return;
+		}
+		Compiler = CreateScope<ShaderCompiler>( ShadersPath / "Cache" );
+		LOG_INFO( "[Vulkan] Watching {} for shader changes.", ShadersPath.string() );
+	}
+
+	// Only the pipeline objects are replaced, layouts and render passes are kept. A reloaded shader is
+	// reflected first, an edit that changes its bindings or push constants is rejected and still needs a
+	// restart, vertex inputs only have to be provided by one of the vertex streams.
+	void Context::UpdateShaderReload()
+	{
+		if ( !Compiler )
+		{
+			return;
+		}
+
+		for ( const std::filesystem::path& path : ShaderWatcher.TakeChanges() )
+		{
+			if ( ShaderCompiler::IsShaderSource( path ) )
+			{
+				Compiler->Submit( path );
+			}
+		}
+
+		std::array<bool, static_cast< size_t >( ReloadTarget::Count )> reload = {};
+		std::array<bool, VulkanPostProcess::StageCount> reload_post = {};
+		for ( const ShaderCompileResult& result : Compiler->TakeResults() )
+		{
+			const std::string source = result.Source.filename().string();
+			if ( !result.Succeeded )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "[Vulkan] Failed to compile {}, keeping the old pipeline.\n{}",
+					source, result.Messages );
+				continue;
+			}
+
+			if ( !result.Messages.empty() )
+			{
+				LOG_WARN_CAT( LogCategory::Vulkan, "[Vulkan] {}", result.Messages );
+			}
+			if ( !result.Changed )
+			{
+				// e.g. only comments changed, the pipelines would come out the same
+				LOG_INFO_CAT( LogCategory::Vulkan, "[Vulkan] {} compiles to the same SPIR-V, nothing to reload.",
+					source );
+				continue;
+			}
+			LOG_INFO_CAT( LogCategory::Vulkan, "[Vulkan] Recompiled {}{}.", source,
+				result.CacheHit ? " from the cache" : "" );
+
+			for ( const ShaderTarget& target : SHADER_TARGETS )
+			{
+				if ( target.Source == source )
+				{
+					reload[static_cast< size_t >( target.Target )] = true;
+				}
+			}
+			for ( uint32 stage = 0; stage < VulkanPostProcess::StageCount; ++stage )
+			{
+				reload_post[stage] |= VulkanPostProcess::SHADERS[stage] == source;
+			}
+		}
+
+		if ( reload[static_cast< size_t >( ReloadTarget::Graphics )] )
+		{
+			for ( VulkanPipelineVariant& variant : GraphicsPipeline.Variants )
+			{
+				ReplacePipeline( variant.Instance, CreateGraphicsVariant( variant.Keywords ) );
+			}
+		}
+
+		if ( OcclusionCulling && reload[static_cast< size_t >( ReloadTarget::HiZ )] )
+		{
+			ReplacePipeline( Culler.HiZPipeline.Instance,
+				ReloadComputePipeline( "hiz.comp", Culler.HiZPipeline.Layout ) );
+		}
+
+		if ( OcclusionCulling && reload[static_cast< size_t >( ReloadTarget::Cull )] )
+		{
+			ReplacePipeline( Culler.CullPipeline.Instance,
+				ReloadComputePipeline( "cull.comp", Culler.CullPipeline.Layout ) );
+		}
+
+		if ( reload[static_cast< size_t >( ReloadTarget::Clusters )] )
+		{
+			ReplacePipeline( LightClusters.Pipeline.Instance,
+				ReloadComputePipeline( "clusters.comp", LightClusters.Pipeline.Layout ) );
+		}
+
+		if ( reload[static_cast< size_t >( ReloadTarget::Shadow )] )
+		{
+			ReplacePipeline( ShadowMaps.Pipeline.Instance, ReloadShadowPipeline() );
+		}
+
+		for ( uint32 stage = 0; stage < VulkanPostProcess::StageCount; ++stage )
+		{
+			if ( reload_post[stage] )
+			{
+				VulkanComputePipeline& pipeline = PostProcess.Pipelines[stage];
+				ReplacePipeline( pipeline.Instance,
+					ReloadComputePipeline( VulkanPostProcess::SHADERS[stage], pipeline.Layout ) );
+			}
+		}
+	}
+
+	Expected<VkPipeline> Context::ReloadComputePipeline( const char* source_name, VkPipelineLayout layout )
+	{
+		auto shader_result = LoadShader( source_name );
+		if ( !shader_result )
+		{
+			return std::unexpected( shader_result.error() );
+		}
+		VulkanShader shader = std::move( shader_result.value() );
+
+		Expected<VkPipeline> pipeline_result;
+		auto layout_result = LayoutCache.Get( Device, shader.Reflection, Allocator );
+		if ( !layout_result )
+		{
+			pipeline_result = std::unexpected( layout_result.error() );
+		}
+		else if ( layout_result.value().Instance != layout )
+		{
+			pipeline_result = std::unexpected( Error( ErrorCode::ShaderInterfaceChanged, VK_SUCCESS, source_name ) );
+		}
+		else
+		{
+			pipeline_result = CreateComputePipelineInstance( shader, layout );
+		}
+
+		shader.Destroy( Device, Allocator );
+		return pipeline_result;
+	}
+
+	Expected<VkPipeline> Context::ReloadShadowPipeline()
+	{
+		const char* source_name = "shadow.vert";
+		auto shader_result = LoadShader( source_name );
+		if ( !shader_result )
+		{
+			return std::unexpected( shader_result.error() );
+		}
+		VulkanShader shader = std::move( shader_result.value() );
+
+		const VulkanShadowPipeline& pipeline = ShadowMaps.Pipeline;
+		Expected<VkPipeline> pipeline_result;
+		auto layout_result = LayoutCache.Get( Device, shader.Reflection, Allocator );
+		if ( !layout_result )
+		{
+			pipeline_result = std::unexpected( layout_result.error() );
+		}
+		else if ( layout_result.value().Instance != pipeline.Layout )
+		{
+			pipeline_result = std::unexpected( Error( ErrorCode::ShaderInterfaceChanged, VK_SUCCESS, source_name ) );
+		}
+		else
+		{
+			pipeline_result = CreateShadowPipelineInstance( shader, pipeline.Layout, pipeline.RenderPass,
+				pipeline.Format );
+		}
+
+		shader.Destroy( Device, Allocator );
+		return pipeline_result;
+	}
+
+	// Frames already submitted may still be executing with the old pipeline, so it is retired to the last
+	// submission and destroyed once that completed. The frame being built only uses the new one.
+	void Context::ReplacePipeline( VkPipeline& pipeline, const Expected<VkPipeline>& reloaded )
+	{
+		if ( !reloaded )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", reloaded.error() );
+			return;
+		}
+
+		const VkPipeline retired = std::exchange( pipeline, reloaded.value() );
+		DeletionQueue.Retire( DeletionQueue.GetSubmittedValue(), [retired] ( VkDevice device,
+			const VkAllocationCallbacks* alloc ) {
+			vkDestroyPipeline( device, retired, alloc );
+		} );
+	}
+
+} // namespace VulkanRHI
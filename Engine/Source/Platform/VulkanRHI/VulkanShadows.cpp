@@ -0,0 +1,777 @@
+#include "VulkanRHI.h"
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Assert.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		// how far in front of a cascade's bounding sphere casters are still drawn, towards the sun
+		constexpr float CASTER_DISTANCE = 10.0f;
+		// 0 splits the cascades uniformly, 1 logarithmically
+		constexpr float SPLIT_BLEND = 0.75f;
+		constexpr float TILE_NEAR_PLANE = 0.02f;
+
+		// the faces a point light's tiles hold, LightShadow in triangle.frag picks them in this order
+		constexpr std::array<glm::vec3, 6> CUBE_FACES = {
+			glm::vec3( 1.0f, 0.0f, 0.0f ), glm::vec3( -1.0f, 0.0f, 0.0f ),
+			glm::vec3( 0.0f, 1.0f, 0.0f ), glm::vec3( 0.0f, -1.0f, 0.0f ),
+			glm::vec3( 0.0f, 0.0f, 1.0f ), glm::vec3( 0.0f, 0.0f, -1.0f )
+		};
+
+		glm::mat4 LookTowards( const glm::vec3& eye, const glm::vec3& direction )
+		{
+			// z is up in the scene, anything pointing along it takes y instead
+			const glm::vec3 up = std::abs( direction.z ) > 0.99f ? glm::vec3( 0.0f, 1.0f, 0.0f ) :
+				glm::vec3( 0.0f, 0.0f, 1.0f );
+			return glm::lookAt( eye, eye + direction, up );
+		}
+
+		glm::mat4 GetTileViewProjection( const SceneLight& light, uint32 face )
+		{
+			if ( light.Spot )
+			{
+				const float fov = std::min( 2.0f * std::acos( light.OuterConeCos ), glm::radians( 170.0f ) );
+				return glm::perspectiveRH_ZO( fov, 1.0f, TILE_NEAR_PLANE, light.Range ) *
+					LookTowards( light.Position, light.Direction );
+			}
+			return glm::perspectiveRH_ZO( glm::radians( 90.0f ), 1.0f, TILE_NEAR_PLANE, light.Range ) *
+				LookTowards( light.Position, CUBE_FACES[face] );
+		}
+
+		VkRect2D GetTileRect( uint32 tile )
+		{
+			constexpr uint32 TILES_PER_ROW = VulkanShadowMaps::TILES_PER_ROW;
+			constexpr uint32 TILE_SIZE = VulkanShadowMaps::TILE_SIZE;
+
+			VkRect2D rect = {};
+			rect.offset.x = static_cast< int32 >( tile % TILES_PER_ROW * TILE_SIZE );
+			rect.offset.y = static_cast< int32 >( tile / TILES_PER_ROW * TILE_SIZE );
+			rect.extent = { VulkanShadowMaps::TILE_SIZE, VulkanShadowMaps::TILE_SIZE };
+			return rect;
+		}
+	}
+
+	Expected<VulkanShadowPipeline> Context::CreateShadowPipeline( const VulkanShader& vertex )
+	{
+		VulkanShadowPipeline pipeline;
+
+		// linear filtering of a comparison gives 2x2 PCF for free
+		const std::array formats = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+		auto format_result = FindSupportedFormat( formats, VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT );
+		if ( !format_result )
+		{
+			return std::unexpected( format_result.error() );
+		}
+		pipeline.Format = format_result.value();
+
+		auto layout_result = LayoutCache.Get( Device, vertex.Reflection, Allocator );
+		if ( !layout_result )
+		{
+			return std::unexpected( layout_result.error() );
+		}
+		pipeline.Layout = layout_result.value().Instance;
+
+		// the maps are moved in and out of the attachment layout by RecordShadows, the render pass keeps it
+		if ( !DynamicRendering )
+		{
+			VkAttachmentDescription depth_attachment = {};
+			depth_attachment.format = pipeline.Format;
+			depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+			VkAttachmentReference depth_attachment_ref = {};
+			depth_attachment_ref.attachment = 0;
+			depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+			VkRenderPassCreateInfo render_pass_info = {};
+			render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			render_pass_info.attachmentCount = 1;
+			render_pass_info.pAttachments = &depth_attachment;
+			render_pass_info.subpassCount = 1;
+			render_pass_info.pSubpasses = &subpass;
+
+			VkResult err = vkCreateRenderPass( Device, &render_pass_info, Allocator, &pipeline.RenderPass );
+			if ( err != VK_SUCCESS )
+			{
+				return std::unexpected( Error( ErrorCode::CreateRenderPass, err ) );
+			}
+		}
+
+		auto instance_result = CreateShadowPipelineInstance( vertex, pipeline.Layout, pipeline.RenderPass,
+			pipeline.Format );
+		if ( !instance_result )
+		{
+			return std::unexpected( instance_result.error() );
+		}
+		pipeline.Instance = instance_result.value();
+		return pipeline;
+	}
+
+	Expected<VkPipeline> Context::CreateShadowPipelineInstance( const VulkanShader& vertex,
+		VkPipelineLayout layout, VkRenderPass render_pass, VkFormat format )
+	{
+		VkResult err;
+
+		VkPipelineShaderStageCreateInfo vertex_stage_info = {};
+		vertex_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertex_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		vertex_stage_info.module = vertex.Module;
+		vertex_stage_info.pName = "main";
+
+		ScratchScope scratch;
+
+		const std::array<VkDynamicState, 2> dynamic_states = {
+			VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamic_state_info = {};
+		dynamic_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamic_state_info.dynamicStateCount = static_cast< uint32 >( dynamic_states.size() );
+		dynamic_state_info.pDynamicStates = dynamic_states.data();
+
+		std::pmr::vector<VkVertexInputAttributeDescription> attribute_desc( scratch.GetResource() );
+		std::pmr::vector<VkVertexInputBindingDescription> binding_desc( scratch.GetResource() );
+		auto vertex_inputs_result = GetVertexInputs( vertex, attribute_desc, binding_desc );
+		if ( !vertex_inputs_result )
+		{
+			return std::unexpected( vertex_inputs_result.error() );
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
+		vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertex_input_info.vertexBindingDescriptionCount = static_cast< uint32 >( binding_desc.size() );
+		vertex_input_info.vertexAttributeDescriptionCount = static_cast< uint32 >( attribute_desc.size() );
+		vertex_input_info.pVertexBindingDescriptions = binding_desc.data();
+		vertex_input_info.pVertexAttributeDescriptions = attribute_desc.data();
+
+		VkPipelineInputAssemblyStateCreateInfo assembly_info = {};
+		assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+		VkPipelineViewportStateCreateInfo viewport_state_info = {};
+		viewport_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewport_state_info.viewportCount = 1;
+		viewport_state_info.scissorCount = 1;
+
+		// the quads are seen from both sides, so they cast from both; the bias keeps them from shadowing
+		// themselves
+		VkPipelineRasterizationStateCreateInfo rasterizer_info = {};
+		rasterizer_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer_info.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer_info.lineWidth = 1.0f;
+		rasterizer_info.cullMode = VK_CULL_MODE_NONE;
+		rasterizer_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer_info.depthBiasEnable = true;
+		rasterizer_info.depthBiasConstantFactor = 1.25f;
+		rasterizer_info.depthBiasSlopeFactor = 1.75f;
+
+		VkPipelineMultisampleStateCreateInfo multisampling_info = {};
+		multisampling_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineColorBlendStateCreateInfo colorblend_info = {};
+		colorblend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+		VkPipelineDepthStencilStateCreateInfo depth_stencil_info = {};
+		depth_stencil_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depth_stencil_info.depthTestEnable = true;
+		depth_stencil_info.depthWriteEnable = true;
+		depth_stencil_info.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		VkGraphicsPipelineCreateInfo pipeline_info = {};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipeline_info.stageCount = 1;
+		pipeline_info.pStages = &vertex_stage_info;
+		pipeline_info.pVertexInputState = &vertex_input_info;
+		pipeline_info.pInputAssemblyState = &assembly_info;
+		pipeline_info.pViewportState = &viewport_state_info;
+		pipeline_info.pRasterizationState = &rasterizer_info;
+		pipeline_info.pMultisampleState = &multisampling_info;
+		pipeline_info.pColorBlendState = &colorblend_info;
+		pipeline_info.pDynamicState = &dynamic_state_info;
+		pipeline_info.pDepthStencilState = &depth_stencil_info;
+		pipeline_info.layout = layout;
+		pipeline_info.renderPass = render_pass;
+
+		VkPipelineRenderingCreateInfoKHR rendering_info = {};
+		if ( render_pass == VK_NULL_HANDLE )
+		{
+			rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+			rendering_info.colorAttachmentCount = 0;
+			rendering_info.depthAttachmentFormat = format;
+			pipeline_info.pNext = &rendering_info;
+		}
+
+		VkPipeline pipeline;
+		const uint32                 create_count = 1;
+		const VkAllocationCallbacks* alloc = Allocator;
+		err = vkCreateGraphicsPipelines( Device, PipelineCache, create_count, &pipeline_info, alloc,
+			&pipeline );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateGraphicsPipeline, err ) );
+		}
+		return pipeline;
+	}
+
+	Expected<VulkanShadowMaps> Context::CreateShadowMaps( const VulkanShadowPipeline& pipeline )
+	{
+		VulkanShadowMaps shadow_maps;
+		shadow_maps.Pipeline = pipeline;
+
+		const VkFormat format = pipeline.Format;
+		const VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		const uint32 mip_levels = 1;
+		const bool   shared = false;
+
+		auto cascade_result = CreateTextureImage( VulkanShadowMaps::CASCADE_SIZE, VulkanShadowMaps::CASCADE_SIZE,
+			format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mip_levels, shared,
+			SHADOW_CASCADE_COUNT );
+		if ( !cascade_result )
+		{
+			return std::unexpected( cascade_result.error() );
+		}
+		shadow_maps.CascadeTexture = cascade_result.value();
+
+		auto array_view_result = CreateImageView( shadow_maps.CascadeTexture.Image, format,
+			VK_IMAGE_ASPECT_DEPTH_BIT, 0, mip_levels, VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, SHADOW_CASCADE_COUNT );
+		if ( !array_view_result )
+		{
+			return std::unexpected( array_view_result.error() );
+		}
+		shadow_maps.CascadeTexture.View = array_view_result.value();
+
+		for ( uint32 layer = 0; layer < SHADOW_CASCADE_COUNT; ++layer )
+		{
+			auto layer_view_result = CreateImageView( shadow_maps.CascadeTexture.Image, format,
+				VK_IMAGE_ASPECT_DEPTH_BIT, 0, mip_levels, VK_IMAGE_VIEW_TYPE_2D, layer, 1 );
+			if ( !layer_view_result )
+			{
+				return std::unexpected( layer_view_result.error() );
+			}
+			shadow_maps.LayerViews.push_back( layer_view_result.value() );
+		}
+
+		auto atlas_result = CreateTextureImage( VulkanShadowMaps::ATLAS_SIZE, VulkanShadowMaps::ATLAS_SIZE,
+			format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mip_levels, shared );
+		if ( !atlas_result )
+		{
+			return std::unexpected( atlas_result.error() );
+		}
+		shadow_maps.AtlasTexture = atlas_result.value();
+
+		auto atlas_view_result = CreateImageView( shadow_maps.AtlasTexture.Image, format, VK_IMAGE_ASPECT_DEPTH_BIT );
+		if ( !atlas_view_result )
+		{
+			return std::unexpected( atlas_view_result.error() );
+		}
+		shadow_maps.AtlasTexture.View = atlas_view_result.value();
+
+		if ( !DynamicRendering )
+		{
+			std::vector<std::pair<VkImageView, uint32>> targets;
+			for ( VkImageView view : shadow_maps.LayerViews )
+			{
+				targets.emplace_back( view, VulkanShadowMaps::CASCADE_SIZE );
+			}
+			targets.emplace_back( shadow_maps.AtlasTexture.View, VulkanShadowMaps::ATLAS_SIZE );
+
+			for ( const auto& [view, size] : targets )
+			{
+				VkFramebufferCreateInfo framebuffer_info = {};
+				framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebuffer_info.renderPass = pipeline.RenderPass;
+				framebuffer_info.attachmentCount = 1;
+				framebuffer_info.pAttachments = &view;
+				framebuffer_info.width = size;
+				framebuffer_info.height = size;
+				framebuffer_info.layers = 1;
+
+				VkFramebuffer framebuffer = VK_NULL_HANDLE;
+				VkResult err = vkCreateFramebuffer( Device, &framebuffer_info, Allocator, &framebuffer );
+				if ( err != VK_SUCCESS )
+				{
+					return std::unexpected( Error( ErrorCode::CreateFramebuffer, err ) );
+				}
+				shadow_maps.Framebuffers.push_back( framebuffer );
+			}
+		}
+
+		auto sampler_result = CreateShadowSampler();
+		if ( !sampler_result )
+		{
+			return std::unexpected( sampler_result.error() );
+		}
+		shadow_maps.Sampler = sampler_result.value();
+
+		auto tile_ring_result = CreateFrameRing( sizeof( ShadowTileData ), VulkanShadowMaps::TILE_COUNT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, Capabilities.Properties.limits.minStorageBufferOffsetAlignment );
+		if ( !tile_ring_result )
+		{
+			return std::unexpected( tile_ring_result.error() );
+		}
+		shadow_maps.TileRing = tile_ring_result.value();
+
+		// tiles are handed out once in scene order, lights that do not fit anymore go without shadows
+		shadow_maps.FirstTiles.assign( Lights.size(), -1 );
+		for ( uint32 light_index = 0; light_index < Lights.size(); ++light_index )
+		{
+			const SceneLight& light = Lights[light_index];
+			const uint32 face_count = light.Spot ? 1 : static_cast< uint32 >( CUBE_FACES.size() );
+			if ( !light.CastsShadow || shadow_maps.Tiles.size() + face_count > VulkanShadowMaps::TILE_COUNT )
+			{
+				continue;
+			}
+
+			shadow_maps.FirstTiles[light_index] = static_cast< int32 >( shadow_maps.Tiles.size() );
+			for ( uint32 face = 0; face < face_count; ++face )
+			{
+				VulkanShadowView tile;
+				tile.Light = light_index;
+				tile.Face = face;
+				shadow_maps.Tiles.push_back( tile );
+			}
+		}
+		shadow_maps.Passes.reserve( SHADOW_CASCADE_COUNT + VulkanShadowMaps::TILE_BUDGET );
+
+		// cleared to the far plane, whatever was not rendered yet reads as lit
+		auto command_buffer_result = BeginSingleTimeCommands();
+		if ( !command_buffer_result )
+		{
+			return std::unexpected( command_buffer_result.error() );
+		}
+		VkCommandBuffer command_buffer = command_buffer_result.value();
+
+		std::array<VkImageMemoryBarrier, 2> barriers = {};
+		const std::array images = { shadow_maps.CascadeTexture.Image, shadow_maps.AtlasTexture.Image };
+		for ( size_t i = 0; i < barriers.size(); ++i )
+		{
+			barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barriers[i].srcAccessMask = 0;
+			barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barriers[i].image = images[i];
+			barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			barriers[i].subresourceRange.levelCount = 1;
+			barriers[i].subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		}
+
+		const VkDependencyFlags dependency_flags = 0;
+		vkCmdPipelineBarrier( command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			dependency_flags, 0, nullptr, 0, nullptr, static_cast< uint32 >( barriers.size() ), barriers.data() );
+
+		const VkClearDepthStencilValue clear_value = { 1.0f, 0 };
+		for ( size_t i = 0; i < barriers.size(); ++i )
+		{
+			const uint32 range_count = 1;
+			vkCmdClearDepthStencilImage( command_buffer, images[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				&clear_value, range_count, &barriers[i].subresourceRange );
+
+			barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barriers[i].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+
+		vkCmdPipelineBarrier( command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			dependency_flags, 0, nullptr, 0, nullptr, static_cast< uint32 >( barriers.size() ), barriers.data() );
+		EndSingleTimeCommands( command_buffer );
+
+		return shadow_maps;
+	}
+
+	Expected<VkSampler> Context::CreateShadowSampler()
+	{
+		VkSamplerCreateInfo sampler_info = {};
+		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler_info.magFilter = VK_FILTER_LINEAR;
+		sampler_info.minFilter = VK_FILTER_LINEAR;
+		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		sampler_info.compareEnable = true;
+		sampler_info.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		sampler_info.minLod = 0.0f;
+		sampler_info.maxLod = 0.0f;
+
+		const VkAllocationCallbacks* alloc = Allocator;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkResult err = vkCreateSampler( Device, &sampler_info, alloc, &sampler );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateSampler, err ) );
+		}
+		return sampler;
+	}
+
+	// Cascades are fitted to a bounding sphere of their slice of the view frustum, whose size does not change
+	// as the camera turns, and their origin is snapped to whole texels of the light's view. Both keep the map
+	// from shimmering and let a fit come out exactly the same while the camera stays inside a texel, which is
+	// what makes caching the far cascades work.
+	void Context::UpdateShadows( uint32 current_frame, UniformBufferObject& ubo )
+	{
+		constexpr uint32 CASCADE_SIZE = VulkanShadowMaps::CASCADE_SIZE;
+
+		++ShadowMaps.Frame;
+		ShadowMaps.Passes.clear();
+
+		// everything the maps hold is drawn under ubo.Model, the objects themselves never move
+		auto schedule = [this, &ubo] ( VulkanShadowView& view, const glm::mat4& view_projection, uint32 target,
+			VkRect2D rect ) {
+			view.ViewProjection = view_projection;
+			view.CasterTransform = ubo.Model;
+			view.RenderedFrame = ShadowMaps.Frame;
+
+			VulkanShadowPass pass = {};
+			pass.Transform = view_projection * ubo.Model;
+			pass.Target = target;
+			pass.Rect = rect;
+			ShadowMaps.Passes.push_back( pass );
+		};
+		auto is_stale = [&ubo] ( const VulkanShadowView& view, const glm::mat4& view_projection ) {
+			return view.RenderedFrame == 0 || view.ViewProjection != view_projection ||
+				view.CasterTransform != ubo.Model;
+		};
+		auto oldest_first = [] ( const VulkanShadowView* lhs, const VulkanShadowView* rhs ) {
+			return lhs->RenderedFrame < rhs->RenderedFrame;
+		};
+
+		const glm::mat4 inverse_view = glm::inverse( ubo.View );
+		const glm::vec2 tan_half_fov = glm::vec2( 1.0f / ubo.Projection[0][0],
+			1.0f / std::abs( ubo.Projection[1][1] ) );
+		const glm::mat4 light_view = LookTowards( glm::vec3( 0.0f ), Sun.Direction );
+
+		std::array<glm::mat4, SHADOW_CASCADE_COUNT> fits = {};
+		float slice_near = NEAR_PLANE;
+		for ( uint32 cascade = 0; cascade < SHADOW_CASCADE_COUNT; ++cascade )
+		{
+			const float t = static_cast< float >( cascade + 1 ) / SHADOW_CASCADE_COUNT;
+			const float uniform_split = NEAR_PLANE + ( FAR_PLANE - NEAR_PLANE ) * t;
+			const float log_split = NEAR_PLANE * std::pow( FAR_PLANE / NEAR_PLANE, t );
+			const float slice_far = glm::mix( uniform_split, log_split, SPLIT_BLEND );
+			ubo.CascadeSplits[cascade] = slice_far;
+
+			// the sphere is centered on the view axis, rounding its radius keeps float noise out of the size
+			const glm::vec3 center = glm::vec3( 0.0f, 0.0f, -( slice_near + slice_far ) * 0.5f );
+			float radius = 0.0f;
+			for ( float depth : { slice_near, slice_far } )
+			{
+				const glm::vec3 corner = glm::vec3( tan_half_fov * depth, -depth );
+				radius = std::max( radius, glm::length( corner - center ) );
+			}
+			radius = std::ceil( radius * 16.0f ) / 16.0f;
+
+			const float texel = 2.0f * radius / CASCADE_SIZE;
+			glm::vec3 light_center = glm::vec3( light_view * inverse_view * glm::vec4( center, 1.0f ) );
+			light_center = glm::floor( light_center / texel ) * texel;
+
+			// the light looks down -z, casters between the sun and the sphere are kept in front of the near plane
+			const glm::mat4 projection = glm::orthoRH_ZO(
+				light_center.x - radius, light_center.x + radius,
+				light_center.y - radius, light_center.y + radius,
+				-light_center.z - radius - CASTER_DISTANCE, -light_center.z + radius );
+			fits[cascade] = projection * light_view;
+			slice_near = slice_far;
+		}
+
+		const VkRect2D cascade_rect = { { 0, 0 }, { CASCADE_SIZE, CASCADE_SIZE } };
+		std::pmr::vector<VulkanShadowView*> stale_views( FrameMemory.GetResource() );
+		for ( uint32 cascade = 0; cascade < SHADOW_CASCADE_COUNT; ++cascade )
+		{
+			VulkanShadowView& view = ShadowMaps.Cascades[cascade];
+			if ( cascade < VulkanShadowMaps::FIRST_CACHED_CASCADE )
+			{
+				schedule( view, fits[cascade], cascade, cascade_rect );
+			}
+			else if ( is_stale( view, fits[cascade] ) )
+			{
+				stale_views.push_back( &view );
+			}
+		}
+
+		// a cascade that is not redrawn keeps the fit it was rendered with, so it lags behind by a few frames
+		const size_t cascade_count = std::min<size_t>( stale_views.size(), VulkanShadowMaps::CACHED_CASCADE_BUDGET );
+		std::ranges::partial_sort( stale_views, stale_views.begin() + cascade_count, oldest_first );
+		for ( size_t i = 0; i < cascade_count; ++i )
+		{
+			const uint32 cascade = static_cast< uint32 >( stale_views[i] - ShadowMaps.Cascades.data() );
+			schedule( *stale_views[i], fits[cascade], cascade, cascade_rect );
+		}
+
+		for ( uint32 cascade = 0; cascade < SHADOW_CASCADE_COUNT; ++cascade )
+		{
+			ubo.CascadeMatrices[cascade] = ShadowMaps.Cascades[cascade].ViewProjection * inverse_view;
+		}
+		ubo.SunDirection = glm::vec4( glm::normalize( glm::mat3( ubo.View ) * -Sun.Direction ), 0.0f );
+		ubo.SunColor = glm::vec4( Sun.Color, 1.0f );
+
+		// tiles of lights outside the view are left alone, they are stale but nothing samples them
+		const Frustum frustum = Frustum::FromMatrix( ubo.Projection * ubo.View );
+		stale_views.clear();
+		for ( VulkanShadowView& tile : ShadowMaps.Tiles )
+		{
+			const SceneLight& light = Lights[tile.Light];
+			if ( frustum.Intersects( light.Position, light.Range ) &&
+				is_stale( tile, GetTileViewProjection( light, tile.Face ) ) )
+			{
+				stale_views.push_back( &tile );
+			}
+		}
+
+		const size_t tile_count = std::min<size_t>( stale_views.size(), VulkanShadowMaps::TILE_BUDGET );
+		std::ranges::partial_sort( stale_views, stale_views.begin() + tile_count, oldest_first );
+		for ( size_t i = 0; i < tile_count; ++i )
+		{
+			VulkanShadowView& tile = *stale_views[i];
+			const uint32 tile_index = static_cast< uint32 >( &tile - ShadowMaps.Tiles.data() );
+			schedule( tile, GetTileViewProjection( Lights[tile.Light], tile.Face ), SHADOW_CASCADE_COUNT,
+				GetTileRect( tile_index ) );
+		}
+
+		// texel centers only, so filtering never reaches into a neighbouring tile
+		std::pmr::vector<ShadowTileData> tile_data( FrameMemory.GetResource() );
+		tile_data.reserve( ShadowMaps.Tiles.size() );
+		for ( uint32 tile_index = 0; tile_index < ShadowMaps.Tiles.size(); ++tile_index )
+		{
+			const VkRect2D rect = GetTileRect( tile_index );
+			const float atlas_size = static_cast< float >( VulkanShadowMaps::ATLAS_SIZE );
+
+			ShadowTileData data = {};
+			data.Matrix = ShadowMaps.Tiles[tile_index].ViewProjection * inverse_view;
+			data.Rect = glm::vec4(
+				( glm::vec2( rect.offset.x, rect.offset.y ) + 0.5f ) / atlas_size,
+				glm::vec2( rect.extent.width - 1.0f, rect.extent.height - 1.0f ) / atlas_size );
+			tile_data.push_back( data );
+		}
+
+		ShadowMaps.TileRing.BeginFrame( current_frame );
+		auto tiles_offset = ShadowMaps.TileRing.Push( tile_data.data(), tile_data.size() * sizeof( ShadowTileData ) );
+		ASSERT( tiles_offset && tiles_offset.value() == 0 );
+	}
+
+	void Context::BuildShadowDraws()
+	{
+		ShadowMaps.Draws.clear();
+
+		for ( VulkanShadowPass& pass : ShadowMaps.Passes )
+		{
+			pass.FirstDraw = static_cast< uint32 >( ShadowMaps.Draws.size() );
+
+			// the tree and the pass transform are both before ubo.Model, like the camera's query
+			ShadowMaps.Casters.clear();
+			SceneTree.QueryFrustum( Frustum::FromMatrix( pass.Transform ), ShadowMaps.Casters );
+			// casters reuse the level of detail the camera picked, ones outside the view keep the level they
+			// were last seen with
+			auto mesh_lod = [this] ( uint32 object_id ) {
+				return Objects[object_id].Mesh * VulkanMesh::MAX_LODS + Objects[object_id].Lod;
+			};
+			std::ranges::sort( ShadowMaps.Casters, {}, mesh_lod );
+
+			for ( size_t begin = 0; begin < ShadowMaps.Casters.size(); )
+			{
+				const uint32 key = mesh_lod( ShadowMaps.Casters[begin] );
+
+				BatchInstances.clear();
+				size_t end = begin;
+				for ( ; end < ShadowMaps.Casters.size() && mesh_lod( ShadowMaps.Casters[end] ) == key; ++end )
+				{
+					BatchInstances.push_back( { Objects[ShadowMaps.Casters[end]].Transform } );
+				}
+
+				auto instance_offset = InstanceRing.Push( BatchInstances.data(),
+					BatchInstances.size() * sizeof( InstanceData ) );
+				if ( !instance_offset )
+				{
+					// frame region is exhausted, the view is drawn with the casters that made it in
+					break;
+				}
+
+				VulkanShadowDraw draw = {};
+				draw.Mesh = key / VulkanMesh::MAX_LODS;
+				draw.Lod = key % VulkanMesh::MAX_LODS;
+				draw.FirstInstance = static_cast< uint32 >(
+					InstanceRing.AbsoluteOffset( instance_offset.value() ) / sizeof( InstanceData ) );
+				draw.InstanceCount = static_cast< uint32 >( end - begin );
+				ShadowMaps.Draws.push_back( draw );
+
+				begin = end;
+			}
+
+			pass.DrawCount = static_cast< uint32 >( ShadowMaps.Draws.size() ) - pass.FirstDraw;
+		}
+	}
+
+	// Runs on the graphics queue before the scene pass. The maps leave the shader read layout only while they
+	// are drawn into, the previous frame's fragment shaders are the last readers.
+	void Context::RecordShadows( VkCommandBuffer command_buffer )
+	{
+		if ( ShadowMaps.Passes.empty() )
+		{
+			return;
+		}
+
+		const VkDependencyFlags    dependency_flags = 0;
+		const VkPipelineStageFlags fragment_tests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		bool draws_cascades = false;
+		bool draws_atlas = false;
+		for ( const VulkanShadowPass& pass : ShadowMaps.Passes )
+		{
+			draws_cascades |= pass.Target < SHADOW_CASCADE_COUNT;
+			draws_atlas |= pass.Target == SHADOW_CASCADE_COUNT;
+		}
+
+		std::array<VkImageMemoryBarrier, 2> barriers = {};
+		uint32 barrier_count = 0;
+		for ( const auto& [image, drawn] : { std::pair( ShadowMaps.CascadeTexture.Image, draws_cascades ),
+			std::pair( ShadowMaps.AtlasTexture.Image, draws_atlas ) } )
+		{
+			if ( !drawn )
+			{
+				continue;
+			}
+
+			VkImageMemoryBarrier& barrier = barriers[barrier_count++];
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		}
+
+		vkCmdPipelineBarrier( command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, fragment_tests,
+			dependency_flags, 0, nullptr, 0, nullptr, barrier_count, barriers.data() );
+
+		vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, ShadowMaps.Pipeline.Instance );
+
+		std::array<VkBuffer, 2> vertex_buffers = { VertexBuffer.Instance, InstanceRing.Buffer.Instance };
+		std::array<VkDeviceSize, 2> offsets = { 0, 0 };
+		const uint32 first_binding = 0;
+		vkCmdBindVertexBuffers( command_buffer, first_binding, static_cast< uint32 >( vertex_buffers.size() ),
+			vertex_buffers.data(), offsets.data() );
+		vkCmdBindIndexBuffer( command_buffer, IndexBuffer.Instance, 0, VK_INDEX_TYPE_UINT16 );
+
+		for ( const VulkanShadowPass& pass : ShadowMaps.Passes )
+		{
+			const VkImageView view = pass.Target < SHADOW_CASCADE_COUNT ? ShadowMaps.LayerViews[pass.Target] :
+				ShadowMaps.AtlasTexture.View;
+
+			if ( DynamicRendering )
+			{
+				VkRenderingAttachmentInfoKHR depth_attachment = {};
+				depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+				depth_attachment.imageView = view;
+				depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+				depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+				VkRenderingInfoKHR rendering_info = {};
+				rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+				rendering_info.renderArea = pass.Rect;
+				rendering_info.layerCount = 1;
+				rendering_info.pDepthAttachment = &depth_attachment;
+				DeviceFunctions.CmdBeginRendering( command_buffer, &rendering_info );
+			}
+			else
+			{
+				VkRenderPassBeginInfo render_pass_info = {};
+				render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				render_pass_info.renderPass = ShadowMaps.Pipeline.RenderPass;
+				render_pass_info.framebuffer = ShadowMaps.Framebuffers[pass.Target];
+				render_pass_info.renderArea = pass.Rect;
+				vkCmdBeginRenderPass( command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
+			}
+
+			VkViewport viewport = {};
+			viewport.x = static_cast< float >( pass.Rect.offset.x );
+			viewport.y = static_cast< float >( pass.Rect.offset.y );
+			viewport.width = static_cast< float >( pass.Rect.extent.width );
+			viewport.height = static_cast< float >( pass.Rect.extent.height );
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+			vkCmdSetViewport( command_buffer, 0, 1, &viewport );
+			vkCmdSetScissor( command_buffer, 0, 1, &pass.Rect );
+
+			// the rest of the map is loaded, only the view's own rect starts over
+			VkClearAttachment clear_attachment = {};
+			clear_attachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			clear_attachment.clearValue.depthStencil = { 1.0f, 0 };
+
+			VkClearRect clear_rect = {};
+			clear_rect.rect = pass.Rect;
+			clear_rect.layerCount = 1;
+			vkCmdClearAttachments( command_buffer, 1, &clear_attachment, 1, &clear_rect );
+
+			ShadowParams params = {};
+			params.Transform = pass.Transform;
+			vkCmdPushConstants( command_buffer, ShadowMaps.Pipeline.Layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+				sizeof( params ), &params );
+
+			for ( uint32 i = pass.FirstDraw; i < pass.FirstDraw + pass.DrawCount; ++i )
+			{
+				const VulkanShadowDraw& draw = ShadowMaps.Draws[i];
+				const VulkanMesh& mesh = Meshes[draw.Mesh];
+				const VulkanMeshLod& lod = mesh.Lods[draw.Lod];
+				vkCmdDrawIndexed( command_buffer, lod.IndexCount, draw.InstanceCount, lod.FirstIndex,
+					mesh.VertexOffset, draw.FirstInstance );
+				++Stats.DrawCalls;
+			}
+
+			if ( DynamicRendering )
+			{
+				DeviceFunctions.CmdEndRendering( command_buffer );
+			}
+			else
+			{
+				vkCmdEndRenderPass( command_buffer );
+			}
+		}
+
+		for ( uint32 i = 0; i < barrier_count; ++i )
+		{
+			barriers[i].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barriers[i].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			barriers[i].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+
+		vkCmdPipelineBarrier( command_buffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, dependency_flags, 0, nullptr, 0, nullptr, barrier_count,
+			barriers.data() );
+	}
+
+} // namespace VulkanRHI
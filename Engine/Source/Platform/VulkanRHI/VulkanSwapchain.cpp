@@ -0,0 +1,318 @@
+#include "VulkanRHI.h"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include <SDL3/SDL_vulkan.h>
+
+#include "Engine/Core/Common.h"
+#include "Engine/Core/Log.h"
+
+namespace VulkanRHI
+{
+
+	namespace
+	{
+		// in order of preference, the renderer writes gamma encoded values itself
+		constexpr std::array<VkSurfaceFormatKHR, 2> PREFERRED_FORMATS = { {
+			{ VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+			{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+		} };
+
+		VkPresentModeKHR ToVkPresentMode( PresentMode mode )
+		{
+			switch ( mode )
+			{
+			case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+			case PresentMode::Mailbox:     return VK_PRESENT_MODE_MAILBOX_KHR;
+			case PresentMode::Immediate:   return VK_PRESENT_MODE_IMMEDIATE_KHR;
+			default:                       return VK_PRESENT_MODE_FIFO_KHR;
+			}
+		}
+
+		const char* GetPresentModeName( VkPresentModeKHR mode )
+		{
+			switch ( mode )
+			{
+			case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+			case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+			case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+			default:                               return "FIFO";
+			}
+		}
+
+		VkSurfaceFormatKHR ChooseSurfaceFormat( std::span<const VkSurfaceFormatKHR> formats )
+		{
+			// a single undefined entry means the surface takes any format
+			if ( formats.size() == 1 && formats[0].format == VK_FORMAT_UNDEFINED )
+			{
+				return PREFERRED_FORMATS[0];
+			}
+
+			for ( const VkSurfaceFormatKHR& preferred : PREFERRED_FORMATS )
+			{
+				auto it = std::ranges::find_if( formats, [&preferred] ( const VkSurfaceFormatKHR& format ) {
+					return format.format == preferred.format && format.colorSpace == preferred.colorSpace;
+				} );
+				if ( it != formats.end() )
+				{
+					return *it;
+				}
+			}
+			return formats[0];
+		}
+
+		// FIFO is the only mode every surface has to support
+		VkPresentModeKHR ChoosePresentMode( std::span<const VkPresentModeKHR> modes, PresentMode requested )
+		{
+			std::array<VkPresentModeKHR, 3> candidates = {};
+			switch ( requested )
+			{
+			case PresentMode::Mailbox:
+				candidates = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+				break;
+			case PresentMode::Immediate:
+				candidates = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+				break;
+			default:
+				candidates = { ToVkPresentMode( requested ), VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR };
+				break;
+			}
+
+			for ( VkPresentModeKHR candidate : candidates )
+			{
+				if ( std::ranges::find( modes, candidate ) != modes.end() )
+				{
+					return candidate;
+				}
+			}
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+
+		uint32 ChooseImageCount( const VkSurfaceCapabilitiesKHR& capabilities, const PresentSettings& settings )
+		{
+			// one image more than the minimum keeps acquire from blocking on the presentation engine,
+			// low latency gives that up to keep fewer frames queued ahead of the display
+			uint32 image_count = settings.ImageCount;
+			if ( image_count == 0 )
+			{
+				image_count = settings.LowLatency ? capabilities.minImageCount : capabilities.minImageCount + 1;
+			}
+
+			image_count = std::max( image_count, capabilities.minImageCount );
+			if ( capabilities.maxImageCount != 0 )
+			{
+				image_count = std::min( image_count, capabilities.maxImageCount );
+			}
+			return image_count;
+		}
+
+		VkExtent2D ChooseExtent( const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D window_extent )
+		{
+			// the surface size follows the window unless it reports the special value
+			if ( capabilities.currentExtent.width != UINT32_MAX )
+			{
+				return capabilities.currentExtent;
+			}
+
+			VkExtent2D extent = {};
+			extent.width = std::clamp( window_extent.width, capabilities.minImageExtent.width,
+				capabilities.maxImageExtent.width );
+			extent.height = std::clamp( window_extent.height, capabilities.minImageExtent.height,
+				capabilities.maxImageExtent.height );
+			return extent;
+		}
+
+		VkCompositeAlphaFlagBitsKHR ChooseCompositeAlpha( VkCompositeAlphaFlagsKHR supported )
+		{
+			constexpr std::array<VkCompositeAlphaFlagBitsKHR, 4> candidates = {
+				VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+				VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+				VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR,
+				VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR,
+			};
+
+			for ( VkCompositeAlphaFlagBitsKHR candidate : candidates )
+			{
+				if ( supported & candidate )
+				{
+					return candidate;
+				}
+			}
+			return VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		}
+	}
+
+	void Context::SetPresentSettings( const PresentSettings& settings )
+	{
+		PresentConfig = settings;
+		SwapchainDirty = Swapchain.Instance != VK_NULL_HANDLE;
+	}
+
+	void Context::OnResize()
+	{
+		ResizePending = true;
+	}
+
+	VkExtent2D Context::GetWindowExtent() const
+	{
+		int32 width, height;
+		SDL_GetWindowSizeInPixels( WindowHandle, &width, &height );
+		return { static_cast< uint32 >( std::max( width, 0 ) ), static_cast< uint32 >( std::max( height, 0 ) ) };
+	}
+
+	Expected<VulkanSwapchain> Context::CreateSwapchain( VkSwapchainKHR old_swapchain )
+	{
+		VkResult err;
+
+		VkSurfaceCapabilitiesKHR capabilities = {};
+		err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR( Gpu, Surface, &capabilities );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::GetSurfaceCapabilities, err ) );
+		}
+
+		uint32 format_count = 0;
+		err = vkGetPhysicalDeviceSurfaceFormatsKHR( Gpu, Surface, &format_count, nullptr );
+		std::vector<VkSurfaceFormatKHR> formats( format_count );
+		if ( err == VK_SUCCESS )
+		{
+			err = vkGetPhysicalDeviceSurfaceFormatsKHR( Gpu, Surface, &format_count, formats.data() );
+		}
+		if ( err != VK_SUCCESS || formats.empty() )
+		{
+			return std::unexpected( Error( ErrorCode::GetSurfaceFormats, err ) );
+		}
+
+		uint32 mode_count = 0;
+		err = vkGetPhysicalDeviceSurfacePresentModesKHR( Gpu, Surface, &mode_count, nullptr );
+		std::vector<VkPresentModeKHR> modes( mode_count );
+		if ( err == VK_SUCCESS )
+		{
+			err = vkGetPhysicalDeviceSurfacePresentModesKHR( Gpu, Surface, &mode_count, modes.data() );
+		}
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::GetSurfacePresentModes, err ) );
+		}
+
+		const VkSurfaceFormatKHR surface_format = ChooseSurfaceFormat( formats );
+
+		// the tonemap shader stores RGBA8, any other format gets its output through a blit
+		VkFormatProperties format_properties = {};
+		vkGetPhysicalDeviceFormatProperties( Gpu, surface_format.format, &format_properties );
+		const bool storage_images = surface_format.format == VulkanPostProcess::OUTPUT_FORMAT &&
+			( capabilities.supportedUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT ) &&
+			( format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT );
+
+		VkSwapchainCreateInfoKHR swapchain_info = {};
+		swapchain_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		swapchain_info.surface = Surface;
+		swapchain_info.minImageCount = ChooseImageCount( capabilities, PresentConfig );
+		swapchain_info.imageFormat = surface_format.format;
+		swapchain_info.imageColorSpace = surface_format.colorSpace;
+		swapchain_info.imageExtent = ChooseExtent( capabilities, GetWindowExtent() );
+		swapchain_info.imageArrayLayers = 1;
+		swapchain_info.imageUsage = storage_images ? VK_IMAGE_USAGE_STORAGE_BIT : VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		swapchain_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		swapchain_info.preTransform = capabilities.currentTransform;
+		swapchain_info.compositeAlpha = ChooseCompositeAlpha( capabilities.supportedCompositeAlpha );
+		swapchain_info.presentMode = ChoosePresentMode( modes, PresentConfig.Mode );
+		swapchain_info.clipped = VK_TRUE;
+		swapchain_info.oldSwapchain = old_swapchain;
+
+		VulkanSwapchain swapchain;
+		swapchain.Format = swapchain_info.imageFormat;
+		swapchain.ColorSpace = swapchain_info.imageColorSpace;
+		swapchain.PresentMode = swapchain_info.presentMode;
+		swapchain.Extent = swapchain_info.imageExtent;
+		swapchain.StorageImages = storage_images;
+		err = vkCreateSwapchainKHR( Device, &swapchain_info, Allocator, &swapchain.Instance );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::CreateSwapchain, err ) );
+		}
+
+		uint32 count_images = 0;
+		err = vkGetSwapchainImagesKHR( Device, swapchain.Instance, &count_images, nullptr );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::GetSwapchainImages, err ) );
+		}
+		swapchain.Images.resize( count_images );
+
+		err = vkGetSwapchainImagesKHR( Device, swapchain.Instance, &count_images, swapchain.Images.data() );
+		if ( err != VK_SUCCESS )
+		{
+			return std::unexpected( Error( ErrorCode::GetSwapchainImages, err ) );
+		}
+
+		LOG_INFO( "[Vulkan] Swapchain {}x{}, {} images, format {}, color space {}, present mode {}, {}.",
+			swapchain.Extent.width, swapchain.Extent.height, count_images, static_cast< int32 >( swapchain.Format ),
+			static_cast< int32 >( swapchain.ColorSpace ), GetPresentModeName( swapchain.PresentMode ),
+			storage_images ? "written by the tonemap pass" : "blitted to" );
+		return swapchain;
+	}
+
+	// Nothing waits for the GPU here. The new swapchain is created from the old one so the presentation
+	// engine can hand over without a gap, and everything sized for the old extent keeps living until the
+	// frames that were submitted with it have completed.
+	void Context::RecreateSwapchain()
+	{
+		auto swapchain_result = CreateSwapchain( Swapchain.Instance );
+		if ( !swapchain_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", swapchain_result.error() );
+			throw std::runtime_error( "swapchain == VK_NULL_HANDLE" );
+		}
+
+		VulkanRetiredSwapchain retired;
+		retired.Swapchain = std::exchange( Swapchain, std::move( swapchain_result.value() ) );
+		retired.DepthTexture = std::exchange( DepthTexture, {} );
+		if ( OcclusionCulling )
+		{
+			retired.HiZPyramid = std::exchange( HiZPyramid, {} );
+		}
+		retired.HdrTargets = std::exchange( HdrTargets, {} );
+		SwapchainDirty = false;
+		++SwapchainGeneration;
+
+		auto image_views_result = CreateImageViews();
+		if ( !image_views_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", image_views_result.error() );
+		}
+		Swapchain.ImageViews = std::move( image_views_result.value() );
+
+		auto texture_result = CreateDepthTexture();
+		if ( !texture_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", texture_result.error() );
+		}
+		DepthTexture = std::move( texture_result.value() );
+
+		// the cull sets still sample the old pyramid, each is pointed at the new one once its frame is free
+		if ( OcclusionCulling )
+		{
+			auto pyramid_result = CreateHiZPyramid();
+			if ( !pyramid_result )
+			{
+				LOG_ERROR_CAT( LogCategory::Vulkan, "{}", pyramid_result.error() );
+			}
+			HiZPyramid = std::move( pyramid_result.value() );
+		}
+
+		auto hdr_targets_result = CreateHdrTargets();
+		if ( !hdr_targets_result )
+		{
+			LOG_ERROR_CAT( LogCategory::Vulkan, "{}", hdr_targets_result.error() );
+		}
+		HdrTargets = std::move( hdr_targets_result.value() );
+
+		// after the uploads of the new resources, so that the next submission is the frame
+		DeletionQueue.RetireResource( DeletionQueue.GetSubmittedValue() + 1, std::move( retired ) );
+	}
+
+} // namespace VulkanRHI
@@ -6,7 +6,7 @@ WindowsWindow::WindowsWindow( const WindowCreateInfo& create_info )
     Data.Position = create_info.Position;
     Data.Size = create_info.Size;
     Data.Title = create_info.Title;
-    Data.VSync = false;
+    Data.VSync = create_info.VSync;
 
     int32 x = Data.Size.X;
     int32 y = Data.Size.Y;
@@ -17,6 +17,11 @@ WindowsWindow::WindowsWindow( const WindowCreateInfo& create_info )
 		SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE );
 
     Context = RHIContext::Create( Window, RHIContext::Backend::Vulkan );
+
+    PresentSettings present_settings = {};
+    present_settings.Mode = Data.VSync ? PresentMode::Fifo : PresentMode::Mailbox;
+    Context->SetPresentSettings( present_settings );
+
     try
     {
         Context->Init();
@@ -46,3 +51,9 @@ void WindowsWindow::OnUpdate()
     }
 }
 
+
+void WindowsWindow::OnResize( uint32_t width, uint32_t height )
+{
+    Data.Size = { width, height };
+    Context->OnResize();
+}
@@ -15,6 +15,7 @@ public:
     ~WindowsWindow() override;
 
     void OnUpdate() override;
+    void OnResize( uint32_t width, uint32_t height ) override;
     virtual void* GetNativeWindow() const { return Window; }
 
 private:
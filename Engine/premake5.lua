@@ -39,17 +39,19 @@ project "Engine"
 
     systemversion "latest"
 
+    -- compiles only the shaders whose preprocessed source, defines or compiler changed, see the script
     postbuildcommands 
     {
-        '"%{VULKAN_SDK}/Bin/glslc" "%{prj.location}/Shaders/triangle.vert" -o "%{prj.location}/Shaders/triangle.vert.spv"',
-        '"%{VULKAN_SDK}/Bin/glslc" "%{prj.location}/Shaders/triangle.frag" -o "%{prj.location}/Shaders/triangle.frag.spv"',
+        'powershell -NoProfile -ExecutionPolicy Bypass -File "%{prj.location}/Scripts/compile_shaders.ps1" -Glslc "%{VULKAN_SDK}/Bin/glslc" -ShaderDir "%{prj.location}/Shaders"',
     }
 
     filter "system:Windows"
     defines 
     {
         "PLATFORM_WINDOWS",
-        "VULKAN_SUPPORTED"
+        "VULKAN_SUPPORTED",
+        -- part of the runtime shader cache key, names the same compiler as the glslc the script runs
+        'VULKAN_SDK_VERSION="' .. VULKAN_SDK_VERSION .. '"'
     }
 
     files
@@ -60,6 +62,11 @@ project "Engine"
         "Source/Platform/VulkanRHI/**.cpp"
     }
 
+    links
+    {
+        Library["ShaderC"]
+    }
+
     filter "configurations:Debug"
         defines "DEBUG"
         runtime "Debug"
@@ -0,0 +1,93 @@
+#include "Test.h"
+
+#include <cstring>
+
+#include "Engine/Core/Memory.h"
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 64 * 1024;
+    // larger than the scratch arena's block, forces an overflow block
+    constexpr size_t OVERFLOW_SIZE = 300 * 1024;
+
+    // A marker taken on an empty allocator must survive an overflow and the rewind back to it.
+    void TestRewindAfterOverflow()
+    {
+        LinearAllocator allocator( BLOCK_SIZE, MemoryTag::General );
+        const LinearAllocator::Marker empty = allocator.GetMarker();
+
+        allocator.Allocate( BLOCK_SIZE / 2 );
+        const LinearAllocator::Marker half = allocator.GetMarker();
+        allocator.Allocate( BLOCK_SIZE * 2 );
+        CHECK( allocator.GetCapacity() > BLOCK_SIZE );
+
+        allocator.Rewind( half );
+        CHECK( allocator.GetUsed() == BLOCK_SIZE / 2 );
+        CHECK( allocator.GetCapacity() == BLOCK_SIZE );
+
+        allocator.Rewind( empty );
+        CHECK( allocator.GetUsed() == 0 );
+        CHECK( allocator.GetCapacity() == BLOCK_SIZE );
+
+        // still usable through the marker's block
+        allocator.Allocate( BLOCK_SIZE / 2 );
+        allocator.Rewind( empty );
+        CHECK( allocator.GetUsed() == 0 );
+    }
+
+    // Reset trades the chain for one block as large as the peak, the same workload then fits it.
+    void TestResetGrowsToPeak()
+    {
+        LinearAllocator allocator( BLOCK_SIZE, MemoryTag::General );
+        allocator.Allocate( BLOCK_SIZE / 2 );
+        allocator.Allocate( BLOCK_SIZE * 2 );
+        const size_t peak = allocator.GetUsed();
+
+        allocator.Reset();
+        CHECK( allocator.GetUsed() == 0 );
+        CHECK( allocator.GetCapacity() >= peak );
+
+        const size_t capacity = allocator.GetCapacity();
+        allocator.Allocate( BLOCK_SIZE / 2 );
+        allocator.Allocate( BLOCK_SIZE * 2 );
+        CHECK( allocator.GetCapacity() == capacity );
+    }
+
+    // An inner scope that overflows the arena must leave the outer scope's marker valid.
+    void TestNestedScratchOverflow()
+    {
+        {
+            ScratchScope outer;
+            uint32* before = outer.AllocateArray<uint32>( 16 );
+            std::memset( before, 0xab, 16 * sizeof( uint32 ) );
+            {
+                ScratchScope inner;
+                std::byte* large = inner.AllocateArray<std::byte>( OVERFLOW_SIZE );
+                std::memset( large, 0, OVERFLOW_SIZE );
+            }
+            CHECK( before[15] == 0xabababab );
+
+            uint32* after = outer.AllocateArray<uint32>( 16 );
+            CHECK( after != nullptr );
+        }
+
+        // the outermost scope has grown the arena to the peak, the same work no longer allocates blocks
+        const uint64 allocations = Memory::GetStats( MemoryTag::Scratch ).Allocations;
+        {
+            ScratchScope outer;
+            outer.AllocateArray<uint32>( 16 );
+            {
+                ScratchScope inner;
+                inner.AllocateArray<std::byte>( OVERFLOW_SIZE );
+            }
+        }
+        CHECK( Memory::GetStats( MemoryTag::Scratch ).Allocations == allocations );
+    }
+}
+
+void RunMemoryTests()
+{
+    TestRewindAfterOverflow();
+    TestResetGrowsToPeak();
+    TestNestedScratchOverflow();
+}
@@ -0,0 +1,26 @@
+// Tests/src/Test.h
+
+#ifndef __tests_test_h_included__
+#define __tests_test_h_included__
+
+#include <cstdio>
+
+#include "Engine/Core/Common.h"
+
+// failed checks of the whole run, main exits with an error when there are any
+inline uint32 FailedChecks = 0;
+
+// reports a failed expression and keeps going, so one run lists every failure
+#define CHECK( expression )                                                                          \
+    do                                                                                               \
+    {                                                                                                \
+        if ( !( expression ) )                                                                       \
+        {                                                                                            \
+            std::printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #expression );          \
+            ++FailedChecks;                                                                          \
+        }                                                                                            \
+    } while ( false )
+
+void RunMemoryTests();
+
+#endif
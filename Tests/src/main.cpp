@@ -0,0 +1,15 @@
+#include "Test.h"
+
+// Runs every test, the exit code is non-zero when a check failed.
+int main()
+{
+    RunMemoryTests();
+
+    if ( FailedChecks > 0 )
+    {
+        std::printf( "%u checks failed\n", FailedChecks );
+        return 1;
+    }
+    std::printf( "all checks passed\n" );
+    return 0;
+}
@@ -11,6 +11,8 @@ workspace "Engine"
     outputdir = "%{cfg.buildcfg}"
 
     VULKAN_SDK = os.getenv("VULKAN_SDK")
+    -- the SDK installs into a directory named after its version, e.g. C:/VulkanSDK/1.3.280.0
+    VULKAN_SDK_VERSION = VULKAN_SDK and path.getname(path.normalize(VULKAN_SDK)) or "unknown"
 
     IncludeDir = {}
     IncludeDir["glm"] = "%{wks.location}/Engine/external/glm"
@@ -26,6 +28,7 @@ workspace "Engine"
 
     Library = {}
     Library["Vulkan"] = "%{LibraryDir.VulkanSDK}/vulkan-1.lib"
+    Library["ShaderC"] = "%{LibraryDir.VulkanSDK}/shaderc_shared.lib"
 
     group "Core"
         include "Engine"
@@ -33,6 +36,8 @@ workspace "Engine"
     group "Miscellaneous"
         include "Sandbox"
         include "Editor"
+        include "Benchmarks"
+        include "Tests"
 
     group "Dependencies"
         include "Engine/external/imgui"